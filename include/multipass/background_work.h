@@ -0,0 +1,86 @@
+/*
+ * Copyright (C) Canonical, Ltd.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#pragma once
+
+#include "disabled_copy_move.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <utility>
+
+namespace multipass
+{
+/*
+ * Marks what the current thread does, for as long as it lives, as background work that should
+ * yield to whatever users are waiting on: the thread runs at the lowest CPU and I/O priority the
+ * platform has, and downloads made from it keep to the given bandwidth limit. Scopes nest, with
+ * the innermost one setting the limit.
+ */
+class BackgroundWork : private DisabledCopyMove
+{
+public:
+    // Set from any thread to have the work go on at normal priority and with no bandwidth limit,
+    // for when users come to wait on work that was started in the background
+    using Promotion = std::shared_ptr<std::atomic_bool>;
+
+    explicit BackgroundWork(std::uint64_t bandwidth_limit = 0, // in bytes per second, 0 for none
+                            Promotion promotion = nullptr);
+    ~BackgroundWork();
+
+    // The innermost scope on the current thread, if any
+    static BackgroundWork* current();
+
+    std::uint64_t bandwidth_limit() const; // 0 once promoted
+
+    // Restores the thread's priority if the work was promoted since last asked
+    void follow_promotion();
+
+    // Accounts for bytes just transferred, sleeping for as long as it takes to keep to the limit.
+    // Follows a promotion first
+    void throttle(std::uint64_t bytes);
+
+private:
+    bool promoted() const;
+
+    const std::uint64_t limit;
+    const Promotion promotion;
+    BackgroundWork* const outer;
+    bool lowered_priority;
+    std::chrono::steady_clock::time_point available_at;
+};
+
+// Wraps a callable so that it runs as background work if it is wrapped in some, for work handed
+// over to other threads. The promotion, if given, lets whoever comes to wait on it promote it
+template <typename Callable>
+auto in_current_background_work(Callable&& callable,
+                                BackgroundWork::Promotion promotion = nullptr)
+{
+    const auto work = BackgroundWork::current();
+    return [bandwidth_limit = work ? std::optional{work->bandwidth_limit()} : std::nullopt,
+            promotion = std::move(promotion),
+            callable = std::forward<Callable>(callable)]() mutable -> decltype(auto) {
+        std::optional<BackgroundWork> scope;
+        if (bandwidth_limit)
+            scope.emplace(*bandwidth_limit, promotion);
+
+        return callable();
+    };
+}
+} // namespace multipass
@@ -42,6 +42,31 @@ public:
     virtual std::string format(const AliasDict& aliases) const = 0;
     virtual std::string format(const ZonesReply& reply) const = 0;
 
+    // The daemon can send replies to list and info in pages, as it gets through instances. Formats
+    // that can render pages on their own, for the given kind of output, render each one as it
+    // comes, given the first page that rendered anything, if any has yet, and finish the output
+    // once the last page is in. The others render all pages at the end, merged into one reply.
+    virtual bool renders_pages(bool) const
+    {
+        return false;
+    }
+    virtual std::string format_page(const InfoReply&, const InfoReply*) const
+    {
+        return {};
+    }
+    virtual std::string format_page(const ListReply&, const ListReply*) const
+    {
+        return {};
+    }
+    virtual std::string finish_pages(const InfoReply& last_page, const InfoReply*) const
+    {
+        return format(last_page);
+    }
+    virtual std::string finish_pages(const ListReply& last_page, const ListReply*) const
+    {
+        return format(last_page);
+    }
+
 protected:
     Formatter() = default;
 };
@@ -31,5 +31,13 @@ public:
     std::string format(const VersionReply& list, const std::string& client_version) const override;
     std::string format(const AliasDict& aliases) const override;
     std::string format(const ZonesReply& reply) const override;
+
+    bool renders_pages(bool to_terminal) const override;
+    std::string format_page(const InfoReply& page, const InfoReply* opening_page) const override;
+    std::string format_page(const ListReply& page, const ListReply* opening_page) const override;
+    std::string finish_pages(const InfoReply& last_page,
+                             const InfoReply* opening_page) const override;
+    std::string finish_pages(const ListReply& last_page,
+                             const ListReply* opening_page) const override;
 };
 } // namespace multipass
@@ -21,7 +21,10 @@
 
 #include <multipass/singleton.h>
 
+#include <cstdint>
 #include <filesystem>
+#include <functional>
+#include <span>
 #include <string>
 #include <vector>
 
@@ -29,6 +32,9 @@
 
 namespace multipass
 {
+struct NetworkInterface;
+
+// The files of a cloud-init ISO, which is built and parsed in memory, and read and written whole
 class CloudInitIso
 {
 public:
@@ -39,8 +45,22 @@ public:
     std::string& operator[](const std::string& name);
     bool erase(const std::string& name);
 
-    void write_to(const std::filesystem::path& path);
+    // Replaces whatever is at the path atomically
+    void write_to(const std::filesystem::path& path) const;
     void read_from(const std::filesystem::path& path);
+    std::string serialise() const;
+
+    // Changes to the meta-data and network-config files, any number of which can be made before
+    // the ISO is written back
+    void set_extra_interfaces_and_instance_id(const std::string& default_mac_addr,
+                                              const std::vector<NetworkInterface>& extra_interfaces,
+                                              const std::string& new_instance_id);
+    void set_identifiers(const std::string& default_mac_addr,
+                         const std::vector<NetworkInterface>& extra_interfaces,
+                         const std::string& new_hostname);
+    void add_extra_interface(const std::string& default_mac_addr,
+                             const NetworkInterface& extra_interface);
+    std::string instance_id() const;
 
     friend bool operator==(const CloudInitIso& lhs, const CloudInitIso& rhs) = default;
 
@@ -52,29 +72,34 @@ private:
         std::string name;
         std::string data;
     };
+    static std::vector<FileEntry> parse(std::span<const std::uint8_t> image);
+
     std::vector<FileEntry> files;
 };
 
-struct NetworkInterface;
 class CloudInitFileOps : public Singleton<CloudInitFileOps>
 {
 public:
     CloudInitFileOps(const Singleton<CloudInitFileOps>::PrivatePass&) noexcept;
 
-    virtual void update_cloud_init_with_new_extra_interfaces_and_new_id(
+    // Reads the ISO at the path once, makes all the given changes and writes it back once. Every
+    // change to an existing ISO goes through here, including those of the helpers below
+    virtual void update_cloud_init(const std::filesystem::path& cloud_init_path,
+                                   const std::function<void(CloudInitIso&)>& update) const;
+
+    void update_cloud_init_with_new_extra_interfaces_and_new_id(
         const std::string& default_mac_addr,
         const std::vector<NetworkInterface>& extra_interfaces,
         const std::string& new_instance_id,
         const std::filesystem::path& cloud_init_path) const;
 
-    virtual void update_identifiers(const std::string& default_mac_addr,
-                                    const std::vector<NetworkInterface>& extra_interfaces,
-                                    const std::string& new_hostname,
-                                    const std::filesystem::path& cloud_init_path) const;
-    virtual void add_extra_interface_to_cloud_init(
-        const std::string& default_mac_addr,
-        const NetworkInterface& extra_interfaces,
-        const std::filesystem::path& cloud_init_path) const;
+    void update_identifiers(const std::string& default_mac_addr,
+                            const std::vector<NetworkInterface>& extra_interfaces,
+                            const std::string& new_hostname,
+                            const std::filesystem::path& cloud_init_path) const;
+    void add_extra_interface_to_cloud_init(const std::string& default_mac_addr,
+                                           const NetworkInterface& extra_interfaces,
+                                           const std::filesystem::path& cloud_init_path) const;
     virtual std::string get_instance_id_from_cloud_init(
         const std::filesystem::path& cloud_init_path) const;
 };
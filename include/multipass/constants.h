@@ -48,6 +48,7 @@ constexpr auto home_automount_dir = "Home";
 constexpr auto multipass_storage_env_var = "MULTIPASS_STORAGE";
 constexpr auto driver_env_var = "MULTIPASS_VM_DRIVER";
 constexpr auto distributions_url_env_var = "MULTIPASS_DISTRIBUTIONS_URL";
+constexpr auto report_metrics_env_var = "MULTIPASS_REPORT_METRICS"; // set for helper processes
 
 constexpr auto winterm_profile_guid =
     "{aaaa9e6d-1e09-4be6-b76c-82b4ba1885fb}"; // identifies the primary Multipass profile in Windows
@@ -66,6 +67,10 @@ constexpr auto bridged_interface_key = "local.bridged-network";
 constexpr auto mounts_key = "local.privileged-mounts";
 constexpr auto winterm_key = "client.apps.windows-terminal.profiles";
 constexpr auto mirror_key = "local.image.mirror"; // the mirror of simple streams
+constexpr auto warm_pool_key = "local.warm-pool";
+constexpr auto metrics_port_key = "local.metrics-port";
+constexpr auto suspend_mode_key = "local.suspend-mode";
+constexpr auto image_bandwidth_limit_key = "local.image.bandwidth-limit";
 
 constexpr auto cloud_init_file_name = "cloud-init-config.iso";
 
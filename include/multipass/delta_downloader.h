@@ -0,0 +1,55 @@
+/*
+ * Copyright (C) Canonical, Ltd.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#pragma once
+
+#include "disabled_copy_move.h"
+#include "progress_monitor.h"
+
+class QString;
+class QUrl;
+
+namespace multipass
+{
+class URLDownloader;
+
+/*
+ * Rebuilds a file from an older version of it, downloading only the blocks that changed.
+ *
+ * This follows zsync: the blocks of the new file are listed, each with a weak rolling checksum and
+ * a strong one, in a control file published next to it, under the same name plus ".zsync". The old
+ * file is searched for those blocks at every offset, and whatever cannot be found there is fetched
+ * with HTTP range requests.
+ */
+class DeltaDownloader : private DisabledCopyMove
+{
+public:
+    explicit DeltaDownloader(URLDownloader* downloader);
+
+    // Returns false, leaving file_name alone, when there is no control file for url or when the old
+    // file has too little in common with the new one for a delta to pay off. Throws if the rebuilt
+    // file does not match the control file.
+    bool download_to(const QUrl& url,
+                     const QString& seed_file_name,
+                     const QString& file_name,
+                     const int progress_type,
+                     const ProgressMonitor& monitor);
+
+private:
+    URLDownloader* const downloader;
+};
+} // namespace multipass
@@ -0,0 +1,45 @@
+/*
+ * Copyright (C) Canonical, Ltd.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <vector>
+
+namespace multipass
+{
+struct FileCopy
+{
+    std::filesystem::path source;
+    std::filesystem::path destination;
+};
+
+// Gets the number of bytes copied so far, out of the total
+using FileCopyProgress = std::function<void(std::uint64_t copied, std::uint64_t total)>;
+
+/*
+ * Copies files as quickly as the host allows, replacing whatever is at their destinations.
+ *
+ * Files are cloned copy-on-write where the filesystem supports it, which takes no time at all. The
+ * others are split in chunks that are copied in parallel, within the kernel where possible, with
+ * holes left where the source has them. Progress is reported on the calling thread, a few times a
+ * second and once more at the end.
+ */
+void copy_files(const std::vector<FileCopy>& files, const FileCopyProgress& progress = {});
+} // namespace multipass
@@ -30,6 +30,7 @@
 #include <QString>
 #include <QTextStream>
 
+#include <cstdint>
 #include <filesystem>
 #include <fstream>
 #include <string_view>
@@ -107,6 +108,8 @@ public:
     virtual int read(int fd, void* buf, size_t nbytes) const;
     virtual int write(int fd, const void* buf, size_t nbytes) const;
     virtual off_t lseek(int fd, off_t offset, int whence) const;
+    virtual bool fsync(int fd) const;
+    virtual std::int64_t pwrite(int fd, const void* buf, size_t nbytes, std::int64_t offset) const;
 
     // std operations
     virtual void open(std::fstream& stream,
@@ -159,6 +162,7 @@ public:
     virtual fs::path relative(const fs::path& path,
                               const fs::path& base,
                               std::error_code& ec) const;
+    virtual bool resolves_beneath(int root_fd, const fs::path& path, bool follow_symlink) const;
 
     virtual fs::perms get_permissions(const fs::path& file) const;
 
@@ -20,7 +20,10 @@
 #include <multipass/image_host/vm_image_host.h>
 #include <multipass/url_downloader.h>
 
+#include <functional>
 #include <shared_mutex>
+#include <string>
+#include <unordered_map>
 
 namespace multipass
 {
@@ -36,24 +39,37 @@ public:
     std::vector<VMImageInfo> all_images_for(const std::string& remote_name,
                                             bool allow_unsupported) const final;
     void for_each_entry_do(const Action& action) const final;
+    // Downloads without the lock, so that lookups go on meanwhile, and swaps the results in at once
     void update_manifests(bool force_update);
+    std::vector<RemoteRefreshStatus> refresh_statuses() const final;
 
 protected:
     void on_manifest_update_failure(const std::string& details);
     void on_manifest_empty(const std::string& details);
 
+    // Changes the manifests with install, under the lock, and indexes them again
+    void replace_manifests(const std::function<void()>& install);
+
     virtual std::optional<VMImageInfo> info_for_impl(const Query& query) const = 0;
     virtual std::vector<std::pair<std::string, VMImageInfo>> all_info_for_impl(
         const Query& query) const = 0;
-    virtual VMImageInfo info_for_full_hash_impl(const std::string& full_hash) const = 0;
     virtual std::vector<VMImageInfo> all_images_for_impl(const std::string& remote_name,
                                                          bool allow_unsupported) const = 0;
     virtual void for_each_entry_do_impl(const Action& action) const = 0;
-    virtual void clear() = 0;
-    virtual void fetch_manifests(bool force_update) = 0;
+    virtual std::vector<RemoteRefreshStatus> refresh_statuses_impl() const = 0;
+    // Downloads and parses the manifests it can refresh, without the lock, and returns what
+    // installs them, for replace_manifests to run
+    virtual std::function<void()> fetch_manifests(bool force_update) = 0;
 
     mutable std::shared_mutex manifest_mutex;
     URLDownloader* const url_downloader;
+
+private:
+    void index_full_hashes();
+
+    // Images by lower-case full hash, across all manifests, rebuilt with them. The entries point
+    // into the manifests, which are only changed through replace_manifests.
+    std::unordered_map<std::string, const VMImageInfo*> images_by_full_hash;
 };
 
 } // namespace multipass
@@ -49,9 +49,9 @@ private:
     std::vector<VMImageInfo> all_images_for_impl(const std::string& remote_name,
                                                  bool allow_unsupported) const override;
     void for_each_entry_do_impl(const Action& action) const override;
-    VMImageInfo info_for_full_hash_impl(const std::string& full_hash) const override;
-    void fetch_manifests(bool force_update) override;
-    void clear() override;
+    std::vector<RemoteRefreshStatus> refresh_statuses_impl() const override;
+    std::function<void()> fetch_manifests(bool force_update) override;
+    void clear();
     const CustomManifest& manifest_from(const std::string& remote_name) const;
 
     const std::string arch;
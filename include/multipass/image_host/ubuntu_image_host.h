@@ -21,7 +21,17 @@
 #include <multipass/image_host/base_image_host.h>
 #include <multipass/simple_streams_manifest.h>
 
+#include <QString>
+#include <QThreadPool>
+
+#include <chrono>
+#include <exception>
+#include <future>
+#include <mutex>
+#include <optional>
 #include <string>
+#include <unordered_map>
+#include <unordered_set>
 #include <utility>
 #include <vector>
 
@@ -52,30 +62,83 @@ private:
     const std::optional<std::string> mirror_key;
 };
 
+// How UbuntuVMImageHost refreshes its manifests, each remote on its own
+struct ManifestRefreshPolicy
+{
+    // For downloading and parsing the manifest of a remote, after which it counts as failed
+    std::chrono::milliseconds deadline{std::chrono::seconds{30}};
+    // Consecutive failures after which a remote is left alone for a while, and for how long: from
+    // min_backoff, doubling with each further failure up to max_backoff
+    int failures_before_backoff{3};
+    std::chrono::milliseconds min_backoff{std::chrono::minutes{1}};
+    std::chrono::milliseconds max_backoff{std::chrono::hours{1}};
+    int max_parallel_downloads{4};
+};
+
 class UbuntuVMImageHost final : public BaseVMImageHost
 {
 public:
+    // With a manifest_cache_dir, the first update serves the manifests cached there by the previous
+    // run, if there are any for every remote, and downloads them again in the background
     UbuntuVMImageHost(std::vector<std::pair<std::string, UbuntuVMImageRemote>> remotes,
-                      URLDownloader* downloader);
+                      URLDownloader* downloader,
+                      const QString& manifest_cache_dir = {},
+                      const ManifestRefreshPolicy& refresh_policy = {});
+    ~UbuntuVMImageHost() override;
 
     std::vector<std::string> supported_remotes() const override;
 
 private:
+    using Manifests = std::vector<std::pair<std::string, std::unique_ptr<SimpleStreamsManifest>>>;
+    using Remote = std::pair<std::string, UbuntuVMImageRemote>;
+    using FetchTimes = std::unordered_map<std::string, std::chrono::system_clock::time_point>;
+
+    struct RemoteFetch
+    {
+        std::string remote_name;
+        std::unique_ptr<SimpleStreamsManifest> manifest; // null if there were no products
+        std::optional<std::string> error;
+        std::exception_ptr download_error;
+    };
+
+    struct RemoteHealth
+    {
+        int consecutive_failures{0};
+        std::string last_error;
+        std::chrono::steady_clock::time_point retry_after{};
+        std::optional<std::chrono::system_clock::time_point> fetched_at;
+    };
+
     std::optional<VMImageInfo> info_for_impl(const Query& query) const override;
     std::vector<std::pair<std::string, VMImageInfo>> all_info_for_impl(
         const Query& query) const override;
     std::vector<VMImageInfo> all_images_for_impl(const std::string& remote_name,
                                                  bool allow_unsupported) const override;
     void for_each_entry_do_impl(const Action& action) const override;
-    VMImageInfo info_for_full_hash_impl(const std::string& full_hash) const override;
-    void fetch_manifests(bool force_update) override;
-    void clear() override;
+    std::vector<RemoteRefreshStatus> refresh_statuses_impl() const override;
+    std::function<void()> fetch_manifests(bool force_update) override;
     const SimpleStreamsManifest& manifest_from(const std::string& remote) const;
     const VMImageInfo* match_alias(const std::string& key,
                                    const SimpleStreamsManifest& manifest) const;
+    std::unique_ptr<SimpleStreamsManifest> fetch_manifest(const Remote& remote, bool force_update);
+    std::vector<RemoteFetch> download_manifests(const std::vector<const Remote*>& due,
+                                                bool force_update);
+    void install(std::vector<RemoteFetch>& fetched); // requires the lock
+    Manifests load_cached_manifests(FetchTimes& fetched_at) const;
+    void refresh_in_background();
+    QString cache_file_for(const std::string& remote_name) const;
 
-    std::vector<std::pair<std::string, std::unique_ptr<SimpleStreamsManifest>>> manifests;
-    std::vector<std::pair<std::string, UbuntuVMImageRemote>> remotes;
+    Manifests manifests;
+    std::unordered_map<std::string, RemoteHealth> health; // by remote name
+    std::vector<Remote> remotes;
+    const QString manifest_cache_dir;
+    const ManifestRefreshPolicy refresh_policy;
+    bool cache_checked{false};
+    std::future<void> background_refresh;
+    // Remotes with a download in the pool, which may have overrun, so that they get one at a time
+    std::mutex downloading_mutex;
+    std::unordered_set<std::string> downloading;
+    QThreadPool refresh_pool; // last, to wait for downloads that overran before anything else goes
 };
 
 } // namespace multipass
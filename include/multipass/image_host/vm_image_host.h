@@ -20,6 +20,7 @@
 #include <multipass/disabled_copy_move.h>
 #include <multipass/vm_image_info.h>
 
+#include <chrono>
 #include <functional>
 #include <optional>
 #include <string>
@@ -30,6 +31,15 @@ namespace multipass
 {
 class Query;
 class VMImage;
+
+// How the latest refresh of a remote's manifest went
+struct RemoteRefreshStatus
+{
+    std::string remote_name;
+    std::string error; // empty if the refresh succeeded
+    std::optional<std::chrono::system_clock::time_point> fetched_at; // of the manifest in use
+};
+
 class VMImageHost : private DisabledCopyMove
 {
 public:
@@ -45,6 +55,7 @@ public:
     virtual void for_each_entry_do(const Action& action) const = 0;
     virtual std::vector<std::string> supported_remotes() const = 0;
     virtual void update_manifests(bool force_update) = 0;
+    virtual std::vector<RemoteRefreshStatus> refresh_statuses() const = 0;
 
 protected:
     VMImageHost() = default;
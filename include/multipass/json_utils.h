@@ -125,6 +125,7 @@ struct PrettyPrintOptions
 {
     int indent = 4;
     bool trailing_newline = true;
+    int nesting = 0; // levels deep the value sits in a document that is printed around it
 };
 
 void pretty_print(std::ostream& os,
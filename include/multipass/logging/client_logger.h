@@ -35,7 +35,7 @@ public:
     ClientLogger(Level level,
                  MultiplexingLogger& mpx,
                  grpc::ServerReaderWriterInterface<T, U>* server)
-        : logging_level{level}, server{server}, mpx_logger{mpx}
+        : Logger{level}, server{server}, mpx_logger{mpx}
     {
         mpx_logger.add_logger(this);
     }
@@ -60,7 +60,6 @@ public:
     }
 
 private:
-    Level logging_level;
     grpc::ServerReaderWriterInterface<T, U>* server;
     MultiplexingLogger& mpx_logger;
 };
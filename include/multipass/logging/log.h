@@ -38,6 +38,20 @@ namespace logging
  * @param [in] message The message
  */
 void log_message(Level level, std::string_view category, std::string_view message);
+
+/**
+ * Whether messages at the given level would be logged anywhere.
+ *
+ * @param [in] level Log level
+ * @return false if the message can be skipped without being formatted
+ */
+bool is_enabled(Level level);
+
+/**
+ * Re-reads which levels the global logger takes, for loggers that change their mind after being
+ * set. Must not be called with any lock that logging takes.
+ */
+void refresh_enabled_level();
 void set_logger(std::shared_ptr<Logger> logger);
 Level get_logging_level();
 Logger* get_logger(); // for tests, don't rely on it lasting
@@ -59,6 +73,9 @@ constexpr void log(Level level,
                    fmt::format_string<Args...> fmt,
                    Args&&... args)
 {
+    if (!logging::is_enabled(level))
+        return;
+
     const auto formatted_log_msg = fmt::format(fmt, std::forward<Args>(args)...);
     logging::log_message(level, category, formatted_log_msg);
 }
@@ -36,7 +36,13 @@ public:
     using UPtr = std::unique_ptr<Logger>;
     virtual ~Logger() = default;
     virtual void log(Level level, std::string_view category, std::string_view message) const = 0;
-    Level get_logging_level()
+    // Whether messages at the given level could be logged at all, for callers to skip formatting
+    // them otherwise. Loggers that filter on their own level are free to be told more.
+    virtual bool is_enabled(Level) const
+    {
+        return true;
+    }
+    Level get_logging_level() const
     {
         return logging_level;
     };
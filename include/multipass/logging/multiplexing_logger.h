@@ -19,6 +19,9 @@
 
 #include "logger.h"
 
+#include <atomic>
+#include <cstdint>
+#include <memory>
 #include <shared_mutex>
 #include <vector>
 
@@ -29,15 +32,45 @@ namespace logging
 class MultiplexingLogger : public Logger
 {
 public:
+    enum class OverflowPolicy
+    {
+        drop, // lose the message, but count it and report how many were lost
+        block // wait for the queue to make room
+    };
+
+    struct AsyncOptions
+    {
+        std::size_t capacity{8192};
+        OverflowPolicy overflow{OverflowPolicy::drop};
+    };
+
     explicit MultiplexingLogger(UPtr system_logger);
+    // Hands messages for the system logger to a background thread, through a bounded queue, so
+    // that logging threads do not wait on it. Client loggers are still called synchronously, as
+    // their messages need to reach clients before the replies that end their requests.
+    MultiplexingLogger(UPtr system_logger, AsyncOptions options);
+    ~MultiplexingLogger() override;
+
     void log(Level level, std::string_view category, std::string_view message) const override;
+    bool is_enabled(Level level) const override;
     void add_logger(const Logger* logger);
     void remove_logger(const Logger* logger);
 
+    // Waits until all messages logged so far have reached the system logger
+    void flush() const;
+    std::uint64_t dropped() const;
+
 private:
+    class AsyncSink;
+
+    void update_enabled_level();
+
     UPtr system_logger;
     mutable std::shared_timed_mutex mutex;
     std::vector<const Logger*> loggers;
+    std::atomic_size_t logger_count{0}; // for log() to skip the lock while there are no loggers
+    std::atomic<Level> enabled_level;
+    const std::unique_ptr<AsyncSink> async_sink; // null when logging synchronously
 };
 } // namespace logging
 } // namespace multipass
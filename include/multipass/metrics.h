@@ -0,0 +1,187 @@
+/*
+ * Copyright (C) Canonical, Ltd.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#pragma once
+
+#include "disabled_copy_move.h"
+#include "singleton.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
+
+#define MP_METRICS multipass::metrics::Registry::instance()
+
+namespace multipass::metrics
+{
+using Labels = std::vector<std::pair<std::string, std::string>>;
+
+// Latency buckets, in seconds, from a tenth of a millisecond to a minute
+inline const std::vector<double> latency_buckets{
+    0.0001, 0.0005, 0.001, 0.005, 0.01, 0.05, 0.1, 0.5, 1, 5, 10, 60};
+
+// Metrics are only ever updated with relaxed atomics, so that they can be used on hot paths
+class Metric : private DisabledCopyMove
+{
+public:
+    virtual ~Metric() = default;
+    virtual void render(std::string& out,
+                        const std::string& name,
+                        const std::string& labels) const = 0;
+};
+
+class Counter : public Metric
+{
+public:
+    void increment(std::uint64_t by = 1) noexcept
+    {
+        count.fetch_add(by, std::memory_order_relaxed);
+    }
+
+    std::uint64_t value() const noexcept
+    {
+        return count.load(std::memory_order_relaxed);
+    }
+
+    void render(std::string& out,
+                const std::string& name,
+                const std::string& labels) const override;
+
+private:
+    std::atomic_uint64_t count{0};
+};
+
+class Gauge : public Metric
+{
+public:
+    void set(std::int64_t value) noexcept
+    {
+        current.store(value, std::memory_order_relaxed);
+    }
+
+    void add(std::int64_t by) noexcept
+    {
+        current.fetch_add(by, std::memory_order_relaxed);
+    }
+
+    std::int64_t value() const noexcept
+    {
+        return current.load(std::memory_order_relaxed);
+    }
+
+    void render(std::string& out,
+                const std::string& name,
+                const std::string& labels) const override;
+
+private:
+    std::atomic_int64_t current{0};
+};
+
+class Histogram : public Metric
+{
+public:
+    explicit Histogram(std::vector<double> bounds);
+
+    void observe(double value) noexcept;
+    std::uint64_t count() const noexcept;
+    double sum() const noexcept;
+
+    void render(std::string& out,
+                const std::string& name,
+                const std::string& labels) const override;
+
+private:
+    const std::vector<double> bounds;
+    // One per bound, plus one for whatever is above them all. Unlike the rendered buckets, these
+    // are not cumulative, so that observing only ever touches one of them
+    const std::unique_ptr<std::atomic_uint64_t[]> buckets;
+    std::atomic<double> total{0};
+};
+
+// Observes how long the enclosing scope took, in seconds
+class ScopedTimer : private DisabledCopyMove
+{
+public:
+    explicit ScopedTimer(Histogram& histogram);
+    ~ScopedTimer();
+
+private:
+    Histogram& histogram;
+    const std::chrono::steady_clock::time_point start;
+};
+
+/*
+ * Owns all metrics in the process and renders them in the Prometheus text exposition format.
+ *
+ * Looking metrics up takes a lock, so hot paths should look them up once and hang on to the
+ * reference. Metrics are never freed, so references stay valid for the life of the process;
+ * removing a metric only stops rendering it, until it is added again.
+ */
+class Registry : public Singleton<Registry>
+{
+public:
+    Registry(const Singleton<Registry>::PrivatePass&) noexcept;
+
+    virtual Counter& counter(const std::string& name,
+                             const std::string& help,
+                             const Labels& labels = {});
+    virtual Gauge& gauge(const std::string& name,
+                         const std::string& help,
+                         const Labels& labels = {});
+    virtual Histogram& histogram(const std::string& name,
+                                 const std::string& help,
+                                 const Labels& labels = {},
+                                 const std::vector<double>& bounds = latency_buckets);
+    virtual void remove(const std::string& name, const Labels& labels);
+
+    // Adds metrics rendered by another process under the given key, replacing whatever that key
+    // held before, with the given labels added to every sample
+    virtual void set_external(const std::string& key,
+                              const std::string& exposition,
+                              const Labels& labels = {});
+    virtual void remove_external(const std::string& key);
+
+    virtual std::string render() const;
+
+private:
+    struct Family
+    {
+        std::string help;
+        std::string type;
+        std::map<Labels, std::unique_ptr<Metric>> metrics;
+        std::set<Labels> removed;
+    };
+
+    template <typename T, typename... Args>
+    T& get_or_add(const std::string& name,
+                  const std::string& help,
+                  const std::string& type,
+                  const Labels& labels,
+                  Args&&... args);
+
+    mutable std::mutex mutex;
+    std::map<std::string, Family> families;
+    std::map<std::string, std::string> externals;
+};
+} // namespace multipass::metrics
@@ -35,6 +35,8 @@
 #include <QDir>
 #include <QString>
 
+#include <cstdint>
+#include <filesystem>
 #include <functional>
 #include <memory>
 #include <string>
@@ -104,6 +106,8 @@ VirtualMachineFactory::UPtr vm_backend(const Path& data_dir, AvailabilityZoneMan
 logging::Logger::UPtr make_logger(logging::Level level);
 UpdatePrompt::UPtr make_update_prompt();
 std::unique_ptr<Process> make_sshfs_server_process(const SSHFSServerConfig& config);
+// Lets an already running sshfs_server access the source paths in config, and only those
+void update_sshfs_server_confinement(const SSHFSServerConfig& config);
 std::unique_ptr<Process> make_process(std::unique_ptr<ProcessSpec>&& process_spec);
 int symlink_attr_from(const char* path, sftp_attributes_struct* attr);
 
@@ -120,6 +124,45 @@ std::string reinterpret_interface_id(
 
 std::string host_version();
 
+// Lowers the CPU and I/O priority of the calling thread, so that it only gets what others leave,
+// or puts back what it had before. Returns whether the platform went along with it.
+bool set_thread_background_priority(bool background);
+
+// Creates the destination as a copy-on-write clone of the source, sharing its blocks, so that it
+// takes no time nor space. Returns false, leaving no destination behind, where the filesystem
+// cannot do that.
+bool clone_file(const std::filesystem::path& source, const std::filesystem::path& destination);
+
+// Copies the range of the source that starts at offset over the same range of the destination,
+// which must exist already, without the data going through user space. Holes in the source are
+// left alone. Returns false where the platform or filesystem cannot do that, in which case the
+// range may have been partly copied.
+bool copy_file_range(const std::filesystem::path& source,
+                     const std::filesystem::path& destination,
+                     std::uint64_t offset,
+                     std::uint64_t length);
+
+// Opens a directory for paths to be resolved beneath it with resolves_beneath(). Returns -1 where
+// the platform cannot resolve paths that way.
+int open_resolution_root(const std::filesystem::path& dir);
+
+// Whether the path, relative to the directory open at root_fd, resolves to something that exists
+// beneath that directory, following a symlink at the end of the path or not. The kernel resolves
+// the whole path in one go and refuses to leave the directory at any step, through ".." or
+// symlinks alike. False means that could not be confirmed, which includes paths that go through
+// absolute symlinks, even to somewhere beneath the directory.
+bool resolves_beneath(int root_fd, const std::filesystem::path& path, bool follow_symlink);
+
+// Flushes whatever was written to the open file down to its storage device
+bool fsync(int fd);
+
+// Flushes the entries of the directory, such as a file just renamed into it, down to its storage
+// device
+bool sync_directory(const std::filesystem::path& dir);
+
+// Writes at the given offset of the open file, in a single call where the platform allows
+std::int64_t pwrite(int fd, const void* buf, std::size_t nbytes, std::int64_t offset);
+
 } // namespace platform
 } // namespace multipass
 
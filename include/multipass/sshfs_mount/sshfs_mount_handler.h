@@ -18,12 +18,14 @@
 #pragma once
 
 #include <multipass/mount_handler.h>
-#include <multipass/process/process.h>
-#include <multipass/qt_delete_later_unique_ptr.h>
 #include <multipass/sshfs_server_config.h>
 
+#include <memory>
+
 namespace multipass
 {
+class SSHFSServerProcess;
+
 class SSHFSMountHandler : public MountHandler
 {
 public:
@@ -37,7 +39,7 @@ public:
     void deactivate_impl(bool force) override;
 
 private:
-    qt_delete_later_unique_ptr<Process> process;
+    std::shared_ptr<SSHFSServerProcess> server_process; // shared with the instance's other mounts
     SSHFSServerConfig config;
 };
 } // namespace multipass
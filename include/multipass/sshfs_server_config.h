@@ -17,9 +17,8 @@
 
 #pragma once
 
-#include <multipass/id_mappings.h>
-
 #include <string>
+#include <vector>
 
 namespace multipass
 {
@@ -31,10 +30,7 @@ struct SSHFSServerConfig
     std::string username;
     std::string instance;
     std::string private_key;
-    std::string source_path;
-    std::string target_path;
-    id_mappings gid_mappings;
-    id_mappings uid_mappings;
+    std::vector<std::string> source_paths; // of all the mounts the server currently serves
 };
 
 } // namespace multipass
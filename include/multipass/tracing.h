@@ -0,0 +1,107 @@
+/*
+ * Copyright (C) Canonical, Ltd.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#pragma once
+
+#include "disabled_copy_move.h"
+#include "singleton.h"
+
+#include <chrono>
+#include <deque>
+#include <filesystem>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+#define MP_TRACER multipass::tracing::Tracer::instance()
+
+namespace multipass::tracing
+{
+using Clock = std::chrono::steady_clock;
+
+struct Span
+{
+    std::string trace; // what the span is part of, e.g. the instance being launched
+    std::string name;
+    Clock::time_point start;
+    Clock::time_point end;
+    std::vector<std::pair<std::string, std::string>> attributes;
+    std::size_t thread;
+};
+
+/*
+ * Collects finished spans. Those belonging to a trace are kept until someone takes them, up to a
+ * bound, after which the oldest ones are dropped. All spans can additionally be appended to a file,
+ * in the Chrome trace event format (loadable in about:tracing or Perfetto).
+ */
+class Tracer : public Singleton<Tracer>
+{
+public:
+    static constexpr std::size_t max_pending_spans = 4096;
+
+    Tracer(const Singleton<Tracer>::PrivatePass&) noexcept;
+
+    virtual void record(Span span);
+    virtual std::vector<Span> take(const std::string& trace);
+    virtual void export_to(const std::filesystem::path& file);
+
+private:
+    std::mutex mutex;
+    std::deque<Span> pending;
+    std::ofstream exported;
+};
+
+// Makes spans started on the current thread part of the given trace, for as long as it lives
+class TraceScope : private DisabledCopyMove
+{
+public:
+    explicit TraceScope(std::string trace);
+    ~TraceScope();
+
+    static const std::string& current();
+
+private:
+    std::string previous;
+};
+
+// Times the enclosing scope and records it with the tracer when it ends
+class ScopedSpan : private DisabledCopyMove
+{
+public:
+    explicit ScopedSpan(std::string name);
+    ~ScopedSpan();
+
+    void add_attribute(std::string key, std::string value);
+
+private:
+    Span span;
+};
+
+// Wraps a callable so that it runs in the trace that is current where it is wrapped, for work
+// handed over to other threads
+template <typename Callable>
+auto in_current_trace(Callable&& callable)
+{
+    return [trace = TraceScope::current(),
+            callable = std::forward<Callable>(callable)]() mutable -> decltype(auto) {
+        TraceScope scope{trace};
+        return callable();
+    };
+}
+} // namespace multipass::tracing
@@ -28,9 +28,12 @@
 
 #include <atomic>
 #include <chrono>
+#include <cstdint>
+#include <memory>
 
 #define MP_NETMGRFACTORY multipass::NetworkManagerFactory::instance()
 
+class QIODevice;
 class QUrl;
 class QString;
 namespace multipass
@@ -49,7 +52,7 @@ class URLDownloader : private DisabledCopyMove
 public:
     URLDownloader(std::chrono::milliseconds timeout);
     URLDownloader(const Path& cache_dir, std::chrono::milliseconds timeout);
-    virtual ~URLDownloader() = default;
+    virtual ~URLDownloader();
 
     // Note: All http urls are converted to https
     virtual void download_to(const QUrl& url,
@@ -59,6 +62,9 @@ public:
                              const ProgressMonitor& monitor);
     virtual QByteArray download(const QUrl& url);
     virtual QByteArray download(const QUrl& url, const bool force_update);
+    // Writes the range to out as it comes in. Throws, as soon as the reply's headers show it, if
+    // the server does not send back exactly the requested range
+    virtual void download_range_to(const QUrl& url, qint64 offset, qint64 length, QIODevice& out);
     virtual QDateTime last_modified(const QUrl& url);
     virtual void abort_all_downloads();
 
@@ -66,7 +72,13 @@ protected:
     std::atomic_bool abort_downloads{false};
 
 private:
+    // Made on first use in each thread and kept for the thread's lifetime, so that connections and
+    // TLS sessions are reused from one request to the next. Threads of the global pool get one per
+    // request instead. Managers of all threads share one disk cache.
+    std::shared_ptr<QNetworkAccessManager> network_manager();
+
     const Path cache_dir_path;
     std::chrono::milliseconds timeout;
+    const std::uint64_t id; // tells apart the managers of downloaders in the same thread
 };
 } // namespace multipass
@@ -116,6 +116,8 @@ public:
     virtual std::shared_ptr<Snapshot> get_snapshot(const std::string& name) = 0;
     virtual std::shared_ptr<Snapshot> get_snapshot(int index) = 0;
 
+    // Whether snapshots can be taken while the instance is running, rather than only when stopped
+    virtual bool supports_live_snapshots() const = 0;
     virtual std::shared_ptr<const Snapshot> take_snapshot(const VMSpecs& specs,
                                                           const std::string& snapshot_name,
                                                           const std::string& comment) = 0;
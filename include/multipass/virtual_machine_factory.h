@@ -19,6 +19,7 @@
 
 #include "days.h"
 #include "disabled_copy_move.h"
+#include "file_copy.h"
 #include "path.h"
 #include "virtual_machine.h"
 #include "vm_image.h"
@@ -53,7 +54,8 @@ public:
                                                const std::string& dest_name,
                                                const VMImage& dest_image,
                                                const SSHKeyProvider& key_provider,
-                                               VMStatusMonitor& monitor) = 0;
+                                               VMStatusMonitor& monitor,
+                                               const FileCopyProgress& copy_progress) = 0;
 
     /** Removes any resources associated with a VM of the given name.
      *
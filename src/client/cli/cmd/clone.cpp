@@ -34,21 +34,49 @@ mp::ReturnCodeVariant cmd::Clone::run(ArgParser* parser)
     }
 
     AnimatedSpinner spinner{cout};
-    auto action_on_success = [this, &spinner](CloneReply& reply) -> ReturnCodeVariant {
+    bool showed_progress{false};
+    auto end_progress_line = [this, &spinner, &showed_progress] {
+        if (showed_progress)
+            cout << "\n";
         spinner.stop();
+    };
+
+    auto action_on_success = [this, &end_progress_line](CloneReply& reply) -> ReturnCodeVariant {
+        end_progress_line();
         cout << reply.reply_message();
 
         return ReturnCode::Ok;
     };
 
-    auto action_on_failure = [this, &spinner](grpc::Status& status,
-                                              CloneReply& reply) -> ReturnCodeVariant {
-        spinner.stop();
+    auto action_on_failure = [this, &end_progress_line](grpc::Status& status,
+                                                        CloneReply& reply) -> ReturnCodeVariant {
+        end_progress_line();
         return standard_failure_handler_for(name(), cerr, status, reply.reply_message());
     };
 
+    auto streaming_callback = [this, &spinner, &showed_progress](
+                                  CloneReply& reply,
+                                  grpc::ClientReaderWriterInterface<CloneRequest, CloneReply>*) {
+        if (!reply.log_line().empty())
+        {
+            spinner.print(cerr, reply.log_line());
+        }
+
+        if (reply.has_percent_copied())
+        {
+            spinner.stop();
+            cout << "\r";
+            cout << "Copying disks: " << reply.percent_copied() << "%" << std::flush;
+            showed_progress = true;
+        }
+    };
+
     spinner.start("Cloning " + rpc_request.source_name());
-    return dispatch(&RpcMethod::clone, rpc_request, action_on_success, action_on_failure);
+    return dispatch(&RpcMethod::clone,
+                    rpc_request,
+                    action_on_success,
+                    action_on_failure,
+                    streaming_callback);
 }
 
 std::string cmd::Clone::name() const
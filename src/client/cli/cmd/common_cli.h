@@ -18,6 +18,7 @@
 #pragma once
 
 #include <multipass/cli/client_common.h>
+#include <multipass/cli/formatter.h>
 #include <multipass/cli/return_codes.h>
 #include <multipass/rpc/multipass.grpc.pb.h>
 #include <multipass/terminal.h>
@@ -25,13 +26,16 @@
 
 #include <QString>
 
+#include <cstdint>
+#include <optional>
+#include <ostream>
+
 using RpcMethod = multipass::Rpc::StubInterface;
 
 namespace multipass
 {
 class AnimatedSpinner;
 class ArgParser;
-class Formatter;
 class SettingsException;
 
 namespace cmd
@@ -39,6 +43,9 @@ namespace cmd
 const QString all_option_name{"all"};
 const QString format_option_name{"format"};
 
+// How many instances the daemon puts in each reply to list and info
+constexpr std::uint32_t instances_per_page = 20;
+
 ParseCode check_for_name_and_all_option_conflict(const ArgParser* parser,
                                                  std::ostream& cerr,
                                                  bool allow_empty = false);
@@ -70,5 +77,48 @@ std::unique_ptr<multipass::utils::Timer> make_timer(int timeout,
                                                     std::ostream& cerr,
                                                     const std::string& msg);
 
+// Prints list and info replies as their pages come in, with formatters that can render pages on
+// their own for where the output goes, or all together once the last one is in, with the others
+template <typename Reply>
+class PagedOutput
+{
+public:
+    PagedOutput(const Formatter& formatter, std::ostream& cout, bool to_terminal)
+        : formatter{formatter}, cout{cout}, paged{formatter.renders_pages(to_terminal)}
+    {
+    }
+
+    void add(const Reply& page)
+    {
+        if (!paged)
+        {
+            merged.MergeFrom(page);
+            return;
+        }
+
+        const auto rendered = formatter.format_page(page, opening_page());
+        cout << rendered << std::flush;
+        if (!opening && !rendered.empty())
+            opening = page;
+    }
+
+    void finish(const Reply& last_page)
+    {
+        cout << (paged ? formatter.finish_pages(last_page, opening_page())
+                       : formatter.format(merged));
+    }
+
+private:
+    const Reply* opening_page() const
+    {
+        return opening ? &*opening : nullptr;
+    }
+
+    const Formatter& formatter;
+    std::ostream& cout;
+    const bool paged;
+    std::optional<Reply> opening; // the first page that rendered anything
+    Reply merged;
+};
 } // namespace cmd
 } // namespace multipass
@@ -20,6 +20,7 @@
 
 #include <multipass/cli/argparser.h>
 #include <multipass/cli/formatter.h>
+#include <multipass/format.h>
 
 namespace mp = multipass;
 namespace cmd = multipass::cmd;
@@ -35,6 +36,26 @@ mp::ReturnCodeVariant cmd::Find::run(mp::ArgParser* parser)
     auto on_success = [this](FindReply& reply) -> ReturnCodeVariant {
         cout << chosen_formatter->format(reply);
 
+        // On stderr, to keep the formatted output parseable
+        for (const auto& status : reply.remote_statuses())
+        {
+            if (status.error().empty())
+                continue;
+
+            if (status.age_seconds() < 0)
+                fmt::print(cerr,
+                           "Could not refresh remote \"{}\" ({}); it has no images to show\n",
+                           status.remote_name(),
+                           status.error());
+            else
+                fmt::print(cerr,
+                           "Could not refresh remote \"{}\" ({}); showing its images from {} "
+                           "minute(s) ago\n",
+                           status.remote_name(),
+                           status.error(),
+                           status.age_seconds() / 60);
+        }
+
         return ReturnCode::Ok;
     };
 
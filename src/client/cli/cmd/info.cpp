@@ -32,8 +32,10 @@ mp::ReturnCodeVariant cmd::Info::run(mp::ArgParser* parser)
         return parser->returnCodeFrom(ret);
     }
 
-    auto on_success = [this](mp::InfoReply& reply) -> ReturnCodeVariant {
-        cout << chosen_formatter->format(reply);
+    PagedOutput<mp::InfoReply> output{*chosen_formatter, cout, term->cout_is_live()};
+
+    auto on_success = [this, &output](mp::InfoReply& reply) -> ReturnCodeVariant {
+        output.finish(reply);
 
         if (term->is_live() && update_available(reply.update_info()))
             cout << update_notice(reply.update_info());
@@ -45,8 +47,18 @@ mp::ReturnCodeVariant cmd::Info::run(mp::ArgParser* parser)
         return standard_failure_handler_for(name(), cerr, status);
     };
 
+    auto streaming_callback =
+        [this, &output](mp::InfoReply& reply,
+                        grpc::ClientReaderWriterInterface<InfoRequest, mp::InfoReply>*) {
+            if (!reply.log_line().empty())
+                cerr << reply.log_line();
+
+            output.add(reply);
+        };
+
     request.set_verbosity_level(parser->verbosityLevel());
-    return dispatch(&RpcMethod::info, request, on_success, on_failure);
+    request.set_page_size(instances_per_page);
+    return dispatch(&RpcMethod::info, request, on_success, on_failure, streaming_callback);
 }
 
 std::string cmd::Info::name() const
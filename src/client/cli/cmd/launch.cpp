@@ -255,6 +255,8 @@ mp::ParseCode cmd::Launch::parse_args(mp::ArgParser* parser)
                        "of the <source> directory.")
             .arg(home_in_instance),
         "source>:<target");
+    QCommandLineOption timingsOption("timings",
+                                     "Show how long each step of the launch took once it is done.");
 
     parser->addOptions({
         cpusOption,
@@ -266,6 +268,7 @@ mp::ParseCode cmd::Launch::parse_args(mp::ArgParser* parser)
         bridgedOption,
         zoneOption,
         mountOption,
+        timingsOption,
     });
 
     mp::cmd::add_instance_timeout(parser);
@@ -466,6 +469,7 @@ mp::ParseCode cmd::Launch::parse_args(mp::ArgParser* parser)
 
     request.set_time_zone(QTimeZone::systemTimeZoneId().toStdString());
     request.set_verbosity_level(parser->verbosityLevel());
+    request.set_timings(parser->isSet(timingsOption));
 
     return status;
 }
@@ -557,6 +561,16 @@ mp::ReturnCodeVariant cmd::Launch::request_launch(const ArgParser* parser)
 
         cout << "Launched: " << reply.vm_instance_name() << " in " << reply.zone() << "\n";
 
+        if (!reply.timings().empty())
+        {
+            cout << fmt::format("{:<24}{:>12}{:>12}\n", "Step", "Started", "Took");
+            for (const auto& timing : reply.timings())
+                cout << fmt::format("{:<24}{:>11.3f}s{:>11.3f}s\n",
+                                    timing.name(),
+                                    timing.start_ms() / 1000.,
+                                    timing.duration_ms() / 1000.);
+        }
+
         if (term->is_live() && update_available(reply.update_info()))
         {
             // TODO: daemon doesn't know if client actually shows this notice. Need to be able
@@ -32,8 +32,10 @@ mp::ReturnCodeVariant cmd::List::run(mp::ArgParser* parser)
         return parser->returnCodeFrom(ret);
     }
 
-    auto on_success = [this](ListReply& reply) -> ReturnCodeVariant {
-        cout << chosen_formatter->format(reply);
+    PagedOutput<ListReply> output{*chosen_formatter, cout, term->cout_is_live()};
+
+    auto on_success = [this, &output](ListReply& reply) -> ReturnCodeVariant {
+        output.finish(reply);
 
         if (term->is_live() && update_available(reply.update_info()))
             cout << update_notice(reply.update_info());
@@ -45,8 +47,18 @@ mp::ReturnCodeVariant cmd::List::run(mp::ArgParser* parser)
         return standard_failure_handler_for(name(), cerr, status);
     };
 
+    auto streaming_callback =
+        [this, &output](ListReply& reply,
+                        grpc::ClientReaderWriterInterface<ListRequest, ListReply>*) {
+            if (!reply.log_line().empty())
+                cerr << reply.log_line();
+
+            output.add(reply);
+        };
+
     request.set_verbosity_level(parser->verbosityLevel());
-    return dispatch(&RpcMethod::list, request, on_success, on_failure);
+    request.set_page_size(instances_per_page);
+    return dispatch(&RpcMethod::list, request, on_success, on_failure, streaming_callback);
 }
 
 std::string cmd::List::name() const
@@ -77,11 +89,19 @@ mp::ParseCode cmd::List::parse_args(mp::ArgParser* parser)
                                     "table (default), json, csv and yaml",
                                     "format",
                                     "table");
+    QCommandLineOption nameOption("name",
+                                  "List only the instances with names that match the given "
+                                  "pattern, where * matches any text and ? any one character",
+                                  "pattern");
+    QCommandLineOption stateOption("state",
+                                   "List only the instances in the given state, e.g. running or "
+                                   "stopped. Repeat to list instances in any of several states",
+                                   "state");
     QCommandLineOption noIpv4Option("no-ipv4",
                                     "Do not query the instances for the IPv4's they are using");
     noIpv4Option.setFlags(QCommandLineOption::HiddenFromHelp);
 
-    parser->addOptions({snapshotsOption, formatOption, noIpv4Option});
+    parser->addOptions({snapshotsOption, formatOption, nameOption, stateOption, noIpv4Option});
 
     auto status = parser->commandParse(this);
 
@@ -102,6 +122,19 @@ mp::ParseCode cmd::List::parse_args(mp::ArgParser* parser)
         return ParseCode::CommandLineError;
     }
 
+    for (const auto& state : parser->values(stateOption))
+    {
+        InstanceStatus::Status status;
+        if (!InstanceStatus::Status_Parse(state.toUpper().replace('-', '_').toStdString(), &status))
+        {
+            cerr << "Invalid state: " << state.toStdString() << "\n";
+            return ParseCode::CommandLineError;
+        }
+
+        request.add_states(status);
+    }
+
+    request.set_name_pattern(parser->value(nameOption).toStdString());
     request.set_snapshots(parser->isSet(snapshotsOption));
     request.set_request_ipv4(!parser->isSet(noIpv4Option));
 
@@ -65,7 +65,9 @@ QString cmd::Snapshot::short_help() const
 QString cmd::Snapshot::description() const
 {
     return QStringLiteral("Take a snapshot of a stopped instance that can later be restored to "
-                          "recover the current state.");
+                          "recover the current state. Where the backend supports it (QEMU), "
+                          "running instances can be snapshotted too; their snapshots hold the "
+                          "disk only and restore to a stopped instance.");
 }
 
 mp::ParseCode cmd::Snapshot::parse_args(mp::ArgParser* parser)
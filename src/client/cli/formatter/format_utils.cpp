@@ -84,6 +84,9 @@ std::string mp::format::status_string_for(const mp::InstanceStatus& status)
     case mp::InstanceStatus::UNAVAILABLE:
         status_val = "Unavailable";
         break;
+    case mp::InstanceStatus::LOADING:
+        status_val = "Loading";
+        break;
     default:
         status_val = "Unknown";
         break;
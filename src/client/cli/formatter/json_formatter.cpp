@@ -18,11 +18,15 @@
 #include <multipass/cli/client_common.h>
 #include <multipass/cli/format_utils.h>
 #include <multipass/cli/json_formatter.h>
+#include <multipass/format.h>
 #include <multipass/json_utils.h>
 #include <multipass/utils.h>
 
 #include <boost/json.hpp>
 
+#include <string>
+#include <vector>
+
 namespace mp = multipass;
 
 namespace
@@ -153,7 +157,7 @@ boost::json::object generate_instance_details(const mp::DetailedInfoItem& item)
     return instance_info;
 }
 
-boost::json::value generate_instances_list(const mp::InstancesList& instance_list)
+boost::json::array generate_instances(const mp::InstancesList& instance_list)
 {
     boost::json::array instances;
     for (const auto& instance : instance_list.instances())
@@ -172,10 +176,10 @@ boost::json::value generate_instances_list(const mp::InstancesList& instance_lis
         });
     }
 
-    return {{"list", std::move(instances)}};
+    return instances;
 }
 
-boost::json::value generate_snapshots_list(const mp::SnapshotsList& snapshot_list)
+boost::json::object generate_snapshots(const mp::SnapshotsList& snapshot_list)
 {
     boost::json::object info_obj;
     for (const auto& item : snapshot_list.snapshots())
@@ -195,11 +199,10 @@ boost::json::value generate_snapshots_list(const mp::SnapshotsList& snapshot_lis
         }
     }
 
-    return {{"errors", boost::json::array{}}, {"info", std::move(info_obj)}};
+    return info_obj;
 }
-} // namespace
 
-std::string mp::JsonFormatter::format(const InfoReply& reply) const
+boost::json::object generate_details(const mp::InfoReply& reply)
 {
     boost::json::object info_obj;
     for (const auto& info : reply.details())
@@ -245,24 +248,127 @@ std::string mp::JsonFormatter::format(const InfoReply& reply) const
         }
     }
 
-    return pretty_print({{"errors", boost::json::array{}}, {"info", std::move(info_obj)}});
+    return info_obj;
 }
 
-std::string mp::JsonFormatter::format(const ListReply& reply) const
+boost::json::value make_list_document(boost::json::array instances)
+{
+    return {{"list", std::move(instances)}};
+}
+
+boost::json::value make_info_document(boost::json::object info)
+{
+    return {{"errors", boost::json::array{}}, {"info", std::move(info)}};
+}
+
+// Pages are printed as parts of one document: the first one opens the document, up to the
+// container that holds the entries, each one prints its own entries as they sit in that container,
+// and the document is closed after the last one. The parts are put together from the same
+// printing of values that whole documents get, so they join into what format() would give.
+constexpr mp::PrettyPrintOptions entry_options{.trailing_newline = false, .nesting = 2};
+
+std::string indentation(int nesting)
+{
+    return std::string(entry_options.indent * nesting, ' ');
+}
+
+std::string print_entries(const boost::json::array& entries)
 {
-    boost::json::value output;
+    std::vector<std::string> printed;
+    for (const auto& entry : entries)
+        printed.push_back(indentation(2) + mp::pretty_print(entry, entry_options));
 
+    return fmt::format("{}", fmt::join(printed, ",\n"));
+}
+
+std::string print_entries(const boost::json::object& entries)
+{
+    std::vector<std::string> printed;
+    for (const auto& [key, value] : entries)
+        printed.push_back(fmt::format("{}{}: {}",
+                                      indentation(2),
+                                      boost::json::serialize(key),
+                                      mp::pretty_print(value, entry_options)));
+
+    return fmt::format("{}", fmt::join(printed, ",\n"));
+}
+
+std::string open_list_document()
+{
+    return fmt::format("{{\n{}\"list\": [\n", indentation(1));
+}
+
+std::string open_info_document()
+{
+    return fmt::format("{{\n{0}\"errors\": [\n{0}],\n{0}\"info\": {{\n", indentation(1));
+}
+
+std::string close_document(char closing_bracket)
+{
+    return fmt::format("\n{}{}\n}}\n", indentation(1), closing_bracket);
+}
+
+template <typename Entries>
+std::string print_page(const Entries& entries, const std::string& opening, bool continued)
+{
+    if (entries.empty())
+        return {};
+
+    return fmt::format("{}{}", continued ? ",\n" : opening, print_entries(entries));
+}
+} // namespace
+
+std::string mp::JsonFormatter::format(const InfoReply& reply) const
+{
+    return pretty_print(make_info_document(generate_details(reply)));
+}
+
+std::string mp::JsonFormatter::format(const ListReply& reply) const
+{
     if (reply.has_instance_list())
-    {
-        output = generate_instances_list(reply.instance_list());
-    }
-    else
-    {
-        assert(reply.has_snapshot_list() && "either one of the reports should be populated");
-        output = generate_snapshots_list(reply.snapshot_list());
-    }
+        return pretty_print(make_list_document(generate_instances(reply.instance_list())));
+
+    assert(reply.has_snapshot_list() && "either one of the reports should be populated");
+    return pretty_print(make_info_document(generate_snapshots(reply.snapshot_list())));
+}
+
+bool mp::JsonFormatter::renders_pages(bool) const
+{
+    return true;
+}
+
+std::string mp::JsonFormatter::format_page(const InfoReply& page,
+                                           const InfoReply* opening_page) const
+{
+    return print_page(generate_details(page), open_info_document(), opening_page != nullptr);
+}
+
+std::string mp::JsonFormatter::format_page(const ListReply& page,
+                                           const ListReply* opening_page) const
+{
+    if (page.has_instance_list())
+        return print_page(generate_instances(page.instance_list()),
+                          open_list_document(),
+                          opening_page != nullptr);
+
+    return print_page(generate_snapshots(page.snapshot_list()),
+                      open_info_document(),
+                      opening_page != nullptr);
+}
+
+std::string mp::JsonFormatter::finish_pages(const InfoReply& last_page,
+                                            const InfoReply* opening_page) const
+{
+    return opening_page ? close_document('}') : format(last_page);
+}
+
+std::string mp::JsonFormatter::finish_pages(const ListReply& last_page,
+                                            const ListReply* opening_page) const
+{
+    if (!opening_page)
+        return format(last_page);
 
-    return pretty_print(output);
+    return close_document(last_page.has_instance_list() ? ']' : '}');
 }
 
 std::string mp::JsonFormatter::format(const NetworksReply& reply) const
@@ -244,7 +244,10 @@ void generate_instance_details(Dest&& dest, const mp::DetailedInfoItem& item)
     }
 }
 
-std::string generate_instances_list(const mp::InstancesList& instance_list)
+// Pages after the first one, given as opening_page, go under its header and keep its column widths,
+// unless their own entries need more room
+std::string generate_instances_list(const mp::InstancesList& instance_list,
+                                    const mp::InstancesList* opening_page = nullptr)
 {
     fmt::memory_buffer buf;
 
@@ -254,28 +257,36 @@ std::string generate_instances_list(const mp::InstancesList& instance_list)
         return "No instances found.\n";
 
     const std::string name_col_header = "Name";
-    const auto name_column_width = mp::format::column_width(
-        instances.begin(),
-        instances.end(),
-        [](const auto& instance) -> int { return instance.name().length(); },
-        name_col_header.length(),
-        24);
+    const auto name_width = [](const auto& instance) -> int { return instance.name().length(); };
+    const auto minimum_name_column_width =
+        opening_page ? mp::format::column_width(opening_page->instances().begin(),
+                                                opening_page->instances().end(),
+                                                name_width,
+                                                name_col_header.length(),
+                                                24)
+                     : 24;
+    const auto name_column_width = mp::format::column_width(instances.begin(),
+                                                            instances.end(),
+                                                            name_width,
+                                                            name_col_header.length(),
+                                                            minimum_name_column_width);
     const std::string::size_type state_column_width = 18;
     const std::string::size_type ip_column_width = 17;
     [[maybe_unused]] const std::string::size_type image_column_width = 20;
 
     constexpr auto row_format = "{:<{}}{:<{}}{:<{}}{:<{}}{:<}\n";
-    fmt::format_to(std::back_inserter(buf),
-                   row_format,
-                   name_col_header,
-                   name_column_width,
-                   "State",
-                   state_column_width,
-                   "IPv4",
-                   ip_column_width,
-                   "Image",
-                   image_column_width,
-                   "Zone");
+    if (!opening_page)
+        fmt::format_to(std::back_inserter(buf),
+                       row_format,
+                       name_col_header,
+                       name_column_width,
+                       "State",
+                       state_column_width,
+                       "IPv4",
+                       ip_column_width,
+                       "Image",
+                       image_column_width,
+                       "Zone");
 
     for (const auto& instance : mp::format::sorted(instance_list.instances()))
     {
@@ -317,7 +328,9 @@ std::string generate_instances_list(const mp::InstancesList& instance_list)
     return fmt::to_string(buf);
 }
 
-std::string generate_snapshots_list(const mp::SnapshotsList& snapshot_list)
+// Pages are laid out as with instances
+std::string generate_snapshots_list(const mp::SnapshotsList& snapshot_list,
+                                    const mp::SnapshotsList* opening_page = nullptr)
 {
     fmt::memory_buffer buf;
 
@@ -326,36 +339,45 @@ std::string generate_snapshots_list(const mp::SnapshotsList& snapshot_list)
     if (snapshots.empty())
         return "No snapshots found.\n";
 
+    const auto width_of = [&snapshots, opening_page](auto get_width, const std::string& header) {
+        const auto minimum_width =
+            opening_page ? mp::format::column_width(opening_page->snapshots().begin(),
+                                                    opening_page->snapshots().end(),
+                                                    get_width,
+                                                    header.length())
+                         : 0;
+        return mp::format::column_width(snapshots.begin(),
+                                        snapshots.end(),
+                                        get_width,
+                                        header.length(),
+                                        minimum_width);
+    };
+
     const std::string name_col_header = "Instance", snapshot_col_header = "Snapshot",
                       parent_col_header = "Parent", comment_col_header = "Comment";
-    const auto name_column_width = mp::format::column_width(
-        snapshots.begin(),
-        snapshots.end(),
+    const auto name_column_width = width_of(
         [](const auto& snapshot) -> int { return snapshot.name().length(); },
-        name_col_header.length());
-    const auto snapshot_column_width = mp::format::column_width(
-        snapshots.begin(),
-        snapshots.end(),
+        name_col_header);
+    const auto snapshot_column_width = width_of(
         [](const auto& snapshot) -> int {
             return snapshot.fundamentals().snapshot_name().length();
         },
-        snapshot_col_header.length());
-    const auto parent_column_width = mp::format::column_width(
-        snapshots.begin(),
-        snapshots.end(),
+        snapshot_col_header);
+    const auto parent_column_width = width_of(
         [](const auto& snapshot) -> int { return snapshot.fundamentals().parent().length(); },
-        parent_col_header.length());
+        parent_col_header);
 
     constexpr auto row_format = "{:<{}}{:<{}}{:<{}}{:<}\n";
-    fmt::format_to(std::back_inserter(buf),
-                   row_format,
-                   name_col_header,
-                   name_column_width,
-                   snapshot_col_header,
-                   snapshot_column_width,
-                   parent_col_header,
-                   parent_column_width,
-                   comment_col_header);
+    if (!opening_page)
+        fmt::format_to(std::back_inserter(buf),
+                       row_format,
+                       name_col_header,
+                       name_column_width,
+                       snapshot_col_header,
+                       snapshot_column_width,
+                       parent_col_header,
+                       parent_column_width,
+                       comment_col_header);
 
     for (const auto& snapshot : mp::format::sorted(snapshot_list.snapshots()))
     {
@@ -436,6 +458,51 @@ std::string mp::TableFormatter::format(const ListReply& reply) const
     return output;
 }
 
+bool mp::TableFormatter::renders_pages(bool to_terminal) const
+{
+    // Whoever reads the table gets to see the first instances sooner, while scripts that read it
+    // get it whole, sorted and aligned over all instances
+    return to_terminal;
+}
+
+std::string mp::TableFormatter::format_page(const InfoReply& page,
+                                            const InfoReply* opening_page) const
+{
+    if (page.details().empty())
+        return {};
+
+    // Instances are kept apart by a blank line, across pages too
+    return fmt::format("{}{}", opening_page ? "\n" : "", format(page));
+}
+
+std::string mp::TableFormatter::format_page(const ListReply& page,
+                                            const ListReply* opening_page) const
+{
+    if (page.has_instance_list())
+        return page.instance_list().instances().empty()
+                   ? std::string{}
+                   : generate_instances_list(page.instance_list(),
+                                             opening_page ? &opening_page->instance_list()
+                                                          : nullptr);
+
+    return page.snapshot_list().snapshots().empty()
+               ? std::string{}
+               : generate_snapshots_list(page.snapshot_list(),
+                                         opening_page ? &opening_page->snapshot_list() : nullptr);
+}
+
+std::string mp::TableFormatter::finish_pages(const InfoReply& last_page,
+                                             const InfoReply* opening_page) const
+{
+    return opening_page ? std::string{} : format(last_page);
+}
+
+std::string mp::TableFormatter::finish_pages(const ListReply& last_page,
+                                             const ListReply* opening_page) const
+{
+    return opening_page ? std::string{} : format(last_page);
+}
+
 std::string mp::TableFormatter::format(const NetworksReply& reply) const
 {
     fmt::memory_buffer buf;
@@ -17,8 +17,12 @@
 
 #include "cli.h"
 
+#include <multipass/constants.h>
+#include <multipass/logging/log.h>
 #include <multipass/logging/standard_logger.h>
 #include <multipass/platform.h>
+#include <multipass/settings/settings.h>
+#include <multipass/tracing.h>
 #include <multipass/utils.h>
 
 #include <multipass/format.h>
@@ -50,6 +54,19 @@ multipass::logging::Level to_logging_level(const QString& value)
                                          "Valid levels are: error|warning|info|debug|trace.",
                                          value));
 }
+
+mpl::MultiplexingLogger::OverflowPolicy to_overflow_policy(const QString& value)
+{
+    auto value_lower = value.toLower();
+
+    if (value_lower == "drop")
+        return mpl::MultiplexingLogger::OverflowPolicy::drop;
+    if (value_lower == "block")
+        return mpl::MultiplexingLogger::OverflowPolicy::block;
+
+    throw std::runtime_error(
+        fmt::format("invalid async logging policy: {}. Valid policies are: drop|block.", value));
+}
 } // namespace
 
 mp::DaemonConfigBuilder mp::cli::parse(const QCoreApplication& app)
@@ -63,14 +80,24 @@ mp::DaemonConfigBuilder mp::cli::parse(const QCoreApplication& app)
     QCommandLineOption verbosity_option{{"V", "verbosity"},
                                         "specifies the logging verbosity level",
                                         "error|warning|info|debug|trace"};
+    QCommandLineOption async_logging_option{
+        "async-logging",
+        "logs from a background thread, dropping or blocking on messages when it falls behind",
+        "drop|block"};
     QCommandLineOption address_option{"address",
                                       "specifies which address to use for the multipassd service;"
                                       " a socket can be specified using unix:<socket_file>",
                                       "server_name:port"};
+    QCommandLineOption trace_file_option{
+        "trace-file",
+        "writes timed operations to a file, in Chrome trace format",
+        "file"};
 
     parser.addOption(logger_option);
     parser.addOption(verbosity_option);
+    parser.addOption(async_logging_option);
     parser.addOption(address_option);
+    parser.addOption(trace_file_option);
 
     parser.process(app);
 
@@ -79,6 +106,9 @@ mp::DaemonConfigBuilder mp::cli::parse(const QCoreApplication& app)
     if (parser.isSet(verbosity_option))
         builder.verbosity_level = to_logging_level(parser.value(verbosity_option));
 
+    if (parser.isSet(async_logging_option))
+        builder.async_logging = to_overflow_policy(parser.value(async_logging_option));
+
     if (parser.isSet(logger_option))
     {
         auto logger = parser.value(logger_option);
@@ -97,5 +127,31 @@ mp::DaemonConfigBuilder mp::cli::parse(const QCoreApplication& app)
         builder.server_address = address;
     }
 
+    if (parser.isSet(trace_file_option))
+    {
+        const auto trace_file = parser.value(trace_file_option);
+        try
+        {
+            MP_TRACER.export_to(MP_PLATFORM.qstr_to_path(trace_file));
+        }
+        catch (const std::exception& e)
+        {
+            throw std::runtime_error(
+                fmt::format("invalid trace file option '{}': {}", trace_file, e.what()));
+        }
+    }
+
+    try
+    {
+        builder.warm_pool_profiles = parse_warm_pool_profiles(MP_SETTINGS.get(warm_pool_key));
+    }
+    catch (const std::invalid_argument& e)
+    {
+        mpl::warn("daemon", "Ignoring invalid {} setting: {}", warm_pool_key, e.what());
+    }
+
+    builder.metrics_port = MP_SETTINGS.get(metrics_port_key).toUShort();
+    builder.load_instances_in_background = true;
+
     return builder;
 }
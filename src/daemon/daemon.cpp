@@ -42,6 +42,7 @@
 #include <multipass/json_utils.h>
 #include <multipass/logging/client_logger.h>
 #include <multipass/logging/log.h>
+#include <multipass/metrics.h>
 #include <multipass/name_generator.h>
 #include <multipass/network_interface.h>
 #include <multipass/platform.h>
@@ -52,6 +53,7 @@
 #include <multipass/ssh/ssh_session.h>
 #include <multipass/sshfs_mount/sshfs_mount_handler.h>
 #include <multipass/top_catch_all.h>
+#include <multipass/tracing.h>
 #include <multipass/utils/grpc_utils.h>
 #include <multipass/version.h>
 #include <multipass/virtual_machine.h>
@@ -67,14 +69,18 @@
 
 #include <QDir>
 #include <QEventLoop>
+#include <QFileInfo>
 #include <QFutureSynchronizer>
+#include <QRegularExpression>
 #include <QStorageInfo>
 #include <QString>
 #include <QSysInfo>
+#include <QTimeZone>
 #include <QtConcurrent/QtConcurrent>
 
 #include <algorithm>
 #include <cassert>
+#include <chrono>
 #include <functional>
 #include <optional>
 #include <stdexcept>
@@ -85,6 +91,8 @@
 
 namespace mp = multipass;
 namespace mpl = multipass::logging;
+namespace mpm = multipass::metrics;
+namespace mpt = multipass::tracing;
 namespace mpu = multipass::utils;
 
 namespace
@@ -98,6 +106,7 @@ constexpr auto category = "daemon";
 constexpr auto instance_db_name = "multipassd-vm-instances.json";
 constexpr auto reboot_cmd = "sudo reboot";
 constexpr auto stop_ssh_cmd = "sudo systemctl stop ssh";
+constexpr auto deferred_request_timeout = 2min;
 constexpr auto sshfs_error_template =
     "Error enabling mount support in '{}'"
     "\n\nPlease install the 'multipass-sshfs' snap manually inside the instance.";
@@ -506,32 +515,103 @@ auto validate_create_arguments(const mp::LaunchRequest* request, const mp::Daemo
     return ret;
 }
 
+// Wraps a slot so that it only runs once all instances are loaded, for requests that need them.
+// Requests that are still waiting when loading takes too long are refused, rather than left hanging
+template <typename Request, typename Reply>
+auto once_instances_loaded(mp::Daemon& daemon,
+                           void (mp::Daemon::*slot)(
+                               const Request*,
+                               grpc::ServerReaderWriterInterface<Reply, Request>*,
+                               mp::DaemonRpcContext*))
+{
+    return [&daemon, slot](const Request* request,
+                           grpc::ServerReaderWriter<Reply, Request>* server,
+                           mp::DaemonRpcContext* context) {
+        // The RPC thread waits on the context, so everything here outlives the deferral
+        daemon.when_instances_loaded(
+            [&daemon, slot, request, server, context] { (daemon.*slot)(request, server, context); },
+            [context] {
+                context->set_value(grpc::Status{grpc::StatusCode::UNAVAILABLE,
+                                                "instances are still being loaded, try again later",
+                                                ""});
+            });
+    };
+}
+
 auto connect_rpc(mp::DaemonRpc& rpc, mp::Daemon& daemon)
 {
-    QObject::connect(&rpc, &mp::DaemonRpc::on_create, &daemon, &mp::Daemon::create);
-    QObject::connect(&rpc, &mp::DaemonRpc::on_launch, &daemon, &mp::Daemon::launch);
-    QObject::connect(&rpc, &mp::DaemonRpc::on_purge, &daemon, &mp::Daemon::purge);
+    QObject::connect(&rpc,
+                     &mp::DaemonRpc::on_create,
+                     &daemon,
+                     once_instances_loaded(daemon, &mp::Daemon::create));
+    QObject::connect(&rpc,
+                     &mp::DaemonRpc::on_launch,
+                     &daemon,
+                     once_instances_loaded(daemon, &mp::Daemon::launch));
+    QObject::connect(&rpc,
+                     &mp::DaemonRpc::on_purge,
+                     &daemon,
+                     once_instances_loaded(daemon, &mp::Daemon::purge));
     QObject::connect(&rpc, &mp::DaemonRpc::on_find, &daemon, &mp::Daemon::find);
-    QObject::connect(&rpc, &mp::DaemonRpc::on_info, &daemon, &mp::Daemon::info);
+    QObject::connect(&rpc,
+                     &mp::DaemonRpc::on_info,
+                     &daemon,
+                     once_instances_loaded(daemon, &mp::Daemon::info));
     QObject::connect(&rpc, &mp::DaemonRpc::on_list, &daemon, &mp::Daemon::list);
-    QObject::connect(&rpc, &mp::DaemonRpc::on_clone, &daemon, &mp::Daemon::clone);
+    QObject::connect(&rpc,
+                     &mp::DaemonRpc::on_clone,
+                     &daemon,
+                     once_instances_loaded(daemon, &mp::Daemon::clone));
     QObject::connect(&rpc, &mp::DaemonRpc::on_networks, &daemon, &mp::Daemon::networks);
-    QObject::connect(&rpc, &mp::DaemonRpc::on_mount, &daemon, &mp::Daemon::mount);
-    QObject::connect(&rpc, &mp::DaemonRpc::on_recover, &daemon, &mp::Daemon::recover);
-    QObject::connect(&rpc, &mp::DaemonRpc::on_ssh_info, &daemon, &mp::Daemon::ssh_info);
-    QObject::connect(&rpc, &mp::DaemonRpc::on_start, &daemon, &mp::Daemon::start);
-    QObject::connect(&rpc, &mp::DaemonRpc::on_stop, &daemon, &mp::Daemon::stop);
-    QObject::connect(&rpc, &mp::DaemonRpc::on_suspend, &daemon, &mp::Daemon::suspend);
-    QObject::connect(&rpc, &mp::DaemonRpc::on_restart, &daemon, &mp::Daemon::restart);
-    QObject::connect(&rpc, &mp::DaemonRpc::on_delete, &daemon, &mp::Daemon::delet);
-    QObject::connect(&rpc, &mp::DaemonRpc::on_umount, &daemon, &mp::Daemon::umount);
+    QObject::connect(&rpc,
+                     &mp::DaemonRpc::on_mount,
+                     &daemon,
+                     once_instances_loaded(daemon, &mp::Daemon::mount));
+    QObject::connect(&rpc,
+                     &mp::DaemonRpc::on_recover,
+                     &daemon,
+                     once_instances_loaded(daemon, &mp::Daemon::recover));
+    QObject::connect(&rpc,
+                     &mp::DaemonRpc::on_ssh_info,
+                     &daemon,
+                     once_instances_loaded(daemon, &mp::Daemon::ssh_info));
+    QObject::connect(&rpc,
+                     &mp::DaemonRpc::on_start,
+                     &daemon,
+                     once_instances_loaded(daemon, &mp::Daemon::start));
+    QObject::connect(&rpc,
+                     &mp::DaemonRpc::on_stop,
+                     &daemon,
+                     once_instances_loaded(daemon, &mp::Daemon::stop));
+    QObject::connect(&rpc,
+                     &mp::DaemonRpc::on_suspend,
+                     &daemon,
+                     once_instances_loaded(daemon, &mp::Daemon::suspend));
+    QObject::connect(&rpc,
+                     &mp::DaemonRpc::on_restart,
+                     &daemon,
+                     once_instances_loaded(daemon, &mp::Daemon::restart));
+    QObject::connect(&rpc,
+                     &mp::DaemonRpc::on_delete,
+                     &daemon,
+                     once_instances_loaded(daemon, &mp::Daemon::delet));
+    QObject::connect(&rpc,
+                     &mp::DaemonRpc::on_umount,
+                     &daemon,
+                     once_instances_loaded(daemon, &mp::Daemon::umount));
     QObject::connect(&rpc, &mp::DaemonRpc::on_version, &daemon, &mp::Daemon::version);
     QObject::connect(&rpc, &mp::DaemonRpc::on_get, &daemon, &mp::Daemon::get);
     QObject::connect(&rpc, &mp::DaemonRpc::on_set, &daemon, &mp::Daemon::set);
     QObject::connect(&rpc, &mp::DaemonRpc::on_keys, &daemon, &mp::Daemon::keys);
     QObject::connect(&rpc, &mp::DaemonRpc::on_authenticate, &daemon, &mp::Daemon::authenticate);
-    QObject::connect(&rpc, &mp::DaemonRpc::on_snapshot, &daemon, &mp::Daemon::snapshot);
-    QObject::connect(&rpc, &mp::DaemonRpc::on_restore, &daemon, &mp::Daemon::restore);
+    QObject::connect(&rpc,
+                     &mp::DaemonRpc::on_snapshot,
+                     &daemon,
+                     once_instances_loaded(daemon, &mp::Daemon::snapshot));
+    QObject::connect(&rpc,
+                     &mp::DaemonRpc::on_restore,
+                     &daemon,
+                     once_instances_loaded(daemon, &mp::Daemon::restore));
     QObject::connect(&rpc, &mp::DaemonRpc::on_daemon_info, &daemon, &mp::Daemon::daemon_info);
     QObject::connect(&rpc, &mp::DaemonRpc::on_wait_ready, &daemon, &mp::Daemon::wait_ready);
     QObject::connect(&rpc, &mp::DaemonRpc::on_zones, &daemon, &mp::Daemon::zones);
@@ -1052,6 +1132,61 @@ std::string generate_unused_mac_address(std::unordered_set<std::string>& s)
                                          s.size())};
 }
 
+// Pooled instances are booted with the default resources and configuration, so they can only
+// stand in for launches that ask for nothing but an image
+bool fits_pooled_instance(const mp::LaunchRequest& request)
+{
+    return request.instance_name().empty() && request.num_cores() == 0 &&
+           request.mem_size().empty() && request.disk_space().empty() &&
+           request.cloud_init_user_data().empty() && request.network_options().empty() &&
+           request.zone().empty() &&
+           request.time_zone() == QTimeZone::systemTimeZoneId().toStdString();
+}
+
+// Picks the instances that list and info report on, by name pattern and state, when asked to
+class InstanceFilter
+{
+public:
+    template <typename Request>
+    explicit InstanceFilter(const Request& request)
+        : name_pattern{request.name_pattern().empty()
+                           ? std::nullopt
+                           : std::optional{QRegularExpression{
+                                 QRegularExpression::wildcardToRegularExpression(
+                                     QString::fromStdString(request.name_pattern()))}}},
+          states{request.states().begin(), request.states().end()}
+    {
+    }
+
+    bool matches(const std::string& name, mp::InstanceStatus::Status status) const
+    {
+        return (states.empty() || states.contains(status)) &&
+               (!name_pattern || name_pattern->match(QString::fromStdString(name)).hasMatch());
+    }
+
+private:
+    const std::optional<QRegularExpression> name_pattern;
+    const std::unordered_set<int> states;
+};
+
+// Sends what is gathered in the reply every page_size instances, if that is not 0, so that clients
+// can show the first instances while the others are still being looked into
+template <typename Reply, typename Request, typename ClearEntries>
+auto make_pager(std::uint32_t page_size,
+                grpc::ServerReaderWriterInterface<Reply, Request>* server,
+                Reply& reply,
+                ClearEntries clear_entries)
+{
+    return [page_size, server, &reply, clear_entries, in_page = 0u]() mutable {
+        if (page_size && ++in_page == page_size)
+        {
+            server->Write(reply);
+            clear_entries(reply);
+            in_page = 0;
+        }
+    };
+}
+
 struct SnapshotPick
 {
     std::unordered_set<std::string> pick;
@@ -1133,6 +1268,27 @@ void add_aliases(google::protobuf::RepeatedPtrField<mp::FindReply_ImageInfo>* co
     }
 }
 
+void add_remote_statuses(
+    google::protobuf::RepeatedPtrField<mp::FindReply_RemoteStatus>* container,
+    const std::vector<std::unique_ptr<mp::VMImageHost>>& image_hosts)
+{
+    const auto now = std::chrono::system_clock::now();
+    for (const auto& image_host : image_hosts)
+    {
+        for (const auto& status : image_host->refresh_statuses())
+        {
+            auto entry = container->Add();
+            entry->set_remote_name(status.remote_name);
+            entry->set_error(status.error);
+            entry->set_age_seconds(
+                status.fetched_at
+                    ? std::chrono::duration_cast<std::chrono::seconds>(now - *status.fetched_at)
+                          .count()
+                    : -1);
+        }
+    }
+}
+
 auto timeout_for(const int requested_timeout)
 {
     if (requested_timeout > 0)
@@ -1277,6 +1433,46 @@ void populate_snapshot_info(mp::VirtualMachine& vm,
 
     populate_snapshot_fundamentals(snapshot, fundamentals);
 }
+
+constexpr auto instance_state_metric = "multipass_instance_state";
+
+// Sets the instance's gauge for the given state to 1 and the rest to 0, or drops all of them when
+// there is no state
+void update_instance_state_metric(const std::string& name,
+                                  std::optional<mp::VirtualMachine::State> state)
+{
+    using State = mp::VirtualMachine::State;
+
+    for (auto i = static_cast<int>(State::off); i <= static_cast<int>(State::unavailable); ++i)
+    {
+        const auto each = static_cast<State>(i);
+        const mpm::Labels labels{{"instance", name}, {"state", fmt::format("{}", each)}};
+
+        if (state)
+            MP_METRICS.gauge(instance_state_metric, "Current state of each instance", labels)
+                .set(each == *state);
+        else
+            MP_METRICS.remove(instance_state_metric, labels);
+    }
+}
+
+void add_launch_timings(mp::LaunchReply& reply, const std::vector<mpt::Span>& spans)
+{
+    using std::chrono::duration_cast;
+    using std::chrono::milliseconds;
+
+    if (spans.empty())
+        return;
+
+    const auto origin = spans.front().start; // spans come sorted by start
+    for (const auto& span : spans)
+    {
+        auto* timing = reply.add_timings();
+        timing->set_name(span.name);
+        timing->set_start_ms(duration_cast<milliseconds>(span.start - origin).count());
+        timing->set_duration_ms(duration_cast<milliseconds>(span.end - span.start).count());
+    }
+}
 } // namespace
 
 mp::Daemon::Daemon(std::unique_ptr<const DaemonConfig> the_config)
@@ -1306,6 +1502,22 @@ mp::Daemon::Daemon(std::unique_ptr<const DaemonConfig> the_config)
 
     connect_rpc(daemon_rpc, *this);
     std::vector<std::string> invalid_specs;
+    std::vector<VirtualMachineDescription> to_load;
+
+    if (config->metrics_port)
+    {
+        try
+        {
+            metrics_server = std::make_unique<MetricsServer>(config->metrics_port);
+
+            // Have helper processes started from here on, like sshfs_server, report theirs too
+            qputenv(mp::report_metrics_env_var, "1");
+        }
+        catch (const std::exception& e)
+        {
+            mpl::error(category, "{}", e.what());
+        }
+    }
 
     try
     {
@@ -1370,11 +1582,6 @@ mp::Daemon::Daemon(std::unique_ptr<const DaemonConfig> the_config)
                                               {},
                                               {}};
 
-        auto& instance_record = spec.deleted ? deleted_instances : operative_instances;
-        auto instance = instance_record[name] =
-            config->factory->create_virtual_machine(vm_desc, *config->ssh_key_provider, *this);
-        instance->load_snapshots();
-
         // Add the new macs to the daemon's list only if we got this far
         allocated_mac_addrs = std::move(new_macs);
 
@@ -1390,42 +1597,17 @@ mp::Daemon::Daemon(std::unique_ptr<const DaemonConfig> the_config)
             spec.state = e_state::stopped;
         }
 
-        if (!spec.deleted)
-            init_mounts(name);
-        std::unique_lock lock{start_mutex};
+        update_instance_state_metric(name, spec.state);
 
-        if (spec.state == e_state::running)
+        if (config->load_instances_in_background)
         {
-            // If the VM was in running state before, we need to do some additional
-            // work to ensure everything is in sync.
-            switch (operative_instances[name]->current_state())
-            {
-            case e_state::running:
-            case e_state::starting:
-            {
-                mpl::info(category, "{} needs syncing. Syncing now...", name);
-                // We don't need to start the instance, but we need to ensure that
-                // the daemon side resources for the VM are initialized.
-                multipass::top_catch_all(name, [this, &name, &lock] {
-                    lock.unlock();
-                    on_restart(name);
-                });
-            }
-            break;
-            default:
-            {
-                assert(!spec.deleted);
-                mpl::info(category, "{} needs starting. Starting now...", name);
-
-                multipass::top_catch_all(name, [this, &name, &lock]() {
-                    operative_instances[name]->start();
-                    lock.unlock();
-                    on_restart(name);
-                });
-            }
-            break;
-            }
+            loading_instances.insert(name);
+            preparing_instances.insert(name); // refuses instance settings until loaded
+            loading_metadata.emplace(name, spec.metadata);
+            to_load.push_back(std::move(vm_desc));
         }
+        else
+            install_instance(name, load_instance(vm_desc));
     }
 
     for (const auto& bad_spec : invalid_specs)
@@ -1440,49 +1622,56 @@ mp::Daemon::Daemon(std::unique_ptr<const DaemonConfig> the_config)
 
     config->vault->prune_expired_images();
 
+    if (!to_load.empty())
+    {
+        // Instances are constructed, and their snapshots loaded, off the daemon thread and in
+        // parallel, while requests that do not depend on them are served already
+        mpl::info(category, "Loading {} instance(s) in the background", to_load.size());
+        connect(&instance_loader,
+                &QFutureWatcher<LoadedInstance>::resultReadyAt,
+                this,
+                [this](int index) { finish_loading_instance(instance_loader.resultAt(index)); });
+        instance_loader.setFuture(QtConcurrent::mapped(
+            std::move(to_load),
+            [this, daemon_thread = thread()](const VirtualMachineDescription& desc) {
+                return load_instance_in_background(desc, daemon_thread);
+            }));
+    }
+
     // Fire timer every six hours to perform maintenance on source images such as
     // pruning expired images and updating to newly released images.
-    connect(&source_images_maintenance_task, &QTimer::timeout, [this]() {
-        if (image_update_future.isRunning())
-        {
-            mpl::info(category, "Image updater already running. Skipping…");
-        }
-        else
-        {
-            image_update_future = QtConcurrent::run([this] {
-                config->vault->prune_expired_images();
-
-                auto prepare_action = [this](const VMImage& source_image) -> VMImage {
-                    return config->factory->prepare_source_image(source_image);
-                };
-
-                auto download_monitor = [](int /*progress_type*/, int percentage) {
-                    static int last_percentage_logged = -1;
-                    if (percentage % 10 == 0)
-                    {
-                        // Note: The progress callback may be called repeatedly with the same
-                        // percentage, so this logic is to only log it once
-                        if (last_percentage_logged != percentage)
-                        {
-                            mpl::info(category, "  {}%", percentage);
-                            last_percentage_logged = percentage;
-                        }
-                    }
-                    return true;
-                };
-
-                try
-                {
-                    config->vault->update_images(prepare_action, download_monitor);
-                }
-                catch (const std::exception& e)
-                {
-                    mpl::error(category, "Error updating images: {}", e.what());
-                }
-            });
-        }
+    connect(&source_images_maintenance_task, &QTimer::timeout, [this] {
+        image_maintenance->run();
     });
     source_images_maintenance_task.start(config->image_refresh_timer);
+
+    if (!config->warm_pool_profiles.empty())
+        warm_pool = std::make_unique<WarmPool>(
+            config->warm_pool_profiles,
+            *config->factory,
+            *config->vault,
+            [this](const std::string& pooled_name, const Query& query) {
+                QMetaObject::invokeMethod(
+                    this,
+                    [this, pooled_name, query] { boot_pooled_instance(pooled_name, query); },
+                    Qt::QueuedConnection);
+            },
+            [this](const VirtualMachineDescription& desc) {
+                auto macs = std::vector<std::string>{desc.default_mac_address};
+                for (const auto& iface : desc.extra_interfaces)
+                    macs.push_back(iface.mac_address);
+
+                QMetaObject::invokeMethod(
+                    this,
+                    [this, macs = std::move(macs)] {
+                        for (const auto& mac : macs)
+                            allocated_mac_addrs.erase(mac);
+                    },
+                    Qt::QueuedConnection);
+            });
+
+    image_maintenance =
+        std::make_unique<ImageMaintenance>(*config->vault, *config->factory, warm_pool.get());
 }
 
 mp::Daemon::~Daemon()
@@ -1502,6 +1691,7 @@ mp::Daemon::~Daemon()
         {
             watcher->waitForFinished();
         }
+        instance_loader.waitForFinished();
 
         /**
          * AsyncPeriodicDownloadTask maintain its own QFutureWatcher.
@@ -1680,6 +1870,7 @@ try
             add_aliases(response.mutable_images_info(), remote, info);
     }
 
+    add_remote_statuses(response.mutable_remote_statuses(), config->image_hosts);
     server->Write(response);
     context->set_value(grpc::Status::OK);
 }
@@ -1694,13 +1885,17 @@ void mp::Daemon::info(const InfoRequest* request,
 try
 {
     InfoReply response;
-    config->update_prompt->populate_if_time_to_show(response.mutable_update_info());
     InstanceSnapshotsMap instance_snapshots_map;
     bool have_mounts = false;
     bool deleted = false;
     bool snapshots_only = request->snapshots();
     response.set_snapshots(snapshots_only);
 
+    const InstanceFilter filter{*request};
+    auto end_of_instance = make_pager(request->page_size(), server, response, [](auto& reply) {
+        reply.clear_details();
+    });
+
     auto process_snapshot_pick = [&response, &have_mounts, snapshots_only](
                                      VirtualMachine& vm,
                                      const SnapshotPick& snapshot_pick) {
@@ -1719,10 +1914,17 @@ try
                                   request,
                                   &response,
                                   &have_mounts,
-                                  &deleted](VirtualMachine& vm) {
+                                  &deleted,
+                                  &filter,
+                                  &end_of_instance](VirtualMachine& vm) {
         fmt::memory_buffer errors;
         const auto& name = vm.get_name();
 
+        const auto status =
+            deleted ? mp::InstanceStatus::DELETED : grpc_instance_status_for(vm.current_state());
+        if (!filter.matches(name, status))
+            return grpc::Status::OK;
+
         const auto& it = instance_snapshots_map.find(name);
         const auto& snapshot_pick = it == instance_snapshots_map.end() ? SnapshotPick{{}, true}
                                                                        : it->second;
@@ -1748,6 +1950,7 @@ try
             add_fmt_to(errors, "{}", e.what());
         }
 
+        end_of_instance();
         return grpc_status_for(errors);
     };
 
@@ -1771,6 +1974,7 @@ try
         if (have_mounts && !MP_SETTINGS.get_as<bool>(mp::mounts_key))
             mpl::error(category, "Mounts have been disabled on this instance of Multipass");
 
+        config->update_prompt->populate_if_time_to_show(response.mutable_update_info());
         server->Write(response);
     }
 
@@ -1787,7 +1991,6 @@ void mp::Daemon::list(const ListRequest* request,
 try
 {
     ListReply response;
-    config->update_prompt->populate_if_time_to_show(response.mutable_update_info());
 
     // Need to 'touch' a report in the response so formatters know what to do with an otherwise
     // empty response
@@ -1798,38 +2001,36 @@ try
 
     bool deleted = false;
 
-    auto fetch_instance = [this, request, &response, &deleted](VirtualMachine& vm) {
+    const InstanceFilter filter{*request};
+    auto end_of_instance =
+        make_pager(request->page_size(), server, response, [request](auto& reply) {
+            if (request->snapshots())
+                reply.mutable_snapshot_list()->clear_snapshots();
+            else
+                reply.mutable_instance_list()->clear_instances();
+        });
+
+    auto fetch_instance = [&, this](VirtualMachine& vm) {
         const auto& name = vm.get_name();
         auto present_state = vm.current_state();
+        const auto status =
+            deleted ? mp::InstanceStatus::DELETED : grpc_instance_status_for(present_state);
+
+        // Filtered out before anything slow, like asking for IP addresses, is done
+        if (!filter.matches(name, status))
+            return grpc::Status::OK;
+
         auto entry = response.mutable_instance_list()->add_instances();
         entry->set_name(name);
         const auto zone = entry->mutable_zone();
         zone->set_name(vm.get_zone().get_name());
         zone->set_available(vm.get_zone().is_available());
-        if (deleted)
-            entry->mutable_instance_status()->set_status(mp::InstanceStatus::DELETED);
-        else
-            entry->mutable_instance_status()->set_status(grpc_instance_status_for(present_state));
-
-        auto vm_image = fetch_image_for(name, *config->factory, *config->vault);
-        auto current_release = vm_image.original_release;
-        auto os = vm_image.os;
+        entry->mutable_instance_status()->set_status(status);
 
-        if (!vm_image.id.empty() && current_release.empty())
-        {
-            try
-            {
-                auto vm_image_info = config->image_hosts.back()->info_for_full_hash(vm_image.id);
-                current_release = vm_image_info.release_title;
-            }
-            catch (const std::exception& e)
-            {
-                mpl::warn(category, "Cannot fetch image information: {}", e.what());
-            }
-        }
-
-        entry->set_current_release(current_release);
-        entry->set_os(os);
+        // The vault record has what there is to know about the image, with no need for manifests
+        const auto vm_image = fetch_image_for(name, *config->factory, *config->vault);
+        entry->set_current_release(vm_image.original_release);
+        entry->set_os(vm_image.os);
 
         if (request->request_ipv4() && MP_UTILS.is_running(present_state))
         {
@@ -1844,13 +2045,19 @@ try
                     entry->add_ipv4(extra_ipv4.as_string());
         }
 
+        end_of_instance();
         return grpc::Status::OK;
     };
 
-    auto fetch_snapshot = [&response](VirtualMachine& vm) {
+    auto fetch_snapshot = [&response, &deleted, &filter, &end_of_instance](VirtualMachine& vm) {
         fmt::memory_buffer errors;
         const auto& name = vm.get_name();
 
+        const auto status =
+            deleted ? mp::InstanceStatus::DELETED : grpc_instance_status_for(vm.current_state());
+        if (!filter.matches(name, status))
+            return grpc::Status::OK;
+
         try
         {
             for (const auto& snapshot : vm.view_snapshots())
@@ -1867,6 +2074,7 @@ try
             add_fmt_to(errors, "{}", e.what());
         }
 
+        end_of_instance();
         return grpc_status_for(errors);
     };
 
@@ -1879,6 +2087,37 @@ try
         status = cmd_vms(select_all(deleted_instances), cmd);
     }
 
+    // Instances that are still being loaded, or that could not be, have no VM to ask, but their
+    // records can tell
+    auto fetch_unloaded_instance = [&, this](const std::string& name, auto status) {
+        // Deleted instances are listed as such, whether their VMs could be loaded or not
+        const auto& spec = vm_instance_specs.at(name);
+        if (spec.deleted)
+            status = mp::InstanceStatus::DELETED;
+
+        if (!filter.matches(name, status))
+            return;
+
+        auto entry = response.mutable_instance_list()->add_instances();
+        entry->set_name(name);
+        entry->mutable_zone()->set_name(spec.zone);
+        entry->mutable_instance_status()->set_status(status);
+
+        const auto vm_image = fetch_image_for(name, *config->factory, *config->vault);
+        entry->set_current_release(vm_image.original_release);
+        entry->set_os(vm_image.os);
+        end_of_instance();
+    };
+
+    if (!request->snapshots())
+    {
+        for (const auto& name : loading_instances)
+            fetch_unloaded_instance(name, mp::InstanceStatus::LOADING);
+        for (const auto& name : unloaded_instances)
+            fetch_unloaded_instance(name, mp::InstanceStatus::UNKNOWN);
+    }
+
+    config->update_prompt->populate_if_time_to_show(response.mutable_update_info());
     server->Write(response);
     context->set_value(status);
 }
@@ -2162,7 +2401,8 @@ try
         starting_vms.push_back(vm_it->first);
     }
 
-    auto future_watcher = create_future_watcher();
+    // Image maintenance holds off until the instances are up
+    auto future_watcher = create_future_watcher([hold = image_maintenance->hold()] {});
     future_watcher->setFuture(
         QtConcurrent::run(&Daemon::async_wait_for_ready_all<StartReply, StartRequest>,
                           this,
@@ -2645,10 +2885,14 @@ try
         assert(vm_ptr);
 
         using St = VirtualMachine::State;
-        if (auto state = vm_ptr->current_state(); state != St::off && state != St::stopped)
-            return context->set_value(
-                grpc::Status{grpc::FAILED_PRECONDITION,
-                             "Multipass can only take snapshots of stopped instances."});
+        const auto state = vm_ptr->current_state();
+        const auto live = state == St::running && vm_ptr->supports_live_snapshots();
+        if (state != St::off && state != St::stopped && !live)
+            return context->set_value(grpc::Status{
+                grpc::FAILED_PRECONDITION,
+                vm_ptr->supports_live_snapshots()
+                    ? "Multipass can only take snapshots of running or stopped instances."
+                    : "Multipass can only take snapshots of stopped instances."});
 
         auto snapshot_name = request->snapshot();
         if (!snapshot_name.empty() && !mp::utils::valid_hostname(snapshot_name))
@@ -2811,14 +3055,29 @@ try
         // Specs need to be in place before the factory can create the VM
         // Notice that we are passing `this`, which can be used to retrieve further info
         vm_instance_specs.emplace(destination_name, dest_spec);
-        operative_instances[destination_name] =
-            config->factory->clone_bare_vm(src_spec,
-                                           dest_spec,
-                                           source_name,
-                                           destination_name,
-                                           dest_vm_image,
-                                           *config->ssh_key_provider,
-                                           *this);
+
+        auto copy_progress = [server, last_percent = -1](std::uint64_t copied,
+                                                         std::uint64_t total) mutable {
+            const auto percent = total ? static_cast<int>(copied * 100 / total) : 100;
+            if (percent != std::exchange(last_percent, percent))
+            {
+                CloneReply reply;
+                reply.set_percent_copied(percent);
+                server->Write(reply);
+            }
+        };
+        {
+            std::lock_guard lock{factory_mutex};
+            operative_instances[destination_name] =
+                config->factory->clone_bare_vm(src_spec,
+                                               dest_spec,
+                                               source_name,
+                                               destination_name,
+                                               dest_vm_image,
+                                               *config->ssh_key_provider,
+                                               *this,
+                                               copy_progress);
+        }
         ++src_spec.clone_count;
         // preparing instance is done
         preparing_instances.erase(destination_name);
@@ -2852,6 +3111,25 @@ try
     response.set_cpus(MP_PLATFORM.get_cpus());
     response.set_memory(MP_PLATFORM.get_total_ram());
 
+    const auto maintenance = image_maintenance->status();
+    auto maintenance_info = response.mutable_image_maintenance();
+    switch (maintenance.state)
+    {
+    case ImageMaintenance::State::idle:
+        maintenance_info->set_state(ImageMaintenanceInfo::IDLE);
+        break;
+    case ImageMaintenance::State::waiting:
+        maintenance_info->set_state(ImageMaintenanceInfo::WAITING);
+        break;
+    case ImageMaintenance::State::running:
+        maintenance_info->set_state(ImageMaintenanceInfo::RUNNING);
+        break;
+    }
+    maintenance_info->set_step(maintenance.step);
+    maintenance_info->set_progress(maintenance.progress);
+    maintenance_info->set_steps_left(maintenance.steps_left);
+    maintenance_info->set_waiting_on(maintenance.holds);
+
     server->Write(response);
     context->set_value(grpc::Status{});
 }
@@ -2991,6 +3269,7 @@ void mp::Daemon::on_restart(const std::string& name)
 void mp::Daemon::persist_state_for(const std::string& name, const VirtualMachine::State& state)
 {
     vm_instance_specs[name].state = state;
+    update_instance_state_metric(name, state);
     persist_instances();
 }
 
@@ -3003,9 +3282,144 @@ void mp::Daemon::update_metadata_for(const std::string& name, const boost::json:
 
 boost::json::object mp::Daemon::retrieve_metadata_for(const std::string& name)
 {
+    {
+        // Instances that are being loaded in the background ask for theirs from other threads
+        std::lock_guard lock{loading_metadata_mutex};
+        if (auto it = loading_metadata.find(name); it != loading_metadata.end())
+            return it->second;
+    }
+
     return vm_instance_specs[name].metadata;
 }
 
+void mp::Daemon::when_instances_loaded(std::function<void()> action,
+                                       std::function<void()> give_up)
+{
+    if (loading_instances.empty())
+        return action();
+
+    const auto id = next_deferred_id++;
+    deferred_until_loaded.emplace(id, std::move(action));
+
+    if (give_up)
+        QTimer::singleShot(deferred_request_timeout,
+                           this,
+                           [this, id, give_up = std::move(give_up)] {
+                               if (deferred_until_loaded.erase(id))
+                                   give_up();
+                           });
+}
+
+mp::VirtualMachine::UPtr mp::Daemon::create_instance(const VirtualMachineDescription& desc,
+                                                     VMStatusMonitor& monitor)
+{
+    std::lock_guard lock{factory_mutex};
+    return config->factory->create_virtual_machine(desc, *config->ssh_key_provider, monitor);
+}
+
+mp::VirtualMachine::ShPtr mp::Daemon::load_instance(const VirtualMachineDescription& desc)
+{
+    // Only the creation is serialised; snapshots are read from each instance's own files
+    VirtualMachine::ShPtr instance = create_instance(desc, *this);
+    instance->load_snapshots();
+
+    return instance;
+}
+
+mp::Daemon::LoadedInstance mp::Daemon::load_instance_in_background(
+    const VirtualMachineDescription& desc,
+    QThread* daemon_thread)
+{
+    LoadedInstance loaded{desc.vm_name, nullptr, {}};
+    try
+    {
+        loaded.instance = load_instance(desc);
+
+        // Instances that are QObjects need to get their signals on the daemon thread, like the
+        // ones created there
+        if (auto object = dynamic_cast<QObject*>(loaded.instance.get()))
+            object->moveToThread(daemon_thread);
+    }
+    catch (const std::exception& e)
+    {
+        loaded.error = e.what();
+    }
+
+    return loaded;
+}
+
+void mp::Daemon::finish_loading_instance(const LoadedInstance& loaded)
+{
+    {
+        std::lock_guard lock{loading_metadata_mutex};
+        loading_metadata.erase(loaded.name);
+    }
+    loading_instances.erase(loaded.name);
+
+    if (loaded.instance)
+        mp::top_catch_all(loaded.name,
+                          [this, &loaded] { install_instance(loaded.name, loaded.instance); });
+    else // the instance stays on record, to be tried again on the next start
+    {
+        mpl::error(category, "Could not load {}: {}", loaded.name, loaded.error);
+        unloaded_instances.insert(loaded.name);
+    }
+    preparing_instances.erase(loaded.name);
+
+    if (loading_instances.empty())
+    {
+        mpl::info(category, "Finished loading instances");
+        for (auto& [id, action] : std::exchange(deferred_until_loaded, {}))
+            action();
+    }
+}
+
+void mp::Daemon::install_instance(const std::string& name, VirtualMachine::ShPtr instance)
+{
+    using e_state = VirtualMachine::State;
+    const auto& spec = vm_instance_specs.at(name);
+
+    auto& instance_record = spec.deleted ? deleted_instances : operative_instances;
+    instance_record[name] = std::move(instance);
+
+    if (!spec.deleted)
+        init_mounts(name);
+    std::unique_lock lock{start_mutex};
+
+    if (spec.state == e_state::running)
+    {
+        // If the VM was in running state before, we need to do some additional
+        // work to ensure everything is in sync.
+        switch (operative_instances[name]->current_state())
+        {
+        case e_state::running:
+        case e_state::starting:
+        {
+            mpl::info(category, "{} needs syncing. Syncing now...", name);
+            // We don't need to start the instance, but we need to ensure that
+            // the daemon side resources for the VM are initialized.
+            multipass::top_catch_all(name, [this, &name, &lock] {
+                lock.unlock();
+                on_restart(name);
+            });
+        }
+        break;
+        default:
+        {
+            assert(!spec.deleted);
+            mpl::info(category, "{} needs starting. Starting now...", name);
+
+            multipass::top_catch_all(name, [this, &name, &lock]() {
+                operative_instances[name]->start();
+                lock.unlock();
+                on_restart(name);
+            });
+        }
+        break;
+        }
+    }
+}
+
 void mp::Daemon::persist_instances()
 {
     auto instance_records_json = boost::json::value_from(vm_instance_specs);
@@ -3019,6 +3433,7 @@ void mp::Daemon::release_resources(const std::string& instance)
 {
     config->vault->remove(instance);
     config->factory->remove_resources_for(instance);
+    update_instance_state_metric(instance, std::nullopt);
 
     auto spec_it = vm_instance_specs.find(instance);
     if (spec_it != cend(vm_instance_specs))
@@ -3061,8 +3476,22 @@ void mp::Daemon::create_vm(const CreateRequest* request,
                                                create_error.SerializeAsString()});
     }
 
+    auto timeout = timeout_for(request->timeout());
+
+    if (warm_pool && start && fits_pooled_instance(*request))
+        if (auto pooled = warm_pool->claim_instance(query_from(request, "")))
+            return launch_pooled_instance(std::move(*pooled),
+                                          server,
+                                          context,
+                                          timeout,
+                                          request->timings());
+
     auto name = name_from(checked_args.instance_name, *config->name_generator, operative_instances);
 
+    // A pooled instance that happens to go by the requested name makes way for it
+    if (warm_pool && warm_pool->holds(name))
+        warm_pool->discard_instance(name);
+
     auto zone_name = checked_args.zone_name.empty() ? config->az_manager->get_automatic_zone_name()
                                                     : checked_args.zone_name;
 
@@ -3083,15 +3512,24 @@ void mp::Daemon::create_vm(const CreateRequest* request,
     if (!instances_running(operative_instances))
         config->factory->hypervisor_health_check();
 
-    auto timeout = timeout_for(request->timeout());
-
     preparing_instances.insert(name);
+    MP_TRACER.take(name); // drop whatever is left over from earlier attempts under this name
+    // Image maintenance holds off for as long as the lambdas below keep this
+    auto maintenance_hold = image_maintenance->hold();
 
     auto prepare_future_watcher = new QFutureWatcher<mp::VirtualMachineDescription>();
 
     QObject::connect(prepare_future_watcher,
                      &QFutureWatcher<mp::VirtualMachineDescription>::finished,
-                     [this, server, context, name, timeout, start, prepare_future_watcher] {
+                     [this,
+                      server,
+                      context,
+                      name,
+                      timeout,
+                      start,
+                      timings = request->timings(),
+                      prepare_future_watcher,
+                      maintenance_hold] {
                          // Per-RPC ClientLogger lifecycle is managed by DaemonRpcContextImpl.
 
                          try
@@ -3112,10 +3550,7 @@ void mp::Daemon::create_vm(const CreateRequest* request,
                                  0,
                                  vm_desc.zone,
                              };
-                             operative_instances[name] =
-                                 config->factory->create_virtual_machine(vm_desc,
-                                                                         *config->ssh_key_provider,
-                                                                         *this);
+                             operative_instances[name] = create_instance(vm_desc, *this);
                              preparing_instances.erase(name);
 
                              persist_instances();
@@ -3126,27 +3561,19 @@ void mp::Daemon::create_vm(const CreateRequest* request,
                                  reply.set_create_message("Starting " + name);
                                  server->Write(reply);
 
-                                 operative_instances[name]->start();
-
-                                 auto future_watcher = create_future_watcher(
-                                     [this, server, name, zone = vm_desc.zone] {
-                                         LaunchReply reply;
-                                         reply.set_vm_instance_name(name);
-                                         config->update_prompt->populate_if_time_to_show(
-                                             reply.mutable_update_info());
-
-                                         reply.set_zone(zone);
-                                         server->Write(reply);
-                                     });
-                                 future_watcher->setFuture(QtConcurrent::run(
-                                     &Daemon::async_wait_for_ready_all<LaunchReply, LaunchRequest>,
-                                     this,
-                                     server,
-                                     std::vector<std::string>{name},
-                                     timeout,
-                                     context,
-                                     std::string(),
-                                     std::string()));
+                                 {
+                                     mpt::TraceScope trace{name};
+                                     mpt::ScopedSpan span{"start instance"};
+                                     operative_instances[name]->start();
+                                 }
+
+                                 reply_when_launched(server,
+                                                     context,
+                                                     name,
+                                                     vm_desc.zone,
+                                                     timeout,
+                                                     timings,
+                                                     maintenance_hold);
                              }
                              else
                              {
@@ -3173,6 +3600,9 @@ void mp::Daemon::create_vm(const CreateRequest* request,
         -> mp::VirtualMachineDescription {
         try
         {
+            mpt::TraceScope trace{name};
+            mpt::ScopedSpan span{"create instance"};
+
             CreateReply reply;
             reply.set_create_message(fmt::format("Creating {} in {}", name, zone_name));
             server->Write(reply);
@@ -3201,6 +3631,12 @@ void mp::Daemon::create_vm(const CreateRequest* request,
             query = query_from(request, name);
             vm_desc.mem_size = checked_args.mem_size;
 
+            if (warm_pool && warm_pool->claim(query))
+            {
+                reply.set_create_message("Using a prepared image for " + name);
+                server->Write(reply);
+            }
+
             auto progress_monitor = [server](int progress_type, int percentage) {
                 CreateReply create_reply;
                 create_reply.mutable_launch_progress()->set_percent_complete(
@@ -3215,6 +3651,7 @@ void mp::Daemon::create_vm(const CreateRequest* request,
                 reply.set_create_message("Preparing image for " + name);
                 server->Write(reply);
 
+                mpt::ScopedSpan span{"prepare image"};
                 return config->factory->prepare_source_image(source_image);
             };
 
@@ -3222,12 +3659,15 @@ void mp::Daemon::create_vm(const CreateRequest* request,
             if (!vm_desc.image.id.empty())
                 checksum = vm_desc.image.id;
 
-            auto vm_image = config->vault->fetch_image(
-                query,
-                prepare_action,
-                progress_monitor,
-                checksum,
-                config->factory->get_instance_directory(name));
+            auto vm_image = [&] {
+                mpt::ScopedSpan span{"fetch image"};
+                span.add_attribute("image", query.release);
+                return config->vault->fetch_image(query,
+                                                  prepare_action,
+                                                  progress_monitor,
+                                                  checksum,
+                                                  config->factory->get_instance_directory(name));
+            }();
 
             const auto image_size = config->vault->minimum_image_size_for(vm_image.id);
             vm_desc.disk_space = compute_final_image_size(
@@ -3271,8 +3711,14 @@ void mp::Daemon::create_vm(const CreateRequest* request,
                                                     checked_args.extra_interfaces);
 
             vm_desc.image = vm_image;
-            config->factory->configure(vm_desc);
-            config->factory->prepare_instance_image(vm_image, vm_desc);
+            {
+                mpt::ScopedSpan span{"write cloud-init"};
+                config->factory->configure(vm_desc);
+            }
+            {
+                mpt::ScopedSpan span{"resize image"};
+                config->factory->prepare_instance_image(vm_image, vm_desc);
+            }
 
             // Everything went well, add the MAC addresses used in this instance.
             allocated_mac_addrs = std::move(new_macs);
@@ -3288,6 +3734,259 @@ void mp::Daemon::create_vm(const CreateRequest* request,
     prepare_future_watcher->setFuture(QtConcurrent::run(make_vm_description));
 }
 
+void mp::Daemon::reply_when_launched(
+    grpc::ServerReaderWriterInterface<LaunchReply, LaunchRequest>* server,
+    DaemonRpcContext* context,
+    const std::string& name,
+    const std::string& zone,
+    const std::chrono::seconds& timeout,
+    bool timings,
+    ImageMaintenance::Hold maintenance_hold)
+{
+    auto future_watcher =
+        create_future_watcher([this, server, name, timings, zone, maintenance_hold] {
+            LaunchReply reply;
+            reply.set_vm_instance_name(name);
+            config->update_prompt->populate_if_time_to_show(reply.mutable_update_info());
+
+            reply.set_zone(zone);
+            if (timings)
+                add_launch_timings(reply, MP_TRACER.take(name));
+            server->Write(reply);
+        });
+    future_watcher->setFuture(
+        QtConcurrent::run(&Daemon::async_wait_for_ready_all<LaunchReply, LaunchRequest>,
+                          this,
+                          server,
+                          std::vector<std::string>{name},
+                          timeout,
+                          context,
+                          std::string(),
+                          std::string()));
+}
+
+void mp::Daemon::launch_pooled_instance(
+    WarmPool::Instance pooled,
+    grpc::ServerReaderWriterInterface<LaunchReply, LaunchRequest>* server,
+    DaemonRpcContext* context,
+    const std::chrono::seconds& timeout,
+    bool timings)
+{
+    const auto name = pooled.name;
+    const auto& desc = pooled.desc;
+    MP_TRACER.take(name);
+
+    try
+    {
+        mpt::TraceScope trace{name};
+
+        // The instance was booted and suspended under the pool's watch; it is recreated here to
+        // report to the daemon, with the suspension metadata it left with the pool
+        vm_instance_specs[name] = {
+            desc.num_cores,
+            desc.mem_size,
+            desc.disk_space,
+            desc.default_mac_address,
+            desc.extra_interfaces,
+            config->ssh_username,
+            VirtualMachine::State::suspended,
+            {},
+            false,
+            std::move(pooled.metadata),
+            0,
+            desc.zone,
+        };
+        operative_instances[name] = create_instance(desc, *this);
+        persist_instances();
+
+        LaunchReply reply;
+        reply.set_create_message("Resuming " + name);
+        server->Write(reply);
+
+        {
+            mpt::ScopedSpan span{"resume instance"};
+            operative_instances[name]->start();
+        }
+
+        reply_when_launched(server, context, name, desc.zone, timeout, timings, nullptr);
+    }
+    catch (const std::exception& e)
+    {
+        mp::top_catch_all(category, [this, &name]() {
+            release_resources(name);
+            operative_instances.erase(name);
+            persist_instances();
+        });
+
+        context->set_value(grpc::Status(grpc::StatusCode::FAILED_PRECONDITION, e.what(), ""));
+    }
+}
+
+// Boots the prepared image pooled_name under a name of its own, with the default resources and
+// configuration, and suspends it once it is up, to hand it back to the warm pool
+void mp::Daemon::boot_pooled_instance(const std::string& pooled_name, const Query& query)
+{
+    std::string name, mac, zone;
+    try
+    {
+        static constexpr auto max_tries = 20;
+        for (auto i = 0; name.empty(); ++i)
+        {
+            auto candidate = config->name_generator->make_name();
+            if (!vm_instance_specs.count(candidate) && !operative_instances.count(candidate) &&
+                !deleted_instances.count(candidate) && !preparing_instances.count(candidate) &&
+                !warm_pool->holds(candidate) &&
+                !QFileInfo::exists(config->factory->get_instance_directory(candidate)))
+                name = std::move(candidate);
+            else if (i == max_tries)
+                throw std::runtime_error{"could not generate an unused name"};
+        }
+
+        mac = generate_unused_mac_address(allocated_mac_addrs);
+        zone = config->az_manager->get_automatic_zone_name();
+    }
+    catch (const std::exception& e)
+    {
+        mpl::warn(category, "Could not boot an instance for the warm pool: {}", e.what());
+        allocated_mac_addrs.erase(mac);
+        warm_pool->boot_failed(pooled_name);
+        return;
+    }
+
+    preparing_instances.insert(name);
+
+    auto abandon = [this, pooled_name, name, mac](const std::string& error) {
+        mpl::warn(category, "Could not boot {} for the warm pool: {}", name, error);
+        mp::top_catch_all(category, [this, &name] {
+            config->factory->remove_resources_for(name);
+            config->vault->remove(name);
+            QDir{config->factory->get_instance_directory(name)}.removeRecursively();
+        });
+
+        allocated_mac_addrs.erase(mac);
+        preparing_instances.erase(name);
+        warm_pool->boot_failed(pooled_name);
+    };
+
+    using Described = std::variant<VirtualMachineDescription, std::string>;
+    auto describe_watcher = new QFutureWatcher<Described>();
+    QObject::connect(describe_watcher, &QFutureWatcher<Described>::finished, this, [=, this] {
+        describe_watcher->deleteLater();
+
+        auto described = describe_watcher->result();
+        if (const auto* error = std::get_if<std::string>(&described))
+            return abandon(*error);
+
+        const auto& desc = std::get<VirtualMachineDescription>(described);
+        VirtualMachine::ShPtr instance;
+        try
+        {
+            instance = create_instance(desc, *warm_pool);
+            instance->start();
+        }
+        catch (const std::exception& e)
+        {
+            return abandon(e.what());
+        }
+
+        auto boot_watcher = new QFutureWatcher<std::string>();
+        QObject::connect(boot_watcher, &QFutureWatcher<std::string>::finished, this, [=, this] {
+            boot_watcher->deleteLater();
+
+            auto error = boot_watcher->result();
+            if (error.empty())
+                try
+                {
+                    instance->suspend();
+                }
+                catch (const std::exception& e)
+                {
+                    error = e.what();
+                }
+
+            if (!error.empty())
+            {
+                mp::top_catch_all(name, [&instance] {
+                    instance->shutdown(VirtualMachine::ShutdownPolicy::Poweroff);
+                });
+                return abandon(error);
+            }
+
+            preparing_instances.erase(name);
+            warm_pool->booted(pooled_name, {name, desc, {}});
+        });
+        boot_watcher->setFuture(QtConcurrent::run([instance]() -> std::string {
+            try
+            {
+                instance->wait_until_ssh_up(mp::default_timeout);
+                instance->wait_for_cloud_init(mp::default_timeout);
+                return {};
+            }
+            catch (const std::exception& e)
+            {
+                return e.what();
+            }
+        }));
+    });
+
+    describe_watcher->setFuture(QtConcurrent::run([this, pooled_name, query, name, mac, zone]() {
+        try
+        {
+            if (!warm_pool->hand_over(pooled_name, name))
+                throw std::runtime_error{"could not take over " + pooled_name};
+
+            CreateRequest request;
+            request.set_image(query.release);
+            request.set_remote_name(query.remote_name);
+            request.set_time_zone(QTimeZone::systemTimeZoneId().toStdString());
+
+            VirtualMachineDescription desc{
+                std::stoi(mp::default_cpu_cores),
+                MemorySize{mp::default_memory_size},
+                MemorySize{},
+                name,
+                zone,
+                mac,
+                {},
+                config->ssh_username,
+                VMImage{},
+                "",
+                mpu::make_cloud_init_meta_config(name),
+                YAML::Node{},
+                make_cloud_init_vendor_config(
+                    *config->ssh_key_provider,
+                    config->ssh_username,
+                    config->factory->get_backend_version_string().toStdString(),
+                    &request),
+                mpu::make_cloud_init_network_config(mac, {})};
+            prepare_user_data(desc.user_data_config, desc.vendor_data_config);
+
+            // The prepared image is in place already, so this only records it in the vault
+            desc.image = config->vault->fetch_image(
+                query,
+                [this](const VMImage& source) {
+                    return config->factory->prepare_source_image(source);
+                },
+                [](int, int) { return true; },
+                std::nullopt,
+                config->factory->get_instance_directory(name));
+            desc.disk_space =
+                compute_final_image_size(config->vault->minimum_image_size_for(desc.image.id),
+                                         MemorySize{mp::default_disk_size},
+                                         config->data_directory);
+
+            config->factory->configure(desc);
+            config->factory->prepare_instance_image(desc.image, desc);
+
+            return Described{std::move(desc)};
+        }
+        catch (const std::exception& e)
+        {
+            return Described{std::string{e.what()}};
+        }
+    }));
+}
+
 bool mp::Daemon::delete_vm(InstanceTable::iterator vm_it, bool purge, DeleteReply& response)
 {
     auto& [name, instance] = *vm_it;
@@ -3532,7 +4231,16 @@ error_string mp::Daemon::async_wait_for_ssh_and_start_mounts_for(
             return fmt::to_string(errors);
         }
         const auto vm = it->second;
-        vm->wait_until_ssh_up(timeout);
+
+        // Only launches are traced, the other commands waiting here have nobody to report to
+        std::optional<mpt::TraceScope> trace;
+        if constexpr (std::is_same_v<Reply, LaunchReply>)
+            trace.emplace(name);
+
+        {
+            mpt::ScopedSpan span{"wait for ssh"};
+            vm->wait_until_ssh_up(timeout);
+        }
 
         if (std::is_same<Reply, LaunchReply>::value)
         {
@@ -3543,6 +4251,7 @@ error_string mp::Daemon::async_wait_for_ssh_and_start_mounts_for(
                 server->Write(reply);
             }
 
+            mpt::ScopedSpan span{"wait for cloud-init"};
             vm->wait_for_cloud_init(timeout);
         }
 
@@ -3747,22 +4456,9 @@ void mp::Daemon::populate_instance_info(VirtualMachine& vm,
     else
         info->mutable_instance_status()->set_status(grpc_instance_status_for(present_state));
 
-    auto vm_image = fetch_image_for(name, *config->factory, *config->vault);
-    auto original_release = vm_image.original_release;
-    auto os = vm_image.os;
-
-    if (!vm_image.id.empty() && original_release.empty())
-    {
-        try
-        {
-            auto vm_image_info = config->image_hosts.back()->info_for_full_hash(vm_image.id);
-            original_release = vm_image_info.release_title;
-        }
-        catch (const std::exception& e)
-        {
-            mpl::warn(category, "Cannot fetch image information: {}", e.what());
-        }
-    }
+    const auto vm_image = fetch_image_for(name, *config->factory, *config->vault);
+    const auto& original_release = vm_image.original_release;
+    const auto& os = vm_image.os;
 
     try
     {
@@ -19,24 +19,33 @@
 
 #include "daemon_config.h"
 #include "daemon_rpc.h"
+#include "image_maintenance.h"
+#include "metrics_server.h"
+#include "warm_pool.h"
 
 #include <multipass/async_periodic_download_task.h>
 #include <multipass/delayed_shutdown_timer.h>
 #include <multipass/format.h>
 #include <multipass/mount_handler.h>
 #include <multipass/virtual_machine.h>
+#include <multipass/virtual_machine_description.h>
 #include <multipass/vm_specs.h>
 #include <multipass/vm_status_monitor.h>
 
 #include <chrono>
+#include <cstdint>
+#include <functional>
 #include <future>
+#include <map>
 #include <memory>
 #include <mutex>
+#include <string>
 #include <unordered_map>
 #include <unordered_set>
 #include <vector>
 
 #include <QFutureWatcher>
+#include <QThread>
 
 namespace multipass
 {
@@ -53,6 +62,11 @@ public:
 
     void persist_instances();
 
+    // Runs the action once all instances are loaded, straight away if they already are. If loading
+    // takes too long, give_up runs instead, when given
+    void when_instances_loaded(std::function<void()> action,
+                               std::function<void()> give_up = nullptr);
+
 protected:
     using InstanceTable = std::unordered_map<std::string, VirtualMachine::ShPtr>;
 
@@ -183,11 +197,40 @@ public slots:
         DaemonRpcContext* context);
 
 private:
+    struct LoadedInstance
+    {
+        std::string name;
+        VirtualMachine::ShPtr instance; // null if loading failed
+        std::string error;
+    };
+
+    VirtualMachine::UPtr create_instance(const VirtualMachineDescription& desc,
+                                         VMStatusMonitor& monitor);
+    VirtualMachine::ShPtr load_instance(const VirtualMachineDescription& desc);
+    LoadedInstance load_instance_in_background(const VirtualMachineDescription& desc,
+                                               QThread* daemon_thread);
+    void finish_loading_instance(const LoadedInstance& loaded);
+    void install_instance(const std::string& name, VirtualMachine::ShPtr instance);
+
     void release_resources(const std::string& instance);
     void create_vm(const CreateRequest* request,
                    grpc::ServerReaderWriterInterface<CreateReply, CreateRequest>* server,
                    DaemonRpcContext* context,
                    bool start);
+    void reply_when_launched(grpc::ServerReaderWriterInterface<LaunchReply, LaunchRequest>* server,
+                             DaemonRpcContext* context,
+                             const std::string& name,
+                             const std::string& zone,
+                             const std::chrono::seconds& timeout,
+                             bool timings,
+                             ImageMaintenance::Hold maintenance_hold);
+    void launch_pooled_instance(
+        WarmPool::Instance pooled,
+        grpc::ServerReaderWriterInterface<LaunchReply, LaunchRequest>* server,
+        DaemonRpcContext* context,
+        const std::chrono::seconds& timeout,
+        bool timings);
+    void boot_pooled_instance(const std::string& pooled_name, const Query& query);
     bool delete_vm(InstanceTable::iterator vm_it, bool purge, DeleteReply& response);
     grpc::Status reboot_vm(VirtualMachine& vm);
     grpc::Status shutdown_vm(VirtualMachine& vm, const std::chrono::milliseconds delay);
@@ -285,10 +328,24 @@ private:
     std::unordered_map<std::string, QFuture<std::string>> async_running_futures;
     std::mutex start_mutex;
     std::unordered_set<std::string> preparing_instances;
-    QFuture<void> image_update_future;
     SettingsHandler* instance_mod_handler;
     SettingsHandler* snapshot_mod_handler;
     std::unordered_map<std::string, std::unordered_map<std::string, MountHandler::UPtr>> mounts;
     std::unordered_set<std::string> user_authorized_bridges;
+    std::unique_ptr<WarmPool> warm_pool;
+    std::unique_ptr<ImageMaintenance> image_maintenance; // after the warm pool, which it uses
+    std::unique_ptr<MetricsServer> metrics_server;
+    // Instances on record whose VMs are still being loaded in the background
+    std::unordered_set<std::string> loading_instances;
+    std::unordered_map<std::string, boost::json::object> loading_metadata;
+    std::mutex loading_metadata_mutex;
+    // Factories keep state of their own that is not safe to change from several threads at once,
+    // and instances are loaded on the global thread pool
+    std::mutex factory_mutex;
+    // Instances on record whose VMs could not be loaded, to be tried again on the next start
+    std::unordered_set<std::string> unloaded_instances;
+    std::map<std::uint64_t, std::function<void()>> deferred_until_loaded; // in arrival order
+    std::uint64_t next_deferred_id{0};
+    QFutureWatcher<LoadedInstance> instance_loader;
 };
 } // namespace multipass
@@ -107,7 +107,12 @@ std::unique_ptr<const mp::DaemonConfig> mp::DaemonConfigBuilder::build()
     if (logger == nullptr)
         logger = std::make_unique<mpl::StandardLogger>(verbosity_level);
 
-    auto multiplexing_logger = std::make_shared<mpl::MultiplexingLogger>(std::move(logger));
+    auto multiplexing_logger =
+        async_logging
+            ? std::make_shared<mpl::MultiplexingLogger>(
+                  std::move(logger),
+                  mpl::MultiplexingLogger::AsyncOptions{.overflow = *async_logging})
+            : std::make_shared<mpl::MultiplexingLogger>(std::move(logger));
     mpl::set_logger(multiplexing_logger);
 
     MP_UTILS.make_dir(QString::fromStdU16String(MP_PLATFORM.get_root_cert_dir().u16string()),
@@ -165,7 +170,8 @@ std::unique_ptr<const mp::DaemonConfig> mp::DaemonConfigBuilder::build()
                  UbuntuVMImageRemote{"https://cdimage.ubuntu.com/",
                                      "ubuntu-core/",
                                      mp::image_mutators::core_mutator}}},
-            url_downloader.get()));
+            url_downloader.get(),
+            MP_UTILS.make_dir(cache_directory, "manifests")));
     }
     if (vault == nullptr)
     {
@@ -238,5 +244,8 @@ std::unique_ptr<const mp::DaemonConfig> mp::DaemonConfigBuilder::build()
                                                                 data_directory,
                                                                 server_address,
                                                                 ssh_username,
-                                                                image_refresh_timer});
+                                                                image_refresh_timer,
+                                                                std::move(warm_pool_profiles),
+                                                                metrics_port,
+                                                                load_instances_in_background});
 }
@@ -17,6 +17,8 @@
 
 #pragma once
 
+#include "warm_pool.h"
+
 #include <multipass/availability_zone_manager.h>
 #include <multipass/cert_provider.h>
 #include <multipass/cert_store.h>
@@ -36,6 +38,7 @@
 #include <QNetworkProxy>
 
 #include <memory>
+#include <optional>
 #include <vector>
 
 namespace multipass
@@ -60,6 +63,9 @@ struct DaemonConfig
     const std::string server_address;
     const std::string ssh_username;
     const std::chrono::hours image_refresh_timer;
+    const std::vector<WarmPoolProfile> warm_pool_profiles;
+    const quint16 metrics_port;
+    const bool load_instances_in_background;
 };
 
 struct DaemonConfigBuilder
@@ -83,6 +89,12 @@ struct DaemonConfigBuilder
     multipass::days days_to_expire{14};
     std::chrono::hours image_refresh_timer{6};
     multipass::logging::Level verbosity_level{multipass::logging::Level::info};
+    // Log from a background thread, with the given policy for when it falls behind; off if unset
+    std::optional<logging::MultiplexingLogger::OverflowPolicy> async_logging;
+    std::vector<WarmPoolProfile> warm_pool_profiles;
+    quint16 metrics_port{0}; // 0 to disable metrics
+    // Serve requests while instances are still being loaded, rather than after
+    bool load_instances_in_background{false};
 
     std::unique_ptr<const DaemonConfig> build();
 };
@@ -16,8 +16,11 @@
  */
 
 #include "daemon_init_settings.h"
+#include "warm_pool.h"
 
 #include <multipass/constants.h>
+#include <multipass/exceptions/invalid_memory_size_exception.h>
+#include <multipass/memory_size.h>
 #include <multipass/platform.h>
 #include <multipass/settings/basic_setting_spec.h>
 #include <multipass/settings/bool_setting_spec.h>
@@ -92,6 +95,57 @@ QString image_mirror_interpreter(QString val)
     return val;
 }
 
+QString warm_pool_interpreter(QString val)
+{
+    try
+    {
+        mp::parse_warm_pool_profiles(val);
+    }
+    catch (const std::invalid_argument& e)
+    {
+        throw mp::InvalidSettingException(mp::warm_pool_key, val, e.what());
+    }
+
+    return val;
+}
+
+QString metrics_port_interpreter(QString val)
+{
+    auto ok = false;
+    if (const auto port = val.toInt(&ok); !ok || port < 0 || port > 65535)
+        throw mp::InvalidSettingException(mp::metrics_port_key,
+                                          val,
+                                          "Expected a port number, or 0 to disable metrics");
+
+    return val;
+}
+
+QString image_bandwidth_limit_interpreter(QString val)
+{
+    try
+    {
+        mp::MemorySize{val.toStdString()};
+    }
+    catch (const mp::InvalidMemorySizeException&)
+    {
+        throw mp::InvalidSettingException(mp::image_bandwidth_limit_key,
+                                          val,
+                                          "Expected a size per second, or 0 for no limit");
+    }
+
+    return val;
+}
+
+QString suspend_mode_interpreter(QString val)
+{
+    if (val != "snapshot" && val != "file")
+        throw mp::InvalidSettingException(mp::suspend_mode_key,
+                                          val,
+                                          "Expected \"snapshot\" or \"file\"");
+
+    return val;
+}
+
 } // namespace
 
 void mp::daemon::monitor_and_quit_on_settings_change() // temporary
@@ -123,6 +177,16 @@ void mp::daemon::register_global_settings_handlers()
     }));
     settings.insert(
         std::make_unique<CustomSettingSpec>(mp::mirror_key, "", image_mirror_interpreter));
+    settings.insert(
+        std::make_unique<CustomSettingSpec>(mp::warm_pool_key, "", warm_pool_interpreter));
+    settings.insert(
+        std::make_unique<CustomSettingSpec>(mp::metrics_port_key, "0", metrics_port_interpreter));
+    settings.insert(std::make_unique<CustomSettingSpec>(mp::suspend_mode_key,
+                                                        "snapshot",
+                                                        suspend_mode_interpreter));
+    settings.insert(std::make_unique<CustomSettingSpec>(mp::image_bandwidth_limit_key,
+                                                        "0",
+                                                        image_bandwidth_limit_interpreter));
 
     MP_SETTINGS.register_handler(
         std::make_unique<PersistentSettingsHandler>(persistent_settings_filename(),
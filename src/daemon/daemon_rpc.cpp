@@ -20,14 +20,18 @@
 #include <multipass/daemon_rpc_context.h>
 #include <multipass/format.h>
 #include <multipass/logging/log.h>
+#include <multipass/metrics.h>
 #include <multipass/platform.h>
 #include <multipass/utils.h>
 
+#include <array>
 #include <chrono>
 #include <stdexcept>
+#include <unordered_map>
 
 namespace mp = multipass;
 namespace mpl = multipass::logging;
+namespace mpm = multipass::metrics;
 
 namespace
 {
@@ -89,12 +93,47 @@ auto server_socket_type_for(const std::string& server_address)
 template <typename T>
 concept HasVerbosityLevel = requires(T t) { t.verbosity_level(); };
 
+std::string_view status_code_name(grpc::StatusCode code)
+{
+    static constexpr std::array<std::string_view, 17> names{"OK",
+                                                            "CANCELLED",
+                                                            "UNKNOWN",
+                                                            "INVALID_ARGUMENT",
+                                                            "DEADLINE_EXCEEDED",
+                                                            "NOT_FOUND",
+                                                            "ALREADY_EXISTS",
+                                                            "PERMISSION_DENIED",
+                                                            "RESOURCE_EXHAUSTED",
+                                                            "FAILED_PRECONDITION",
+                                                            "ABORTED",
+                                                            "OUT_OF_RANGE",
+                                                            "UNIMPLEMENTED",
+                                                            "INTERNAL",
+                                                            "UNAVAILABLE",
+                                                            "DATA_LOSS",
+                                                            "UNAUTHENTICATED"};
+
+    const auto index = static_cast<std::size_t>(code);
+    return index < names.size() ? names[index] : "UNKNOWN";
+}
+
 template <typename T, typename U, typename OperationSignal>
-grpc::Status emit_signal_and_wait_for_result(OperationSignal operation_signal,
+grpc::Status emit_signal_and_wait_for_result(const std::string& method,
+                                             OperationSignal operation_signal,
                                              grpc::ServerReaderWriterInterface<T, U>* server,
                                              U* request,
                                              mpl::MultiplexingLogger& mpx)
 {
+    // Cached per thread, so that handling an RPC takes no lock on the registry
+    thread_local std::unordered_map<std::string, mpm::Histogram*> durations;
+    auto& duration = durations[method];
+    if (!duration)
+        duration = &MP_METRICS.histogram(
+            "multipass_rpc_duration_seconds",
+            "Time taken to handle daemon RPCs, from request to final status",
+            {{"method", method}});
+
+    const mpm::ScopedTimer timer{*duration};
     auto level = [&request]() {
         if constexpr (HasVerbosityLevel<U>)
             return mpl::level_from(request->verbosity_level());
@@ -108,7 +147,15 @@ grpc::Status emit_signal_and_wait_for_result(OperationSignal operation_signal,
     emit operation_signal(request,
                           static_cast<grpc::ServerReaderWriter<T, U>*>(server),
                           static_cast<multipass::DaemonRpcContext*>(&ctx));
-    return future.get();
+
+    auto status = future.get();
+    MP_METRICS
+        .counter("multipass_rpc_requests_total",
+                 "Daemon RPCs handled, by method and status code",
+                 {{"method", method}, {"code", std::string{status_code_name(status.error_code())}}})
+        .increment();
+
+    return status;
 }
 
 std::string client_cert_from(grpc::ServerContext* context)
@@ -171,7 +218,8 @@ void mp::DaemonRpc::shutdown_and_wait()
 grpc::Status mp::DaemonRpc::create(grpc::ServerContext* context,
                                    grpc::ServerReaderWriter<CreateReply, CreateRequest>* server)
 {
-    return verify_client_and_dispatch_operation(std::bind(&DaemonRpc::on_create,
+    return verify_client_and_dispatch_operation("create",
+                                                std::bind(&DaemonRpc::on_create,
                                                           this,
                                                           std::placeholders::_1,
                                                           std::placeholders::_2,
@@ -183,7 +231,8 @@ grpc::Status mp::DaemonRpc::create(grpc::ServerContext* context,
 grpc::Status mp::DaemonRpc::launch(grpc::ServerContext* context,
                                    grpc::ServerReaderWriter<LaunchReply, LaunchRequest>* server)
 {
-    return verify_client_and_dispatch_operation(std::bind(&DaemonRpc::on_launch,
+    return verify_client_and_dispatch_operation("launch",
+                                                std::bind(&DaemonRpc::on_launch,
                                                           this,
                                                           std::placeholders::_1,
                                                           std::placeholders::_2,
@@ -195,7 +244,8 @@ grpc::Status mp::DaemonRpc::launch(grpc::ServerContext* context,
 grpc::Status mp::DaemonRpc::purge(grpc::ServerContext* context,
                                   grpc::ServerReaderWriter<PurgeReply, PurgeRequest>* server)
 {
-    return verify_client_and_dispatch_operation(std::bind(&DaemonRpc::on_purge,
+    return verify_client_and_dispatch_operation("purge",
+                                                std::bind(&DaemonRpc::on_purge,
                                                           this,
                                                           std::placeholders::_1,
                                                           std::placeholders::_2,
@@ -207,7 +257,8 @@ grpc::Status mp::DaemonRpc::purge(grpc::ServerContext* context,
 grpc::Status mp::DaemonRpc::find(grpc::ServerContext* context,
                                  grpc::ServerReaderWriter<FindReply, FindRequest>* server)
 {
-    return verify_client_and_dispatch_operation(std::bind(&DaemonRpc::on_find,
+    return verify_client_and_dispatch_operation("find",
+                                                std::bind(&DaemonRpc::on_find,
                                                           this,
                                                           std::placeholders::_1,
                                                           std::placeholders::_2,
@@ -219,7 +270,8 @@ grpc::Status mp::DaemonRpc::find(grpc::ServerContext* context,
 grpc::Status mp::DaemonRpc::info(grpc::ServerContext* context,
                                  grpc::ServerReaderWriter<InfoReply, InfoRequest>* server)
 {
-    return verify_client_and_dispatch_operation(std::bind(&DaemonRpc::on_info,
+    return verify_client_and_dispatch_operation("info",
+                                                std::bind(&DaemonRpc::on_info,
                                                           this,
                                                           std::placeholders::_1,
                                                           std::placeholders::_2,
@@ -231,7 +283,8 @@ grpc::Status mp::DaemonRpc::info(grpc::ServerContext* context,
 grpc::Status mp::DaemonRpc::list(grpc::ServerContext* context,
                                  grpc::ServerReaderWriter<ListReply, ListRequest>* server)
 {
-    return verify_client_and_dispatch_operation(std::bind(&DaemonRpc::on_list,
+    return verify_client_and_dispatch_operation("list",
+                                                std::bind(&DaemonRpc::on_list,
                                                           this,
                                                           std::placeholders::_1,
                                                           std::placeholders::_2,
@@ -243,7 +296,8 @@ grpc::Status mp::DaemonRpc::list(grpc::ServerContext* context,
 grpc::Status mp::DaemonRpc::clone(grpc::ServerContext* context,
                                   grpc::ServerReaderWriter<CloneReply, CloneRequest>* server)
 {
-    return verify_client_and_dispatch_operation(std::bind(&DaemonRpc::on_clone,
+    return verify_client_and_dispatch_operation("clone",
+                                                std::bind(&DaemonRpc::on_clone,
                                                           this,
                                                           std::placeholders::_1,
                                                           std::placeholders::_2,
@@ -256,7 +310,8 @@ grpc::Status mp::DaemonRpc::networks(
     grpc::ServerContext* context,
     grpc::ServerReaderWriter<NetworksReply, NetworksRequest>* server)
 {
-    return verify_client_and_dispatch_operation(std::bind(&DaemonRpc::on_networks,
+    return verify_client_and_dispatch_operation("networks",
+                                                std::bind(&DaemonRpc::on_networks,
                                                           this,
                                                           std::placeholders::_1,
                                                           std::placeholders::_2,
@@ -268,7 +323,8 @@ grpc::Status mp::DaemonRpc::networks(
 grpc::Status mp::DaemonRpc::mount(grpc::ServerContext* context,
                                   grpc::ServerReaderWriter<MountReply, MountRequest>* server)
 {
-    return verify_client_and_dispatch_operation(std::bind(&DaemonRpc::on_mount,
+    return verify_client_and_dispatch_operation("mount",
+                                                std::bind(&DaemonRpc::on_mount,
                                                           this,
                                                           std::placeholders::_1,
                                                           std::placeholders::_2,
@@ -280,7 +336,8 @@ grpc::Status mp::DaemonRpc::mount(grpc::ServerContext* context,
 grpc::Status mp::DaemonRpc::recover(grpc::ServerContext* context,
                                     grpc::ServerReaderWriter<RecoverReply, RecoverRequest>* server)
 {
-    return verify_client_and_dispatch_operation(std::bind(&DaemonRpc::on_recover,
+    return verify_client_and_dispatch_operation("recover",
+                                                std::bind(&DaemonRpc::on_recover,
                                                           this,
                                                           std::placeholders::_1,
                                                           std::placeholders::_2,
@@ -292,7 +349,8 @@ grpc::Status mp::DaemonRpc::recover(grpc::ServerContext* context,
 grpc::Status mp::DaemonRpc::ssh_info(grpc::ServerContext* context,
                                      grpc::ServerReaderWriter<SSHInfoReply, SSHInfoRequest>* server)
 {
-    return verify_client_and_dispatch_operation(std::bind(&DaemonRpc::on_ssh_info,
+    return verify_client_and_dispatch_operation("ssh_info",
+                                                std::bind(&DaemonRpc::on_ssh_info,
                                                           this,
                                                           std::placeholders::_1,
                                                           std::placeholders::_2,
@@ -304,7 +362,8 @@ grpc::Status mp::DaemonRpc::ssh_info(grpc::ServerContext* context,
 grpc::Status mp::DaemonRpc::start(grpc::ServerContext* context,
                                   grpc::ServerReaderWriter<StartReply, StartRequest>* server)
 {
-    return verify_client_and_dispatch_operation(std::bind(&DaemonRpc::on_start,
+    return verify_client_and_dispatch_operation("start",
+                                                std::bind(&DaemonRpc::on_start,
                                                           this,
                                                           std::placeholders::_1,
                                                           std::placeholders::_2,
@@ -316,7 +375,8 @@ grpc::Status mp::DaemonRpc::start(grpc::ServerContext* context,
 grpc::Status mp::DaemonRpc::stop(grpc::ServerContext* context,
                                  grpc::ServerReaderWriter<StopReply, StopRequest>* server)
 {
-    return verify_client_and_dispatch_operation(std::bind(&DaemonRpc::on_stop,
+    return verify_client_and_dispatch_operation("stop",
+                                                std::bind(&DaemonRpc::on_stop,
                                                           this,
                                                           std::placeholders::_1,
                                                           std::placeholders::_2,
@@ -328,7 +388,8 @@ grpc::Status mp::DaemonRpc::stop(grpc::ServerContext* context,
 grpc::Status mp::DaemonRpc::suspend(grpc::ServerContext* context,
                                     grpc::ServerReaderWriter<SuspendReply, SuspendRequest>* server)
 {
-    return verify_client_and_dispatch_operation(std::bind(&DaemonRpc::on_suspend,
+    return verify_client_and_dispatch_operation("suspend",
+                                                std::bind(&DaemonRpc::on_suspend,
                                                           this,
                                                           std::placeholders::_1,
                                                           std::placeholders::_2,
@@ -340,7 +401,8 @@ grpc::Status mp::DaemonRpc::suspend(grpc::ServerContext* context,
 grpc::Status mp::DaemonRpc::restart(grpc::ServerContext* context,
                                     grpc::ServerReaderWriter<RestartReply, RestartRequest>* server)
 {
-    return verify_client_and_dispatch_operation(std::bind(&DaemonRpc::on_restart,
+    return verify_client_and_dispatch_operation("restart",
+                                                std::bind(&DaemonRpc::on_restart,
                                                           this,
                                                           std::placeholders::_1,
                                                           std::placeholders::_2,
@@ -352,7 +414,8 @@ grpc::Status mp::DaemonRpc::restart(grpc::ServerContext* context,
 grpc::Status mp::DaemonRpc::delet(grpc::ServerContext* context,
                                   grpc::ServerReaderWriter<DeleteReply, DeleteRequest>* server)
 {
-    return verify_client_and_dispatch_operation(std::bind(&DaemonRpc::on_delete,
+    return verify_client_and_dispatch_operation("delete",
+                                                std::bind(&DaemonRpc::on_delete,
                                                           this,
                                                           std::placeholders::_1,
                                                           std::placeholders::_2,
@@ -364,7 +427,8 @@ grpc::Status mp::DaemonRpc::delet(grpc::ServerContext* context,
 grpc::Status mp::DaemonRpc::umount(grpc::ServerContext* context,
                                    grpc::ServerReaderWriter<UmountReply, UmountRequest>* server)
 {
-    return verify_client_and_dispatch_operation(std::bind(&DaemonRpc::on_umount,
+    return verify_client_and_dispatch_operation("umount",
+                                                std::bind(&DaemonRpc::on_umount,
                                                           this,
                                                           std::placeholders::_1,
                                                           std::placeholders::_2,
@@ -376,7 +440,8 @@ grpc::Status mp::DaemonRpc::umount(grpc::ServerContext* context,
 grpc::Status mp::DaemonRpc::version(grpc::ServerContext* context,
                                     grpc::ServerReaderWriter<VersionReply, VersionRequest>* server)
 {
-    return verify_client_and_dispatch_operation(std::bind(&DaemonRpc::on_version,
+    return verify_client_and_dispatch_operation("version",
+                                                std::bind(&DaemonRpc::on_version,
                                                           this,
                                                           std::placeholders::_1,
                                                           std::placeholders::_2,
@@ -402,7 +467,8 @@ grpc::Status mp::DaemonRpc::ping(grpc::ServerContext* context,
 grpc::Status mp::DaemonRpc::get(grpc::ServerContext* context,
                                 grpc::ServerReaderWriter<GetReply, GetRequest>* server)
 {
-    return verify_client_and_dispatch_operation(std::bind(&DaemonRpc::on_get,
+    return verify_client_and_dispatch_operation("get",
+                                                std::bind(&DaemonRpc::on_get,
                                                           this,
                                                           std::placeholders::_1,
                                                           std::placeholders::_2,
@@ -418,7 +484,8 @@ grpc::Status mp::DaemonRpc::authenticate(
     AuthenticateRequest request;
     server->Read(&request);
 
-    auto status = emit_signal_and_wait_for_result(std::bind(&DaemonRpc::on_authenticate,
+    auto status = emit_signal_and_wait_for_result("authenticate",
+                                                  std::bind(&DaemonRpc::on_authenticate,
                                                             this,
                                                             std::placeholders::_1,
                                                             std::placeholders::_2,
@@ -445,7 +512,8 @@ grpc::Status mp::DaemonRpc::authenticate(
 grpc::Status mp::DaemonRpc::set(grpc::ServerContext* context,
                                 grpc::ServerReaderWriter<SetReply, SetRequest>* server)
 {
-    return verify_client_and_dispatch_operation(std::bind(&DaemonRpc::on_set,
+    return verify_client_and_dispatch_operation("set",
+                                                std::bind(&DaemonRpc::on_set,
                                                           this,
                                                           std::placeholders::_1,
                                                           std::placeholders::_2,
@@ -457,7 +525,8 @@ grpc::Status mp::DaemonRpc::set(grpc::ServerContext* context,
 grpc::Status mp::DaemonRpc::keys(grpc::ServerContext* context,
                                  grpc::ServerReaderWriter<KeysReply, KeysRequest>* server)
 {
-    return verify_client_and_dispatch_operation(std::bind(&DaemonRpc::on_keys,
+    return verify_client_and_dispatch_operation("keys",
+                                                std::bind(&DaemonRpc::on_keys,
                                                           this,
                                                           std::placeholders::_1,
                                                           std::placeholders::_2,
@@ -470,7 +539,8 @@ grpc::Status mp::DaemonRpc::snapshot(
     grpc::ServerContext* context,
     grpc::ServerReaderWriter<SnapshotReply, SnapshotRequest>* server)
 {
-    return verify_client_and_dispatch_operation(std::bind(&DaemonRpc::on_snapshot,
+    return verify_client_and_dispatch_operation("snapshot",
+                                                std::bind(&DaemonRpc::on_snapshot,
                                                           this,
                                                           std::placeholders::_1,
                                                           std::placeholders::_2,
@@ -482,7 +552,8 @@ grpc::Status mp::DaemonRpc::snapshot(
 grpc::Status mp::DaemonRpc::restore(grpc::ServerContext* context,
                                     grpc::ServerReaderWriter<RestoreReply, RestoreRequest>* server)
 {
-    return verify_client_and_dispatch_operation(std::bind(&DaemonRpc::on_restore,
+    return verify_client_and_dispatch_operation("restore",
+                                                std::bind(&DaemonRpc::on_restore,
                                                           this,
                                                           std::placeholders::_1,
                                                           std::placeholders::_2,
@@ -495,7 +566,8 @@ grpc::Status mp::DaemonRpc::daemon_info(
     grpc::ServerContext* context,
     grpc::ServerReaderWriter<DaemonInfoReply, DaemonInfoRequest>* server)
 {
-    return verify_client_and_dispatch_operation(std::bind(&DaemonRpc::on_daemon_info,
+    return verify_client_and_dispatch_operation("daemon_info",
+                                                std::bind(&DaemonRpc::on_daemon_info,
                                                           this,
                                                           std::placeholders::_1,
                                                           std::placeholders::_2,
@@ -508,7 +580,8 @@ grpc::Status mp::DaemonRpc::wait_ready(
     grpc::ServerContext* context,
     grpc::ServerReaderWriter<WaitReadyReply, WaitReadyRequest>* server)
 {
-    return verify_client_and_dispatch_operation(std::bind(&DaemonRpc::on_wait_ready,
+    return verify_client_and_dispatch_operation("wait_ready",
+                                                std::bind(&DaemonRpc::on_wait_ready,
                                                           this,
                                                           std::placeholders::_1,
                                                           std::placeholders::_2,
@@ -520,7 +593,8 @@ grpc::Status mp::DaemonRpc::wait_ready(
 grpc::Status mp::DaemonRpc::zones(grpc::ServerContext* context,
                                   grpc::ServerReaderWriter<ZonesReply, ZonesRequest>* server)
 {
-    return verify_client_and_dispatch_operation(std::bind(&DaemonRpc::on_zones,
+    return verify_client_and_dispatch_operation("zones",
+                                                std::bind(&DaemonRpc::on_zones,
                                                           this,
                                                           std::placeholders::_1,
                                                           std::placeholders::_2,
@@ -533,7 +607,8 @@ grpc::Status mp::DaemonRpc::zones_state(
     grpc::ServerContext* context,
     grpc::ServerReaderWriter<ZonesStateReply, ZonesStateRequest>* server)
 {
-    return verify_client_and_dispatch_operation(std::bind(&DaemonRpc::on_zones_state,
+    return verify_client_and_dispatch_operation("zones_state",
+                                                std::bind(&DaemonRpc::on_zones_state,
                                                           this,
                                                           std::placeholders::_1,
                                                           std::placeholders::_2,
@@ -544,7 +619,8 @@ grpc::Status mp::DaemonRpc::zones_state(
 
 template <typename T, typename U, typename OperationSignal>
 grpc::Status
-mp::DaemonRpc::verify_client_and_dispatch_operation(OperationSignal signal,
+mp::DaemonRpc::verify_client_and_dispatch_operation(const std::string& method,
+                                                    OperationSignal signal,
                                                     const std::string& client_cert,
                                                     grpc::ServerReaderWriterInterface<T, U>* server)
 {
@@ -571,5 +647,5 @@ mp::DaemonRpc::verify_client_and_dispatch_operation(OperationSignal signal,
             "(e.g. via 'multipass set local.passphrase')."};
     }
 
-    return emit_signal_and_wait_for_result(signal, server, &request, *logger);
+    return emit_signal_and_wait_for_result(method, signal, server, &request, *logger);
 }
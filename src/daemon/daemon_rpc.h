@@ -150,7 +150,8 @@ signals:
 private:
     template <typename T, typename U, typename OperationSignal>
     grpc::Status
-    verify_client_and_dispatch_operation(OperationSignal signal,
+    verify_client_and_dispatch_operation(const std::string& method,
+                                         OperationSignal signal,
                                          const std::string& client_cert,
                                          grpc::ServerReaderWriterInterface<T, U>* server);
 
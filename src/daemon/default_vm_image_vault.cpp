@@ -17,6 +17,8 @@
 
 #include "default_vm_image_vault.h"
 
+#include <multipass/background_work.h>
+#include <multipass/delta_downloader.h>
 #include <multipass/exceptions/aborted_download_exception.h>
 #include <multipass/exceptions/create_image_exception.h>
 #include <multipass/exceptions/image_vault_exceptions.h>
@@ -25,10 +27,12 @@
 #include <multipass/format.h>
 #include <multipass/json_utils.h>
 #include <multipass/logging/log.h>
+#include <multipass/metrics.h>
 #include <multipass/platform.h>
 #include <multipass/process/qemuimg_process_spec.h>
 #include <multipass/query.h>
 #include <multipass/rpc/multipass.grpc.pb.h>
+#include <multipass/tracing.h>
 #include <multipass/url_downloader.h>
 #include <multipass/utils.h>
 #include <multipass/utils/qemu_img_utils.h>
@@ -37,6 +41,8 @@
 #include <QUrl>
 #include <QtConcurrent/QtConcurrent>
 
+#include <scope_guard.hpp>
+
 #include <boost/algorithm/string/replace.hpp>
 #include <boost/json.hpp>
 
@@ -44,6 +50,8 @@
 
 namespace mp = multipass;
 namespace mpl = multipass::logging;
+namespace mpm = multipass::metrics;
+namespace mpt = multipass::tracing;
 
 namespace
 {
@@ -95,6 +103,26 @@ void persist_records(const std::unordered_map<std::string, mp::VaultRecord>& rec
     auto json = boost::json::value_from(records);
     MP_FILEOPS.write_transactionally(path, mp::pretty_print(json));
 }
+
+// Sizes are taken whenever the records change, which is good enough for cached images but lags
+// behind instance images that grow as they are used
+void update_metrics(const std::unordered_map<std::string, mp::VaultRecord>& records,
+                    const std::string& kind)
+{
+    std::uintmax_t bytes = 0;
+    for (const auto& [_, record] : records)
+    {
+        std::error_code err;
+        if (const auto size = std::filesystem::file_size(record.image.image_path, err); !err)
+            bytes += size;
+    }
+
+    const mpm::Labels labels{{"kind", kind}};
+    MP_METRICS.gauge("multipass_vault_images", "Images held in the vault", labels)
+        .set(records.size());
+    MP_METRICS.gauge("multipass_vault_image_bytes", "Size of images held in the vault", labels)
+        .set(bytes);
+}
 } // namespace
 
 void mp::tag_invoke(const boost::json::value_from_tag&,
@@ -145,6 +173,9 @@ mp::DefaultVMImageVault::DefaultVMImageVault(std::vector<VMImageHost*> image_hos
     // if the OS field is empty, it was a previously existing Ubuntu cloud image. The same can be
     // said for instance image records with instances created with the Alias Query::Type.
     amend_db();
+
+    update_metrics(prepared_image_records, "cached");
+    update_metrics(instance_image_records, "instance");
 }
 
 mp::DefaultVMImageVault::~DefaultVMImageVault()
@@ -159,13 +190,25 @@ mp::VMImage mp::DefaultVMImageVault::fetch_image(const Query& query,
                                                  const mp::Path& save_dir)
 {
     {
-        std::lock_guard<decltype(fetch_mutex)> lock{fetch_mutex};
+        std::unique_lock<decltype(fetch_mutex)> lock{fetch_mutex};
         auto name_entry = instance_image_records.find(query.name);
         if (name_entry != instance_image_records.end())
         {
-            const auto& record = name_entry->second;
+            auto image = name_entry->second.image;
+            if (!needs_release_lookup(name_entry->second))
+                return image;
+
+            // The lookup waits for manifests being swapped in, so it runs outside the lock
+            lock.unlock();
+            const auto info = info_for_full_hash(image.id);
+            lock.lock();
+
+            name_entry = instance_image_records.find(query.name);
+            if (name_entry == instance_image_records.end())
+                return image;
 
-            return record.image;
+            backfill_release(name_entry->second, info);
+            return name_entry->second.image;
         }
     }
 
@@ -269,18 +312,21 @@ mp::VMImage mp::DefaultVMImageVault::fetch_image(const Query& query,
                     QLocale::c().toString(last_modified, "yyyyMMdd"));
                 const auto image_dir = MP_UTILS.make_dir(images_dir, image_dir_name);
 
-                // Had to use std::bind here to workaround the 5 allowable function arguments
-                // constraint of QtConcurrent::run()
-                future = QtConcurrent::run(
-                    std::bind(&DefaultVMImageVault::download_and_prepare_source_image,
-                              this,
-                              info,
-                              source_image,
-                              image_dir,
-                              prepare,
-                              monitor));
-
-                in_progress_image_fetches[id] = {image_dir, future};
+                // Wrapped in a lambda to workaround the 5 allowable function arguments constraint
+                // of QtConcurrent::run(), and to carry the trace and background work, if any,
+                // over to the download thread
+                auto promotion = std::make_shared<std::atomic_bool>(false);
+                future = QtConcurrent::run(mpt::in_current_trace(mp::in_current_background_work(
+                    [this, info, source_image, image_dir, prepare, monitor]() mutable {
+                        return download_and_prepare_source_image(info,
+                                                                 source_image,
+                                                                 image_dir,
+                                                                 prepare,
+                                                                 monitor);
+                    },
+                    promotion)));
+
+                in_progress_image_fetches[id] = {image_dir, future, std::move(promotion)};
             }
         }
         else
@@ -320,18 +366,21 @@ mp::VMImage mp::DefaultVMImageVault::fetch_image(const Query& query,
                     MP_UTILS.make_dir(images_dir,
                                       QString("%1-%2").arg(info->release).arg(info->version));
 
-                // Had to use std::bind here to workaround the 5 allowable function arguments
-                // constraint of QtConcurrent::run()
-                future = QtConcurrent::run(
-                    std::bind(&DefaultVMImageVault::download_and_prepare_source_image,
-                              this,
-                              *info,
-                              source_image,
-                              image_dir,
-                              prepare,
-                              monitor));
-
-                in_progress_image_fetches[id] = {image_dir, future};
+                // Wrapped in a lambda to workaround the 5 allowable function arguments constraint
+                // of QtConcurrent::run(), and to carry the trace and background work, if any,
+                // over to the download thread
+                auto promotion = std::make_shared<std::atomic_bool>(false);
+                future = QtConcurrent::run(mpt::in_current_trace(mp::in_current_background_work(
+                    [this, info = *info, source_image, image_dir, prepare, monitor]() mutable {
+                        return download_and_prepare_source_image(info,
+                                                                 source_image,
+                                                                 image_dir,
+                                                                 prepare,
+                                                                 monitor);
+                    },
+                    promotion)));
+
+                in_progress_image_fetches[id] = {image_dir, future, std::move(promotion)};
             }
         }
 
@@ -353,6 +402,7 @@ mp::VMImage mp::DefaultVMImageVault::fetch_image(const Query& query,
 
 void mp::DefaultVMImageVault::remove(const std::string& name)
 {
+    std::lock_guard<decltype(fetch_mutex)> lock{fetch_mutex};
     const auto& name_entry = instance_image_records.find(name);
     if (name_entry == instance_image_records.end())
         return;
@@ -363,6 +413,7 @@ void mp::DefaultVMImageVault::remove(const std::string& name)
 
 bool mp::DefaultVMImageVault::has_record_for(const std::string& name)
 {
+    std::lock_guard<decltype(fetch_mutex)> lock{fetch_mutex};
     return instance_image_records.find(name) != instance_image_records.end();
 }
 
@@ -398,7 +449,7 @@ void mp::DefaultVMImageVault::prune_expired_images()
             !std::any_of(in_progress_image_fetches.cbegin(),
                          in_progress_image_fetches.cend(),
                          [&entry](const auto& fetch) {
-                             return fetch.second.first == entry.absoluteFilePath();
+                             return fetch.second.image_dir == entry.absoluteFilePath();
                          }))
         {
             mpl::info(category,
@@ -419,7 +470,8 @@ void mp::DefaultVMImageVault::update_images(const PrepareAction& prepare,
 {
     mpl::debug(category, "Checking for images to update…");
 
-    std::vector<decltype(prepared_image_records)::key_type> keys_to_update;
+    // Each with the id of the image to update to
+    std::vector<std::pair<decltype(prepared_image_records)::key_type, std::string>> keys_to_update;
     for (const auto& record : prepared_image_records)
     {
         if (record.second.query.query_type == Query::Type::Alias &&
@@ -436,7 +488,7 @@ void mp::DefaultVMImageVault::update_images(const PrepareAction& prepare,
 
                 if (info->id != record.first)
                 {
-                    keys_to_update.push_back(record.first);
+                    keys_to_update.emplace_back(record.first, info->id);
                 }
             }
             catch (const mp::UnsupportedImageException& e)
@@ -450,10 +502,22 @@ void mp::DefaultVMImageVault::update_images(const PrepareAction& prepare,
         }
     }
 
-    for (const auto& key : keys_to_update)
+    for (const auto& [key, new_id] : keys_to_update)
     {
         const auto& record = prepared_image_records[key];
         mpl::info(category, "Updating {} source image to latest", record.query.release);
+
+        // Consecutive images share most of their blocks, so the new one is built from the old one
+        // where possible
+        {
+            std::lock_guard<decltype(fetch_mutex)> lock{fetch_mutex};
+            delta_seeds[new_id] = record.image.image_path;
+        }
+        auto erase_seed = sg::make_scope_guard([this, &new_id]() noexcept {
+            std::lock_guard<decltype(fetch_mutex)> lock{fetch_mutex};
+            delta_seeds.erase(new_id);
+        });
+
         try
         {
             fetch_image(record.query,
@@ -503,6 +567,7 @@ mp::MemorySize mp::DefaultVMImageVault::minimum_image_size_for(const std::string
 void mp::DefaultVMImageVault::clone(const std::string& source_instance_name,
                                     const std::string& destination_instance_name)
 {
+    std::lock_guard<decltype(fetch_mutex)> lock{fetch_mutex};
     const auto source_iter = instance_image_records.find(source_instance_name);
 
     if (source_iter == instance_image_records.end())
@@ -565,14 +630,24 @@ mp::VMImage mp::DefaultVMImageVault::download_and_prepare_source_image(
 
     try
     {
-        url_downloader->download_to(QString::fromStdString(info.image_location),
-                                    MP_PLATFORM.path_to_qstr(source_image.image_path),
-                                    info.size,
-                                    LaunchProgress::IMAGE,
-                                    monitor);
+        {
+            mpt::ScopedSpan span{"download image"};
+            span.add_attribute("url", info.image_location);
+            if (!download_delta(info, source_image, monitor))
+                url_downloader->download_to(QString::fromStdString(info.image_location),
+                                            MP_PLATFORM.path_to_qstr(source_image.image_path),
+                                            info.size,
+                                            LaunchProgress::IMAGE,
+                                            monitor);
+        }
+
+        // A launch may have come to wait on the image during the download
+        if (auto work = BackgroundWork::current())
+            work->follow_promotion();
 
         if (info.verify)
         {
+            mpt::ScopedSpan span{"verify image"};
             mpl::debug(category, "Verifying hash \"{}\"", id);
             monitor(LaunchProgress::VERIFY, -1);
             MP_IMAGE_VAULT_UTILS.verify_file_hash(source_image.image_path, id);
@@ -580,6 +655,7 @@ mp::VMImage mp::DefaultVMImageVault::download_and_prepare_source_image(
 
         if (source_image.image_path.extension() == ".xz")
         {
+            mpt::ScopedSpan span{"decompress image"};
             source_image.image_path =
                 MP_IMAGE_VAULT_UTILS.extract_file(source_image.image_path, monitor, true);
         }
@@ -599,11 +675,47 @@ mp::VMImage mp::DefaultVMImageVault::download_and_prepare_source_image(
     }
 }
 
+bool mp::DefaultVMImageVault::download_delta(const VMImageInfo& info,
+                                             const VMImage& source_image,
+                                             const ProgressMonitor& monitor)
+{
+    std::filesystem::path seed;
+    {
+        std::lock_guard<decltype(fetch_mutex)> lock{fetch_mutex};
+        if (auto it = delta_seeds.find(info.id); it != delta_seeds.end())
+            seed = it->second;
+    }
+
+    // Compressed images change throughout and do not compare to the decompressed old ones
+    if (seed.empty() || source_image.image_path.extension() == ".xz" || !MP_FILEOPS.exists(seed))
+        return false;
+
+    try
+    {
+        return DeltaDownloader{url_downloader}.download_to(
+            QString::fromStdString(info.image_location),
+            MP_PLATFORM.path_to_qstr(seed),
+            MP_PLATFORM.path_to_qstr(source_image.image_path),
+            LaunchProgress::IMAGE,
+            monitor);
+    }
+    catch (const AbortedDownloadException&)
+    {
+        throw;
+    }
+    catch (const std::exception& e)
+    {
+        mpl::warn(category, "Cannot update {} incrementally: {}", info.image_location, e.what());
+        return false;
+    }
+}
+
 std::filesystem::path mp::DefaultVMImageVault::extract_image_from(
     const VMImage& source_image,
     const ProgressMonitor& monitor,
     const std::filesystem::path& dest_dir)
 {
+    mpt::ScopedSpan span{"decompress image"};
     MP_UTILS.make_dir(dest_dir);
     QFileInfo file_info{source_image.image_path};
     const auto image_name = file_info.fileName().remove(".xz");
@@ -615,6 +727,7 @@ std::filesystem::path mp::DefaultVMImageVault::extract_image_from(
 mp::VMImage mp::DefaultVMImageVault::image_instance_from(const VMImage& prepared_image,
                                                          const mp::Path& dest_dir)
 {
+    mpt::ScopedSpan span{"copy image to instance"};
     MP_UTILS.make_dir(dest_dir);
 
     return {MP_IMAGE_VAULT_UTILS.copy_to_dir(prepared_image.image_path,
@@ -632,7 +745,11 @@ std::optional<QFuture<mp::VMImage>> mp::DefaultVMImageVault::get_image_future(co
     auto it = in_progress_image_fetches.find(id);
     if (it != in_progress_image_fetches.end())
     {
-        return it->second.second;
+        // Whoever joins a fetch from the foreground is not to wait on it at background pace
+        if (!BackgroundWork::current())
+            *it->second.promotion = true;
+
+        return it->second.future;
     }
 
     return std::nullopt;
@@ -665,11 +782,13 @@ mp::VMImage mp::DefaultVMImageVault::finalize_image_records(const Query& query,
 void mp::DefaultVMImageVault::persist_instance_records()
 {
     persist_records(instance_image_records, data_dir.filePath(instance_db_name));
+    update_metrics(instance_image_records, "instance");
 }
 
 void mp::DefaultVMImageVault::persist_image_records()
 {
     persist_records(prepared_image_records, cache_dir.filePath(image_db_name));
+    update_metrics(prepared_image_records, "cached");
 }
 
 void mp::DefaultVMImageVault::amend_db()
@@ -694,3 +813,32 @@ void mp::DefaultVMImageVault::amend_db()
         }
     }
 }
+
+// Instances launched before their image's release was kept in their record get it from the
+// manifests the first time they are fetched with their image there, and keep it for good. Images
+// that are not in the manifests, which may just not be loaded yet, are looked up again next time.
+bool mp::DefaultVMImageVault::needs_release_lookup(const VaultRecord& record) const
+{
+    return record.image.original_release.empty() && !record.image.id.empty() &&
+           record.query.query_type == Query::Type::Alias &&
+           !release_lookups.count(record.image.id);
+}
+
+void mp::DefaultVMImageVault::backfill_release(VaultRecord& record,
+                                               const std::optional<VMImageInfo>& info)
+{
+    if (!info || !record.image.original_release.empty())
+        return;
+
+    if (info->release_title.empty())
+    {
+        release_lookups.insert(record.image.id);
+        return;
+    }
+
+    record.image.original_release = info->release_title;
+    if (record.image.os.empty())
+        record.image.os = info->os;
+
+    persist_instance_records();
+}
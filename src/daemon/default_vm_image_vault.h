@@ -17,6 +17,7 @@
 
 #pragma once
 
+#include <multipass/background_work.h>
 #include <multipass/days.h>
 #include <multipass/image_host/vm_image_host.h>
 #include <multipass/query.h>
@@ -31,6 +32,7 @@
 #include <mutex>
 #include <optional>
 #include <unordered_map>
+#include <unordered_set>
 
 namespace multipass
 {
@@ -73,6 +75,10 @@ private:
                                               const QDir& image_dir,
                                               const PrepareAction& prepare,
                                               const ProgressMonitor& monitor);
+    // Builds the image from the one it updates, if there is one, returning whether it could
+    bool download_delta(const VMImageInfo& info,
+                        const VMImage& source_image,
+                        const ProgressMonitor& monitor);
     std::filesystem::path extract_image_from(const VMImage& source_image,
                                              const ProgressMonitor& monitor,
                                              const std::filesystem::path& dest_dir);
@@ -84,6 +90,8 @@ private:
     void persist_image_records();
     void persist_instance_records();
     void amend_db();
+    bool needs_release_lookup(const VaultRecord& record) const;
+    void backfill_release(VaultRecord& record, const std::optional<VMImageInfo>& info);
 
     URLDownloader* const url_downloader;
     const QDir cache_dir;
@@ -94,7 +102,17 @@ private:
 
     std::unordered_map<std::string, VaultRecord> prepared_image_records;
     std::unordered_map<std::string, VaultRecord> instance_image_records;
-    std::unordered_map<std::string, std::pair<QString, QFuture<VMImage>>> in_progress_image_fetches;
+    struct ImageFetch
+    {
+        QString image_dir;
+        QFuture<VMImage> future;
+        BackgroundWork::Promotion promotion; // for when it runs as background work
+    };
+    std::unordered_map<std::string, ImageFetch> in_progress_image_fetches;
+    // Images being updated to, by id, with the images they update
+    std::unordered_map<std::string, std::filesystem::path> delta_seeds;
+    // Images found in the manifests without a release, by id, so that they are not looked up again
+    std::unordered_set<std::string> release_lookups;
 };
 
 void tag_invoke(const boost::json::value_from_tag&,
@@ -0,0 +1,194 @@
+/*
+ * Copyright (C) Canonical, Ltd.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#include "image_maintenance.h"
+#include "warm_pool.h"
+
+#include <multipass/background_work.h>
+#include <multipass/constants.h>
+#include <multipass/logging/log.h>
+#include <multipass/memory_size.h>
+#include <multipass/settings/settings.h>
+#include <multipass/virtual_machine_factory.h>
+#include <multipass/vm_image.h>
+#include <multipass/vm_image_vault.h>
+
+#include <QtConcurrent/QtConcurrent>
+
+namespace mp = multipass;
+namespace mpl = multipass::logging;
+
+namespace
+{
+constexpr auto category = "image maintenance";
+
+// Read for every round, so that a new limit applies from the next one
+std::uint64_t bandwidth_limit()
+{
+    const auto limit = MP_SETTINGS.get(mp::image_bandwidth_limit_key);
+    try
+    {
+        return mp::MemorySize{limit.toStdString()}.in_bytes();
+    }
+    catch (const std::exception& e)
+    {
+        mpl::warn(category,
+                  "Ignoring invalid {} setting: {}",
+                  mp::image_bandwidth_limit_key,
+                  e.what());
+        return 0;
+    }
+}
+} // namespace
+
+mp::ImageMaintenance::ImageMaintenance(VMImageVault& vault,
+                                       VirtualMachineFactory& factory,
+                                       WarmPool* warm_pool)
+    : vault{vault}, factory{factory}, warm_pool{warm_pool}
+{
+    round_pool.setMaxThreadCount(1);
+}
+
+mp::ImageMaintenance::~ImageMaintenance()
+{
+    {
+        std::lock_guard lock{holds->mutex};
+        stopping = true;
+    }
+    holds->released.notify_all();
+
+    round.waitForFinished(); // downloads see that it is stopping and abort
+}
+
+void mp::ImageMaintenance::run()
+{
+    if (round.isRunning())
+    {
+        mpl::info(category, "Image maintenance already running. Skipping…");
+        return;
+    }
+
+    std::vector<Step> steps{{"prune expired images", [this] { vault.prune_expired_images(); }},
+                            {"update images", [this] { update_images(); }}};
+    if (warm_pool)
+        // Replaces whatever is out of date now, and retries whatever failed to prepare
+        steps.push_back({"refill warm pool", [this] {
+                             warm_pool->discard_stale();
+                             warm_pool->refill();
+                         }});
+
+    round = QtConcurrent::run(&round_pool, [this, steps = std::move(steps)] { run_steps(steps); });
+}
+
+mp::ImageMaintenance::Hold mp::ImageMaintenance::hold()
+{
+    {
+        std::lock_guard lock{holds->mutex};
+        ++holds->count;
+    }
+
+    return Hold{nullptr, [holds = holds](void*) {
+                    {
+                        std::lock_guard lock{holds->mutex};
+                        --holds->count;
+                    }
+                    holds->released.notify_all();
+                }};
+}
+
+mp::ImageMaintenance::Status mp::ImageMaintenance::status() const
+{
+    int hold_count;
+    {
+        std::lock_guard lock{holds->mutex};
+        hold_count = holds->count;
+    }
+
+    std::lock_guard lock{status_mutex};
+    return {state, step, state == State::running ? progress.load() : -1, steps_left, hold_count};
+}
+
+void mp::ImageMaintenance::run_steps(const std::vector<Step>& steps)
+{
+    BackgroundWork work{bandwidth_limit()};
+
+    for (std::size_t i = 0; i < steps.size(); ++i)
+    {
+        const auto& [name, action] = steps[i];
+        const auto steps_after = static_cast<int>(steps.size() - i - 1);
+
+        set_status(State::waiting, name, steps_after);
+        if (!wait_for_holds())
+            break;
+
+        progress = -1;
+        set_status(State::running, name, steps_after);
+
+        try
+        {
+            action();
+        }
+        catch (const std::exception& e)
+        {
+            mpl::error(category, "Failed to {}: {}", name, e.what());
+        }
+    }
+
+    set_status(State::idle, {}, 0);
+}
+
+void mp::ImageMaintenance::update_images()
+{
+    auto prepare_action = [this](const VMImage& source_image) -> VMImage {
+        return factory.prepare_source_image(source_image);
+    };
+
+    auto last_percentage_logged = -1;
+    auto download_monitor = [this, &last_percentage_logged](int /*progress_type*/,
+                                                            int percentage) {
+        progress = percentage;
+
+        // The progress callback may be called repeatedly with the same percentage, so this only
+        // logs it once
+        if (percentage % 10 == 0 && last_percentage_logged != percentage)
+        {
+            mpl::info(category, "  {}%", percentage);
+            last_percentage_logged = percentage;
+        }
+
+        return !stopping;
+    };
+
+    vault.update_images(prepare_action, download_monitor);
+}
+
+bool mp::ImageMaintenance::wait_for_holds()
+{
+    std::unique_lock lock{holds->mutex};
+    if (holds->count && !stopping)
+        mpl::debug(category, "Waiting for {} operation(s) to finish", holds->count);
+
+    holds->released.wait(lock, [this] { return !holds->count || stopping; });
+    return !stopping;
+}
+
+void mp::ImageMaintenance::set_status(State new_state, const std::string& new_step, int remaining)
+{
+    std::lock_guard lock{status_mutex};
+    state = new_state;
+    step = new_step;
+    steps_left = remaining;
+}
@@ -0,0 +1,112 @@
+/*
+ * Copyright (C) Canonical, Ltd.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#pragma once
+
+#include <multipass/disabled_copy_move.h>
+
+#include <QFuture>
+#include <QThreadPool>
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace multipass
+{
+class VirtualMachineFactory;
+class VMImageVault;
+class WarmPool;
+
+/*
+ * Runs the periodic upkeep of source images - pruning expired ones, updating to newly released ones
+ * and topping up the warm pool - as background work: at a low CPU and I/O priority, with downloads
+ * kept to a bandwidth limit, and holding off whenever instances are being launched or started.
+ *
+ * Upkeep goes in steps, and it only holds off before each one: a step that is under way, such as
+ * a download, is left to finish at its low priority.
+ */
+class ImageMaintenance : private DisabledCopyMove
+{
+public:
+    enum class State
+    {
+        idle,
+        waiting, // for whatever holds it off
+        running
+    };
+
+    struct Status
+    {
+        State state;
+        std::string step; // the one running or waiting to run, if any
+        int progress;     // of the step, in percent, or -1 if unknown
+        int steps_left;   // after this one
+        int holds;        // operations it is waiting on, or would wait on
+    };
+
+    // Holds maintenance off for as long as any copy of it lives
+    using Hold = std::shared_ptr<void>;
+
+    ImageMaintenance(VMImageVault& vault, VirtualMachineFactory& factory, WarmPool* warm_pool);
+    ~ImageMaintenance();
+
+    // Starts a round of upkeep in the background, unless one is under way already
+    void run();
+
+    Hold hold();
+    Status status() const;
+
+private:
+    struct Step
+    {
+        std::string name;
+        std::function<void()> action;
+    };
+
+    // Shared with holds, which may outlive this
+    struct Holds
+    {
+        std::mutex mutex;
+        std::condition_variable released;
+        int count{0};
+    };
+
+    void run_steps(const std::vector<Step>& steps);
+    void update_images();
+    bool wait_for_holds(); // returns false when stopping instead
+    void set_status(State new_state, const std::string& new_step, int remaining);
+
+    VMImageVault& vault;
+    VirtualMachineFactory& factory;
+    WarmPool* const warm_pool;
+
+    const std::shared_ptr<Holds> holds{std::make_shared<Holds>()};
+    mutable std::mutex status_mutex;
+    State state{State::idle};
+    std::string step;
+    int steps_left{0};
+    std::atomic_int progress{-1};
+    std::atomic_bool stopping{false};
+    QThreadPool round_pool; // a round may wait for long, which should not tie up the global pool
+    QFuture<void> round;
+};
+} // namespace multipass
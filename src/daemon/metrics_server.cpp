@@ -0,0 +1,109 @@
+/*
+ * Copyright (C) Canonical, Ltd.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "metrics_server.h"
+
+#include <multipass/format.h>
+#include <multipass/logging/log.h>
+#include <multipass/metrics.h>
+
+#include <QTcpSocket>
+
+#include <memory>
+#include <stdexcept>
+
+namespace mp = multipass;
+namespace mpl = multipass::logging;
+
+namespace
+{
+constexpr auto category = "metrics";
+constexpr auto max_request_size = 8192;
+
+QByteArray http_response(const char* status, const char* content_type, const QByteArray& body)
+{
+    return QByteArray{fmt::format("HTTP/1.1 {}\r\n"
+                                  "Content-Type: {}\r\n"
+                                  "Content-Length: {}\r\n"
+                                  "Connection: close\r\n"
+                                  "\r\n",
+                                  status,
+                                  content_type,
+                                  body.size())
+                          .c_str()} +
+           body;
+}
+
+QByteArray respond_to(const QByteArray& request_line)
+{
+    const auto parts = request_line.simplified().split(' ');
+    if (parts.size() != 3 || !parts[2].startsWith("HTTP/"))
+        return http_response("400 Bad Request", "text/plain", "Bad request\n");
+
+    if (parts[0] != "GET" && parts[0] != "HEAD")
+        return http_response("405 Method Not Allowed", "text/plain", "Method not allowed\n");
+
+    if (parts[1] != "/metrics")
+        return http_response("404 Not Found", "text/plain", "Not found\n");
+
+    const auto body = QByteArray::fromStdString(MP_METRICS.render());
+    auto response = http_response("200 OK", "text/plain; version=0.0.4; charset=utf-8", body);
+
+    return parts[0] == "HEAD" ? response.left(response.size() - body.size()) : response;
+}
+} // namespace
+
+mp::MetricsServer::MetricsServer(quint16 port)
+{
+    // Only ever listen on loopback: metrics reveal instance names and activity
+    if (!server.listen(QHostAddress::LocalHost, port))
+        throw std::runtime_error{
+            fmt::format("Cannot serve metrics on port {}: {}", port, server.errorString())};
+
+    QObject::connect(&server, &QTcpServer::newConnection, [this] {
+        while (auto socket = server.nextPendingConnection())
+            serve(socket);
+    });
+
+    mpl::info(category, "Serving metrics on http://localhost:{}/metrics", this->port());
+}
+
+quint16 mp::MetricsServer::port() const
+{
+    return server.serverPort();
+}
+
+void mp::MetricsServer::serve(QTcpSocket* socket)
+{
+    QObject::connect(socket, &QTcpSocket::disconnected, socket, &QObject::deleteLater);
+
+    auto request = std::make_shared<QByteArray>();
+    QObject::connect(socket, &QTcpSocket::readyRead, socket, [socket, request] {
+        request->append(socket->readAll());
+
+        // Only the request line matters, but wait for the headers to end so the client is done
+        const auto headers_end = request->indexOf("\r\n\r\n");
+        if (headers_end < 0 && request->size() < max_request_size)
+            return;
+
+        socket->write(headers_end < 0
+                          ? http_response("431 Request Header Fields Too Large", "text/plain", {})
+                          : respond_to(request->left(request->indexOf("\r\n"))));
+        socket->disconnectFromHost();
+        request->clear();
+    });
+}
@@ -0,0 +1,44 @@
+/*
+ * Copyright (C) Canonical, Ltd.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#pragma once
+
+#include <multipass/disabled_copy_move.h>
+
+#include <QTcpServer>
+
+class QTcpSocket;
+
+namespace multipass
+{
+/*
+ * Serves the metrics registry over plain HTTP on the loopback interface, for Prometheus to scrape
+ * from `/metrics`. Nothing else is served and nothing can be changed through it.
+ */
+class MetricsServer : private DisabledCopyMove
+{
+public:
+    explicit MetricsServer(quint16 port);
+
+    quint16 port() const;
+
+private:
+    void serve(QTcpSocket* socket);
+
+    QTcpServer server;
+};
+} // namespace multipass
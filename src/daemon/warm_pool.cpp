@@ -0,0 +1,547 @@
+/*
+ * Copyright (C) Canonical, Ltd.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "warm_pool.h"
+
+#include <multipass/file_ops.h>
+#include <multipass/format.h>
+#include <multipass/logging/log.h>
+#include <multipass/query.h>
+#include <multipass/top_catch_all.h>
+#include <multipass/virtual_machine_factory.h>
+#include <multipass/vm_image.h>
+#include <multipass/vm_image_vault.h>
+
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace mp = multipass;
+namespace mpl = multipass::logging;
+
+namespace
+{
+constexpr auto category = "warm pool";
+
+// Underscores are not valid in hostnames, so these can never clash with instance names
+constexpr auto name_prefix = "_warm-pool-";
+// Pooled instances have ordinary names, so those are kept on record, to be dropped on restart
+constexpr auto instance_names_file = "_warm-pool-instances";
+
+QDir instances_dir(const mp::VirtualMachineFactory& factory)
+{
+    return QFileInfo{factory.get_instance_directory(name_prefix)}.dir();
+}
+
+std::invalid_argument invalid_entry(const QString& item)
+{
+    return std::invalid_argument{fmt::format(
+        "Invalid warm pool entry `{}`, expected `[<remote>:]<image>=<images>[+<instances>]`",
+        item)};
+}
+
+int parse_count(const QString& count, const QString& item)
+{
+    auto ok = false;
+    const auto value = count.trimmed().toInt(&ok);
+    if (!ok || value < 0)
+        throw invalid_entry(item);
+
+    return value;
+}
+} // namespace
+
+std::vector<mp::WarmPoolProfile> mp::parse_warm_pool_profiles(const QString& setting)
+{
+    std::vector<WarmPoolProfile> profiles;
+
+    for (const auto& item : setting.split(',', Qt::SkipEmptyParts))
+    {
+        const auto image_and_size = item.trimmed().split('=');
+        const auto counts =
+            image_and_size.size() == 2 ? image_and_size[1].split('+') : QStringList{};
+        if (counts.isEmpty() || counts.size() > 2)
+            throw invalid_entry(item.trimmed());
+
+        const auto size = parse_count(counts[0], item.trimmed());
+        const auto instances = counts.size() == 2 ? parse_count(counts[1], item.trimmed()) : 0;
+
+        const auto image = image_and_size[0].trimmed();
+        const auto remote_and_release = image.split(':');
+        if (image.isEmpty() || remote_and_release.size() > 2 ||
+            remote_and_release.back().isEmpty() || image.startsWith("file") ||
+            image.startsWith("http"))
+            throw std::invalid_argument{
+                fmt::format("Invalid warm pool image `{}`, expected `[<remote>:]<image>`", image)};
+
+        const auto remote =
+            remote_and_release.size() == 2 ? remote_and_release.front() : QString{};
+        WarmPoolProfile profile{remote.toStdString(),
+                                remote_and_release.back().toStdString(),
+                                size,
+                                instances};
+        if (std::ranges::any_of(profiles, [&profile](const auto& other) {
+                return other.remote_name == profile.remote_name && other.release == profile.release;
+            }))
+            throw std::invalid_argument{fmt::format("Repeated warm pool image `{}`", image)};
+
+        if (size > 0 || instances > 0)
+            profiles.push_back(std::move(profile));
+    }
+
+    return profiles;
+}
+
+mp::WarmPool::WarmPool(std::vector<WarmPoolProfile> profiles,
+                       VirtualMachineFactory& factory,
+                       VMImageVault& vault,
+                       BootAction boot,
+                       ReleaseAction release)
+    : profiles{std::move(profiles)},
+      factory{factory},
+      vault{vault},
+      boot{std::move(boot)},
+      release{std::move(release)},
+      provisioned(this->profiles.size())
+{
+    fill_pool.setMaxThreadCount(1);
+
+    discard_leftovers();
+    refill();
+}
+
+mp::WarmPool::~WarmPool()
+{
+    stopping = true;
+    fill_pool.clear();
+    fill_pool.waitForDone();
+}
+
+bool mp::WarmPool::claim(const Query& query)
+{
+    const auto profile = profile_for(query);
+    if (!profile)
+        return false;
+
+    std::string pooled_name;
+    {
+        std::lock_guard lock{mutex};
+
+        auto it = std::ranges::find(ready, *profile, &Entry::profile);
+        if (it == ready.end())
+            return false;
+
+        pooled_name = it->name;
+        --provisioned[it->profile].images;
+        ready.erase(it);
+    }
+
+    const auto adopted = hand_over(pooled_name, query.name);
+    if (!adopted)
+        discard(pooled_name);
+
+    refill();
+    return adopted;
+}
+
+auto mp::WarmPool::claim_instance(const Query& query) -> std::optional<Instance>
+{
+    const auto profile = profile_for(query);
+    if (!profile)
+        return std::nullopt;
+
+    std::optional<Instance> instance;
+    {
+        std::lock_guard lock{mutex};
+
+        auto it = std::ranges::find(suspended, *profile, &Pooled::profile);
+        if (it == suspended.end())
+            return std::nullopt;
+
+        instance = std::move(it->instance);
+        --provisioned[it->profile].instances;
+        suspended.erase(it);
+        metadata.erase(instance->name);
+        save_instance_names();
+    }
+
+    mpl::debug(category, "Handing over {}", instance->name);
+
+    refill();
+    return instance;
+}
+
+bool mp::WarmPool::hand_over(const std::string& pooled_name, const std::string& name)
+{
+    try
+    {
+        const auto pooled_dir = factory.get_instance_directory(pooled_name);
+        const auto instance_dir = factory.get_instance_directory(name);
+
+        if (!QFileInfo::exists(instance_dir) && QDir{}.rename(pooled_dir, instance_dir))
+        {
+            // The vault record is cloned and dropped, rather than renamed, as cloning already
+            // rewrites the image path to point into the new instance directory
+            vault.clone(pooled_name, name);
+            vault.remove(pooled_name);
+
+            mpl::debug(category, "{} adopted {}", name, pooled_name);
+
+            std::lock_guard lock{mutex};
+            if (const auto it = booting.find(pooled_name); it != booting.end())
+            {
+                it->second.name = name;
+                save_instance_names();
+            }
+
+            return true;
+        }
+    }
+    catch (const std::exception& e)
+    {
+        mpl::warn(category, "Could not hand {} over to {}: {}", pooled_name, name, e.what());
+    }
+
+    return false;
+}
+
+void mp::WarmPool::booted(const std::string& pooled_name, Instance instance)
+{
+    {
+        std::lock_guard lock{mutex};
+
+        const auto it = booting.find(pooled_name);
+        if (it != booting.end() && !stopping)
+        {
+            mpl::debug(category, "{} is ready", instance.name);
+
+            instance.metadata = metadata[instance.name];
+            suspended.push_back({it->second.profile, std::move(instance)});
+            booting.erase(it);
+            save_instance_names();
+            return;
+        }
+    }
+
+    discard(instance);
+}
+
+void mp::WarmPool::boot_failed(const std::string& pooled_name)
+{
+    discard(pooled_name);
+
+    // Leave the slot unprovisioned, to be retried on the next refill rather than in a loop
+    std::lock_guard lock{mutex};
+    if (const auto it = booting.find(pooled_name); it != booting.end())
+    {
+        --provisioned[it->second.profile].instances;
+        booting.erase(it);
+        save_instance_names();
+    }
+}
+
+bool mp::WarmPool::holds(const std::string& name)
+{
+    std::lock_guard lock{mutex};
+    return std::ranges::any_of(suspended, [&name](const Pooled& pooled) {
+        return pooled.instance.name == name;
+    });
+}
+
+void mp::WarmPool::discard_instance(const std::string& name)
+{
+    std::optional<Instance> instance;
+    {
+        std::lock_guard lock{mutex};
+
+        auto it = std::ranges::find_if(suspended, [&name](const Pooled& pooled) {
+            return pooled.instance.name == name;
+        });
+        if (it == suspended.end())
+            return;
+
+        instance = std::move(it->instance);
+        --provisioned[it->profile].instances;
+        suspended.erase(it);
+        save_instance_names();
+    }
+
+    discard(*instance);
+    refill();
+}
+
+void mp::WarmPool::discard_stale()
+{
+    // Looked up before taking the lock, as it can wait on the image hosts
+    std::vector<std::optional<std::string>> latest_ids;
+    for (const auto& profile : profiles)
+    {
+        try
+        {
+            const auto info = vault.all_info_for(
+                {"", profile.release, false, profile.remote_name, Query::Type::Alias, true});
+            latest_ids.push_back(info.empty() ? std::nullopt
+                                              : std::make_optional(info.front().second.id));
+        }
+        catch (const std::exception& e)
+        {
+            mpl::warn(category,
+                      "Could not look up the latest image for {}:{}: {}",
+                      profile.remote_name,
+                      profile.release,
+                      e.what());
+            latest_ids.push_back(std::nullopt);
+        }
+    }
+
+    auto is_stale = [&latest_ids](std::size_t profile, const std::string& image_id) {
+        return latest_ids[profile] && *latest_ids[profile] != image_id;
+    };
+
+    std::vector<std::string> stale_images;
+    std::vector<Instance> stale_instances;
+    {
+        std::lock_guard lock{mutex};
+
+        std::erase_if(ready, [&](const Entry& entry) {
+            if (!is_stale(entry.profile, entry.image_id))
+                return false;
+
+            --provisioned[entry.profile].images;
+            stale_images.push_back(entry.name);
+            return true;
+        });
+        std::erase_if(suspended, [&](Pooled& pooled) {
+            if (!is_stale(pooled.profile, pooled.instance.desc.image.id))
+                return false;
+
+            --provisioned[pooled.profile].instances;
+            stale_instances.push_back(std::move(pooled.instance));
+            return true;
+        });
+
+        if (!stale_instances.empty())
+            save_instance_names();
+    }
+
+    for (const auto& name : stale_images)
+    {
+        mpl::debug(category, "Discarding {}, whose image was updated", name);
+        discard(name);
+    }
+    for (const auto& instance : stale_instances)
+    {
+        mpl::debug(category, "Discarding {}, whose image was updated", instance.name);
+        discard(instance);
+    }
+}
+
+void mp::WarmPool::refill()
+{
+    std::lock_guard lock{mutex};
+
+    for (std::size_t i = 0; i < profiles.size(); ++i)
+    {
+        for (; provisioned[i].images < profiles[i].size; ++provisioned[i].images)
+        {
+            auto name = fmt::format("{}{}", name_prefix, ++serial);
+            fill_pool.start([this, i, name = std::move(name)] { prepare(i, name, Kind::image); });
+        }
+
+        for (; boot && provisioned[i].instances < profiles[i].instances;
+             ++provisioned[i].instances)
+        {
+            auto name = fmt::format("{}{}", name_prefix, ++serial);
+            fill_pool.start(
+                [this, i, name = std::move(name)] { prepare(i, name, Kind::instance); });
+        }
+    }
+}
+
+void mp::WarmPool::on_resume()
+{
+}
+
+void mp::WarmPool::on_shutdown()
+{
+}
+
+void mp::WarmPool::on_suspend()
+{
+}
+
+void mp::WarmPool::on_restart(const std::string& /*name*/)
+{
+}
+
+void mp::WarmPool::persist_state_for(const std::string& /*name*/,
+                                     const VirtualMachine::State& /*state*/)
+{
+}
+
+void mp::WarmPool::update_metadata_for(const std::string& name,
+                                       const boost::json::object& metadata)
+{
+    std::lock_guard lock{mutex};
+    this->metadata[name] = metadata;
+}
+
+boost::json::object mp::WarmPool::retrieve_metadata_for(const std::string& name)
+{
+    std::lock_guard lock{mutex};
+    if (const auto it = metadata.find(name); it != metadata.end())
+        return it->second;
+
+    return {};
+}
+
+std::optional<std::size_t> mp::WarmPool::profile_for(const Query& query) const
+{
+    if (query.query_type != Query::Type::Alias)
+        return std::nullopt;
+
+    const auto it = std::ranges::find_if(profiles, [&query](const WarmPoolProfile& profile) {
+        return profile.release == query.release && profile.remote_name == query.remote_name;
+    });
+    if (it == profiles.end())
+        return std::nullopt;
+
+    return static_cast<std::size_t>(it - profiles.begin());
+}
+
+void mp::WarmPool::discard(const std::string& name)
+{
+    mp::top_catch_all(category, [this, &name] {
+        vault.remove(name);
+        QDir{factory.get_instance_directory(name)}.removeRecursively();
+    });
+}
+
+void mp::WarmPool::discard(const Instance& instance)
+{
+    mp::top_catch_all(category, [this, &instance] {
+        factory.remove_resources_for(instance.name);
+        discard(instance.name);
+
+        {
+            std::lock_guard lock{mutex};
+            metadata.erase(instance.name);
+        }
+
+        if (release)
+            release(instance.desc);
+    });
+}
+
+void mp::WarmPool::discard_leftovers()
+{
+    // Whatever the pool held when the daemon last stopped may be for profiles that are no longer
+    // configured, so it is cheaper to start over than to work out which ones to keep
+    const auto dir = instances_dir(factory);
+    for (const auto& entry : dir.entryList({QString{name_prefix} + "*"}, QDir::Dirs))
+    {
+        mpl::debug(category, "Discarding leftover {}", entry);
+        discard(entry.toStdString());
+    }
+
+    QFile names_file{dir.filePath(instance_names_file)};
+    if (!MP_FILEOPS.open(names_file, QIODevice::ReadOnly))
+        return;
+
+    for (const auto& name : names_file.readAll().split('\n'))
+    {
+        if (name.isEmpty())
+            continue;
+
+        mpl::debug(category, "Discarding leftover {}", name);
+        discard(Instance{name.toStdString(), {}, {}});
+    }
+    names_file.close();
+    names_file.remove();
+}
+
+void mp::WarmPool::prepare(std::size_t profile, const std::string& name, Kind kind)
+{
+    if (stopping)
+        return;
+
+    const auto& remote_name = profiles[profile].remote_name;
+    const auto& release = profiles[profile].release;
+    mpl::debug(category, "Preparing {} for {}:{}", name, remote_name, release);
+
+    const Query query{name, release, false, remote_name, Query::Type::Alias, true};
+    try
+    {
+        auto prepare_action = [this](const VMImage& source_image) -> VMImage {
+            return factory.prepare_source_image(source_image);
+        };
+
+        const auto image = vault.fetch_image(query,
+                                             prepare_action,
+                                             [this](int, int) { return !stopping; },
+                                             std::nullopt,
+                                             factory.get_instance_directory(name));
+
+        std::lock_guard lock{mutex};
+        if (kind == Kind::image)
+            ready.push_back({profile, name, image.id});
+        else
+            booting.emplace(name, Booting{profile, {}});
+    }
+    catch (const std::exception& e)
+    {
+        mpl::warn(category,
+                  "Could not prepare {} for {}:{}: {}",
+                  name,
+                  remote_name,
+                  release,
+                  e.what());
+        discard(name);
+
+        // Leave the slot unprovisioned, to be retried on the next refill rather than in a loop
+        std::lock_guard lock{mutex};
+        if (kind == Kind::image)
+            --provisioned[profile].images;
+        else
+            --provisioned[profile].instances;
+
+        return;
+    }
+
+    if (kind == Kind::instance)
+        boot(name, query);
+}
+
+void mp::WarmPool::save_instance_names()
+{
+    QByteArray names;
+    for (const auto& pooled : suspended)
+        names += QByteArray::fromStdString(pooled.instance.name) + '\n';
+    for (const auto& [_, instance] : booting)
+    {
+        if (!instance.name.empty())
+            names += QByteArray::fromStdString(instance.name) + '\n';
+    }
+
+    mp::top_catch_all(category, [this, &names] {
+        MP_FILEOPS.write_transactionally(instances_dir(factory).filePath(instance_names_file),
+                                         names);
+    });
+}
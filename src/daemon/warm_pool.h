@@ -0,0 +1,184 @@
+/*
+ * Copyright (C) Canonical, Ltd.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#pragma once
+
+#include <multipass/virtual_machine_description.h>
+#include <multipass/vm_status_monitor.h>
+
+#include <QString>
+#include <QThreadPool>
+
+#include <boost/json.hpp>
+
+#include <atomic>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace multipass
+{
+class Query;
+class VirtualMachineFactory;
+class VMImageVault;
+
+struct WarmPoolProfile
+{
+    std::string remote_name;
+    std::string release;
+    int size;         // prepared images
+    int instances{0}; // booted and suspended instances
+
+    bool operator==(const WarmPoolProfile&) const = default;
+};
+
+// Parses the value of the warm pool setting: a comma-separated list of
+// `[<remote>:]<image>=<images>[+<instances>]`
+std::vector<WarmPoolProfile> parse_warm_pool_profiles(const QString& setting);
+
+/*
+ * Keeps instances ready ahead of time, per profile, in two forms.
+ *
+ * Prepared images are fetched, extracted and copied into their own instance directories, under
+ * reserved names. A launch whose image matches a profile adopts one of them instead of going
+ * through the vault. They are never booted, so the launched instance still gets its own name,
+ * cloud-init configuration and networks.
+ *
+ * Pooled instances go further: the daemon boots them from a prepared image, under a generated name
+ * and with the default resources and cloud-init configuration, and suspends them once cloud-init
+ * is done. A launch that asks for nothing more than the image, without a name, takes one of them
+ * over and only has to resume it.
+ *
+ * The pool tops itself up again in the background, and drops whatever was prepared from an image
+ * that has since been updated.
+ */
+class WarmPool : public VMStatusMonitor
+{
+public:
+    // A booted and suspended instance, to be resumed under its own name
+    struct Instance
+    {
+        std::string name;
+        VirtualMachineDescription desc;
+        boost::json::object metadata;
+    };
+
+    // Boots an instance from the prepared image pooled_name, which matches the query, taking it
+    // over with hand_over() and reporting back with booted() or boot_failed(). Called from the
+    // pool's thread.
+    using BootAction = std::function<void(const std::string& pooled_name, const Query& query)>;
+    // Gives back what booting an instance reserved, once the pool drops it. Called from any thread.
+    using ReleaseAction = std::function<void(const VirtualMachineDescription& desc)>;
+
+    WarmPool(std::vector<WarmPoolProfile> profiles,
+             VirtualMachineFactory& factory,
+             VMImageVault& vault,
+             BootAction boot = {},
+             ReleaseAction release = {});
+    ~WarmPool() override;
+
+    // Hands a prepared image matching the query over to the instance it names, so that fetching
+    // the image for that instance finds it in place. Returns whether there was one to hand over.
+    bool claim(const Query& query);
+
+    // Takes a pooled instance booted from the image in the query out of the pool
+    std::optional<Instance> claim_instance(const Query& query);
+
+    // Moves the prepared image pooled_name over to the instance name, returning whether it could
+    bool hand_over(const std::string& pooled_name, const std::string& name);
+    void booted(const std::string& pooled_name, Instance instance);
+    void boot_failed(const std::string& pooled_name);
+
+    // Whether name is taken by a pooled instance, and dropping it to free the name
+    bool holds(const std::string& name);
+    void discard_instance(const std::string& name);
+
+    // Drops whatever was prepared from an image that is no longer the latest for its profile
+    void discard_stale();
+
+    // Starts preparing images and instances for any profile that is short of its size
+    void refill();
+
+    // Pooled instances report to the pool while they are booted
+    void on_resume() override;
+    void on_shutdown() override;
+    void on_suspend() override;
+    void on_restart(const std::string& name) override;
+    void persist_state_for(const std::string& name, const VirtualMachine::State& state) override;
+    void update_metadata_for(const std::string& name, const boost::json::object& metadata) override;
+    boost::json::object retrieve_metadata_for(const std::string& name) override;
+
+private:
+    enum class Kind
+    {
+        image,
+        instance
+    };
+
+    struct Entry
+    {
+        std::size_t profile;
+        std::string name;
+        std::string image_id;
+    };
+
+    struct Pooled
+    {
+        std::size_t profile;
+        Instance instance;
+    };
+
+    struct Booting
+    {
+        std::size_t profile;
+        std::string name; // once the prepared image is handed over
+    };
+
+    struct Provisioned
+    {
+        int images{0};    // both ready and still being prepared
+        int instances{0}; // both suspended and still being prepared or booted
+    };
+
+    std::optional<std::size_t> profile_for(const Query& query) const;
+    void discard(const std::string& name);
+    void discard(const Instance& instance);
+    void discard_leftovers();
+    void prepare(std::size_t profile, const std::string& name, Kind kind);
+    void save_instance_names(); // requires the lock
+
+    const std::vector<WarmPoolProfile> profiles;
+    VirtualMachineFactory& factory;
+    VMImageVault& vault;
+    const BootAction boot;
+    const ReleaseAction release;
+
+    std::mutex mutex;
+    std::vector<Entry> ready;
+    std::vector<Pooled> suspended;
+    std::unordered_map<std::string, Booting> booting; // by prepared image
+    std::unordered_map<std::string, boost::json::object> metadata; // of pooled instances
+    std::vector<Provisioned> provisioned; // per profile
+    int serial{0};
+    std::atomic_bool stopping{false};
+    QThreadPool fill_pool; // keeps refills off the global pool, which launches rely on
+};
+} // namespace multipass
@@ -15,18 +15,26 @@
  *
  */
 
+#include <multipass/exceptions/image_not_found_exception.h>
 #include <multipass/format.h>
 #include <multipass/image_host/base_image_host.h>
 #include <multipass/logging/log.h>
 #include <multipass/platform.h>
 
+#include <QString>
+
 namespace mp = multipass;
 namespace mpl = multipass::logging;
 
 namespace
 {
 constexpr auto category = "VMImageHost";
+
+std::string full_hash_key(const std::string& full_hash)
+{
+    return QString::fromStdString(full_hash).toLower().toStdString();
 }
+} // namespace
 
 mp::BaseVMImageHost::BaseVMImageHost(URLDownloader* downloader) : url_downloader(downloader)
 {
@@ -48,7 +56,11 @@ auto mp::BaseVMImageHost::all_info_for(const Query& query) const
 auto mp::BaseVMImageHost::info_for_full_hash(const std::string& full_hash) const -> VMImageInfo
 {
     std::shared_lock lock{manifest_mutex};
-    return info_for_full_hash_impl(full_hash);
+    if (auto it = images_by_full_hash.find(full_hash_key(full_hash));
+        it != images_by_full_hash.end())
+        return *it->second;
+
+    throw mp::ImageNotFoundException(full_hash);
 }
 
 auto mp::BaseVMImageHost::all_images_for(const std::string& remote_name,
@@ -64,11 +76,30 @@ void mp::BaseVMImageHost::for_each_entry_do(const Action& action) const
     for_each_entry_do_impl(action);
 }
 
+auto mp::BaseVMImageHost::refresh_statuses() const -> std::vector<RemoteRefreshStatus>
+{
+    std::shared_lock lock{manifest_mutex};
+    return refresh_statuses_impl();
+}
+
 void mp::BaseVMImageHost::update_manifests(bool force_update)
+{
+    replace_manifests(fetch_manifests(force_update));
+}
+
+void mp::BaseVMImageHost::replace_manifests(const std::function<void()>& install)
 {
     std::lock_guard lock{manifest_mutex};
-    clear();
-    fetch_manifests(force_update);
+    images_by_full_hash.clear();
+    install();
+    index_full_hashes();
+}
+
+void mp::BaseVMImageHost::index_full_hashes()
+{
+    for_each_entry_do_impl([this](const std::string&, const VMImageInfo& info) {
+        images_by_full_hash.try_emplace(full_hash_key(info.id), &info);
+    });
 }
 
 void mp::BaseVMImageHost::on_manifest_empty(const std::string& details)
@@ -29,6 +29,7 @@
 
 #include <boost/json.hpp>
 
+#include <memory>
 #include <utility>
 
 namespace mp = multipass;
@@ -150,31 +151,27 @@ void mp::CustomVMImageHost::for_each_entry_do_impl(const Action& action) const
     }
 }
 
-mp::VMImageInfo mp::CustomVMImageHost::info_for_full_hash_impl(const std::string& full_hash) const
+std::vector<mp::RemoteRefreshStatus> mp::CustomVMImageHost::refresh_statuses_impl() const
 {
-    for (const auto& product : manifest.second->products)
-    {
-        if (multipass::utils::iequals(product.id, full_hash))
-        {
-            return product;
-        }
-    }
-
-    throw mp::ImageNotFoundException(full_hash);
+    return {};
 }
 
-void mp::CustomVMImageHost::fetch_manifests(bool force_update)
+std::function<void()> mp::CustomVMImageHost::fetch_manifests(bool force_update)
 {
+    auto fetched = std::make_shared<std::unique_ptr<CustomManifest>>();
     try
     {
-        auto custom_manifest = std::make_unique<mp::CustomManifest>(
+        *fetched = std::make_unique<mp::CustomManifest>(
             fetch_image_info(arch, url_downloader, force_update));
-        manifest = std::make_pair(no_remote, std::move(custom_manifest));
     }
-    catch (mp::DownloadException& e)
+    catch (...)
     {
-        throw e;
+        // Nothing is served after a failed update
+        replace_manifests([this] { clear(); });
+        throw;
     }
+
+    return [this, fetched] { manifest = std::make_pair(no_remote, std::move(*fetched)); };
 }
 
 void mp::CustomVMImageHost::clear()
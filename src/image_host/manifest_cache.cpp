@@ -0,0 +1,201 @@
+/*
+ * Copyright (C) Canonical, Ltd.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "manifest_cache.h"
+
+#include <multipass/file_ops.h>
+#include <multipass/format.h>
+#include <multipass/logging/log.h>
+
+#include <QDataStream>
+#include <QFile>
+
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace mp = multipass;
+namespace mpl = multipass::logging;
+
+namespace
+{
+constexpr auto category = "manifest cache";
+constexpr quint32 magic = 0x4d504d43; // "MPMC"
+constexpr quint32 format_version = 2;
+constexpr auto stream_version = QDataStream::Qt_6_0;
+
+class StringTable
+{
+public:
+    quint32 index_of(const std::string& str)
+    {
+        const auto [it, inserted] = indices.try_emplace(str, static_cast<quint32>(strings.size()));
+        if (inserted)
+            strings.push_back(&it->first);
+
+        return it->second;
+    }
+
+    void write_to(QDataStream& stream) const
+    {
+        stream << static_cast<quint32>(strings.size());
+        for (const auto* str : strings)
+            stream << QByteArray::fromStdString(*str);
+    }
+
+private:
+    std::unordered_map<std::string, quint32> indices;
+    std::vector<const std::string*> strings;
+};
+
+const std::string& read_string(QDataStream& stream, const std::vector<std::string>& strings)
+{
+    quint32 index = 0;
+    stream >> index;
+    if (index >= strings.size())
+        throw std::out_of_range{fmt::format("String index {} out of range", index)};
+
+    return strings[index];
+}
+} // namespace
+
+void mp::manifest_cache::save(const QString& file_path,
+                              const QString& source_url,
+                              const SimpleStreamsManifest& manifest,
+                              std::chrono::system_clock::time_point fetched_at)
+{
+    StringTable table;
+    QByteArray products;
+    QDataStream products_stream{&products, QIODevice::WriteOnly};
+    products_stream.setVersion(stream_version);
+
+    products_stream << static_cast<quint32>(manifest.products.size());
+    for (const auto& info : manifest.products)
+    {
+        products_stream << static_cast<quint32>(info.aliases.size());
+        for (const auto& alias : info.aliases)
+            products_stream << table.index_of(alias);
+
+        products_stream << table.index_of(info.os) << table.index_of(info.release)
+                        << table.index_of(info.release_title)
+                        << table.index_of(info.release_codename) << info.supported
+                        << table.index_of(info.image_location) << table.index_of(info.id)
+                        << table.index_of(info.stream_location) << table.index_of(info.version)
+                        << static_cast<qint64>(info.size) << info.verify;
+    }
+
+    QByteArray data;
+    QDataStream stream{&data, QIODevice::WriteOnly};
+    stream.setVersion(stream_version);
+    const auto fetched_at_ms =
+        std::chrono::duration_cast<std::chrono::milliseconds>(fetched_at.time_since_epoch());
+    stream << magic << format_version << source_url << manifest.updated_at
+           << static_cast<qint64>(fetched_at_ms.count());
+    table.write_to(stream);
+    stream.writeRawData(products.constData(), products.size());
+
+    MP_FILEOPS.write_transactionally(file_path, data);
+    mpl::debug(category, "Saved {} products to {}", manifest.products.size(), file_path);
+}
+
+auto mp::manifest_cache::load(const QString& file_path, const QString& source_url)
+    -> std::optional<CachedManifest>
+try
+{
+    QFile file{file_path};
+    if (!MP_FILEOPS.exists(file) || !MP_FILEOPS.open(file, QIODevice::ReadOnly))
+        return std::nullopt;
+
+    const auto size = file.size();
+    QDataStream stream{&file};
+    stream.setVersion(stream_version);
+
+    quint32 file_magic = 0, file_version = 0;
+    QString file_source_url, updated_at;
+    qint64 fetched_at_ms = 0;
+    stream >> file_magic >> file_version >> file_source_url >> updated_at >> fetched_at_ms;
+    if (stream.status() != QDataStream::Ok || file_magic != magic ||
+        file_version != format_version)
+    {
+        mpl::warn(category, "Ignoring {}, which is not a cached manifest", file_path);
+        return std::nullopt;
+    }
+
+    if (file_source_url != source_url)
+    {
+        mpl::debug(category, "Ignoring {}, which is from {}", file_path, file_source_url);
+        return std::nullopt;
+    }
+
+    quint32 num_strings = 0;
+    stream >> num_strings;
+    std::vector<std::string> strings;
+    strings.reserve(std::min<qint64>(num_strings, size));
+    for (quint32 i = 0; i < num_strings && stream.status() == QDataStream::Ok; ++i)
+    {
+        QByteArray str;
+        stream >> str;
+        strings.push_back(str.toStdString());
+    }
+
+    quint32 num_products = 0;
+    stream >> num_products;
+    std::vector<VMImageInfo> products;
+    for (quint32 i = 0; i < num_products && stream.status() == QDataStream::Ok; ++i)
+    {
+        VMImageInfo info;
+
+        quint32 num_aliases = 0;
+        stream >> num_aliases;
+        for (quint32 j = 0; j < num_aliases && stream.status() == QDataStream::Ok; ++j)
+            info.aliases.push_back(read_string(stream, strings));
+
+        info.os = read_string(stream, strings);
+        info.release = read_string(stream, strings);
+        info.release_title = read_string(stream, strings);
+        info.release_codename = read_string(stream, strings);
+        stream >> info.supported;
+        info.image_location = read_string(stream, strings);
+        info.id = read_string(stream, strings);
+        info.stream_location = read_string(stream, strings);
+        info.version = read_string(stream, strings);
+
+        qint64 image_size = 0;
+        stream >> image_size >> info.verify;
+        info.size = image_size;
+
+        products.push_back(std::move(info));
+    }
+
+    if (stream.status() != QDataStream::Ok || products.empty())
+    {
+        mpl::warn(category, "Ignoring {}, which is incomplete", file_path);
+        return std::nullopt;
+    }
+
+    mpl::debug(category, "Loaded {} products from {}", products.size(), file_path);
+    return CachedManifest{std::make_unique<SimpleStreamsManifest>(updated_at, std::move(products)),
+                          std::chrono::system_clock::time_point{
+                              std::chrono::milliseconds{fetched_at_ms}}};
+}
+catch (const std::out_of_range& e)
+{
+    mpl::warn(category, "Ignoring {}, which is corrupt: {}", file_path, e.what());
+    return std::nullopt;
+}
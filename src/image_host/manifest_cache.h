@@ -0,0 +1,53 @@
+/*
+ * Copyright (C) Canonical, Ltd.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#pragma once
+
+#include <multipass/simple_streams_manifest.h>
+
+#include <QString>
+
+#include <chrono>
+#include <memory>
+#include <optional>
+
+namespace multipass::manifest_cache
+{
+/*
+ * Parsed manifests, kept on disk between daemon runs so that images can be found before the
+ * manifests are downloaded again.
+ *
+ * A cached manifest is a binary table of its products, where each distinct string is stored once
+ * and products refer to strings by index. It is tagged with the URL it was downloaded from, so that
+ * a manifest from a previous mirror is not taken for the current one, and with when it was.
+ */
+
+struct CachedManifest
+{
+    std::unique_ptr<SimpleStreamsManifest> manifest;
+    std::chrono::system_clock::time_point fetched_at;
+};
+
+// Throws if the file cannot be written
+void save(const QString& file_path,
+          const QString& source_url,
+          const SimpleStreamsManifest& manifest,
+          std::chrono::system_clock::time_point fetched_at);
+
+// Returns nullopt if there is no usable manifest from source_url in the file
+std::optional<CachedManifest> load(const QString& file_path, const QString& source_url);
+} // namespace multipass::manifest_cache
@@ -15,12 +15,15 @@
  *
  */
 
+#include "manifest_cache.h"
+
 #include <multipass/constants.h>
 #include <multipass/exceptions/download_exception.h>
 #include <multipass/exceptions/image_not_found_exception.h>
 #include <multipass/exceptions/manifest_exceptions.h>
 #include <multipass/exceptions/unsupported_image_exception.h>
 #include <multipass/image_host/ubuntu_image_host.h>
+#include <multipass/logging/log.h>
 #include <multipass/platform.h>
 #include <multipass/query.h>
 #include <multipass/settings/settings.h>
@@ -28,15 +31,20 @@
 #include <multipass/url_downloader.h>
 #include <multipass/utils.h>
 
+#include <QDir>
 #include <QUrl>
 
 #include <algorithm>
+#include <memory>
 #include <unordered_set>
+#include <utility>
 
 namespace mp = multipass;
+namespace mpl = multipass::logging;
 
 namespace
 {
+constexpr auto category = "ubuntu image host";
 constexpr auto index_path = "streams/v1/index.json";
 
 auto download_manifest(const std::string& host_url,
@@ -109,9 +117,23 @@ bool mp::UbuntuVMImageRemote::default_image_mutator(VMImageInfo&)
 
 mp::UbuntuVMImageHost::UbuntuVMImageHost(
     std::vector<std::pair<std::string, UbuntuVMImageRemote>> remotes,
-    URLDownloader* downloader)
-    : BaseVMImageHost{downloader}, remotes{std::move(remotes)}
+    URLDownloader* downloader,
+    const QString& manifest_cache_dir,
+    const ManifestRefreshPolicy& refresh_policy)
+    : BaseVMImageHost{downloader},
+      remotes{std::move(remotes)},
+      manifest_cache_dir{manifest_cache_dir},
+      refresh_policy{refresh_policy}
+{
+    refresh_pool.setMaxThreadCount(refresh_policy.max_parallel_downloads);
+    // Threads that stay keep their connections to the remotes open for the next refresh
+    refresh_pool.setExpiryTimeout(-1);
+}
+
+mp::UbuntuVMImageHost::~UbuntuVMImageHost()
 {
+    if (background_refresh.valid())
+        background_refresh.wait();
 }
 
 std::optional<mp::VMImageInfo> mp::UbuntuVMImageHost::info_for_impl(const Query& query) const
@@ -181,22 +203,6 @@ std::vector<std::pair<std::string, mp::VMImageInfo>> mp::UbuntuVMImageHost::all_
     return images;
 }
 
-mp::VMImageInfo mp::UbuntuVMImageHost::info_for_full_hash_impl(const std::string& full_hash) const
-{
-    for (const auto& manifest : manifests)
-    {
-        for (const auto& product : manifest.second->products)
-        {
-            if (utils::iequals(product.id, full_hash))
-            {
-                return product;
-            }
-        }
-    }
-
-    throw mp::ImageNotFoundException(full_hash);
-}
-
 std::vector<mp::VMImageInfo> mp::UbuntuVMImageHost::all_images_for_impl(
     const std::string& remote_name,
     bool allow_unsupported) const
@@ -242,63 +248,303 @@ std::vector<std::string> mp::UbuntuVMImageHost::supported_remotes() const
     return supported_remotes;
 }
 
-void mp::UbuntuVMImageHost::fetch_manifests(bool force_update)
+auto mp::UbuntuVMImageHost::refresh_statuses_impl() const -> std::vector<RemoteRefreshStatus>
 {
-    auto fetch_one_remote =
-        [this, force_update](const std::pair<std::string, UbuntuVMImageRemote>& remote_pair)
-        -> std::pair<std::string, std::unique_ptr<SimpleStreamsManifest>> {
-        const auto& [remote_name, remote_info] = remote_pair;
+    std::vector<RemoteRefreshStatus> statuses;
+    for (const auto& [remote_name, _] : remotes)
+    {
+        if (const auto it = health.find(remote_name); it != health.end())
+            statuses.push_back({remote_name, it->second.last_error, it->second.fetched_at});
+    }
+
+    return statuses;
+}
+
+std::function<void()> mp::UbuntuVMImageHost::fetch_manifests(bool force_update)
+{
+    if (!force_update && !manifest_cache_dir.isEmpty() && !std::exchange(cache_checked, true))
+    {
+        FetchTimes fetched_at;
+        if (auto cached = load_cached_manifests(fetched_at); cached.size() == remotes.size())
+        {
+            // Refreshed once they are in, so that the fresh manifests are swapped in after them
+            auto shared_cached = std::make_shared<Manifests>(std::move(cached));
+            return [this, shared_cached, fetched_at] {
+                manifests = std::move(*shared_cached);
+                for (const auto& [remote_name, time] : fetched_at)
+                    health[remote_name].fetched_at = time;
+
+                background_refresh =
+                    std::async(std::launch::async, [this] { refresh_in_background(); });
+            };
+        }
+    }
 
+    // Remotes that keep failing are left alone until they are due to be tried again, unless asked
+    const auto now = std::chrono::steady_clock::now();
+    std::vector<const Remote*> due, skipped;
+    {
+        std::shared_lock lock{manifest_mutex}; // health is only changed under it, when installing
+        for (const auto& remote : remotes)
+        {
+            const auto it = health.find(remote.first);
+            if (force_update || it == health.end() || it->second.retry_after <= now)
+            {
+                due.push_back(&remote);
+            }
+            else
+            {
+                mpl::debug(category, "Not refreshing \"{}\" until it is due", remote.first);
+                skipped.push_back(&remote);
+            }
+        }
+    }
+
+    auto fetched =
+        std::make_shared<std::vector<RemoteFetch>>(download_manifests(due, force_update));
+    return [this, fetched, skipped] {
+        install(*fetched);
+
+        // With nothing to serve, the caller needs to know to try again soon, remotes that were left
+        // alone included
+        if (manifests.empty())
+        {
+            for (const auto& fetch : *fetched)
+            {
+                if (fetch.download_error)
+                    std::rethrow_exception(fetch.download_error);
+            }
+
+            for (const auto* remote : skipped)
+                throw DownloadException{remote->second.get_official_url(),
+                                        fmt::format("not tried again yet, after: {}",
+                                                    health[remote->first].last_error)};
+        }
+    };
+}
+
+std::unique_ptr<mp::SimpleStreamsManifest> mp::UbuntuVMImageHost::fetch_manifest(
+    const Remote& remote,
+    bool force_update)
+{
+    const auto& [remote_name, remote_info] = remote;
+
+    auto official_site = remote_info.get_official_url();
+    auto manifest_bytes_from_official =
+        download_manifest(official_site, url_downloader, force_update);
+
+    auto mirror_site = remote_info.get_mirror_url();
+    std::optional<QByteArray> manifest_bytes_from_mirror = std::nullopt;
+    if (mirror_site)
+    {
+        auto bytes = download_manifest(mirror_site.value(), url_downloader, force_update);
+        manifest_bytes_from_mirror = std::make_optional(bytes);
+    }
+
+    const auto source_url = QString::fromStdString(mirror_site.value_or(official_site));
+    auto manifest = mp::SimpleStreamsManifest::fromJson(
+        manifest_bytes_from_official,
+        manifest_bytes_from_mirror,
+        source_url,
+        [&remote_info](VMImageInfo& info) { return remote_info.apply_image_mutator(info); });
+
+    if (!manifest_cache_dir.isEmpty())
+    {
         try
         {
-            auto official_site = remote_info.get_official_url();
-            auto manifest_bytes_from_official =
-                download_manifest(official_site, url_downloader, force_update);
+            manifest_cache::save(cache_file_for(remote_name),
+                                 source_url,
+                                 *manifest,
+                                 std::chrono::system_clock::now());
+        }
+        catch (const std::exception& e)
+        {
+            mpl::warn(category,
+                      "Could not cache the manifest of {}: {}",
+                      remote_name,
+                      e.what());
+        }
+    }
+
+    return manifest;
+}
 
-            auto mirror_site = remote_info.get_mirror_url();
-            std::optional<QByteArray> manifest_bytes_from_mirror = std::nullopt;
-            if (mirror_site)
+auto mp::UbuntuVMImageHost::download_manifests(const std::vector<const Remote*>& due,
+                                               bool force_update) -> std::vector<RemoteFetch>
+{
+    using Promise = std::promise<std::unique_ptr<SimpleStreamsManifest>>;
+
+    // Downloads that overrun the deadline are left to finish in the pool, with nobody waiting.
+    // Remotes whose download is still there are not given another one, which would only queue up
+    // behind it and take a thread from the others.
+    std::vector<std::future<std::unique_ptr<SimpleStreamsManifest>>> futures;
+    for (const auto* remote : due)
+    {
+        auto& future = futures.emplace_back();
+        {
+            std::lock_guard lock{downloading_mutex};
+            if (!downloading.insert(remote->first).second)
+                continue;
+        }
+
+        auto promise = std::make_shared<Promise>();
+        future = promise->get_future();
+
+        refresh_pool.start([this, remote, force_update, promise] {
+            std::unique_ptr<SimpleStreamsManifest> manifest;
+            std::exception_ptr error;
+            try
             {
-                auto bytes = download_manifest(mirror_site.value(), url_downloader, force_update);
-                manifest_bytes_from_mirror = std::make_optional(bytes);
+                manifest = fetch_manifest(*remote, force_update);
             }
+            catch (...)
+            {
+                error = std::current_exception();
+            }
+
+            // Done before anyone waiting hears of it, so that they can start the next one
+            {
+                std::lock_guard lock{downloading_mutex};
+                downloading.erase(remote->first);
+            }
+
+            if (error)
+                promise->set_exception(error);
+            else
+                promise->set_value(std::move(manifest));
+        });
+    }
+
+    const auto deadline = std::chrono::steady_clock::now() + refresh_policy.deadline;
+    std::vector<RemoteFetch> fetched;
+    for (std::size_t i = 0; i < due.size(); ++i)
+    {
+        auto& fetch = fetched.emplace_back(RemoteFetch{due[i]->first});
 
-            auto manifest = mp::SimpleStreamsManifest::fromJson(
-                manifest_bytes_from_official,
-                manifest_bytes_from_mirror,
-                QString::fromStdString(mirror_site.value_or(official_site)),
-                [&remote_info](VMImageInfo& info) {
-                    return remote_info.apply_image_mutator(info);
-                });
+        if (!futures[i].valid())
+        {
+            fetch.error = "the previous download has not finished yet";
+            fetch.download_error = std::make_exception_ptr(
+                DownloadException{due[i]->second.get_official_url(), *fetch.error});
+            continue;
+        }
+
+        if (futures[i].wait_until(deadline) == std::future_status::timeout)
+        {
+            fetch.error = fmt::format("no manifest within {}ms", refresh_policy.deadline.count());
+            fetch.download_error = std::make_exception_ptr(
+                DownloadException{due[i]->second.get_official_url(), *fetch.error});
+            continue;
+        }
 
-            return std::make_pair(remote_name, std::move(manifest));
+        try
+        {
+            fetch.manifest = futures[i].get();
         }
-        catch (mp::EmptyManifestException& /* e */)
+        catch (const mp::EmptyManifestException&)
         {
             on_manifest_empty(
-                fmt::format("Did not find any supported products in \"{}\"", remote_name));
+                fmt::format("Did not find any supported products in \"{}\"", fetch.remote_name));
         }
-        catch (mp::GenericManifestException& e)
+        catch (const mp::GenericManifestException& e)
         {
             on_manifest_update_failure(e.what());
+            fetch.error = e.what();
         }
-        catch (mp::DownloadException& e)
+        catch (const mp::DownloadException& e)
         {
-            throw e;
+            fetch.error = e.what();
+            fetch.download_error = std::current_exception();
         }
-        return {};
-    };
+        catch (const std::exception& e)
+        {
+            fetch.error = e.what();
+        }
+    }
+
+    return fetched;
+}
+
+void mp::UbuntuVMImageHost::install(std::vector<RemoteFetch>& fetched)
+{
+    const auto now = std::chrono::steady_clock::now();
+
+    for (auto& fetch : fetched)
+    {
+        auto& remote_health = health[fetch.remote_name];
+        auto it = std::ranges::find(manifests, fetch.remote_name, &Manifests::value_type::first);
+
+        if (!fetch.error)
+        {
+            remote_health = {};
+            if (fetch.manifest)
+                remote_health.fetched_at = std::chrono::system_clock::now();
+
+            if (it == manifests.end())
+                manifests.emplace_back(fetch.remote_name, std::move(fetch.manifest));
+            else
+                it->second = std::move(fetch.manifest);
+
+            continue;
+        }
+
+        // Whatever was there before stays
+        remote_health.last_error = *fetch.error;
+        const auto failures = ++remote_health.consecutive_failures;
+        if (failures < refresh_policy.failures_before_backoff)
+        {
+            mpl::warn(category, "Could not refresh \"{}\": {}", fetch.remote_name, *fetch.error);
+            continue;
+        }
+
+        const auto doublings = std::min(failures - refresh_policy.failures_before_backoff, 16);
+        const auto backoff = std::min(refresh_policy.min_backoff * (1 << doublings),
+                                      refresh_policy.max_backoff);
+        remote_health.retry_after = now + backoff;
+        mpl::warn(category,
+                  "Could not refresh \"{}\" {} times in a row, not trying again for {}s: {}",
+                  fetch.remote_name,
+                  failures,
+                  std::chrono::duration_cast<std::chrono::seconds>(backoff).count(),
+                  *fetch.error);
+    }
+
+    // Remotes without products are not served
+    std::erase_if(manifests, [](const auto& manifest) { return !manifest.second; });
+}
+
+auto mp::UbuntuVMImageHost::load_cached_manifests(FetchTimes& fetched_at) const -> Manifests
+{
+    Manifests cached;
+    for (const auto& [remote_name, remote_info] : remotes)
+    {
+        const auto source_url =
+            remote_info.get_mirror_url().value_or(remote_info.get_official_url());
+        if (auto entry = manifest_cache::load(cache_file_for(remote_name),
+                                              QString::fromStdString(source_url)))
+        {
+            cached.emplace_back(remote_name, std::move(entry->manifest));
+            fetched_at[remote_name] = entry->fetched_at;
+        }
+    }
+
+    return cached;
+}
+
+void mp::UbuntuVMImageHost::refresh_in_background()
+{
+    std::vector<const Remote*> all;
+    for (const auto& remote : remotes)
+        all.push_back(&remote);
 
-    auto local_manifests = mp::utils::parallel_transform(remotes, fetch_one_remote);
-    // append local_manifests to manifests
-    manifests.insert(manifests.end(),
-                     std::make_move_iterator(local_manifests.begin()),
-                     std::make_move_iterator(local_manifests.end()));
+    // Remotes that cannot be refreshed keep the manifests from the cache
+    auto fetched = download_manifests(all, false);
+    replace_manifests([this, &fetched] { install(fetched); });
 }
 
-void mp::UbuntuVMImageHost::clear()
+QString mp::UbuntuVMImageHost::cache_file_for(const std::string& remote_name) const
 {
-    manifests.clear();
+    return QDir{manifest_cache_dir}.filePath(QString::fromStdString(remote_name) + ".manifest");
 }
 
 const mp::SimpleStreamsManifest& mp::UbuntuVMImageHost::manifest_from(
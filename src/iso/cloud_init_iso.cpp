@@ -20,13 +20,23 @@
 #include <multipass/cloud_init_iso.h>
 #include <multipass/file_ops.h>
 #include <multipass/format.h>
+#include <multipass/platform.h>
 #include <multipass/yaml_node_utils.h>
 
+#include <algorithm>
 #include <array>
 #include <bit>
 #include <cctype>
+#include <cerrno>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <limits>
 #include <span>
 #include <stdexcept>
+#include <system_error>
+
+#include <fcntl.h>
 
 namespace mp = multipass;
 namespace mpu = multipass::utils;
@@ -121,54 +131,39 @@ void set_at(T& t, SizeType offset, const V& value)
     std::copy(std::begin(value), std::end(value), t.begin() + offset);
 }
 
+// The ISO is put together in memory and written in one go, each part appended to the image
 template <typename T>
-void write(const T& t, std::ofstream& f)
+void append(std::string& image, const T& t)
 {
-    f.write(reinterpret_cast<const char*>(t.data.data()), t.data.size());
+    image.append(reinterpret_cast<const char*>(t.data.data()), t.data.size());
 }
 
-// The below three utility functions should serve as the abstraction layer for binary file reading,
-// the std::vector<uint8_t>, std::array<uint8_t, N> and uint8_t should be the only ones to receive
-// data because they indicate the nature of the data which is raw binary bytes.
-std::vector<uint8_t> read_bytes_to_vec(std::ifstream& file, std::streampos pos, size_t size)
+// The below three utility functions are the only ones to pick data out of an image that is read,
+// checking that it is all there. The spans, arrays and uint8_t they return indicate the nature of
+// the data, which is raw binary bytes.
+std::span<const uint8_t> bytes_at(std::span<const uint8_t> image, size_t pos, size_t size)
 {
-    std::vector<uint8_t> buffer(size);
-    file.seekg(pos);
-
-    if (!MP_FILEOPS.read(file, reinterpret_cast<char*>(buffer.data()), size))
+    if (pos > image.size() || size > image.size() - pos)
     {
         throw std::runtime_error(
-            fmt::format("Can not read {} bytes data from file at {}.", size, std::streamoff(pos)));
+            fmt::format("Can not read {} bytes data from the image at {}, which has only {}.",
+                        size,
+                        pos,
+                        image.size()));
     }
 
-    return buffer;
+    return image.subspan(pos, size);
 }
 
 template <size_t N>
-std::array<uint8_t, N> read_bytes_to_array(std::ifstream& file, std::streampos pos)
+std::span<const uint8_t, N> array_at(std::span<const uint8_t> image, size_t pos)
 {
-    std::array<uint8_t, N> buffer{};
-    file.seekg(pos);
-    if (!MP_FILEOPS.read(file, reinterpret_cast<char*>(buffer.data()), N))
-    {
-        throw std::runtime_error(
-            fmt::format("Can not read {} bytes data from file at {}.", N, std::streamoff(pos)));
-    }
-
-    return buffer;
+    return bytes_at(image, pos, N).first<N>();
 }
 
-uint8_t read_single_byte(std::ifstream& file, std::streampos pos)
+uint8_t byte_at(std::span<const uint8_t> image, size_t pos)
 {
-    uint8_t data{};
-    file.seekg(pos);
-    if (!MP_FILEOPS.read(file, reinterpret_cast<char*>(&data), 1))
-    {
-        throw std::runtime_error(
-            fmt::format("Can not read the next byte data from file at {}.", std::streamoff(pos)));
-    }
-
-    return data;
+    return bytes_at(image, pos, 1)[0];
 }
 
 template <size_t size>
@@ -456,17 +451,71 @@ std::size_t num_blocks(std::size_t num_bytes)
     return ((num_bytes + logical_block_size - 1) / logical_block_size);
 }
 
-void seek_to_next_block(std::ofstream& f)
+void pad_to_next_block(std::string& image)
 {
-    const auto next_block_pos = num_blocks(f.tellp()) * logical_block_size;
-    f.seekp(next_block_pos);
+    image.resize(num_blocks(image.size()) * logical_block_size, '\0');
+}
+
+bool write_all(int fd, std::string_view data)
+{
+    while (!data.empty())
+    {
+        const auto chunk = std::min<std::size_t>(data.size(), std::numeric_limits<int>::max());
+        const auto written = MP_FILEOPS.write(fd, data.data(), chunk);
+        if (written <= 0)
+            return false;
+
+        data.remove_prefix(written);
+    }
+
+    return true;
 }
 
-void pad_to_end(std::ofstream& f)
+void write_atomically(const std::filesystem::path& path, std::string_view image)
 {
-    seek_to_next_block(f);
-    f.seekp(-1, std::ios::cur);
-    f.put('\0');
+    // Whoever reads the ISO, including a hypervisor holding it open, sees either the old contents
+    // or the new ones, never a mix or a truncated file, and neither does anyone after a crash
+    auto temp_path = path;
+    temp_path += ".tmp";
+
+    {
+        auto file = MP_FILEOPS.open_fd(temp_path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if (file->fd < 0)
+            throw std::runtime_error{fmt::format(
+                "Failed to open file for writing during cloud-init generation; path: {}",
+                temp_path.string())};
+
+        // The contents reach the disk before the rename does, so that a crash cannot leave the new
+        // name on an empty file
+        if (!write_all(file->fd, image) || !MP_FILEOPS.fsync(file->fd))
+        {
+            const std::string error = std::strerror(errno);
+            file.reset();
+            std::filesystem::remove(temp_path);
+            throw std::runtime_error{fmt::format("Failed to write cloud-init ISO; path: {}: {}",
+                                                 temp_path.string(),
+                                                 error)};
+        }
+    }
+
+    std::error_code err;
+    std::filesystem::rename(temp_path, path, err);
+    if (err)
+    {
+        std::filesystem::remove(temp_path);
+        throw std::runtime_error{fmt::format("Failed to replace cloud-init ISO {}: {}",
+                                             path.string(),
+                                             err.message())};
+    }
+
+    // And the rename is on disk before the ISO is used, so that it is not undone by a crash
+    const auto dir = path.has_parent_path() ? path.parent_path() : std::filesystem::path{"."};
+    if (!mp::platform::sync_directory(dir))
+        throw std::runtime_error{
+            fmt::format("Failed to sync {} after writing cloud-init ISO {}: {}",
+                        dir.string(),
+                        path.string(),
+                        std::strerror(errno))};
 }
 } // namespace
 
@@ -535,17 +584,15 @@ bool mp::CloudInitIso::erase(const std::string& name)
     return false;
 }
 
-void mp::CloudInitIso::write_to(const std::filesystem::path& path)
+void mp::CloudInitIso::write_to(const std::filesystem::path& path) const
 {
-    std::ofstream f{path, std::ios::binary | std::ios::out};
-    if (!f.is_open())
-        throw std::runtime_error{
-            fmt::format("Failed to open file for writing during cloud-init generation; path: {}",
-                        path.string())};
+    write_atomically(path, serialise());
+}
 
+std::string mp::CloudInitIso::serialise() const
+{
     const uint32_t num_reserved_bytes = 32768u;
     const uint32_t num_reserved_blocks = num_blocks(num_reserved_bytes);
-    f.seekp(num_reserved_bytes);
 
     PrimaryVolumeDescriptor prim_desc;
     JolietVolumeDescriptor joliet_desc;
@@ -595,44 +642,47 @@ void mp::CloudInitIso::write_to(const std::filesystem::path& path)
         current_block_index += num_blocks(entry.data.size());
     }
 
-    write(prim_desc, f);
-    write(joliet_desc, f);
-    write(VolumeDescriptorSetTerminator(), f);
+    std::string image;
+    image.reserve(volume_size * logical_block_size);
+    image.resize(num_reserved_bytes, '\0');
+
+    append(image, prim_desc);
+    append(image, joliet_desc);
+    append(image, VolumeDescriptorSetTerminator());
 
-    write(root_path, f);
-    seek_to_next_block(f);
-    write(joliet_root_path, f);
-    seek_to_next_block(f);
+    append(image, root_path);
+    pad_to_next_block(image);
+    append(image, joliet_root_path);
+    pad_to_next_block(image);
 
-    write(root_record, f);
-    write(root_parent_record, f);
+    append(image, root_record);
+    append(image, root_parent_record);
     for (const auto& iso_record : iso_file_records)
     {
-        write(iso_record, f);
+        append(image, iso_record);
     }
-    seek_to_next_block(f);
+    pad_to_next_block(image);
 
-    write(joliet_root_record, f);
-    write(joliet_root_parent_record, f);
+    append(image, joliet_root_record);
+    append(image, joliet_root_parent_record);
     for (const auto& joliet_record : joliet_file_records)
     {
-        write(joliet_record, f);
+        append(image, joliet_record);
     }
-    seek_to_next_block(f);
+    pad_to_next_block(image);
 
     for (const auto& entry : files)
     {
-        f.write(entry.data.data(), entry.data.size());
-        seek_to_next_block(f);
+        image.append(entry.data);
+        pad_to_next_block(image);
     }
-    pad_to_end(f);
+
+    return image;
 }
 
 void mp::CloudInitIso::read_from(const std::filesystem::path& fs_path)
 {
-    // Please refer to the cloud_Init_Iso_read_me.md file for the preliminaries and the thought
-    // process of the implementation
-    std::ifstream iso_file{fs_path, std::ios_base::in | std::ios::binary};
+    std::ifstream iso_file{fs_path, std::ios_base::in | std::ios::binary | std::ios::ate};
     if (!MP_FILEOPS.is_open(iso_file))
     {
         throw std::runtime_error{fmt::format(R"("Failed to open file "{}" for reading: {}.")",
@@ -640,15 +690,35 @@ void mp::CloudInitIso::read_from(const std::filesystem::path& fs_path)
                                              strerror(errno))};
     }
 
+    // The whole image is read at once, to be picked apart in memory
+    const auto size = static_cast<std::streamsize>(iso_file.tellg());
+    std::vector<uint8_t> image(std::max<std::streamsize>(size, 0));
+    iso_file.seekg(0);
+    if (!MP_FILEOPS.read(iso_file, reinterpret_cast<char*>(image.data()), image.size()))
+    {
+        throw std::runtime_error(fmt::format("Can not read {} bytes data from file {}.",
+                                             image.size(),
+                                             fs_path.string()));
+    }
+
+    auto entries = parse(image);
+    files.insert(files.end(),
+                 std::make_move_iterator(entries.begin()),
+                 std::make_move_iterator(entries.end()));
+}
+
+std::vector<mp::CloudInitIso::FileEntry> mp::CloudInitIso::parse(std::span<const uint8_t> image)
+{
+    // Please refer to the cloud_Init_Iso_read_me.md file for the preliminaries and the thought
+    // process of the implementation
     const uint32_t num_reserved_bytes = 32768u; // 16 data blocks, 32kb
     const uint32_t joliet_des_start_pos = num_reserved_bytes + sizeof(PrimaryVolumeDescriptor);
-    if (read_single_byte(iso_file, joliet_des_start_pos) != 2_u8)
+    if (byte_at(image, joliet_des_start_pos) != 2_u8)
     {
         throw std::runtime_error("The Joliet volume descriptor is not in place.");
     }
 
-    const std::array<uint8_t, 5> volume_identifier =
-        read_bytes_to_array<5>(iso_file, joliet_des_start_pos + 1u);
+    const auto volume_identifier = array_at<5>(image, joliet_des_start_pos + 1u);
     if (std::string_view(reinterpret_cast<const char*>(volume_identifier.data()),
                          volume_identifier.size()) != "CD001")
     {
@@ -656,8 +726,7 @@ void mp::CloudInitIso::read_from(const std::filesystem::path& fs_path)
     }
 
     const uint32_t root_dir_record_data_start_pos = joliet_des_start_pos + 156u;
-    const std::array<uint8_t, 34> root_dir_record_data =
-        read_bytes_to_array<34>(iso_file, root_dir_record_data_start_pos);
+    const auto root_dir_record_data = array_at<34>(image, root_dir_record_data_start_pos);
     // size of the data should 34, record is a directory entry and directory is a root directory
     // instead of a root parent directory
     if (root_dir_record_data[0] != 34_u8 || root_dir_record_data[25] != 2_u8 ||
@@ -667,116 +736,147 @@ void mp::CloudInitIso::read_from(const std::filesystem::path& fs_path)
     }
 
     // location lsb_msb bytes starts from 2
-    std::span<const uint8_t, 8> root_dir_record_data_location_lsb_bytes(
-        root_dir_record_data.begin() + 2u,
-        std::size_t(8));
     const uint32_t root_dir_record_data_location_by_blocks =
-        from_lsb_msb(root_dir_record_data_location_lsb_bytes);
-    const uint32_t file_records_start_pos =
-        root_dir_record_data_location_by_blocks * logical_block_size +
+        from_lsb_msb(root_dir_record_data.subspan<2, 8>());
+    const size_t file_records_start_pos =
+        size_t{root_dir_record_data_location_by_blocks} * logical_block_size +
         2u * sizeof(RootDirRecord); // total size of root dir and root dir parent
 
-    uint32_t current_file_record_start_pos = file_records_start_pos;
+    std::vector<FileEntry> entries;
+    size_t current_file_record_start_pos = file_records_start_pos;
     while (true)
     {
-        const uint8_t file_record_data_size =
-            read_single_byte(iso_file, current_file_record_start_pos);
+        const uint8_t file_record_data_size = byte_at(image, current_file_record_start_pos);
         if (file_record_data_size == 0_u8)
         {
             break;
         }
 
-        // In each iteration, the file record provides the size and location of the extent.
-        // Initially, we utilize this information to navigate to and read the file data.
-        // Subsequently, we return to the file record to extract the file name.
+        // In each iteration, the file record provides the size and location of the extent, which
+        // lead to the file data, and the file name
         const uint32_t file_content_location_by_blocks =
-            from_lsb_msb(read_bytes_to_array<8>(iso_file, current_file_record_start_pos + 2u));
+            from_lsb_msb(array_at<8>(image, current_file_record_start_pos + 2u));
         const uint32_t file_content_size =
-            from_lsb_msb(read_bytes_to_array<8>(iso_file, current_file_record_start_pos + 10u));
-        const std::vector<uint8_t> file_content =
-            read_bytes_to_vec(iso_file,
-                              file_content_location_by_blocks * logical_block_size,
-                              file_content_size);
-
-        const uint32_t file_name_length_start_pos = current_file_record_start_pos + 32u;
-        const uint8_t encoded_file_name_length =
-            read_single_byte(iso_file, file_name_length_start_pos);
-        const uint32_t file_name_start_pos = file_name_length_start_pos + 1u;
-        const std::vector<uint8_t> encoded_file_name =
-            read_bytes_to_vec(iso_file, file_name_start_pos, to_u32(encoded_file_name_length));
+            from_lsb_msb(array_at<8>(image, current_file_record_start_pos + 10u));
+        const auto file_content =
+            bytes_at(image,
+                     size_t{file_content_location_by_blocks} * logical_block_size,
+                     file_content_size);
+
+        const size_t file_name_length_start_pos = current_file_record_start_pos + 32u;
+        const uint8_t encoded_file_name_length = byte_at(image, file_name_length_start_pos);
+        const auto encoded_file_name =
+            bytes_at(image, file_name_length_start_pos + 1u, to_u32(encoded_file_name_length));
 
         const std::string original_file_name = convert_u16_name_back(
             std::string_view{reinterpret_cast<const char*>(encoded_file_name.data()),
                              encoded_file_name.size()});
-        files.emplace_back(
-            FileEntry{original_file_name, std::string{file_content.cbegin(), file_content.cend()}});
+        entries.emplace_back(
+            FileEntry{original_file_name, std::string{file_content.begin(), file_content.end()}});
 
         current_file_record_start_pos += to_u32(file_record_data_size);
     }
-}
 
-mp::CloudInitFileOps::CloudInitFileOps(
-    const Singleton<CloudInitFileOps>::PrivatePass& pass) noexcept
-    : Singleton<CloudInitFileOps>::Singleton{pass}
-{
+    return entries;
 }
 
-void mp::CloudInitFileOps::update_cloud_init_with_new_extra_interfaces_and_new_id(
+void mp::CloudInitIso::set_extra_interfaces_and_instance_id(
     const std::string& default_mac_addr,
     const std::vector<NetworkInterface>& extra_interfaces,
-    const std::string& new_instance_id,
-    const std::filesystem::path& cloud_init_path) const
+    const std::string& new_instance_id)
 {
-    CloudInitIso iso_file;
-    iso_file.read_from(cloud_init_path);
-
-    std::string& meta_data_file_content = iso_file.at("meta-data");
+    std::string& meta_data_file_content = at("meta-data");
     meta_data_file_content = mpu::emit_cloud_config(
         mpu::make_cloud_init_meta_config_with_id_tweak(meta_data_file_content, new_instance_id));
 
     // overwrite the whole network-config file content
-    iso_file["network-config"] = mpu::emit_cloud_config(
+    (*this)["network-config"] = mpu::emit_cloud_config(
         mpu::make_cloud_init_network_config(default_mac_addr, extra_interfaces));
-    iso_file.write_to(cloud_init_path);
 }
 
-void mp::CloudInitFileOps::update_identifiers(const std::string& default_mac_addr,
-                                              const std::vector<NetworkInterface>& extra_interfaces,
-                                              const std::string& new_hostname,
-                                              const std::filesystem::path& cloud_init_path) const
+void mp::CloudInitIso::set_identifiers(const std::string& default_mac_addr,
+                                       const std::vector<NetworkInterface>& extra_interfaces,
+                                       const std::string& new_hostname)
 {
-    CloudInitIso iso_file;
-    iso_file.read_from(cloud_init_path);
-
-    std::string& meta_data_file_content = iso_file.at("meta-data");
+    std::string& meta_data_file_content = at("meta-data");
     meta_data_file_content = mpu::emit_cloud_config(
         mpu::make_cloud_init_meta_config(new_hostname, meta_data_file_content));
 
-    std::string& network_config_file_content = iso_file["network-config"];
+    std::string& network_config_file_content = (*this)["network-config"];
     network_config_file_content =
         mpu::emit_cloud_config(mpu::make_cloud_init_network_config(default_mac_addr,
                                                                    extra_interfaces,
                                                                    network_config_file_content));
+}
+
+void mp::CloudInitIso::add_extra_interface(const std::string& default_mac_addr,
+                                           const NetworkInterface& extra_interface)
+{
+    std::string& meta_data_file_content = at("meta-data");
+    meta_data_file_content = mpu::emit_cloud_config(
+        mpu::make_cloud_init_meta_config_with_id_tweak(meta_data_file_content));
+
+    std::string& network_config_file_content = (*this)["network-config"];
+    network_config_file_content =
+        mpu::emit_cloud_config(mpu::add_extra_interface_to_network_config(
+            default_mac_addr,
+            extra_interface,
+            network_config_file_content));
+}
+
+std::string mp::CloudInitIso::instance_id() const
+{
+    const auto meta_data_node = YAML::Load(at("meta-data"));
+
+    return meta_data_node["instance-id"].as<std::string>();
+}
 
+mp::CloudInitFileOps::CloudInitFileOps(
+    const Singleton<CloudInitFileOps>::PrivatePass& pass) noexcept
+    : Singleton<CloudInitFileOps>::Singleton{pass}
+{
+}
+
+void mp::CloudInitFileOps::update_cloud_init(const std::filesystem::path& cloud_init_path,
+                                             const std::function<void(CloudInitIso&)>& update) const
+{
+    CloudInitIso iso_file;
+    iso_file.read_from(cloud_init_path);
+    update(iso_file);
     iso_file.write_to(cloud_init_path);
 }
 
+void mp::CloudInitFileOps::update_cloud_init_with_new_extra_interfaces_and_new_id(
+    const std::string& default_mac_addr,
+    const std::vector<NetworkInterface>& extra_interfaces,
+    const std::string& new_instance_id,
+    const std::filesystem::path& cloud_init_path) const
+{
+    update_cloud_init(cloud_init_path, [&](CloudInitIso& iso_file) {
+        iso_file.set_extra_interfaces_and_instance_id(default_mac_addr,
+                                                      extra_interfaces,
+                                                      new_instance_id);
+    });
+}
+
+void mp::CloudInitFileOps::update_identifiers(const std::string& default_mac_addr,
+                                              const std::vector<NetworkInterface>& extra_interfaces,
+                                              const std::string& new_hostname,
+                                              const std::filesystem::path& cloud_init_path) const
+{
+    update_cloud_init(cloud_init_path, [&](CloudInitIso& iso_file) {
+        iso_file.set_identifiers(default_mac_addr, extra_interfaces, new_hostname);
+    });
+}
+
 void mp::CloudInitFileOps::add_extra_interface_to_cloud_init(
     const std::string& default_mac_addr,
     const NetworkInterface& extra_interface,
     const std::filesystem::path& cloud_init_path) const
 {
-    CloudInitIso iso_file;
-    iso_file.read_from(cloud_init_path);
-    std::string& meta_data_file_content = iso_file.at("meta-data");
-    meta_data_file_content = mpu::emit_cloud_config(
-        mpu::make_cloud_init_meta_config_with_id_tweak(meta_data_file_content));
-
-    iso_file["network-config"] = mpu::emit_cloud_config(
-        mpu::add_extra_interface_to_network_config(default_mac_addr,
-                                                   extra_interface,
-                                                   iso_file["network-config"]));
-    iso_file.write_to(cloud_init_path);
+    update_cloud_init(cloud_init_path, [&](CloudInitIso& iso_file) {
+        iso_file.add_extra_interface(default_mac_addr, extra_interface);
+    });
 }
 
 std::string mp::CloudInitFileOps::get_instance_id_from_cloud_init(
@@ -784,8 +884,6 @@ std::string mp::CloudInitFileOps::get_instance_id_from_cloud_init(
 {
     CloudInitIso iso_file;
     iso_file.read_from(cloud_init_path);
-    const std::string& meta_data_file_content = iso_file.at("meta-data");
-    const auto meta_data_node = YAML::Load(meta_data_file_content);
 
-    return meta_data_node["instance-id"].as<std::string>();
+    return iso_file.instance_id();
 }
@@ -22,6 +22,7 @@
 #include <QString>
 #include <QtGlobal>
 
+#include <atomic>
 #include <shared_mutex>
 #include <stdexcept>
 
@@ -31,6 +32,9 @@ namespace
 {
 std::shared_timed_mutex mutex;
 std::shared_ptr<multipass::logging::Logger> global_logger;
+// The most verbose level the global logger takes, kept apart so that checking it takes no lock.
+// Without a logger, everything goes to stderr.
+std::atomic<mpl::Level> enabled_level{mpl::Level::trace};
 
 mpl::Level to_level(QtMsgType type)
 {
@@ -54,6 +58,17 @@ void qt_message_handler(QtMsgType type, const QMessageLogContext&, const QString
     auto msg = message.toLocal8Bit();
     mpl::log_message(to_level(type), "Qt", msg.constData());
 }
+
+// To be called with the mutex held
+void update_enabled_level()
+{
+    auto level = mpl::Level::trace;
+    if (global_logger)
+        while (level != mpl::Level::error && !global_logger->is_enabled(level))
+            level = static_cast<mpl::Level>(static_cast<int>(level) - 1);
+
+    enabled_level.store(level, std::memory_order_relaxed);
+}
 } // namespace
 
 void mpl::log_message(Level level, std::string_view category, std::string_view message)
@@ -65,6 +80,17 @@ void mpl::log_message(Level level, std::string_view category, std::string_view m
         fmt::print(stderr, "[{}] [{}] {}\n", as_string(level), category, message);
 }
 
+bool mpl::is_enabled(Level level)
+{
+    return level <= enabled_level.load(std::memory_order_relaxed);
+}
+
+void mpl::refresh_enabled_level()
+{
+    std::shared_lock<decltype(mutex)> lock{mutex};
+    update_enabled_level();
+}
+
 mpl::Level mpl::get_logging_level()
 {
     if (global_logger)
@@ -79,6 +105,7 @@ void mpl::set_logger(std::shared_ptr<Logger> logger)
 {
     std::lock_guard<decltype(mutex)> lock{mutex};
     global_logger = std::move(logger);
+    update_enabled_level();
     qInstallMessageHandler(qt_message_handler);
 }
 
@@ -0,0 +1,85 @@
+/*
+ * Copyright (C) Canonical, Ltd.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "log_ring_buffer.h"
+
+#include <algorithm>
+#include <bit>
+
+namespace mpl = multipass::logging;
+
+namespace
+{
+// How far ahead of the expected position a sequence number is, wrapping included
+std::ptrdiff_t lead(std::size_t sequence, std::size_t position)
+{
+    return static_cast<std::ptrdiff_t>(sequence - position);
+}
+} // namespace
+
+mpl::LogRingBuffer::LogRingBuffer(std::size_t capacity)
+    : mask{std::bit_ceil(std::max<std::size_t>(capacity, 2)) - 1},
+      slots{std::make_unique<Slot[]>(mask + 1)}
+{
+    for (std::size_t i = 0; i <= mask; ++i)
+        slots[i].sequence.store(i, std::memory_order_relaxed);
+}
+
+bool mpl::LogRingBuffer::try_push(LogEntry& entry)
+{
+    auto position = enqueue_position.load(std::memory_order_relaxed);
+    for (;;)
+    {
+        auto& slot = slots[position & mask];
+        const auto ahead = lead(slot.sequence.load(std::memory_order_acquire), position);
+
+        if (ahead == 0)
+        {
+            // The slot is free for this position, try to claim it
+            if (enqueue_position.compare_exchange_weak(position,
+                                                       position + 1,
+                                                       std::memory_order_relaxed))
+            {
+                slot.entry = std::move(entry);
+                slot.sequence.store(position + 1, std::memory_order_release);
+                return true;
+            }
+        }
+        else if (ahead < 0)
+            return false; // the consumer has yet to free the slot, a lap behind: we are full
+        else
+            position = enqueue_position.load(std::memory_order_relaxed); // someone beat us to it
+    }
+}
+
+bool mpl::LogRingBuffer::try_pop(LogEntry& entry)
+{
+    auto& slot = slots[dequeue_position & mask];
+    if (lead(slot.sequence.load(std::memory_order_acquire), dequeue_position + 1) < 0)
+        return false; // not published yet
+
+    entry = std::move(slot.entry);
+    slot.sequence.store(dequeue_position + mask + 1, std::memory_order_release);
+    ++dequeue_position;
+
+    return true;
+}
+
+std::size_t mpl::LogRingBuffer::capacity() const noexcept
+{
+    return mask + 1;
+}
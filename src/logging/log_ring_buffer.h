@@ -0,0 +1,77 @@
+/*
+ * Copyright (C) Canonical, Ltd.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#pragma once
+
+#include <multipass/disabled_copy_move.h>
+#include <multipass/logging/level.h>
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <string>
+
+namespace multipass
+{
+namespace logging
+{
+struct LogEntry
+{
+    Level level;
+    std::string category;
+    std::string message;
+};
+
+/**
+ * A bounded queue of log entries, which any number of threads can push to without taking locks
+ * and a single thread pops from.
+ *
+ * Every slot carries a sequence number that tells whose turn it is: producers claim a position
+ * with a CAS on the enqueue position and publish the entry by bumping the slot's sequence, which
+ * is what the consumer waits for. See Dmitry Vyukov's bounded MPMC queue.
+ */
+class LogRingBuffer : private DisabledCopyMove
+{
+public:
+    explicit LogRingBuffer(std::size_t capacity); // rounded up to a power of two
+
+    // Moves the entry in and returns true, or leaves it alone and returns false if the buffer is
+    // full
+    bool try_push(LogEntry& entry);
+
+    // Only ever to be called from one thread at a time
+    bool try_pop(LogEntry& entry);
+
+    std::size_t capacity() const noexcept;
+
+private:
+    struct Slot
+    {
+        std::atomic_size_t sequence;
+        LogEntry entry;
+    };
+
+    static constexpr std::size_t cache_line = 64;
+
+    const std::size_t mask;
+    const std::unique_ptr<Slot[]> slots;
+    alignas(cache_line) std::atomic_size_t enqueue_position{0};
+    alignas(cache_line) std::size_t dequeue_position{0};
+};
+} // namespace logging
+} // namespace multipass
@@ -17,33 +17,215 @@
 
 #include <multipass/logging/multiplexing_logger.h>
 
+#include "log_ring_buffer.h"
+
+#include <multipass/format.h>
+#include <multipass/logging/log.h>
+
 #include <algorithm>
+#include <thread>
 
 namespace mpl = multipass::logging;
 
-multipass::logging::MultiplexingLogger::MultiplexingLogger(UPtr system_logger)
-    : Logger{system_logger->get_logging_level()}, system_logger{std::move(system_logger)}
+class mpl::MultiplexingLogger::AsyncSink
+{
+public:
+    AsyncSink(const Logger& system_logger, AsyncOptions options)
+        : system_logger{system_logger},
+          queue{options.capacity},
+          overflow{options.overflow},
+          drainer{[this] { drain(); }}
+    {
+    }
+
+    ~AsyncSink()
+    {
+        stopping.store(true, std::memory_order_release);
+        wake_drainer();
+        drainer.join(); // after draining whatever is left
+    }
+
+    void push(Level level, std::string_view category, std::string_view message)
+    {
+        LogEntry entry{level, std::string{category}, std::string{message}};
+        for (;;)
+        {
+            const auto popped_before = popped.load(std::memory_order_acquire);
+            if (queue.try_push(entry))
+                break;
+
+            if (overflow == OverflowPolicy::drop)
+            {
+                dropped.fetch_add(1, std::memory_order_relaxed);
+                return;
+            }
+
+            popped.wait(popped_before, std::memory_order_acquire);
+        }
+
+        pushed.fetch_add(1, std::memory_order_release);
+        wake_drainer();
+    }
+
+    void flush() const
+    {
+        const auto target = pushed.load(std::memory_order_acquire);
+        for (auto current = popped.load(std::memory_order_acquire); current < target;
+             current = popped.load(std::memory_order_acquire))
+            popped.wait(current, std::memory_order_acquire);
+    }
+
+    std::uint64_t dropped_count() const
+    {
+        return dropped.load(std::memory_order_relaxed);
+    }
+
+private:
+    void wake_drainer()
+    {
+        wakeups.fetch_add(1, std::memory_order_release);
+        wakeups.notify_one();
+    }
+
+    void drain()
+    {
+        std::uint64_t reported_drops = 0;
+        LogEntry entry;
+
+        for (;;)
+        {
+            const auto wakeups_before = wakeups.load(std::memory_order_acquire);
+
+            while (queue.try_pop(entry))
+            {
+                write(entry.level, entry.category, entry.message);
+                popped.fetch_add(1, std::memory_order_release);
+                popped.notify_all();
+            }
+
+            if (const auto drops = dropped_count(); drops != reported_drops)
+            {
+                write(Level::warning,
+                      "logging",
+                      fmt::format("Dropped {} log messages, the queue was full",
+                                  drops - reported_drops));
+                reported_drops = drops;
+            }
+
+            if (popped.load(std::memory_order_acquire) != pushed.load(std::memory_order_acquire))
+                std::this_thread::yield(); // a producer claimed a slot but is yet to fill it
+            else if (stopping.load(std::memory_order_acquire))
+                return;
+            else
+                wakeups.wait(wakeups_before, std::memory_order_acquire);
+        }
+    }
+
+    void write(Level level, std::string_view category, std::string_view message) const
+    {
+        try
+        {
+            system_logger.log(level, category, message);
+        }
+        catch (...)
+        {
+            // There is nowhere left to report this, but it must not bring the drainer down
+        }
+    }
+
+    const Logger& system_logger;
+    LogRingBuffer queue;
+    const OverflowPolicy overflow;
+    std::atomic_uint64_t pushed{0};
+    std::atomic_uint64_t popped{0};
+    std::atomic_uint64_t dropped{0};
+    std::atomic_uint64_t wakeups{0};
+    std::atomic_bool stopping{false};
+    std::thread drainer; // last, to start once everything else is in place
+};
+
+mpl::MultiplexingLogger::MultiplexingLogger(UPtr system_logger)
+    : Logger{system_logger->get_logging_level()},
+      system_logger{std::move(system_logger)},
+      enabled_level{logging_level}
 {
 }
 
+mpl::MultiplexingLogger::MultiplexingLogger(UPtr system_logger, AsyncOptions options)
+    : Logger{system_logger->get_logging_level()},
+      system_logger{std::move(system_logger)},
+      enabled_level{logging_level},
+      async_sink{std::make_unique<AsyncSink>(*this->system_logger, options)}
+{
+}
+
+mpl::MultiplexingLogger::~MultiplexingLogger() = default;
+
 void mpl::MultiplexingLogger::log(mpl::Level level,
                                   std::string_view category,
                                   std::string_view message) const
 {
+    if (!async_sink)
+        system_logger->log(level, category, message);
+    else if (level <= logging_level) // don't queue what the system logger would filter out anyway
+        async_sink->push(level, category, message);
+
+    // Client loggers only come and go with requests, so most messages have none to go to. One
+    // added concurrently can miss this message, as it could have had it been added a bit later.
+    if (logger_count.load(std::memory_order_acquire) == 0)
+        return;
+
     std::shared_lock<decltype(mutex)> lock{mutex};
-    system_logger->log(level, category, message);
     for (auto logger : loggers)
         logger->log(level, category, message);
 }
 
+bool mpl::MultiplexingLogger::is_enabled(Level level) const
+{
+    return level <= enabled_level.load(std::memory_order_relaxed);
+}
+
 void mpl::MultiplexingLogger::add_logger(const Logger* logger)
 {
-    std::lock_guard<decltype(mutex)> lock{mutex};
-    loggers.push_back(logger);
+    {
+        std::lock_guard<decltype(mutex)> lock{mutex};
+        loggers.push_back(logger);
+        logger_count.store(loggers.size(), std::memory_order_release);
+        update_enabled_level();
+    }
+
+    refresh_enabled_level(); // in case this is the global logger
 }
 
 void mpl::MultiplexingLogger::remove_logger(const Logger* logger)
 {
-    std::lock_guard<decltype(mutex)> lock{mutex};
-    loggers.erase(std::remove(loggers.begin(), loggers.end(), logger), loggers.end());
+    {
+        std::lock_guard<decltype(mutex)> lock{mutex};
+        loggers.erase(std::remove(loggers.begin(), loggers.end(), logger), loggers.end());
+        logger_count.store(loggers.size(), std::memory_order_release);
+        update_enabled_level();
+    }
+
+    refresh_enabled_level();
+}
+
+void mpl::MultiplexingLogger::flush() const
+{
+    if (async_sink)
+        async_sink->flush();
+}
+
+std::uint64_t mpl::MultiplexingLogger::dropped() const
+{
+    return async_sink ? async_sink->dropped_count() : 0;
+}
+
+// To be called with the mutex held
+void mpl::MultiplexingLogger::update_enabled_level()
+{
+    auto level = logging_level;
+    for (auto logger : loggers)
+        level = std::max(level, logger->get_logging_level());
+
+    enabled_level.store(level, std::memory_order_relaxed);
 }
@@ -0,0 +1,363 @@
+/*
+ * Copyright (C) Canonical, Ltd.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#include <multipass/delta_downloader.h>
+
+#include <multipass/exceptions/aborted_download_exception.h>
+#include <multipass/exceptions/download_exception.h>
+#include <multipass/format.h>
+#include <multipass/logging/log.h>
+#include <multipass/url_downloader.h>
+
+#include <QCryptographicHash>
+#include <QFile>
+#include <QUrl>
+
+#include <algorithm>
+#include <cstdint>
+#include <stdexcept>
+#include <unordered_map>
+#include <vector>
+
+namespace mp = multipass;
+namespace mpl = multipass::logging;
+
+namespace
+{
+constexpr auto category = "delta downloader";
+constexpr qint64 max_range_gap = 256 * 1024; // unit: bytes; cheaper to fetch than a new request
+constexpr auto min_reused_share = 0.5; // of the new file, for a delta to be worth the requests
+
+struct ControlFile
+{
+    qint64 length = 0;
+    qint64 block_size = 0;
+    int seq_matches = 1;
+    int rsum_bytes = 4;
+    int checksum_bytes = 16;
+    QByteArray sha1;
+    std::vector<std::uint32_t> rsums;
+    std::vector<QByteArray> checksums;
+
+    qint64 block_count() const
+    {
+        return (length + block_size - 1) / block_size;
+    }
+};
+
+// The weak checksum from rsync, which can be rolled along a file one byte at a time
+struct RollingChecksum
+{
+    std::uint16_t a = 0;
+    std::uint16_t b = 0;
+
+    RollingChecksum(const char* data, qint64 size)
+    {
+        for (qint64 i = 0; i < size; ++i)
+        {
+            a += static_cast<uchar>(data[i]);
+            b += static_cast<std::uint16_t>((size - i) * static_cast<uchar>(data[i]));
+        }
+    }
+
+    void roll(char out, char in, qint64 block_size)
+    {
+        a += static_cast<uchar>(in) - static_cast<uchar>(out);
+        b += a - static_cast<std::uint16_t>(block_size * static_cast<uchar>(out));
+    }
+
+    // Control files only keep the lower bytes of the checksum
+    std::uint32_t value(int bytes) const
+    {
+        const auto full = std::uint32_t{a} << 16 | b;
+        return bytes == 4 ? full : full & ((1u << 8 * bytes) - 1);
+    }
+};
+
+QByteArray strong_checksum(const char* data, qint64 size, const ControlFile& control)
+{
+    QByteArray block{data, static_cast<qsizetype>(size)};
+    block.resize(control.block_size, '\0'); // the last block is checksummed padded with zeros
+
+    return QCryptographicHash::hash(block, QCryptographicHash::Md4).first(control.checksum_bytes);
+}
+
+ControlFile parse_control_file(const QByteArray& data)
+{
+    ControlFile control;
+    qsizetype pos = 0;
+
+    while (true)
+    {
+        const auto end = data.indexOf('\n', pos);
+        if (end < 0)
+            throw std::runtime_error{"truncated zsync header"};
+
+        const auto line = data.sliced(pos, end - pos);
+        pos = end + 1;
+        if (line.isEmpty())
+            break;
+
+        const auto colon = line.indexOf(':');
+        if (colon < 0)
+            throw std::runtime_error{fmt::format("invalid zsync header line: {}", line)};
+
+        const auto key = line.first(colon);
+        const auto value = line.sliced(colon + 1).trimmed();
+        if (key == "Length")
+            control.length = value.toLongLong();
+        else if (key == "Blocksize")
+            control.block_size = value.toLongLong();
+        else if (key == "SHA-1")
+            control.sha1 = QByteArray::fromHex(value);
+        else if (key == "Z-Map2")
+            throw std::runtime_error{"compressed zsync targets are not supported"};
+        else if (key == "Hash-Lengths")
+        {
+            const auto lengths = value.split(',');
+            if (lengths.size() != 3)
+                throw std::runtime_error{fmt::format("invalid zsync hash lengths: {}", value)};
+
+            control.seq_matches = lengths[0].toInt();
+            control.rsum_bytes = lengths[1].toInt();
+            control.checksum_bytes = lengths[2].toInt();
+        }
+    }
+
+    if (control.length <= 0 || control.block_size <= 0 || control.seq_matches < 1 ||
+        control.seq_matches > 2 || control.rsum_bytes < 1 || control.rsum_bytes > 4 ||
+        control.checksum_bytes < 3 || control.checksum_bytes > 16 || control.sha1.size() != 20)
+        throw std::runtime_error{"invalid zsync header"};
+
+    const auto entry_size = control.rsum_bytes + control.checksum_bytes;
+    if (data.size() - pos < control.block_count() * entry_size)
+        throw std::runtime_error{"truncated zsync block list"};
+
+    for (qint64 i = 0; i < control.block_count(); ++i, pos += entry_size)
+    {
+        std::uint32_t rsum = 0;
+        for (int byte = 0; byte < control.rsum_bytes; ++byte)
+            rsum = rsum << 8 | static_cast<uchar>(data[pos + byte]);
+
+        control.rsums.push_back(rsum);
+        control.checksums.push_back(data.sliced(pos + control.rsum_bytes, control.checksum_bytes));
+    }
+
+    return control;
+}
+
+// Finds where in the seed each block of the new file is, if anywhere, as an offset or -1
+std::vector<qint64> find_blocks(const ControlFile& control, const char* seed, qint64 seed_size)
+{
+    const auto block_size = control.block_size;
+    std::vector<qint64> found(control.block_count(), -1);
+
+    std::unordered_multimap<std::uint32_t, qint64> blocks_by_rsum;
+    for (qint64 i = 0; i < control.block_count(); ++i)
+        blocks_by_rsum.emplace(control.rsums[i], i);
+
+    const auto matches = [&](qint64 block, qint64 pos, const QByteArray& checksum) {
+        if (control.checksums[block] != checksum)
+            return false;
+
+        // Weak control files need the following block to match too, where there is one
+        const auto next = block + 1;
+        if (control.seq_matches == 1 || next == control.block_count())
+            return true;
+        if (pos + 2 * block_size > seed_size)
+            return false;
+
+        const auto next_pos = seed + pos + block_size;
+        return RollingChecksum{next_pos, block_size}.value(control.rsum_bytes) ==
+                   control.rsums[next] &&
+               strong_checksum(next_pos, block_size, control) == control.checksums[next];
+    };
+
+    qint64 pos = 0;
+    while (pos + block_size <= seed_size)
+    {
+        RollingChecksum rsum{seed + pos, block_size};
+        for (; pos + block_size <= seed_size; ++pos)
+        {
+            bool matched = false;
+            auto [first, last] = blocks_by_rsum.equal_range(rsum.value(control.rsum_bytes));
+            if (first != last)
+            {
+                const auto checksum = strong_checksum(seed + pos, block_size, control);
+                for (auto it = first; it != last; ++it)
+                {
+                    if (found[it->second] < 0 && matches(it->second, pos, checksum))
+                    {
+                        // Identical blocks can all be taken from the same place
+                        found[it->second] = pos;
+                        matched = true;
+                    }
+                }
+            }
+
+            if (matched)
+            {
+                pos += block_size;
+                break; // start over with a fresh checksum after the match
+            }
+
+            if (pos + block_size < seed_size)
+                rsum.roll(seed[pos], seed[pos + block_size], block_size);
+        }
+    }
+
+    return found;
+}
+
+struct Range
+{
+    qint64 begin;
+    qint64 end;
+};
+
+// Merges the blocks that were not found into as few ranges as is reasonable
+std::vector<Range> missing_ranges(const ControlFile& control, const std::vector<qint64>& found)
+{
+    std::vector<Range> ranges;
+    for (qint64 i = 0; i < control.block_count(); ++i)
+    {
+        if (found[i] >= 0)
+            continue;
+
+        const auto begin = i * control.block_size;
+        const auto end = std::min(begin + control.block_size, control.length);
+        if (!ranges.empty() && begin - ranges.back().end <= max_range_gap)
+            ranges.back().end = end;
+        else
+            ranges.push_back({begin, end});
+    }
+
+    return ranges;
+}
+
+void write_at(QFile& file, qint64 pos, const char* data, qint64 size)
+{
+    if (!file.seek(pos) || file.write(data, size) != size)
+        throw std::runtime_error{
+            fmt::format("error writing {}: {}", file.fileName(), file.errorString())};
+}
+} // namespace
+
+mp::DeltaDownloader::DeltaDownloader(URLDownloader* downloader) : downloader{downloader}
+{
+}
+
+bool mp::DeltaDownloader::download_to(const QUrl& url,
+                                      const QString& seed_file_name,
+                                      const QString& file_name,
+                                      const int progress_type,
+                                      const ProgressMonitor& monitor)
+{
+    QByteArray control_data;
+    try
+    {
+        control_data = downloader->download(QUrl{url.toString() + ".zsync"}, true);
+    }
+    catch (const DownloadException& e)
+    {
+        mpl::debug(category, "No delta available for {}: {}", url.toString(), e.what());
+        return false;
+    }
+
+    if (control_data.isEmpty())
+        return false;
+
+    const auto control = parse_control_file(control_data);
+
+    QFile seed_file{seed_file_name};
+    if (!seed_file.open(QIODevice::ReadOnly))
+        throw std::runtime_error{
+            fmt::format("cannot open {}: {}", seed_file_name, seed_file.errorString())};
+
+    const auto seed_size = seed_file.size();
+    const auto seed = seed_size ? reinterpret_cast<const char*>(seed_file.map(0, seed_size))
+                                : nullptr;
+    if (seed_size && !seed)
+        throw std::runtime_error{
+            fmt::format("cannot map {}: {}", seed_file_name, seed_file.errorString())};
+
+    const auto found = find_blocks(control, seed, seed_size);
+    const auto ranges = missing_ranges(control, found);
+
+    qint64 to_fetch = 0;
+    for (const auto& range : ranges)
+        to_fetch += range.end - range.begin;
+
+    mpl::info(category,
+              "Reusing {} of {} bytes of {} from {}",
+              control.length - to_fetch,
+              control.length,
+              url.toString(),
+              seed_file_name);
+
+    if (to_fetch > control.length * (1 - min_reused_share))
+        return false;
+
+    QFile file{file_name};
+    if (!file.open(QIODevice::ReadWrite | QIODevice::Truncate))
+        throw std::runtime_error{fmt::format("unable to write to file \"{}\"", file_name)};
+
+    try
+    {
+        for (qint64 i = 0; i < control.block_count(); ++i)
+        {
+            if (found[i] >= 0)
+            {
+                const auto pos = i * control.block_size;
+                write_at(file,
+                         pos,
+                         seed + found[i],
+                         std::min(control.block_size, control.length - pos));
+            }
+        }
+
+        qint64 fetched = 0;
+        for (const auto& range : ranges)
+        {
+            const auto length = range.end - range.begin;
+            if (!file.seek(range.begin))
+                throw std::runtime_error{
+                    fmt::format("error writing {}: {}", file_name, file.errorString())};
+            downloader->download_range_to(url, range.begin, length, file);
+
+            fetched += length;
+            if (!monitor(progress_type, static_cast<int>(100 * fetched / to_fetch)))
+                throw AbortedDownloadException{"Delta download aborted"};
+        }
+
+        if (!file.resize(control.length) || !file.seek(0))
+            throw std::runtime_error{
+                fmt::format("error writing {}: {}", file_name, file.errorString())};
+
+        QCryptographicHash sha1{QCryptographicHash::Sha1};
+        sha1.addData(&file);
+        if (sha1.result() != control.sha1)
+            throw std::runtime_error{
+                fmt::format("{} does not match its zsync control file", url.toString())};
+    }
+    catch (...)
+    {
+        file.remove();
+        throw;
+    }
+
+    return true;
+}
@@ -17,44 +17,148 @@
 
 #include <multipass/url_downloader.h>
 
+#include <multipass/background_work.h>
 #include <multipass/exceptions/aborted_download_exception.h>
 #include <multipass/exceptions/download_exception.h>
 #include <multipass/file_ops.h>
 #include <multipass/format.h>
 #include <multipass/logging/log.h>
+#include <multipass/metrics.h>
 #include <multipass/platform.h>
 #include <multipass/utils.h>
 #include <multipass/version.h>
 
+#include <QAbstractNetworkCache>
 #include <QDir>
 #include <QEventLoop>
 #include <QFile>
 #include <QNetworkDiskCache>
 #include <QNetworkReply>
+#include <QThread>
+#include <QThreadPool>
 #include <QTimer>
 #include <QUrl>
 
 #include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
 
 namespace mp = multipass;
 namespace mpl = multipass::logging;
+namespace mpm = multipass::metrics;
 
 namespace
 {
 constexpr auto category = "url downloader";
+// How much a throttled download may get ahead of its limit, since Qt stops reading off the socket
+// once its buffer is full
+constexpr qint64 throttled_read_buffer_size = 256 * 1024;
 using NetworkReplyUPtr = std::unique_ptr<QNetworkReply>;
 
+// Network managers are bound to the thread that made them, so each thread keeps its own, by
+// downloader. Those of downloaders that are gone linger until their thread ends
+thread_local std::unordered_map<std::uint64_t, std::shared_ptr<QNetworkAccessManager>>
+    thread_network_managers;
+std::atomic<std::uint64_t> next_downloader_id{0};
+
+// QNetworkDiskCache keeps its own account of what is in its directory and expires entries by it, so
+// caches of their own for the managers of each thread would drift apart and evict each other's
+// entries. There is a single one per directory instead, with no thread of its own, which the
+// managers reach through caches that take its lock.
+struct DiskCache
+{
+    std::mutex mutex;
+    QNetworkDiskCache cache;
+};
+
+std::shared_ptr<DiskCache> disk_cache_for(const mp::Path& cache_dir_path)
+{
+    static std::mutex mutex;
+    static std::unordered_map<std::string, std::weak_ptr<DiskCache>> disk_caches;
+
+    std::lock_guard lock{mutex};
+    auto& weak_cache = disk_caches[cache_dir_path.toStdString()];
+    auto disk_cache = weak_cache.lock();
+    if (!disk_cache)
+    {
+        disk_cache = std::make_shared<DiskCache>();
+        disk_cache->cache.setCacheDirectory(cache_dir_path);
+        disk_cache->cache.moveToThread(nullptr);
+        weak_cache = disk_cache;
+    }
+
+    return disk_cache;
+}
+
+class SharedDiskCache : public QAbstractNetworkCache
+{
+public:
+    explicit SharedDiskCache(std::shared_ptr<DiskCache> disk_cache)
+        : disk_cache{std::move(disk_cache)}
+    {
+    }
+
+    QNetworkCacheMetaData metaData(const QUrl& url) override
+    {
+        std::lock_guard lock{disk_cache->mutex};
+        return disk_cache->cache.metaData(url);
+    }
+
+    void updateMetaData(const QNetworkCacheMetaData& meta_data) override
+    {
+        std::lock_guard lock{disk_cache->mutex};
+        disk_cache->cache.updateMetaData(meta_data);
+    }
+
+    QIODevice* data(const QUrl& url) override
+    {
+        std::lock_guard lock{disk_cache->mutex};
+        return disk_cache->cache.data(url);
+    }
+
+    bool remove(const QUrl& url) override
+    {
+        std::lock_guard lock{disk_cache->mutex};
+        return disk_cache->cache.remove(url);
+    }
+
+    qint64 cacheSize() const override
+    {
+        std::lock_guard lock{disk_cache->mutex};
+        return disk_cache->cache.cacheSize();
+    }
+
+    QIODevice* prepare(const QNetworkCacheMetaData& meta_data) override
+    {
+        std::lock_guard lock{disk_cache->mutex};
+        return disk_cache->cache.prepare(meta_data);
+    }
+
+    void insert(QIODevice* device) override
+    {
+        std::lock_guard lock{disk_cache->mutex};
+        disk_cache->cache.insert(device);
+    }
+
+    void clear() override
+    {
+        std::lock_guard lock{disk_cache->mutex};
+        disk_cache->cache.clear();
+    }
+
+private:
+    const std::shared_ptr<DiskCache> disk_cache;
+};
+
 auto make_network_manager(const mp::Path& cache_dir_path)
 {
     auto manager = std::make_unique<QNetworkAccessManager>();
 
     if (!cache_dir_path.isEmpty())
     {
-        auto network_cache = new QNetworkDiskCache;
-        network_cache->setCacheDirectory(cache_dir_path);
-
-        // Manager now owns network_cache and so it will delete it in its dtor
-        manager->setCache(network_cache);
+        // Manager now owns the cache and so it will delete it in its dtor
+        manager->setCache(new SharedDiskCache{disk_cache_for(cache_dir_path)});
     }
 
     return manager;
@@ -80,6 +184,36 @@ QString multipass_user_agent()
     return user_agent;
 }
 
+struct DownloadMetrics
+{
+    explicit DownloadMetrics(const std::string& source)
+        : downloads{MP_METRICS.counter("multipass_downloads_total",
+                                       "Completed downloads",
+                                       {{"source", source}})},
+          bytes{MP_METRICS.counter("multipass_download_bytes_total",
+                                   "Bytes downloaded",
+                                   {{"source", source}})},
+          duration{MP_METRICS.histogram("multipass_download_duration_seconds",
+                                        "Time taken by downloads",
+                                        {{"source", source}})}
+    {
+    }
+
+    mpm::Counter& downloads;
+    mpm::Counter& bytes;
+    mpm::Histogram& duration;
+};
+
+void record_download(bool from_cache, qint64 bytes, std::chrono::steady_clock::duration took)
+{
+    static DownloadMetrics cache_metrics{"cache"}, network_metrics{"network"};
+    auto& metrics = from_cache ? cache_metrics : network_metrics;
+
+    metrics.downloads.increment();
+    metrics.bytes.increment(bytes);
+    metrics.duration.observe(std::chrono::duration<double>(took).count());
+}
+
 void wait_for_reply(QNetworkReply* reply, QTimer& download_timeout)
 {
     QEventLoop event_loop;
@@ -103,7 +237,8 @@ QByteArray download(QNetworkAccessManager* manager,
                     ErrorAction&& on_error,
                     const std::atomic_bool& abort_download,
                     const QNetworkRequest::CacheLoadControl cache_load_control =
-                        QNetworkRequest::CacheLoadControl::PreferNetwork)
+                        QNetworkRequest::CacheLoadControl::PreferNetwork,
+                    const QByteArray& range = {})
 {
     QTimer download_timeout;
     download_timeout.setInterval(timeout);
@@ -113,14 +248,23 @@ QByteArray download(QNetworkAccessManager* manager,
     QNetworkRequest request{adjusted_url};
     request.setRawHeader("Connection", "Keep-Alive");
     request.setAttribute(QNetworkRequest::HttpPipeliningAllowedAttribute, true);
+    request.setAttribute(QNetworkRequest::Http2AllowedAttribute, true);
     request.setAttribute(QNetworkRequest::CacheLoadControlAttribute, cache_load_control);
     request.setHeader(QNetworkRequest::UserAgentHeader, multipass_user_agent());
+    if (!range.isEmpty())
+    {
+        request.setRawHeader("Range", "bytes=" + range);
+        request.setAttribute(QNetworkRequest::CacheSaveControlAttribute, false);
+    }
 
+    const auto start = std::chrono::steady_clock::now();
+    qint64 received = 0;
     NetworkReplyUPtr reply{manager->get(request)};
 
     QObject::connect(reply.get(),
                      &QNetworkReply::downloadProgress,
                      [&](qint64 bytes_received, qint64 bytes_total) {
+                         received = bytes_received;
                          on_progress(reply.get(), bytes_received, bytes_total);
                      });
     QObject::connect(reply.get(), &QNetworkReply::readyRead, [&]() {
@@ -134,6 +278,10 @@ QByteArray download(QNetworkAccessManager* manager,
         const auto error_code = reply->error();
         const auto error_string = reply->errorString().toStdString();
 
+        static auto& failures =
+            MP_METRICS.counter("multipass_download_failures_total", "Failed download attempts");
+        failures.increment();
+
         // Log the original error message at debug level
         mpl::debug(category,
                    "Qt error {}: {}",
@@ -168,13 +316,13 @@ QByteArray download(QNetworkAccessManager* manager,
                           on_download,
                           on_error,
                           abort_download,
-                          QNetworkRequest::CacheLoadControl::AlwaysCache);
+                          QNetworkRequest::CacheLoadControl::AlwaysCache,
+                          range);
     }
 
-    mpl::trace(category,
-               "Found {} in cache: {}",
-               url.toString(),
-               reply->attribute(QNetworkRequest::SourceIsFromCacheAttribute).toBool());
+    const auto from_cache = reply->attribute(QNetworkRequest::SourceIsFromCacheAttribute).toBool();
+    mpl::trace(category, "Found {} in cache: {}", url.toString(), from_cache);
+    record_download(from_cache, received, std::chrono::steady_clock::now() - start);
 
     return reply->readAll();
 }
@@ -190,6 +338,7 @@ auto get_header(QNetworkAccessManager* manager,
 
     const QUrl adjusted_url = make_http_url_https(url);
     QNetworkRequest request{adjusted_url};
+    request.setAttribute(QNetworkRequest::Http2AllowedAttribute, true);
     request.setHeader(QNetworkRequest::UserAgentHeader, multipass_user_agent());
 
     NetworkReplyUPtr reply{manager->head(request)};
@@ -242,8 +391,28 @@ mp::URLDownloader::URLDownloader(std::chrono::milliseconds timeout) : URLDownloa
 
 mp::URLDownloader::URLDownloader(const mp::Path& cache_dir, std::chrono::milliseconds timeout)
     : cache_dir_path{cache_dir.isEmpty() ? Path() : QDir(cache_dir).filePath("network-cache")},
-      timeout{timeout}
+      timeout{timeout},
+      id{next_downloader_id++}
+{
+}
+
+mp::URLDownloader::~URLDownloader()
 {
+    thread_network_managers.erase(id);
+}
+
+std::shared_ptr<QNetworkAccessManager> mp::URLDownloader::network_manager()
+{
+    // Threads of the global pool run all sorts of tasks, and stay around for a while after them,
+    // so they make a manager per request rather than keep one, with its connections, for good
+    if (QThreadPool::globalInstance()->contains(QThread::currentThread()))
+        return MP_NETMGRFACTORY.make_network_manager(cache_dir_path);
+
+    auto& manager = thread_network_managers[id];
+    if (!manager)
+        manager = MP_NETMGRFACTORY.make_network_manager(cache_dir_path);
+
+    return manager;
 }
 
 void mp::URLDownloader::download_to(const QUrl& url,
@@ -253,7 +422,7 @@ void mp::URLDownloader::download_to(const QUrl& url,
                                     const mp::ProgressMonitor& monitor)
 {
     std::atomic_bool abort_download{false};
-    auto manager{MP_NETMGRFACTORY.make_network_manager(cache_dir_path)};
+    auto manager = network_manager();
 
     QFile file{file_name};
     if (!file.open(QIODevice::ReadWrite | QIODevice::Truncate))
@@ -298,12 +467,21 @@ void mp::URLDownloader::download_to(const QUrl& url,
         else
             return;
 
-        if (MP_FILEOPS.write(file, reply->readAll()) < 0)
+        const auto data = reply->readAll();
+        if (MP_FILEOPS.write(file, data) < 0)
         {
             mpl::error(category, "error writing image: {}", file.errorString());
             abort_download = true;
             reply->abort();
         }
+
+        // With the timeout stopped, so that waiting for the limit does not count against it
+        if (auto work = mp::BackgroundWork::current())
+        {
+            work->throttle(data.size());
+            reply->setReadBufferSize(work->bandwidth_limit() ? throttled_read_buffer_size : 0);
+        }
+
         download_timeout.start();
     };
 
@@ -325,7 +503,7 @@ QByteArray mp::URLDownloader::download(const QUrl& url)
 
 QByteArray mp::URLDownloader::download(const QUrl& url, const bool force_update)
 {
-    auto manager{MP_NETMGRFACTORY.make_network_manager(cache_dir_path)};
+    auto manager = network_manager();
 
     // This will connect to the QNetworkReply::readReady signal and when emitted,
     // reset the timer.
@@ -354,9 +532,105 @@ QByteArray mp::URLDownloader::download(const QUrl& url, const bool force_update)
         cache_load_control);
 }
 
+void mp::URLDownloader::download_range_to(const QUrl& url,
+                                          qint64 offset,
+                                          qint64 length,
+                                          QIODevice& out)
+{
+    std::atomic_bool abort_download{false};
+    auto manager = network_manager();
+
+    const auto last = offset + length - 1;
+    const auto expected_range =
+        QByteArray::fromStdString(fmt::format("bytes {}-{}/", offset, last));
+    std::string refusal; // why the reply was given up on, if it was
+    bool checked_reply = false;
+    qint64 received = 0;
+
+    auto write = [&](QNetworkReply* reply, const QByteArray& data) {
+        if (received + data.size() > length)
+            refusal = fmt::format("got more than the {} bytes requested", length);
+        else if (out.write(data) != data.size())
+            refusal = fmt::format("error writing range: {}", out.errorString());
+
+        if (!refusal.empty())
+        {
+            abort_download = true;
+            reply->abort();
+            return;
+        }
+
+        received += data.size();
+    };
+
+    auto on_download = [&, this](QNetworkReply* reply, QTimer& download_timeout) {
+        abort_download = abort_download || abort_downloads;
+        if (abort_download)
+        {
+            reply->abort();
+            return;
+        }
+
+        // Servers that cannot do ranges send the whole file instead, so that is given up on as soon
+        // as the headers tell, rather than after it is all in
+        if (!std::exchange(checked_reply, true))
+        {
+            const auto status = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+            if (status != 206 || !reply->rawHeader("Content-Range").startsWith(expected_range))
+            {
+                refusal = fmt::format("server did not send bytes {}-{} (HTTP status {})",
+                                      offset,
+                                      last,
+                                      status);
+                abort_download = true;
+                reply->abort();
+                return;
+            }
+        }
+
+        download_timeout.stop();
+        const auto data = reply->readAll();
+        write(reply, data);
+
+        // With the timeout stopped, so that waiting for the limit does not count against it
+        if (auto work = mp::BackgroundWork::current())
+        {
+            work->throttle(data.size());
+            reply->setReadBufferSize(work->bandwidth_limit() ? throttled_read_buffer_size : 0);
+        }
+
+        download_timeout.start();
+    };
+
+    try
+    {
+        ::download(manager.get(),
+                   timeout,
+                   url,
+                   [](QNetworkReply*, qint64, qint64) {},
+                   on_download,
+                   [] {},
+                   abort_download,
+                   QNetworkRequest::CacheLoadControl::AlwaysNetwork,
+                   QByteArray::number(offset) + '-' + QByteArray::number(last));
+    }
+    catch (const mp::AbortedDownloadException&)
+    {
+        if (refusal.empty())
+            throw;
+
+        throw mp::DownloadException{url.toString().toStdString(), refusal};
+    }
+
+    if (received != length)
+        throw mp::DownloadException{
+            url.toString().toStdString(),
+            fmt::format("expected {} bytes at offset {}, got {}", length, offset, received)};
+}
+
 QDateTime mp::URLDownloader::last_modified(const QUrl& url)
 {
-    auto manager{MP_NETMGRFACTORY.make_network_manager(cache_dir_path)};
+    auto manager = network_manager();
 
     return get_header(manager.get(), url, QNetworkRequest::LastModifiedHeader, timeout)
         .toDateTime();
@@ -27,8 +27,15 @@
 #include <QDir>
 
 #include <algorithm>
+#include <cerrno>
+#include <charconv>
 #include <chrono>
+#include <cstring>
 #include <fstream>
+#include <string_view>
+
+#include <sys/inotify.h>
+#include <unistd.h>
 
 namespace mp = multipass;
 namespace mpl = multipass::logging;
@@ -37,6 +44,7 @@ namespace
 {
 constexpr auto immediate_wait = 100; // period to wait for immediate dnsmasq failures, in ms
 constexpr auto log_category = "dnsmasq";
+constexpr auto leases_filename = "dnsmasq.leases";
 
 auto make_dnsmasq_process(const mp::Path& data_dir,
                           const mp::BridgeSubnetList& subnets,
@@ -52,6 +60,37 @@ bool ip_in_served_subnets(const mp::BridgeSubnetList& subnets, const mp::IPAddre
         return bridge_subnet.second.contains(ip);
     });
 }
+
+// Consume all pending inotify events, returning whether any of them concerns the leases file.
+bool leases_file_changed(int watch_fd)
+{
+    alignas(inotify_event) char buffer[4096];
+    auto changed = false;
+
+    while (true)
+    {
+        const auto len = read(watch_fd, buffer, sizeof(buffer));
+        if (len < 0)
+            return changed || errno != EAGAIN; // when in doubt, assume it changed
+        if (len == 0)
+            return changed;
+
+        for (auto ptr = buffer; ptr < buffer + len;)
+        {
+            const auto* event = reinterpret_cast<const inotify_event*>(ptr);
+            if (event->mask & IN_Q_OVERFLOW ||
+                (event->len && std::string_view{event->name} == leases_filename))
+                changed = true;
+
+            ptr += sizeof(inotify_event) + event->len;
+        }
+    }
+}
+
+std::time_t current_time()
+{
+    return std::chrono::system_clock::to_time_t(std::chrono::system_clock::now());
+}
 } // namespace
 
 mp::DNSMasqServer::DNSMasqServer(const Path& data_dir, const BridgeSubnetList& subnets)
@@ -73,6 +112,8 @@ mp::DNSMasqServer::DNSMasqServer(const Path& data_dir, const BridgeSubnetList& s
 
     dnsmasq_cmd = make_dnsmasq_process(data_dir, subnets, conf_file.fileName());
     start_dnsmasq();
+
+    watch_leases(); // after anything that can throw, so that the watch is always closed
 }
 
 mp::DNSMasqServer::~DNSMasqServer()
@@ -100,49 +141,29 @@ mp::DNSMasqServer::~DNSMasqServer()
             }
         }
     }
+
+    if (leases_watch_fd >= 0)
+        close(leases_watch_fd);
 }
 
 std::optional<mp::IPAddress> mp::DNSMasqServer::get_ip_for(const std::string& hw_addr)
 {
-    // DNSMasq leases entries consist of:
-    // <lease expiration> <mac addr> <ipv4> <name> * * *
-    const auto path = QDir(data_dir).filePath("dnsmasq.leases").toStdString();
-    const std::string delimiter{" "};
-    const int hw_addr_idx{1};
-    const int ipv4_idx{2};
-    std::ifstream leases_file{path};
-    std::string line;
-    while (getline(leases_file, line))
-    {
-        const auto fields = mp::utils::split(line, delimiter);
-        if (fields.size() > 2 && fields[hw_addr_idx] == hw_addr)
-        {
-            try
-            {
-                const IPAddress ip{fields[ipv4_idx]};
-                // Ignore leases outside the subnets we currently serve. A version upgrade that
-                // changes the bridge layout can leave an old lease pointing at an unreachable
-                // address; skip it so we resolve the current, reachable one instead.
-                if (ip_in_served_subnets(subnets, ip))
-                    return ip;
-                // TODO: Also check if the lease is still valid
-                // TODO: Aggregate all leases for the MAC before filtering
-            }
-            catch (const std::invalid_argument& ex) // unparseable address -> skip this line
-            {
-                mpl::debug(log_category,
-                           "Could not parse `{}` as IPv4 address: {}, ignoring lease line",
-                           fields[ipv4_idx],
-                           ex.what());
-            }
-        }
-    }
-    return std::nullopt;
+    std::lock_guard lock{leases_mutex};
+    refresh_leases();
+
+    return find_live_lease(hw_addr);
 }
 
 void mp::DNSMasqServer::release_mac(const std::string& hw_addr, const QString& bridge_name)
 {
-    auto ip = get_ip_for(hw_addr);
+    std::optional<IPAddress> ip;
+    {
+        std::lock_guard lock{leases_mutex};
+        refresh_leases();
+
+        ip = find_live_lease(hw_addr);
+    }
+
     if (!ip)
     {
         mpl::warn(log_category, "attempting to release non-existent addr: {}", hw_addr);
@@ -181,6 +202,14 @@ void mp::DNSMasqServer::release_mac(const std::string& hw_addr, const QString& b
                            << QString::fromStdString(hw_addr));
 
     dhcp_release.waitForFinished();
+
+    // Leases that could not be released are still dnsmasq's, so the index keeps them
+    if (dhcp_release.error() == QProcess::UnknownError &&
+        dhcp_release.exitStatus() == QProcess::NormalExit && dhcp_release.exitCode() == 0)
+    {
+        std::lock_guard lock{leases_mutex};
+        leases.erase(hw_addr); // dnsmasq drops it from the file too, which triggers a fresh parse
+    }
 }
 
 void mp::DNSMasqServer::check_dnsmasq_running()
@@ -192,6 +221,96 @@ void mp::DNSMasqServer::check_dnsmasq_running()
     }
 }
 
+void mp::DNSMasqServer::watch_leases()
+{
+    leases_watch_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (leases_watch_fd < 0)
+    {
+        mpl::warn(log_category,
+                  "Could not watch leases: {}. Falling back to re-reading them on every lookup",
+                  std::strerror(errno));
+        return;
+    }
+
+    // Watch the directory rather than the file, so that we notice the file being (re)created
+    constexpr auto mask = IN_CLOSE_WRITE | IN_MODIFY | IN_CREATE | IN_DELETE | IN_MOVED_TO |
+                          IN_MOVED_FROM | IN_ONLYDIR;
+    if (inotify_add_watch(leases_watch_fd, QFile::encodeName(data_dir).constData(), mask) < 0)
+    {
+        mpl::warn(log_category,
+                  "Could not watch {}: {}. Falling back to re-reading leases on every lookup",
+                  data_dir,
+                  std::strerror(errno));
+        close(leases_watch_fd);
+        leases_watch_fd = -1;
+    }
+}
+
+void mp::DNSMasqServer::refresh_leases()
+{
+    if (leases_watch_fd < 0 || leases_file_changed(leases_watch_fd))
+        leases_stale = true;
+
+    if (!leases_stale)
+        return;
+
+    // DNSMasq leases entries consist of:
+    // <lease expiration> <mac addr> <ipv4> <name> * * *
+    const auto path = QDir(data_dir).filePath(leases_filename).toStdString();
+    const std::string delimiter{" "};
+    const int expiry_idx{0};
+    const int hw_addr_idx{1};
+    const int ipv4_idx{2};
+
+    leases.clear();
+    leases_stale = false;
+
+    std::ifstream leases_file{path};
+    std::string line;
+    while (getline(leases_file, line))
+    {
+        const auto fields = mp::utils::split(line, delimiter);
+        if (fields.size() <= 2)
+            continue;
+
+        std::time_t expiry{};
+        const auto& expiry_field = fields[expiry_idx];
+        if (std::from_chars(expiry_field.data(), expiry_field.data() + expiry_field.size(), expiry)
+                .ec != std::errc{})
+            continue; // e.g. the duid line
+
+        try
+        {
+            const IPAddress ip{fields[ipv4_idx]};
+            // Ignore leases outside the subnets we currently serve. A version upgrade that
+            // changes the bridge layout can leave an old lease pointing at an unreachable
+            // address; skip it so we resolve the current, reachable one instead.
+            if (ip_in_served_subnets(subnets, ip))
+                leases[fields[hw_addr_idx]].push_back({ip, expiry});
+        }
+        catch (const std::invalid_argument& ex) // unparseable address -> skip this line
+        {
+            mpl::debug(log_category,
+                       "Could not parse `{}` as IPv4 address: {}, ignoring lease line",
+                       fields[ipv4_idx],
+                       ex.what());
+        }
+    }
+}
+
+std::optional<mp::IPAddress> mp::DNSMasqServer::find_live_lease(const std::string& hw_addr) const
+{
+    if (const auto it = leases.find(hw_addr); it != leases.end())
+    {
+        const auto now = current_time();
+        for (const auto& [ip, expiry] : it->second)
+            if (expiry == 0 || expiry > now)
+                return ip;
+    }
+
+    return std::nullopt;
+}
+
 namespace
 {
 std::string dnsmasq_failure_msg(std::string err_base, const mp::ProcessState& state)
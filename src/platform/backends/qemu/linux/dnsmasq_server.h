@@ -25,9 +25,13 @@
 
 #include <QTemporaryFile>
 
+#include <ctime>
 #include <memory>
+#include <mutex>
 #include <optional>
 #include <string>
+#include <unordered_map>
+#include <vector>
 
 namespace multipass
 {
@@ -51,13 +55,30 @@ protected:
     DNSMasqServer() = default; // For testing
 
 private:
+    struct Lease
+    {
+        IPAddress ip;
+        std::time_t expiry; // 0 means the lease never expires
+    };
+
     void start_dnsmasq();
+    void watch_leases();
+    void refresh_leases(); // requires leases_mutex to be held
+    std::optional<IPAddress> find_live_lease(const std::string& hw_addr) const; // ditto
 
     const QString data_dir;
     const BridgeSubnetList subnets;
     std::unique_ptr<Process> dnsmasq_cmd;
     QMetaObject::Connection finish_connection;
     QTemporaryFile conf_file;
+
+    // In-memory index of dnsmasq.leases, keyed by MAC and kept in file order. It is only re-parsed
+    // when inotify reports that the leases file changed (or on every lookup, if inotify is not
+    // available).
+    std::mutex leases_mutex;
+    std::unordered_map<std::string, std::vector<Lease>> leases;
+    bool leases_stale{true};
+    int leases_watch_fd{-1};
 };
 
 #define MP_DNSMASQ_SERVER_FACTORY multipass::DNSMasqServerFactory::instance()
@@ -32,18 +32,6 @@ namespace mp = multipass;
 
 namespace
 {
-std::unique_ptr<mp::QemuImgProcessSpec> make_capture_spec(const std::string& tag,
-                                                          const std::filesystem::path& image_path)
-{
-    return std::make_unique<mp::QemuImgProcessSpec>(
-        QStringList{"snapshot",
-                    "-c",
-                    QString::fromStdString(tag),
-                    MP_PLATFORM.path_to_qstr(image_path)},
-        /* src_img = */ "",
-        image_path);
-}
-
 std::unique_ptr<mp::QemuImgProcessSpec> make_restore_spec(const std::string& tag,
                                                           const std::filesystem::path& image_path)
 {
@@ -55,18 +43,6 @@ std::unique_ptr<mp::QemuImgProcessSpec> make_restore_spec(const std::string& tag
         /* src_img = */ "",
         image_path);
 }
-
-std::unique_ptr<mp::QemuImgProcessSpec> make_delete_spec(const std::string& tag,
-                                                         const std::filesystem::path& image_path)
-{
-    return std::make_unique<mp::QemuImgProcessSpec>(
-        QStringList{"snapshot",
-                    "-d",
-                    QString::fromStdString(tag),
-                    MP_PLATFORM.path_to_qstr(image_path)},
-        /* src_img = */ "",
-        image_path);
-}
 } // namespace
 
 mp::QemuSnapshot::QemuSnapshot(const std::string& name,
@@ -77,6 +53,7 @@ mp::QemuSnapshot::QemuSnapshot(const std::string& name,
                                QemuVirtualMachine& vm,
                                VirtualMachineDescription& desc)
     : BaseSnapshot{name, comment, cloud_init_instance_id, std::move(parent), specs, vm},
+      vm{vm},
       desc{desc},
       image_path{desc.image.image_path}
 {
@@ -85,7 +62,7 @@ mp::QemuSnapshot::QemuSnapshot(const std::string& name,
 mp::QemuSnapshot::QemuSnapshot(const std::filesystem::path& filename,
                                QemuVirtualMachine& vm,
                                VirtualMachineDescription& desc)
-    : BaseSnapshot{filename, vm, desc}, desc{desc}, image_path{desc.image.image_path}
+    : BaseSnapshot{filename, vm, desc}, vm{vm}, desc{desc}, image_path{desc.image.image_path}
 {
 }
 
@@ -95,20 +72,20 @@ void mp::QemuSnapshot::capture_impl()
 
     // Avoid creating more than one snapshot with the same tag (creation would succeed, but we'd
     // then be unable to identify the snapshot by tag)
-    if (backend::instance_image_has_snapshot(image_path, tag))
+    if (vm.image_has_snapshot(tag))
         throw std::runtime_error{fmt::format(
             "A snapshot with the same tag already exists in the image. Image: {}; tag: {})",
             image_path,
             tag)};
 
-    mp::backend::checked_exec_qemu_img(make_capture_spec(tag, image_path));
+    vm.capture_image_snapshot(tag);
 }
 
 void mp::QemuSnapshot::erase_impl()
 {
     const auto& tag = get_id();
-    if (backend::instance_image_has_snapshot(image_path, tag))
-        mp::backend::checked_exec_qemu_img(make_delete_spec(tag, image_path));
+    if (vm.image_has_snapshot(tag))
+        vm.delete_image_snapshot(tag);
     else
         mpl::warn(BaseSnapshot::get_name(),
                   "Could not find the underlying QEMU snapshot. Assuming it is already "
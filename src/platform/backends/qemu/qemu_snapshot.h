@@ -46,6 +46,7 @@ protected:
     void apply_impl() override;
 
 private:
+    QemuVirtualMachine& vm;
     VirtualMachineDescription& desc;
     const std::filesystem::path& image_path;
 };
@@ -31,17 +31,22 @@
 #include <multipass/logging/log.h>
 #include <multipass/memory_size.h>
 #include <multipass/platform.h>
+#include <multipass/process/qemuimg_process_spec.h>
 #include <multipass/top_catch_all.h>
 #include <multipass/utils/qemu_img_utils.h>
 #include <multipass/vm_mount.h>
 #include <multipass/vm_status_monitor.h>
 
+#include <QEventLoop>
 #include <QFile>
 #include <QProcess>
 #include <QRegularExpression>
 #include <QString>
 #include <QTemporaryFile>
+#include <QThread>
+#include <QTimer>
 
+#include <algorithm>
 #include <cassert>
 
 namespace mp = multipass;
@@ -57,8 +62,16 @@ constexpr auto arguments_key = "arguments";
 constexpr auto mount_data_key = "mount_data";
 constexpr auto mount_source_key = "source";
 constexpr auto mount_arguments_key = "arguments";
+constexpr auto suspend_state_key = "suspend_state";
+constexpr auto suspend_state_file_key = "file";
+constexpr auto multifd_channels_key = "multifd_channels";
+// Identifies the reply to the migration that suspends to a file, which may refuse to start
+constexpr auto suspend_migration_id = "suspend-to-file";
+constexpr auto image_device = "hda"; // as named in the process spec
 
 constexpr int kill_process_timeout = 5000; // unit: ms, 5 seconds timeout for killing the process
+// Internal snapshots of large images take a while, as QEMU updates the refcount of every cluster
+constexpr auto qmp_command_timeout = 60s;
 
 QString get_vm_machine(const boost::json::value& metadata)
 {
@@ -70,6 +83,30 @@ QStringList get_arguments(const boost::json::value& metadata)
     return mp::lookup_or<QStringList>(metadata, arguments_key, {});
 }
 
+// The file that the instance was suspended to, if it was suspended to one and the file is there
+QString get_suspend_state_file(const boost::json::object& metadata)
+{
+    const auto* suspend_state = metadata.if_contains(suspend_state_key);
+    const auto file = suspend_state
+                          ? mp::lookup_or<QString>(*suspend_state, suspend_state_file_key, {})
+                          : QString{};
+
+    return !file.isEmpty() && QFile::exists(file) ? file : QString{};
+}
+
+bool has_suspend_state(const mp::VirtualMachineDescription& desc,
+                       const boost::json::object& metadata)
+{
+    return !get_suspend_state_file(metadata).isEmpty() ||
+           mp::backend::instance_image_has_snapshot(desc.image.image_path, suspend_tag);
+}
+
+int get_multifd_channels(const boost::json::object& metadata)
+{
+    const auto* suspend_state = metadata.if_contains(suspend_state_key);
+    return suspend_state ? mp::lookup_or<int>(*suspend_state, multifd_channels_key, 1) : 1;
+}
+
 auto mount_args_from_json(const boost::json::object& object)
 {
     mp::QemuVirtualMachine::MountArgs mount_args;
@@ -111,7 +148,8 @@ auto make_qemu_process(const mp::VirtualMachineDescription& desc,
         const auto& data = resume_metadata.value();
         resume_data = mp::QemuVMProcessSpec::ResumeData{suspend_tag,
                                                         get_vm_machine(data),
-                                                        get_arguments(data)};
+                                                        get_arguments(data),
+                                                        get_suspend_state_file(data)};
     }
 
     auto process_spec =
@@ -136,6 +174,58 @@ boost::json::object hmc_to_qmp_json(const QString& command_line)
     return qmp;
 }
 
+// With mapped-ram every page gets a fixed offset in the file, so multifd channels can write and
+// read it in parallel and the file never grows beyond the guest's memory
+boost::json::object migration_capabilities_json()
+{
+    boost::json::array capabilities;
+    for (const auto* capability : {"events", "mapped-ram", "multifd"})
+        capabilities.push_back(boost::json::object{{"capability", capability}, {"state", true}});
+
+    auto qmp = qmp_execute_json("migrate-set-capabilities");
+    qmp["arguments"] = {{"capabilities", std::move(capabilities)}};
+    return qmp;
+}
+
+boost::json::object migration_parameters_json(int multifd_channels)
+{
+    auto qmp = qmp_execute_json("migrate-set-parameters");
+    qmp["arguments"] = {{"multifd-channels", multifd_channels}};
+    return qmp;
+}
+
+boost::json::object migrate_file_json(const QString& command, const QString& file)
+{
+    auto qmp = qmp_execute_json(command);
+    qmp["arguments"] = {{"uri", QString{"file:%1"}.arg(file).toStdString()}};
+    return qmp;
+}
+
+boost::json::object internal_snapshot_json(const QString& command, const std::string& tag)
+{
+    auto qmp = qmp_execute_json(command);
+    qmp["arguments"] = {{"device", image_device}, {"name", tag}};
+    return qmp;
+}
+
+std::unique_ptr<mp::QemuImgProcessSpec> make_capture_spec(const std::string& tag,
+                                                          const std::filesystem::path& image_path)
+{
+    return std::make_unique<mp::QemuImgProcessSpec>(
+        QStringList{"snapshot",
+                    "-c",
+                    QString::fromStdString(tag),
+                    MP_PLATFORM.path_to_qstr(image_path)},
+        /* src_img = */ "",
+        image_path);
+}
+
+int suspend_multifd_channels()
+{
+    // Beyond a handful of channels the disk, rather than the CPU, is what limits the transfer
+    return std::clamp(QThread::idealThreadCount(), 2, 8);
+}
+
 std::string get_qemu_machine_type(const QStringList& platform_args)
 {
     QTemporaryFile dump_file;
@@ -216,6 +306,26 @@ QStringList extract_snapshot_tags(const QByteArray& snapshot_list_output_stream)
     return snapshot_tags;
 }
 
+// Same, from the reply to a query-block QMP command
+QStringList extract_snapshot_tags(const boost::json::object& query_block_reply)
+{
+    QStringList snapshot_tags;
+    for (const auto& device : query_block_reply.at("return").as_array())
+    {
+        if (mp::lookup_or<std::string>(device, "device", "") != image_device)
+            continue;
+
+        const auto* inserted = device.as_object().if_contains("inserted");
+        const auto* image = inserted ? inserted->as_object().if_contains("image") : nullptr;
+        const auto* snapshots = image ? image->as_object().if_contains("snapshots") : nullptr;
+        if (snapshots)
+            for (const auto& snapshot : snapshots->as_array())
+                snapshot_tags.append(value_to<QString>(snapshot.at("name")));
+    }
+
+    return snapshot_tags;
+}
+
 } // namespace
 
 mp::QemuVirtualMachine::QemuVirtualMachine(const VirtualMachineDescription& desc,
@@ -224,9 +334,9 @@ mp::QemuVirtualMachine::QemuVirtualMachine(const VirtualMachineDescription& desc
                                            const SSHKeyProvider& key_provider,
                                            AvailabilityZone& zone,
                                            const Path& instance_dir,
-                                           bool remove_snapshots)
-    : BaseVirtualMachine{mp::backend::instance_image_has_snapshot(desc.image.image_path,
-                                                                  suspend_tag)
+                                           bool remove_snapshots,
+                                           SuspendMode suspend_mode)
+    : BaseVirtualMachine{has_suspend_state(desc, monitor.retrieve_metadata_for(desc.vm_name))
                              ? State::suspended
                              : State::off,
                          desc.vm_name,
@@ -235,6 +345,7 @@ mp::QemuVirtualMachine::QemuVirtualMachine(const VirtualMachineDescription& desc
                          zone,
                          instance_dir},
       qemu_platform{qemu_platform},
+      suspend_mode{suspend_mode},
       monitor{&monitor},
       mount_args{mount_args_from_json(monitor.retrieve_metadata_for(vm_name))}
 {
@@ -290,6 +401,9 @@ void mp::QemuVirtualMachine::start()
         monitor->update_metadata_for(
             vm_name,
             generate_metadata(qemu_platform->vmstate_platform_args(), proc_args, mount_args));
+
+        // the metadata no longer points at it, so a state file could only be a leftover
+        QFile::remove(QemuVMProcessSpec::suspend_state_file(desc));
     }
 
     vm_process->start();
@@ -317,6 +431,20 @@ void mp::QemuVirtualMachine::start()
     }
 
     vm_process->write(QByteArray::fromStdString(serialize(qmp_execute_json("qmp_capabilities"))));
+
+    if (resuming_from_file)
+    {
+        const auto file = get_suspend_state_file(monitor->retrieve_metadata_for(vm_name));
+        mpl::info(vm_name, "Restoring from {} with {} channels", file, *resuming_from_file);
+
+        // The guest was stopped before it was saved, so it comes back stopped; it is only let run
+        // once the whole state has been loaded, when the migration completes
+        vm_process->write(QByteArray::fromStdString(serialize(migration_capabilities_json())));
+        vm_process->write(QByteArray::fromStdString(
+            serialize(migration_parameters_json(*resuming_from_file))));
+        vm_process->write(
+            QByteArray::fromStdString(serialize(migrate_file_json("migrate-incoming", file))));
+    }
 }
 
 void mp::QemuVirtualMachine::shutdown(ShutdownPolicy shutdown_policy)
@@ -356,13 +484,22 @@ void mp::QemuVirtualMachine::shutdown(ShutdownPolicy shutdown_policy)
             mpl::debug(vm_name, "No process to kill");
         }
 
+        const auto has_suspend_file =
+            !get_suspend_state_file(monitor->retrieve_metadata_for(vm_name)).isEmpty();
         const auto has_suspend_snapshot =
             mp::backend::instance_image_has_snapshot(desc.image.image_path, suspend_tag);
-        if (has_suspend_snapshot != (state == State::suspended)) // clang-format off
+        const auto has_suspend_state = has_suspend_file || has_suspend_snapshot;
+        if (has_suspend_state != (state == State::suspended)) // clang-format off
             mpl::warn(vm_name, "Image has {} suspension snapshot, but the state is {}",
-                                                               has_suspend_snapshot ? "a" : "no",
+                                                               has_suspend_state ? "a" : "no",
                                                                static_cast<short>(state)); // clang-format on
 
+        if (has_suspend_file)
+        {
+            mpl::info(vm_name, "Deleting suspend state file");
+            remove_suspend_state_file();
+        }
+
         if (has_suspend_snapshot)
         {
             mpl::info(vm_name, "Deleting suspend image");
@@ -408,8 +545,11 @@ void mp::QemuVirtualMachine::suspend()
         }
 
         drop_ssh_session();
-        vm_process->write(QByteArray::fromStdString(
-            serialize(hmc_to_qmp_json(QString{"savevm "} + suspend_tag))));
+        if (suspend_mode == SuspendMode::file)
+            suspend_to_file();
+        else
+            vm_process->write(QByteArray::fromStdString(
+                serialize(hmc_to_qmp_json(QString{"savevm "} + suspend_tag))));
         vm_process->wait_for_finished(vm_shutdown_timeout);
 
         vm_process.reset(nullptr);
@@ -422,6 +562,66 @@ void mp::QemuVirtualMachine::suspend()
     }
 }
 
+void mp::QemuVirtualMachine::suspend_to_file()
+{
+    suspending_to_file = suspend_multifd_channels();
+    const auto file = QemuVMProcessSpec::suspend_state_file(desc) + ".part";
+    mpl::info(vm_name, "Suspending to {} with {} channels", file, *suspending_to_file);
+
+    // The guest is stopped first, so that every page is written exactly once
+    vm_process->write(QByteArray::fromStdString(serialize(migration_capabilities_json())));
+    vm_process->write(
+        QByteArray::fromStdString(serialize(migration_parameters_json(*suspending_to_file))));
+    vm_process->write(QByteArray::fromStdString(serialize(qmp_execute_json("stop"))));
+
+    auto migrate = migrate_file_json("migrate", file);
+    migrate["id"] = suspend_migration_id;
+    vm_process->write(QByteArray::fromStdString(serialize(migrate)));
+}
+
+void mp::QemuVirtualMachine::on_suspended_to_file()
+{
+    // The file only gets its final name once complete, so a partial one is never resumed from
+    const auto file = QemuVMProcessSpec::suspend_state_file(desc);
+    QFile::remove(file);
+    if (!QFile::rename(file + ".part", file))
+    {
+        on_suspend_to_file_failed();
+        return;
+    }
+
+    auto metadata = monitor->retrieve_metadata_for(vm_name);
+    metadata[suspend_state_key] = {{suspend_state_file_key, file.toStdString()},
+                                   {multifd_channels_key, *suspending_to_file}};
+    monitor->update_metadata_for(vm_name, metadata);
+    suspending_to_file.reset();
+
+    mpl::info(vm_name, "VM suspended to file");
+    vm_process->kill();
+    on_suspend();
+}
+
+void mp::QemuVirtualMachine::on_suspend_to_file_failed()
+{
+    mpl::warn(vm_name, "Suspending to file failed, falling back to a snapshot");
+    suspending_to_file.reset();
+    QFile::remove(QemuVMProcessSpec::suspend_state_file(desc) + ".part");
+
+    // savevm only resumes the guest, which is what tells us it is done, if it was running before
+    falling_back_to_snapshot = true;
+    vm_process->write(QByteArray::fromStdString(serialize(qmp_execute_json("cont"))));
+}
+
+void mp::QemuVirtualMachine::remove_suspend_state_file()
+{
+    auto metadata = monitor->retrieve_metadata_for(vm_name);
+    if (const auto file = get_suspend_state_file(metadata); !file.isEmpty())
+        QFile::remove(file);
+
+    metadata.erase(suspend_state_key);
+    monitor->update_metadata_for(vm_name, metadata);
+}
+
 mp::VirtualMachine::State mp::QemuVirtualMachine::current_state()
 {
     return state;
@@ -518,12 +718,16 @@ void mp::QemuVirtualMachine::wait_until_ssh_up(std::chrono::milliseconds timeout
 
 void mp::QemuVirtualMachine::initialize_vm_process()
 {
-    vm_process = make_qemu_process(
-        desc,
-        ((state == State::suspended) ? std::make_optional(monitor->retrieve_metadata_for(vm_name))
-                                     : std::nullopt),
-        mount_args,
-        qemu_platform->vm_platform_args(desc));
+    const auto resume_metadata =
+        (state == State::suspended) ? std::make_optional(monitor->retrieve_metadata_for(vm_name))
+                                    : std::nullopt;
+
+    resuming_from_file.reset();
+    if (resume_metadata && !get_suspend_state_file(*resume_metadata).isEmpty())
+        resuming_from_file = get_multifd_channels(*resume_metadata);
+
+    vm_process =
+        make_qemu_process(desc, resume_metadata, mount_args, qemu_platform->vm_platform_args(desc));
 
     QObject::connect(vm_process.get(), &Process::started, [this]() {
         mpl::info(vm_name, "process started");
@@ -533,48 +737,11 @@ void mp::QemuVirtualMachine::initialize_vm_process()
     QObject::connect(vm_process.get(), &Process::ready_read_standard_output, [this]() {
         auto qmp_output = vm_process->read_all_standard_output();
         mpl::debug(vm_name, "QMP: {}", qmp_output);
-        // Skip non-JSON output.
-        const auto lines = qmp_output.split('\n');
-        const auto json_line = std::find_if(lines.cbegin(), lines.cend(), [](const QString& line) {
-            return line.startsWith('{');
-        });
-        if (json_line == lines.cend())
-            return;
-        auto qmp_object = boost::json::parse(json_line->toStdString()).as_object();
-
-        if (auto event = qmp_object.if_contains("event"))
+        // Skip non-JSON output. Several replies and events can come at once, e.g. when migrating
+        for (const auto& line : QString{qmp_output}.split('\n'))
         {
-            auto event_str = value_to<std::string>(*event);
-            if (event_str == "RESET" && state != State::restarting)
-            {
-                mpl::info(vm_name, "VM restarting");
-                on_restart();
-            }
-            else if (event_str == "POWERDOWN")
-            {
-                mpl::info(vm_name, "VM powering down");
-            }
-            else if (event_str == "SHUTDOWN")
-            {
-                mpl::info(vm_name, "VM shut down");
-            }
-            else if (event_str == "STOP")
-            {
-                mpl::info(vm_name, "VM suspending");
-            }
-            else if (event_str == "RESUME")
-            {
-                mpl::info(vm_name, "VM suspended");
-                if (state == State::suspending || state == State::running)
-                {
-                    vm_process->kill();
-                    on_suspend();
-                }
-            }
-        }
-        else if (auto error = qmp_object.if_contains("error"))
-        {
-            mpl::error(vm_name, "QMP error: {}", value_to<std::string>(error->at("desc")));
+            if (line.startsWith('{'))
+                handle_qmp_message(boost::json::parse(line.toStdString()).as_object());
         }
     });
 
@@ -643,6 +810,132 @@ void mp::QemuVirtualMachine::initialize_vm_process()
     });
 }
 
+void mp::QemuVirtualMachine::handle_qmp_message(const boost::json::object& qmp_object)
+{
+    // The migration to a file only replies once it has started, or with why it could not
+    if (auto id = qmp_object.if_contains("id"); id && *id == suspend_migration_id)
+    {
+        if (auto error = qmp_object.if_contains("error"); error && suspending_to_file)
+        {
+            mpl::warn(vm_name,
+                      "QEMU refused to suspend to file: {}",
+                      value_to<std::string>(error->at("desc")));
+            on_suspend_to_file_failed();
+        }
+        return;
+    }
+
+    // Other commands that carry an id are sent through execute_qmp(), which handles their errors
+    if (auto id = qmp_object.if_contains("id"))
+    {
+        qmp_replies[value_to<std::string>(*id)] = qmp_object;
+        emit qmp_reply_received();
+        return;
+    }
+
+    if (auto event = qmp_object.if_contains("event"))
+    {
+        auto event_str = value_to<std::string>(*event);
+        if (event_str == "RESET" && state != State::restarting)
+        {
+            mpl::info(vm_name, "VM restarting");
+            on_restart();
+        }
+        else if (event_str == "POWERDOWN")
+        {
+            mpl::info(vm_name, "VM powering down");
+        }
+        else if (event_str == "SHUTDOWN")
+        {
+            mpl::info(vm_name, "VM shut down");
+        }
+        else if (event_str == "STOP")
+        {
+            mpl::info(vm_name, "VM suspending");
+        }
+        else if (event_str == "RESUME" && falling_back_to_snapshot)
+        {
+            falling_back_to_snapshot = false;
+            vm_process->write(QByteArray::fromStdString(
+                serialize(hmc_to_qmp_json(QString{"savevm "} + suspend_tag))));
+        }
+        else if (event_str == "RESUME")
+        {
+            mpl::info(vm_name, "VM suspended");
+            if (state == State::suspending || state == State::running)
+            {
+                vm_process->kill();
+                on_suspend();
+            }
+        }
+        else if (event_str == "MIGRATION")
+        {
+            const auto* data = qmp_object.if_contains("data");
+            const auto status = data ? mp::lookup_or<std::string>(*data, "status", "") : "";
+            mpl::debug(vm_name, "Migration {}", status);
+
+            if (suspending_to_file && status == "completed")
+                on_suspended_to_file();
+            else if (suspending_to_file && status == "failed")
+                on_suspend_to_file_failed();
+            else if (resuming_from_file && status == "completed")
+            {
+                mpl::info(vm_name, "Restored from suspend state file");
+                vm_process->write(
+                    QByteArray::fromStdString(serialize(qmp_execute_json("cont"))));
+            }
+        }
+    }
+    else if (auto error = qmp_object.if_contains("error"))
+    {
+        mpl::error(vm_name, "QMP error: {}", value_to<std::string>(error->at("desc")));
+    }
+}
+
+// Sends a command and waits for its reply. The reply is handled as QEMU output always is, through
+// the process's signals, so this waits in an event loop of the thread that owns the process
+boost::json::object mp::QemuVirtualMachine::execute_qmp(boost::json::object command)
+{
+    // qmp_replies is only ever touched on the VM's thread
+    assert(QThread::currentThread() == thread());
+
+    const auto id = std::to_string(++qmp_command_count);
+    const auto execute = value_to<std::string>(command.at("execute"));
+    command["id"] = id;
+    vm_process->write(QByteArray::fromStdString(serialize(command)));
+
+    if (!qmp_replies.contains(id))
+    {
+        QEventLoop wait;
+        QTimer timeout;
+        timeout.setSingleShot(true);
+
+        QObject::connect(&timeout, &QTimer::timeout, &wait, &QEventLoop::quit);
+        QObject::connect(vm_process.get(), &Process::finished, &wait, &QEventLoop::quit);
+        QObject::connect(this, &QemuVirtualMachine::qmp_reply_received, &wait, [this, &id, &wait] {
+            if (qmp_replies.contains(id))
+                wait.quit();
+        });
+
+        timeout.start(qmp_command_timeout);
+        wait.exec();
+    }
+
+    auto node = qmp_replies.extract(id);
+    if (node.empty())
+        throw std::runtime_error{
+            fmt::format("QEMU did not reply to {} on instance {}", execute, vm_name)};
+
+    auto reply = std::move(node.mapped());
+    if (auto error = reply.if_contains("error"))
+        throw std::runtime_error{fmt::format("QEMU failed to {} on instance {}: {}",
+                                             execute,
+                                             vm_name,
+                                             value_to<std::string>(error->at("desc")))};
+
+    return reply;
+}
+
 void mp::QemuVirtualMachine::connect_vm_signals()
 {
     std::unique_lock lock{vm_signal_mutex};
@@ -655,9 +948,18 @@ void mp::QemuVirtualMachine::connect_vm_signals()
         &QemuVirtualMachine::on_delete_memory_snapshot,
         this,
         [this] {
-            mpl::debug(vm_name, "Deleted memory snapshot");
-            vm_process->write(QByteArray::fromStdString(
-                serialize(hmc_to_qmp_json(QString("delvm ") + suspend_tag))));
+            if (resuming_from_file)
+            {
+                mpl::debug(vm_name, "Deleted suspend state file");
+                remove_suspend_state_file();
+                resuming_from_file.reset();
+            }
+            else
+            {
+                mpl::debug(vm_name, "Deleted memory snapshot");
+                vm_process->write(QByteArray::fromStdString(
+                    serialize(hmc_to_qmp_json(QString("delvm ") + suspend_tag))));
+            }
             is_starting_from_suspend = false;
         },
         Qt::QueuedConnection);
@@ -744,6 +1046,66 @@ mp::MountHandler::UPtr mp::QemuVirtualMachine::make_native_mount_handler(const s
     return std::make_unique<QemuMountHandler>(this, &key_provider, target, mount);
 }
 
+bool mp::QemuVirtualMachine::supports_live_snapshots() const
+{
+    return true;
+}
+
+bool mp::QemuVirtualMachine::image_has_snapshot(const std::string& tag)
+{
+    return image_snapshot_tags().contains(tag);
+}
+
+void mp::QemuVirtualMachine::capture_image_snapshot(const std::string& tag)
+{
+    auto& tags = image_snapshot_tags();
+
+    if (live())
+        execute_qmp(internal_snapshot_json("blockdev-snapshot-internal-sync", tag));
+    else
+        backend::checked_exec_qemu_img(make_capture_spec(tag, desc.image.image_path));
+
+    tags.insert(tag);
+}
+
+void mp::QemuVirtualMachine::delete_image_snapshot(const std::string& tag)
+{
+    auto& tags = image_snapshot_tags();
+
+    if (live())
+        execute_qmp(internal_snapshot_json("blockdev-snapshot-delete-internal-sync", tag));
+    else
+        backend::delete_snapshot_from_image(desc.image.image_path, QString::fromStdString(tag));
+
+    tags.erase(tag);
+}
+
+bool mp::QemuVirtualMachine::live() const
+{
+    return vm_process && vm_process->running();
+}
+
+std::unordered_set<std::string>& mp::QemuVirtualMachine::image_snapshot_tags()
+{
+    // Listed on first use rather than when the instance is loaded, so that loading does not wait
+    // on qemu-img. Nothing is cached when listing fails, so that the next use tries again.
+    if (!snapshot_tags)
+    {
+        // qemu-img cannot open the image while QEMU holds it, so ask QEMU then
+        const auto tags =
+            live() ? extract_snapshot_tags(execute_qmp(qmp_execute_json("query-block")))
+                   : extract_snapshot_tags(backend::snapshot_list_output(desc.image.image_path));
+
+        // The suspend snapshot is left out, it comes and goes with QEMU's savevm and loadvm
+        snapshot_tags.emplace();
+        for (const auto& tag : tags)
+            if (tag != suspend_tag)
+                snapshot_tags->insert(tag.toStdString());
+    }
+
+    return *snapshot_tags;
+}
+
 void mp::QemuVirtualMachine::remove_snapshots_from_backend() const
 {
     const QStringList snapshot_tag_list =
@@ -767,8 +1129,6 @@ auto mp::QemuVirtualMachine::make_specific_snapshot(const std::string& snapshot_
                                                     std::shared_ptr<Snapshot> parent)
     -> std::shared_ptr<Snapshot>
 {
-    assert(state == VirtualMachine::State::off ||
-           state == VirtualMachine::State::stopped); // would need QMP otherwise
     return std::make_shared<QemuSnapshot>(snapshot_name,
                                           comment,
                                           instance_id,
@@ -28,8 +28,14 @@
 #include <QObject>
 #include <QStringList>
 
+#include <boost/json.hpp>
+
 #include <chrono>
+#include <cstdint>
+#include <optional>
+#include <string>
 #include <unordered_map>
+#include <unordered_set>
 
 namespace multipass
 {
@@ -42,13 +48,21 @@ class QemuVirtualMachine : public QObject, public BaseVirtualMachine
 public:
     using MountArgs = std::unordered_map<std::string, std::pair<std::string, QStringList>>;
 
+    // Where suspend() saves the guest's state
+    enum class SuspendMode
+    {
+        snapshot, // an internal snapshot of the instance image, with savevm
+        file      // a file of its own, with a migration
+    };
+
     QemuVirtualMachine(const VirtualMachineDescription& desc,
                        QemuPlatform* qemu_platform,
                        VMStatusMonitor& monitor,
                        const SSHKeyProvider& key_provider,
                        AvailabilityZone& zone,
                        const Path& instance_dir,
-                       bool remove_snapshots = false);
+                       bool remove_snapshots = false,
+                       SuspendMode suspend_mode = SuspendMode::snapshot);
     ~QemuVirtualMachine();
 
     void start() override;
@@ -69,10 +83,18 @@ public:
     virtual MountArgs& modifiable_mount_args();
     std::unique_ptr<MountHandler> make_native_mount_handler(const std::string& target,
                                                             const VMMount& mount) override;
+    bool supports_live_snapshots() const override;
+
+    // Internal snapshots in the instance image. They are taken and deleted over QMP while the
+    // instance runs, and with qemu-img otherwise. Virtual to allow mocking
+    virtual bool image_has_snapshot(const std::string& tag);
+    virtual void capture_image_snapshot(const std::string& tag);
+    virtual void delete_image_snapshot(const std::string& tag);
 signals:
     void on_delete_memory_snapshot();
     void on_reset_network();
     void on_synchronize_clock();
+    void qmp_reply_received();
 
 protected:
     // TODO remove this, the onus of composing a VM of stubs should be on the stub VMs
@@ -101,6 +123,14 @@ private:
     void on_shutdown();
     void on_suspend();
     void on_restart();
+    void suspend_to_file();
+    void on_suspended_to_file();
+    void on_suspend_to_file_failed();
+    void remove_suspend_state_file();
+    void handle_qmp_message(const boost::json::object& qmp_object);
+    boost::json::object execute_qmp(boost::json::object command);
+    bool live() const;
+    std::unordered_set<std::string>& image_snapshot_tags();
     void initialize_vm_process();
 
     void connect_vm_signals();
@@ -109,11 +139,21 @@ private:
 
     std::unique_ptr<Process> vm_process{nullptr};
     QemuPlatform* qemu_platform;
+    const SuspendMode suspend_mode{SuspendMode::snapshot};
     VMStatusMonitor* monitor;
     MountArgs mount_args;
     bool update_shutdown_status{true};
     bool is_starting_from_suspend{false};
     bool force_shutdown{false};
+    // Multifd channels of the migration to or from a suspend state file, while there is one
+    std::optional<int> suspending_to_file;
+    std::optional<int> resuming_from_file;
+    bool falling_back_to_snapshot{false};
+    // Replies to the QMP commands that execute_qmp() is waiting on, by command id
+    std::unordered_map<std::string, boost::json::object> qmp_replies;
+    std::uint64_t qmp_command_count{0};
+    // Tags of the snapshots in the image, listed once and then kept up to date as they change
+    std::optional<std::unordered_set<std::string>> snapshot_tags;
     std::mutex vm_signal_mutex;
     bool vm_signals_connected{false};
     std::chrono::steady_clock::time_point network_deadline;
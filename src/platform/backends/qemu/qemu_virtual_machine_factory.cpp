@@ -37,22 +37,28 @@ namespace
 constexpr auto category = "qemu factory";
 } // namespace
 
-mp::QemuVirtualMachineFactory::QemuVirtualMachineFactory(const mp::Path& data_dir,
-                                                         AvailabilityZoneManager& az_manager)
+mp::QemuVirtualMachineFactory::QemuVirtualMachineFactory(
+    const mp::Path& data_dir,
+    AvailabilityZoneManager& az_manager,
+    QemuVirtualMachine::SuspendMode suspend_mode)
     : QemuVirtualMachineFactory{MP_QEMU_PLATFORM_FACTORY.make_qemu_platform(data_dir, az_manager),
                                 data_dir,
-                                az_manager}
+                                az_manager,
+                                suspend_mode}
 {
 }
 
-mp::QemuVirtualMachineFactory::QemuVirtualMachineFactory(QemuPlatform::UPtr qemu_platform,
-                                                         const mp::Path& data_dir,
-                                                         AvailabilityZoneManager& az_manager)
+mp::QemuVirtualMachineFactory::QemuVirtualMachineFactory(
+    QemuPlatform::UPtr qemu_platform,
+    const mp::Path& data_dir,
+    AvailabilityZoneManager& az_manager,
+    QemuVirtualMachine::SuspendMode suspend_mode)
     : BaseVirtualMachineFactory(MP_UTILS.derive_instances_dir(data_dir,
                                                               qemu_platform->get_directory_name(),
                                                               instances_subdir),
                                 az_manager),
-      qemu_platform{std::move(qemu_platform)}
+      qemu_platform{std::move(qemu_platform)},
+      suspend_mode{suspend_mode}
 {
 }
 
@@ -66,7 +72,9 @@ mp::VirtualMachine::UPtr mp::QemuVirtualMachineFactory::create_virtual_machine(
                                                     monitor,
                                                     key_provider,
                                                     az_manager.get_zone(desc.zone),
-                                                    get_instance_directory(desc.vm_name));
+                                                    get_instance_directory(desc.vm_name),
+                                                    false,
+                                                    suspend_mode);
 }
 
 void mp::QemuVirtualMachineFactory::remove_resources_for_impl(const std::string& name)
@@ -188,5 +196,6 @@ mp::VirtualMachine::UPtr mp::QemuVirtualMachineFactory::clone_vm_impl(
                                                     key_provider,
                                                     az_manager.get_zone(desc.zone),
                                                     get_instance_directory(desc.vm_name),
-                                                    true);
+                                                    true,
+                                                    suspend_mode);
 }
@@ -17,6 +17,7 @@
 #pragma once
 
 #include "qemu_platform.h"
+#include "qemu_virtual_machine.h"
 
 #include <multipass/path.h>
 #include <shared/base_virtual_machine_factory.h>
@@ -30,7 +31,10 @@ namespace multipass
 class QemuVirtualMachineFactory final : public BaseVirtualMachineFactory
 {
 public:
-    explicit QemuVirtualMachineFactory(const Path& data_dir, AvailabilityZoneManager& az_manager);
+    QemuVirtualMachineFactory(
+        const Path& data_dir,
+        AvailabilityZoneManager& az_manager,
+        QemuVirtualMachine::SuspendMode suspend_mode = QemuVirtualMachine::SuspendMode::snapshot);
 
     VirtualMachine::UPtr create_virtual_machine(const VirtualMachineDescription& desc,
                                                 const SSHKeyProvider& key_provider,
@@ -51,7 +55,8 @@ protected:
 private:
     QemuVirtualMachineFactory(QemuPlatform::UPtr qemu_platform,
                               const Path& data_dir,
-                              AvailabilityZoneManager& az_manager);
+                              AvailabilityZoneManager& az_manager,
+                              QemuVirtualMachine::SuspendMode suspend_mode);
     VirtualMachine::UPtr clone_vm_impl(const std::string& source_vm_name,
                                        const multipass::VMSpecs& src_vm_specs,
                                        const VirtualMachineDescription& desc,
@@ -59,5 +64,6 @@ private:
                                        const SSHKeyProvider& key_provider) override;
 
     QemuPlatform::UPtr qemu_platform;
+    const QemuVirtualMachine::SuspendMode suspend_mode;
 };
 } // namespace multipass
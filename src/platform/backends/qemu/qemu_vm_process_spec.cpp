@@ -54,8 +54,12 @@ QStringList mp::QemuVMProcessSpec::arguments() const
             args.prepend("-L");
         }
 
-        // need to append extra arguments for resume
-        args << "-loadvm" << resume_data->suspend_tag;
+        // need to append extra arguments for resume; state files are loaded over QMP once the
+        // process is up, so that migration parameters can be set first
+        if (resume_data->state_file.isEmpty())
+            args << "-loadvm" << resume_data->suspend_tag;
+        else
+            args << "-incoming" << "defer";
 
         QString machine_type = resume_data->machine_type;
         if (!machine_type.isEmpty())
@@ -211,6 +215,7 @@ profile %1 flags=(attach_disconnected) {
   # Disk images
   %6 rwk,  # QCow2 filesystem image
   %7 rk,   # cloud-init ISO
+  %9 rw,   # suspended VM state
 
   # allow full access just to user-specified mount directories on the host
   %8
@@ -249,7 +254,13 @@ profile %1 flags=(attach_disconnected) {
                                 program(),
                                 QString::fromStdString(desc.image.image_path),
                                 desc.cloud_init_iso,
-                                mount_dirs);
+                                mount_dirs,
+                                suspend_state_file(desc) + "{,.part}");
+}
+
+QString mp::QemuVMProcessSpec::suspend_state_file(const VirtualMachineDescription& desc)
+{
+    return MP_PLATFORM.path_to_qstr(desc.image.image_path.parent_path() / "suspend.state");
 }
 
 QString mp::QemuVMProcessSpec::identifier() const
@@ -35,9 +35,12 @@ public:
         QString suspend_tag;
         QString machine_type;
         QStringList arguments;
+        QString state_file; // when set, the VM is restored from this file instead of the snapshot
     };
 
     static QString default_machine_type();
+    // Where the VM's state goes when it is suspended to a file, next to its image
+    static QString suspend_state_file(const VirtualMachineDescription& desc);
 
     explicit QemuVMProcessSpec(const VirtualMachineDescription& desc,
                                const QStringList& platform_args,
@@ -513,7 +513,13 @@ std::shared_ptr<const mp::Snapshot> mp::BaseVirtualMachine::take_snapshot(
     const std::string& comment)
 {
     std::unique_lock lock{snapshot_mutex};
-    assert_vm_stopped(state); // precondition
+    if (!supports_live_snapshots())
+        assert_vm_stopped(state); // precondition
+
+    // Live snapshots hold the disk only, so they are restored to a stopped instance
+    auto snapshot_specs = specs;
+    if (state != St::off && state != St::stopped)
+        snapshot_specs.state = St::off;
 
     auto sname = snapshot_name.empty() ? generate_snapshot_name() : snapshot_name;
 
@@ -531,7 +537,7 @@ std::shared_ptr<const mp::Snapshot> mp::BaseVirtualMachine::take_snapshot(
         make_specific_snapshot(sname,
                                comment,
                                get_instance_id_from_the_cloud_init(),
-                               specs,
+                               snapshot_specs,
                                head_snapshot);
     ret->capture();
 
@@ -82,6 +82,10 @@ public:
     std::shared_ptr<Snapshot> get_snapshot(const std::string& name) override;
     std::shared_ptr<Snapshot> get_snapshot(int index) override;
 
+    bool supports_live_snapshots() const override
+    {
+        return false;
+    }
     // TODO: the VM should know its directory, but that is true of everything in its VMDescription;
     // pulling that from derived classes is a big refactor
     std::shared_ptr<const Snapshot> take_snapshot(const VMSpecs& specs,
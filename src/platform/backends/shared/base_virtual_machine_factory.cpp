@@ -97,12 +97,13 @@ mp::VirtualMachine::UPtr mp::BaseVirtualMachineFactory::clone_bare_vm(
     const std::string& dest_name,
     const VMImage& dest_image,
     const multipass::SSHKeyProvider& key_provider,
-    VMStatusMonitor& monitor)
+    VMStatusMonitor& monitor,
+    const FileCopyProgress& copy_progress)
 {
     const std::filesystem::path src_instance_dir{get_instance_directory(src_name).toStdString()};
     const std::filesystem::path dest_instance_dir{get_instance_directory(dest_name).toStdString()};
 
-    copy_instance_dir_with_essential_files(src_instance_dir, dest_instance_dir);
+    copy_instance_dir_with_essential_files(src_instance_dir, dest_instance_dir, copy_progress);
 
     const fs::path cloud_init_path = dest_instance_dir / cloud_init_file_name;
 
@@ -132,19 +133,22 @@ mp::VirtualMachine::UPtr mp::BaseVirtualMachineFactory::clone_bare_vm(
 
 void mp::BaseVirtualMachineFactory::copy_instance_dir_with_essential_files(
     const fs::path& source_instance_dir_path,
-    const fs::path& dest_instance_dir_path)
+    const fs::path& dest_instance_dir_path,
+    const FileCopyProgress& progress)
 {
     assert(fs::exists(source_instance_dir_path) && fs::is_directory(source_instance_dir_path));
 
     fs::create_directory(dest_instance_dir_path);
+
+    std::vector<FileCopy> files;
     for (const auto& entry : fs::directory_iterator(source_instance_dir_path))
     {
         const auto ext = entry.path().extension().string();
         // snapshot files are intentionally skipped; .raw is skipped when an .asif image exists
         if (cloneable_files.contains(ext))
-        {
-            const fs::path dest_file_path = dest_instance_dir_path / entry.path().filename();
-            fs::copy(entry.path(), dest_file_path, fs::copy_options::update_existing);
-        }
+            files.push_back({entry.path(), dest_instance_dir_path / entry.path().filename()});
     }
+
+    // Disks can take several GB, so they are cloned or copied in parallel, all together
+    copy_files(files, progress);
 }
@@ -24,6 +24,7 @@
 #include <multipass/vm_image_vault.h>
 #include <multipass/vm_image_vault_utils.h>
 
+#include <optional>
 #include <string>
 #include <utility>
 #include <vector>
@@ -93,6 +94,24 @@ protected:
         return info;
     };
 
+    // Looks an image up by full hash in all image hosts
+    std::optional<VMImageInfo> info_for_full_hash(const std::string& full_hash) const
+    {
+        for (const auto& image_host : image_hosts)
+        {
+            try
+            {
+                return image_host->info_for_full_hash(full_hash);
+            }
+            catch (const std::exception&)
+            {
+                // Not in this host's manifests
+            }
+        }
+
+        return std::nullopt;
+    };
+
 private:
     std::vector<VMImageHost*> image_hosts;
     std::unordered_map<std::string, VMImageHost*> remote_image_host_map;
@@ -169,3 +169,10 @@ std::unique_ptr<mp::Process> mp::ProcessFactory::create_process(const QString& c
 {
     return create_process(simple_process_spec(command, arguments));
 }
+
+void mp::ProcessFactory::update_confinement(const ProcessSpec& process_spec) const
+{
+    // Replacing a loaded profile applies to the processes it already confines
+    if (apparmor && !process_spec.apparmor_profile().isNull())
+        apparmor->load_policy(process_spec.apparmor_profile().toLatin1());
+}
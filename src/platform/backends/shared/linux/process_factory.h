@@ -40,6 +40,10 @@ public:
     std::unique_ptr<Process> create_process(const QString& command,
                                             const QStringList& args = QStringList()) const;
 
+    // Reloads the confinement of processes already running under the given spec's profile, e.g.
+    // after the set of paths they may access changed
+    virtual void update_confinement(const ProcessSpec& process_spec) const;
+
 private:
     const std::optional<AppArmor> apparmor;
 };
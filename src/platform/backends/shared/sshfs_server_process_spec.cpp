@@ -18,12 +18,10 @@
 #include "sshfs_server_process_spec.h"
 
 #include <multipass/exceptions/snap_environment_exception.h>
-#include <multipass/id_mappings.h>
 #include <multipass/logging/log.h>
 #include <multipass/snap_utils.h>
 
 #include <QCoreApplication>
-#include <QCryptographicHash>
 #include <QDir>
 
 namespace mp = multipass;
@@ -31,28 +29,18 @@ namespace mpu = multipass::utils;
 
 namespace
 {
-QString serialise_id_mappings(const mp::id_mappings& xid_mappings)
+QString source_path_rules(const std::vector<std::string>& source_paths)
 {
-    QString out;
-    for (auto ids : xid_mappings)
-    {
-        out += QString("%1:%2,").arg(ids.first).arg(ids.second);
-    }
-    return out;
-}
+    QString rules;
+    for (const auto& path : source_paths)
+        rules += QString("    %1/ rw,\n    %1/** rwlk,\n").arg(QString::fromStdString(path));
 
-QByteArray gen_hash(const std::string& path)
-{
-    // need to return unique name for each mount.  The target directory string will be unique,
-    // so hash it and return first 8 hex chars.
-    return QCryptographicHash::hash(QByteArray::fromStdString(path), QCryptographicHash::Sha256)
-        .toHex()
-        .left(8);
+    return rules;
 }
 } // namespace
 
 mp::SSHFSServerProcessSpec::SSHFSServerProcessSpec(const SSHFSServerConfig& config)
-    : config(config), target_hash(gen_hash(config.source_path))
+    : config(config)
 {
 }
 
@@ -65,10 +53,6 @@ QStringList mp::SSHFSServerProcessSpec::arguments() const
 {
     return QStringList() << QString::fromStdString(config.host) << QString::number(config.port)
                          << QString::fromStdString(config.username)
-                         << QString::fromStdString(config.source_path)
-                         << QString::fromStdString(config.target_path)
-                         << serialise_id_mappings(config.uid_mappings)
-                         << serialise_id_mappings(config.gid_mappings)
                          << QString::number(static_cast<int>(mp::logging::get_logging_level()));
 }
 
@@ -93,7 +77,7 @@ profile %1 flags=(attach_disconnected) {
     #include <abstractions/nameservice>
 
     # Sshfs_server requires broad filesystem altering permissions, but only for the
-    # host directory the user has specified to be shared with the VM.
+    # host directories the user has specified to be shared with the VM.
 
     # Required for reading and searching host directories
     capability dac_override,
@@ -123,10 +107,9 @@ profile %1 flags=(attach_disconnected) {
     # CLASSIC ONLY: need to specify required libs from core snap
     /{,var/lib/snapd/}snap/core18/*/{,usr/}lib/@{multiarch}/{,**/}*.so* rm,
 
-    # allow full access just to this user-specified source directory on the host
-    %4/ rw,
-    %4/** rwlk,
-}
+    # allow full access just to the user-specified source directories on the host,
+    # which change as mounts come and go
+%4}
     )END");
 
     /* Customisations depending on if running inside snap or not */
@@ -150,10 +133,11 @@ profile %1 flags=(attach_disconnected) {
     return profile_template.arg(apparmor_profile_name(),
                                 signal_peer,
                                 root_dir,
-                                QString::fromStdString(config.source_path));
+                                source_path_rules(config.source_paths));
 }
 
 QString mp::SSHFSServerProcessSpec::identifier() const
 {
-    return QString::fromStdString(config.instance) + "." + target_hash;
+    // One server serves all the mounts of an instance
+    return QString::fromStdString(config.instance);
 }
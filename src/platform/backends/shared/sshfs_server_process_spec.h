@@ -39,7 +39,6 @@ public:
 
 private:
     const SSHFSServerConfig config;
-    const QByteArray target_hash;
 };
 
 } // namespace multipass
@@ -0,0 +1,152 @@
+/*
+ * Copyright (C) Canonical, Ltd.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "virtualbox_state_cache.h"
+
+#include <multipass/format.h>
+#include <multipass/logging/log.h>
+
+#include <QProcess>
+#include <QProcessEnvironment>
+
+#include <stdexcept>
+
+namespace mp = multipass;
+namespace mpl = multipass::logging;
+
+namespace
+{
+constexpr auto category = "virtualbox states";
+
+mp::VirtualMachine::State to_state(const QString& name, const QString& vbox_state)
+{
+    mpl::trace(name.toStdString(), "Got VMState: {}", vbox_state.toStdString());
+
+    if (vbox_state == "starting" || vbox_state == "restoring")
+        return mp::VirtualMachine::State::starting;
+
+    if (vbox_state == "running" || vbox_state == "paused" || vbox_state == "online snapshotting" ||
+        vbox_state == "live snapshotting" || vbox_state == "stopping")
+        return mp::VirtualMachine::State::running;
+
+    if (vbox_state == "saving")
+        return mp::VirtualMachine::State::suspending;
+
+    if (vbox_state == "saved")
+        return mp::VirtualMachine::State::suspended;
+
+    if (vbox_state == "powered off" || vbox_state == "aborted")
+        return mp::VirtualMachine::State::stopped;
+
+    mpl::error(name.toStdString(), "Failed to parse instance state: {}", vbox_state.toStdString());
+    return mp::VirtualMachine::State::unknown;
+}
+
+// The long listing has a block per instance, where the first "Name:" is that of the instance and
+// the only "State:" comes before any of the names of its snapshots or shared folders
+std::unordered_map<std::string, mp::VirtualMachine::State> parse_states(const QString& listing)
+{
+    std::unordered_map<std::string, mp::VirtualMachine::State> states;
+
+    QString name;
+    for (const auto& line : listing.split('\n'))
+    {
+        if (line.startsWith("Name:"))
+        {
+            name = line.mid(5).trimmed();
+        }
+        else if (line.startsWith("State:") && !name.isEmpty())
+        {
+            // e.g. "powered off (since 2024-04-10T15:34:09.000000000)"
+            const auto state = line.mid(6).trimmed();
+            states[name.toStdString()] = to_state(name, state.left(state.indexOf(" (since")));
+            name.clear();
+        }
+    }
+
+    return states;
+}
+} // namespace
+
+mp::VirtualBoxStateCache::VirtualBoxStateCache(std::chrono::milliseconds max_age)
+    : max_age{max_age}
+{
+}
+
+mp::VirtualMachine::State mp::VirtualBoxStateCache::state_of(const QString& name)
+{
+    std::lock_guard lock{mutex};
+
+    auto fresh = false;
+    if (!refreshed_at || std::chrono::steady_clock::now() - *refreshed_at > max_age)
+    {
+        refresh();
+        fresh = true;
+    }
+
+    const auto key = name.toStdString();
+    auto it = states.find(key);
+    if (it == states.end() && !fresh && !missing.contains(key)) // it may have been created since
+    {
+        refresh();
+        it = states.find(key);
+    }
+
+    if (it == states.end())
+    {
+        missing.insert(key);
+        return VirtualMachine::State::unknown;
+    }
+
+    return it->second;
+}
+
+void mp::VirtualBoxStateCache::invalidate()
+{
+    std::lock_guard lock{mutex};
+    refreshed_at.reset();
+}
+
+void mp::VirtualBoxStateCache::refresh()
+{
+    // The states are parsed from their English names, whatever the locale of the daemon
+    auto environment = QProcessEnvironment::systemEnvironment();
+    environment.insert("LC_ALL", "C");
+
+    QProcess list;
+    list.setProcessEnvironment(environment);
+    list.start("VBoxManage", {"list", "--long", "vms"});
+    if (!list.waitForFinished() || list.exitStatus() != QProcess::NormalExit)
+        throw std::runtime_error(
+            fmt::format("Failed to run VBoxManage: {}", list.errorString().toStdString()));
+
+    if (list.exitCode() != 0)
+    {
+        mpl::warn(category,
+                  "Could not list instances: {}",
+                  QString::fromUtf8(list.readAllStandardError()).trimmed().toStdString());
+        states.clear();
+    }
+    else
+    {
+        states = parse_states(QString::fromUtf8(list.readAllStandardOutput()));
+        mpl::trace(category, "Got the states of {} instance(s)", states.size());
+    }
+
+    missing.clear();
+    refreshed_at = std::chrono::steady_clock::now();
+}
@@ -0,0 +1,62 @@
+/*
+ * Copyright (C) Canonical, Ltd.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#pragma once
+
+#include <multipass/disabled_copy_move.h>
+#include <multipass/virtual_machine.h>
+
+#include <QString>
+
+#include <chrono>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+
+namespace multipass
+{
+/*
+ * The states of all VirtualBox instances, as reported by a single VBoxManage call, so that asking
+ * for the state of every instance does not take a process per instance.
+ *
+ * States are kept for max_age, after which the next lookup asks VirtualBox again. Whoever changes
+ * the state of an instance through VBoxManage should invalidate the cache afterwards. Names that
+ * VirtualBox did not list are asked for again once, in case they were just created, and then
+ * reported unknown until the states are refreshed.
+ */
+class VirtualBoxStateCache : private DisabledCopyMove
+{
+public:
+    static constexpr std::chrono::milliseconds default_max_age{1000};
+
+    explicit VirtualBoxStateCache(std::chrono::milliseconds max_age = default_max_age);
+
+    VirtualMachine::State state_of(const QString& name);
+    void invalidate();
+
+private:
+    void refresh(); // requires the lock
+
+    const std::chrono::milliseconds max_age;
+    std::mutex mutex;
+    std::unordered_map<std::string, VirtualMachine::State> states;
+    std::unordered_set<std::string> missing; // looked up since the last refresh, but not listed
+    std::optional<std::chrono::steady_clock::time_point> refreshed_at;
+};
+} // namespace multipass
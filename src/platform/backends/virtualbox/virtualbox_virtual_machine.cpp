@@ -17,6 +17,7 @@
 
 #include "virtualbox_virtual_machine.h"
 #include "virtualbox_snapshot.h"
+#include "virtualbox_state_cache.h"
 
 #include <multipass/exceptions/virtual_machine_state_exceptions.h>
 #include <multipass/ip_address.h>
@@ -32,7 +33,6 @@
 
 #include <fmt/format.h>
 
-#include <QProcess>
 #include <QRegularExpression>
 #include <QtNetwork/QTcpServer>
 
@@ -43,63 +43,6 @@ namespace fs = std::filesystem;
 
 namespace
 {
-auto instance_state_for(const QString& name)
-{
-    QRegularExpression vmstate_re("VMState=\"([a-z]+)\"");
-
-    QProcess vminfo;
-    vminfo.start("VBoxManage", {"showvminfo", name, "--machinereadable"});
-    auto success = vminfo.waitForFinished();
-    if (!success || vminfo.exitStatus() != QProcess::NormalExit)
-    {
-        throw std::runtime_error(
-            fmt::format("Failed to run VBoxManage: {}", vminfo.errorString().toStdString()));
-    }
-    auto vminfo_output = QString::fromUtf8(vminfo.readAllStandardOutput());
-    auto vmstate_match = vmstate_re.match(vminfo_output);
-
-    if (vmstate_match.hasMatch())
-    {
-        auto state = vmstate_match.captured(1);
-
-        mpl::trace(name.toStdString(), "Got VMState: {}", state.toStdString());
-
-        if (state == "starting" || state == "restoring")
-        {
-            return mp::VirtualMachine::State::starting;
-        }
-        else if (state == "running" || state == "paused" || state == "onlinesnapshotting" ||
-                 state == "stopping")
-        {
-            return mp::VirtualMachine::State::running;
-        }
-        else if (state == "saving")
-        {
-            return mp::VirtualMachine::State::suspending;
-        }
-        else if (state == "saved")
-        {
-            return mp::VirtualMachine::State::suspended;
-        }
-        else if (state == "poweroff" || state == "aborted")
-        {
-            return mp::VirtualMachine::State::stopped;
-        }
-
-        mpl::error(name.toStdString(),
-                   "Failed to parse instance state: {}",
-                   vmstate_match.captured().toStdString());
-    }
-    else if (vminfo.exitCode() == 0)
-    {
-        mpl::error(name.toStdString(),
-                   "Failed to parse info output: {}",
-                   vminfo_output.toStdString());
-    }
-
-    return mp::VirtualMachine::State::unknown;
-}
-
 QStringList extra_net_args(int index, const mp::NetworkInterface& net)
 {
     QString iface_index_str = QString::number(index);
@@ -184,8 +127,9 @@ mp::VirtualBoxVirtualMachine::VirtualBoxVirtualMachine(const VirtualMachineDescr
                                                        VMStatusMonitor& monitor,
                                                        const SSHKeyProvider& key_provider,
                                                        AvailabilityZone& zone,
-                                                       const mp::Path& instance_dir_qstr)
-    : VirtualBoxVirtualMachine(desc, monitor, key_provider, zone, instance_dir_qstr, true)
+                                                       const mp::Path& instance_dir_qstr,
+                                                       VirtualBoxStateCache& states)
+    : VirtualBoxVirtualMachine(desc, monitor, key_provider, zone, instance_dir_qstr, states, true)
 {
     if (desc.extra_interfaces.size() > 7)
     {
@@ -257,7 +201,7 @@ mp::VirtualBoxVirtualMachine::VirtualBoxVirtualMachine(const VirtualMachineDescr
     }
     else
     {
-        state = instance_state_for(name);
+        state = states.state_of(name);
     }
 }
 
@@ -266,8 +210,9 @@ mp::VirtualBoxVirtualMachine::VirtualBoxVirtualMachine(const std::string& source
                                                        VMStatusMonitor& monitor,
                                                        const SSHKeyProvider& key_provider,
                                                        AvailabilityZone& zone,
-                                                       const Path& dest_instance_dir)
-    : VirtualBoxVirtualMachine(desc, monitor, key_provider, zone, dest_instance_dir, true)
+                                                       const Path& dest_instance_dir,
+                                                       VirtualBoxStateCache& states)
+    : VirtualBoxVirtualMachine(desc, monitor, key_provider, zone, dest_instance_dir, states, true)
 {
     const fs::path instances_dir = fs::path{dest_instance_dir.toStdString()}.parent_path();
 
@@ -334,10 +279,12 @@ mp::VirtualBoxVirtualMachine::VirtualBoxVirtualMachine(const VirtualMachineDescr
                                                        const SSHKeyProvider& key_provider,
                                                        AvailabilityZone& zone,
                                                        const mp::Path& instance_dir_qstr,
+                                                       VirtualBoxStateCache& states,
                                                        bool /*is_internal*/)
     : BaseVirtualMachine{desc.vm_name, desc, key_provider, zone, instance_dir_qstr},
       name{QString::fromStdString(desc.vm_name)},
-      monitor{&monitor}
+      monitor{&monitor},
+      states{states}
 {
 }
 
@@ -360,6 +307,7 @@ void mp::VirtualBoxVirtualMachine::start()
                                 {"startvm", name, "--type", "headless"},
                                 "Could not start VM: {}",
                                 name);
+    states.invalidate();
 }
 
 void mp::VirtualBoxVirtualMachine::shutdown(ShutdownPolicy shutdown_policy)
@@ -408,6 +356,7 @@ void mp::VirtualBoxVirtualMachine::shutdown(ShutdownPolicy shutdown_policy)
                                     name);
     }
 
+    states.invalidate();
     state = State::stopped;
 
     // If it wasn't force, we wouldn't be here
@@ -422,7 +371,8 @@ void mp::VirtualBoxVirtualMachine::shutdown(ShutdownPolicy shutdown_policy)
 
 void mp::VirtualBoxVirtualMachine::suspend()
 {
-    auto present_state = instance_state_for(name);
+    states.invalidate(); // this needs to act on what the instance is doing now
+    auto present_state = states.state_of(name);
 
     if (present_state == State::running || present_state == State::delayed_shutdown)
     {
@@ -430,6 +380,7 @@ void mp::VirtualBoxVirtualMachine::suspend()
                                     {"controlvm", name, "savestate"},
                                     "Could not suspend VM: {}",
                                     name);
+        states.invalidate();
 
         drop_ssh_session();
         if (update_suspend_status)
@@ -448,7 +399,7 @@ void mp::VirtualBoxVirtualMachine::suspend()
 
 mp::VirtualMachine::State mp::VirtualBoxVirtualMachine::current_state()
 {
-    auto present_state = instance_state_for(name);
+    auto present_state = states.state_of(name);
 
     if ((state == State::delayed_shutdown && present_state == State::running) ||
         state == State::starting)
@@ -29,6 +29,7 @@ namespace multipass
 {
 class PowerShell;
 class SSHKeyProvider;
+class VirtualBoxStateCache;
 class VirtualMachineDescription;
 class VMStatusMonitor;
 
@@ -39,14 +40,16 @@ public:
                              VMStatusMonitor& monitor,
                              const SSHKeyProvider& key_provider,
                              AvailabilityZone& zone,
-                             const Path& instance_dir);
+                             const Path& instance_dir,
+                             VirtualBoxStateCache& states);
     // Contruct the vm based on the source virtual machine
     VirtualBoxVirtualMachine(const std::string& source_vm_name,
                              const VirtualMachineDescription& desc,
                              VMStatusMonitor& monitor,
                              const SSHKeyProvider& key_provider,
                              AvailabilityZone& zone,
-                             const Path& dest_instance_dir);
+                             const Path& dest_instance_dir,
+                             VirtualBoxStateCache& states);
     ~VirtualBoxVirtualMachine() override;
 
     void start() override;
@@ -80,12 +83,14 @@ private:
                              const SSHKeyProvider& key_provider,
                              AvailabilityZone& zone,
                              const Path& instance_dir_qstr,
+                             VirtualBoxStateCache& states,
                              bool is_internal);
     void remove_snapshots_from_backend() const;
 
     const QString name;
     std::optional<int> port;
     VMStatusMonitor* monitor;
+    VirtualBoxStateCache& states;
     bool update_suspend_status{true};
 };
 } // namespace multipass
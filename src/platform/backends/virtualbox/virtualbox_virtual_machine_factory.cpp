@@ -137,7 +137,8 @@ auto mp::VirtualBoxVirtualMachineFactory::create_virtual_machine(
                                                           monitor,
                                                           key_provider,
                                                           az_manager.get_zone(desc.zone),
-                                                          get_instance_directory(desc.vm_name));
+                                                          get_instance_directory(desc.vm_name),
+                                                          states);
 }
 
 void mp::VirtualBoxVirtualMachineFactory::remove_resources_for_impl(const std::string& name)
@@ -161,6 +162,7 @@ void mp::VirtualBoxVirtualMachineFactory::remove_resources_for_impl(const std::s
                               "Could not unregister VM: {}",
                               QString::fromStdString(name),
                               mpl::Level::error);
+    states.invalidate();
 
     if (cloudinit_match.hasMatch())
     {
@@ -287,5 +289,6 @@ mp::VirtualMachine::UPtr mp::VirtualBoxVirtualMachineFactory::clone_vm_impl(
         monitor,
         key_provider,
         az_manager.get_zone(dest_vm_desc.zone),
-        get_instance_directory(dest_vm_desc.vm_name));
+        get_instance_directory(dest_vm_desc.vm_name),
+        states);
 }
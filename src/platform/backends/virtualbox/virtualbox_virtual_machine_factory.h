@@ -17,6 +17,8 @@
 
 #pragma once
 
+#include "virtualbox_state_cache.h"
+
 #include <shared/base_virtual_machine_factory.h>
 
 namespace multipass
@@ -55,5 +57,7 @@ private:
                                        const VirtualMachineDescription& desc,
                                        VMStatusMonitor& monitor,
                                        const SSHKeyProvider& key_provider) override;
+
+    VirtualBoxStateCache states;
 };
 } // namespace multipass
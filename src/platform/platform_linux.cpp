@@ -54,10 +54,21 @@
 #include <QString>
 #include <QTextStream>
 
+#include <algorithm>
+#include <atomic>
+#include <optional>
+#include <utility>
+
 #include <errno.h>
+#include <fcntl.h>
+#include <linux/fs.h>
 #include <linux/if_arp.h>
+#include <linux/openat2.h>
 #include <string.h>
+#include <sys/ioctl.h>
+#include <sys/resource.h>
 #include <sys/stat.h>
+#include <sys/syscall.h>
 #include <sys/types.h>
 #include <unistd.h>
 
@@ -70,6 +81,15 @@ namespace
 constexpr auto category = "Linux platform";
 constexpr auto br_nomenclature = "bridge";
 
+// From linux/ioprio.h, which is not exported to userspace everywhere
+constexpr auto ioprio_who_process = 1;
+constexpr auto ioprio_class_shift = 13;
+constexpr auto ioprio_class_idle = 3;
+constexpr auto background_nice = 19;
+
+// The priorities the thread had before it was put in the background, if it was
+thread_local std::optional<std::pair<int, long>> foreground_priorities;
+
 // Fetch the ARP protocol HARDWARE identifier.
 int get_net_type(const QDir& net_dir) // types defined in if_arp.h
 {
@@ -454,7 +474,12 @@ mp::VirtualMachineFactory::UPtr mp::platform::vm_backend(const mp::Path& data_di
 {
     const auto& driver = MP_SETTINGS.get(mp::driver_key);
     if (driver == QStringLiteral("qemu"))
-        return std::make_unique<QemuVirtualMachineFactory>(data_dir, az_manager);
+        return std::make_unique<QemuVirtualMachineFactory>(
+            data_dir,
+            az_manager,
+            MP_SETTINGS.get(mp::suspend_mode_key) == QStringLiteral("file")
+                ? QemuVirtualMachine::SuspendMode::file
+                : QemuVirtualMachine::SuspendMode::snapshot);
 
 #if VIRTUALBOX_ENABLED
     if (driver == QStringLiteral("virtualbox"))
@@ -470,6 +495,11 @@ std::unique_ptr<mp::Process> mp::platform::make_sshfs_server_process(
     return MP_PROCFACTORY.create_process(std::make_unique<mp::SSHFSServerProcessSpec>(config));
 }
 
+void mp::platform::update_sshfs_server_confinement(const mp::SSHFSServerConfig& config)
+{
+    MP_PROCFACTORY.update_confinement(mp::SSHFSServerProcessSpec{config});
+}
+
 std::unique_ptr<mp::Process> mp::platform::make_process(
     std::unique_ptr<mp::ProcessSpec>&& process_spec)
 {
@@ -495,6 +525,158 @@ std::string mp::platform::reinterpret_interface_id(const std::string& ux_id)
     return ux_id;
 }
 
+bool mp::platform::set_thread_background_priority(bool background)
+{
+    // Both nice values and I/O priorities apply to single threads when given a thread ID
+    const auto tid = static_cast<id_t>(syscall(SYS_gettid));
+
+    if (!background)
+    {
+        if (!foreground_priorities)
+            return true;
+
+        const auto [nice, ioprio] = *std::exchange(foreground_priorities, std::nullopt);
+        return setpriority(PRIO_PROCESS, tid, nice) == 0 &&
+               syscall(SYS_ioprio_set, ioprio_who_process, tid, ioprio) == 0;
+    }
+
+    errno = 0;
+    const auto nice = getpriority(PRIO_PROCESS, tid);
+    const auto ioprio = syscall(SYS_ioprio_get, ioprio_who_process, tid);
+    if (errno)
+        return false;
+
+    if (!foreground_priorities)
+        foreground_priorities.emplace(nice, ioprio);
+
+    return setpriority(PRIO_PROCESS, tid, background_nice) == 0 &&
+           syscall(SYS_ioprio_set,
+                   ioprio_who_process,
+                   tid,
+                   ioprio_class_idle << ioprio_class_shift) == 0;
+}
+
+bool mp::platform::clone_file(const std::filesystem::path& source,
+                              const std::filesystem::path& destination)
+{
+    const mp::NamedFd in{source, ::open(source.c_str(), O_RDONLY | O_CLOEXEC)};
+    struct stat source_stat;
+    if (in.fd == -1 || fstat(in.fd, &source_stat) != 0)
+        return false;
+
+    auto cloned = false;
+    {
+        const mp::NamedFd out{destination,
+                              ::open(destination.c_str(),
+                                     O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC,
+                                     source_stat.st_mode & 07777)};
+        // Btrfs and XFS share extents; other filesystems refuse with EOPNOTSUPP or EXDEV
+        cloned = out.fd != -1 && ioctl(out.fd, FICLONE, in.fd) == 0;
+    }
+
+    if (!cloned)
+        ::unlink(destination.c_str());
+
+    return cloned;
+}
+
+bool mp::platform::copy_file_range(const std::filesystem::path& source,
+                                   const std::filesystem::path& destination,
+                                   std::uint64_t offset,
+                                   std::uint64_t length)
+{
+    const mp::NamedFd in{source, ::open(source.c_str(), O_RDONLY | O_CLOEXEC)};
+    const mp::NamedFd out{destination, ::open(destination.c_str(), O_WRONLY | O_CLOEXEC)};
+    if (in.fd == -1 || out.fd == -1)
+        return false;
+
+    const auto end = static_cast<off_t>(offset + length);
+    for (auto position = static_cast<off_t>(offset); position < end;)
+    {
+        // Only data is copied, the destination has holes where the source does already
+        const auto data = lseek(in.fd, position, SEEK_DATA);
+        if (data == -1)
+            return errno == ENXIO; // nothing but a hole up to the end of the file
+        if (data >= end)
+            break;
+
+        const auto hole = lseek(in.fd, data, SEEK_HOLE);
+        if (hole == -1)
+            return false;
+
+        // The kernel may copy less than asked, or share the blocks where the filesystem can
+        auto in_offset = data, out_offset = data;
+        for (const auto data_end = std::min(hole, end); in_offset < data_end;)
+        {
+            const auto copied = ::copy_file_range(in.fd,
+                                                  &in_offset,
+                                                  out.fd,
+                                                  &out_offset,
+                                                  data_end - in_offset,
+                                                  0);
+            // Whatever was copied already is simply copied again by whoever takes over
+            if (copied <= 0)
+                return false;
+        }
+
+        position = in_offset;
+    }
+
+    return true;
+}
+
+int mp::platform::open_resolution_root(const std::filesystem::path& dir)
+{
+    return ::open(dir.c_str(), O_PATH | O_DIRECTORY | O_CLOEXEC);
+}
+
+bool mp::platform::resolves_beneath(int root_fd,
+                                    const std::filesystem::path& path,
+                                    bool follow_symlink)
+{
+    // Kernels before 5.6 do not have openat2, and some sandboxes filter it out
+    static std::atomic_bool supported{true};
+    if (!supported.load(std::memory_order_relaxed))
+        return false;
+
+    open_how how{};
+    how.flags = O_PATH | O_CLOEXEC | (follow_symlink ? 0 : O_NOFOLLOW);
+    how.resolve = RESOLVE_BENEATH | RESOLVE_NO_MAGICLINKS;
+
+    const auto fd = syscall(SYS_openat2, root_fd, path.c_str(), &how, sizeof(how));
+    if (fd < 0)
+    {
+        if (errno == ENOSYS || errno == EPERM)
+            supported.store(false, std::memory_order_relaxed);
+
+        return false;
+    }
+
+    close(static_cast<int>(fd));
+    return true;
+}
+
+bool mp::platform::fsync(int fd)
+{
+    return ::fsync(fd) == 0;
+}
+
+bool mp::platform::sync_directory(const std::filesystem::path& dir)
+{
+    const auto fd = ::open(dir.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (fd < 0)
+        return false;
+
+    const auto synced = ::fsync(fd) == 0;
+    ::close(fd);
+    return synced;
+}
+
+std::int64_t mp::platform::pwrite(int fd, const void* buf, std::size_t nbytes, std::int64_t offset)
+{
+    return ::pwrite(fd, buf, nbytes, offset);
+}
+
 std::string multipass::platform::host_version()
 {
     return mpu::in_multipass_snap()
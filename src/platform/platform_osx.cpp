@@ -57,7 +57,10 @@
 #include <vector>
 
 #include <errno.h>
+#include <fcntl.h>
 #include <string.h>
+#include <sys/clonefile.h>
+#include <sys/resource.h>
 #include <sys/stat.h>
 #include <sys/types.h>
 #include <unistd.h>
@@ -331,7 +334,12 @@ mp::VirtualMachineFactory::UPtr mp::platform::vm_backend(const mp::Path& data_di
     else if (driver == QStringLiteral("qemu"))
     {
 #if QEMU_ENABLED
-        return std::make_unique<QemuVirtualMachineFactory>(data_dir, az_manager);
+        return std::make_unique<QemuVirtualMachineFactory>(
+            data_dir,
+            az_manager,
+            MP_SETTINGS.get(mp::suspend_mode_key) == QStringLiteral("file")
+                ? QemuVirtualMachine::SuspendMode::file
+                : QemuVirtualMachine::SuspendMode::snapshot);
 #endif
     }
     else if (driver == QStringLiteral("applevz"))
@@ -350,6 +358,11 @@ std::unique_ptr<mp::Process> mp::platform::make_sshfs_server_process(
     return MP_PROCFACTORY.create_process(std::make_unique<mp::SSHFSServerProcessSpec>(config));
 }
 
+void mp::platform::update_sshfs_server_confinement(const mp::SSHFSServerConfig& config)
+{
+    // sshfs_server is not confined on macOS
+}
+
 std::unique_ptr<mp::Process> mp::platform::make_process(
     std::unique_ptr<mp::ProcessSpec>&& process_spec)
 {
@@ -421,6 +434,61 @@ std::string mp::platform::reinterpret_interface_id(const std::string& ux_id)
     return ux_id;
 }
 
+bool mp::platform::set_thread_background_priority(bool background)
+{
+    // Background threads get throttled on CPU, disk and network alike
+    return setpriority(PRIO_DARWIN_THREAD, 0, background ? PRIO_DARWIN_BG : 0) == 0;
+}
+
+bool mp::platform::clone_file(const std::filesystem::path& source,
+                              const std::filesystem::path& destination)
+{
+    // APFS clones files whole, with their permissions, but refuses to replace existing ones
+    ::unlink(destination.c_str());
+    return clonefile(source.c_str(), destination.c_str(), 0) == 0;
+}
+
+bool mp::platform::copy_file_range(const std::filesystem::path&,
+                                   const std::filesystem::path&,
+                                   std::uint64_t,
+                                   std::uint64_t)
+{
+    return false;
+}
+
+int mp::platform::open_resolution_root(const std::filesystem::path&)
+{
+    // macOS cannot confine path resolution to a directory, so mounts always validate paths with
+    // the walk that resolves them one component at a time
+    return -1;
+}
+
+bool mp::platform::resolves_beneath(int, const std::filesystem::path&, bool)
+{
+    return false;
+}
+
+bool mp::platform::fsync(int fd)
+{
+    return ::fsync(fd) == 0;
+}
+
+bool mp::platform::sync_directory(const std::filesystem::path& dir)
+{
+    const auto fd = ::open(dir.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (fd < 0)
+        return false;
+
+    const auto synced = ::fsync(fd) == 0;
+    ::close(fd);
+    return synced;
+}
+
+std::int64_t mp::platform::pwrite(int fd, const void* buf, std::size_t nbytes, std::int64_t offset)
+{
+    return ::pwrite(fd, buf, nbytes, offset);
+}
+
 std::filesystem::path mp::platform::Platform::get_root_cert_dir() const
 {
     static const std::filesystem::path base_dir = "/usr/local/etc";
@@ -73,6 +73,8 @@
 #include <windows.h>
 #include <winternl.h>
 
+#include <io.h>
+
 #include <algorithm>
 #include <cerrno>
 #include <codecvt>
@@ -957,6 +959,11 @@ std::unique_ptr<mp::Process> mp::platform::make_sshfs_server_process(
     return MP_PROCFACTORY.create_process(std::make_unique<mp::SSHFSServerProcessSpec>(config));
 }
 
+void mp::platform::update_sshfs_server_confinement(const mp::SSHFSServerConfig& config)
+{
+    // sshfs_server is not confined on Windows
+}
+
 std::unique_ptr<mp::Process> mp::platform::make_process(
     std::unique_ptr<mp::ProcessSpec>&& process_spec)
 {
@@ -1347,6 +1354,66 @@ std::string mp::platform::reinterpret_interface_id(const std::string& ux_id)
     throw std::runtime_error{err};
 }
 
+bool mp::platform::set_thread_background_priority(bool background)
+{
+    // Background mode lowers I/O and memory priorities along with the CPU one, but it cannot be
+    // entered twice, so keep track of whether the thread is in it already
+    thread_local auto in_background = false;
+    if (background == in_background)
+        return true;
+
+    if (!SetThreadPriority(GetCurrentThread(),
+                           background ? THREAD_MODE_BACKGROUND_BEGIN : THREAD_MODE_BACKGROUND_END))
+        return false;
+
+    in_background = background;
+    return true;
+}
+
+bool mp::platform::clone_file(const std::filesystem::path&, const std::filesystem::path&)
+{
+    // Windows has no copy-on-write clones, so callers always fall back to a full copy
+    return false;
+}
+
+bool mp::platform::copy_file_range(const std::filesystem::path&,
+                                   const std::filesystem::path&,
+                                   std::uint64_t,
+                                   std::uint64_t)
+{
+    return false;
+}
+
+int mp::platform::open_resolution_root(const std::filesystem::path&)
+{
+    return -1;
+}
+
+bool mp::platform::resolves_beneath(int, const std::filesystem::path&, bool)
+{
+    return false;
+}
+
+bool mp::platform::fsync(int fd)
+{
+    return _commit(fd) == 0;
+}
+
+bool mp::platform::sync_directory(const std::filesystem::path&)
+{
+    // Directories cannot be opened for flushing here, but NTFS journals renames
+    return true;
+}
+
+std::int64_t mp::platform::pwrite(int fd, const void* buf, std::size_t nbytes, std::int64_t offset)
+{
+    // The CRT has no positional writes
+    if (_lseeki64(fd, offset, SEEK_SET) == -1)
+        return -1;
+
+    return _write(fd, buf, static_cast<unsigned int>(nbytes));
+}
+
 int mp::platform::Platform::get_cpus() const
 {
     SYSTEM_INFO sysinfo;
@@ -22,8 +22,16 @@
 #include <QSysInfo>
 
 #include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
 
 #include <boost/json.hpp>
+#include <boost/json/basic_parser_impl.hpp>
 
 #include <multipass/constants.h>
 #include <multipass/exceptions/manifest_exceptions.h>
@@ -52,19 +60,341 @@ const boost::json::object* if_contains_object(const boost::json::value& data, st
     return nullptr;
 }
 
-QString latest_version_in(const boost::json::object& versions)
+std::string_view string_or_empty(const boost::json::value& data, std::string_view key)
 {
-    QString max_version;
-    for (const auto& [key, _] : versions)
+    if (auto elem = data.as_object().if_contains(key))
     {
-        const auto version = QString::fromStdString(key);
-        if (version < max_version)
-            continue;
-        max_version = version;
+        if (auto str = elem->if_string())
+            return *str;
     }
+    return {};
+}
+
+std::string_view latest_version_in(const boost::json::object& versions)
+{
+    std::string_view max_version;
+    for (const auto& [key, _] : versions)
+        max_version = std::max(max_version, std::string_view{key});
+
     return max_version;
 }
 
+// The items of a version that can be launched, of which the products keep nothing else
+bool is_image_item(std::string_view key)
+{
+    return key == "uefi1.img" || key == "img.xz" || key == "disk1.img";
+}
+
+// Keeps the products of one architecture from a simplestreams document as it is parsed. Each
+// product is built on its own and dropped unless it is for that architecture, and only the image
+// items of its versions are kept, so that neither the whole document nor the products of other
+// architectures are ever held at once.
+class ProductsHandler
+{
+public:
+    static constexpr std::size_t max_object_size = std::size_t(-1);
+    static constexpr std::size_t max_array_size = std::size_t(-1);
+    static constexpr std::size_t max_key_size = std::size_t(-1);
+    static constexpr std::size_t max_string_size = std::size_t(-1);
+
+    explicit ProductsHandler(std::string arch) : arch{std::move(arch)}
+    {
+    }
+
+    bool on_document_begin(boost::json::error_code&)
+    {
+        return true;
+    }
+
+    bool on_document_end(boost::json::error_code&)
+    {
+        return true;
+    }
+
+    bool on_object_begin(boost::json::error_code&)
+    {
+        ++depth;
+        if (depth == 1)
+            top_level_object = true;
+        else if (depth == 2 && top_key == "products" && !in_products)
+            in_products = has_products = true;
+        else if (depth == 3 && in_products)
+            begin_product();
+        else
+            begin_container();
+
+        return true;
+    }
+
+    bool on_object_end(std::size_t, boost::json::error_code&)
+    {
+        if (capturing && !skipped_depth && depth == product_depth)
+            end_product();
+        else if (in_products && depth == 2)
+            in_products = false;
+        else
+            end_container(true);
+
+        --depth;
+        return true;
+    }
+
+    bool on_array_begin(boost::json::error_code&)
+    {
+        ++depth;
+        begin_container();
+        return true;
+    }
+
+    bool on_array_end(std::size_t, boost::json::error_code&)
+    {
+        end_container(false);
+        --depth;
+        return true;
+    }
+
+    bool on_key_part(boost::json::string_view s, std::size_t, boost::json::error_code&)
+    {
+        if (!skipped_depth)
+            key.append(s.data(), s.size());
+
+        return true;
+    }
+
+    bool on_key(boost::json::string_view s, std::size_t, boost::json::error_code&)
+    {
+        if (skipped_depth)
+            return true;
+
+        key.append(s.data(), s.size());
+        if (depth == 1)
+        {
+            top_key = key;
+        }
+        else if (depth == 2 && in_products)
+        {
+            product_key = key;
+            ++product_count;
+        }
+        else if (capturing)
+        {
+            // The path is that of the object holding the key, from the product down
+            skip_next = path.size() == 3 && path[0] == "versions" && path[2] == "items" &&
+                        !is_image_item(key);
+            if (!skip_next)
+                stack.push_key(key);
+
+            member_key = key;
+        }
+
+        key.clear();
+        return true;
+    }
+
+    bool on_string_part(boost::json::string_view s, std::size_t, boost::json::error_code&)
+    {
+        if (!in_string)
+            begin_string();
+
+        if (string_kept)
+            stack.push_chars(s);
+        else if (string_is_updated)
+            updated.append(s.data(), s.size());
+
+        return true;
+    }
+
+    bool on_string(boost::json::string_view s, std::size_t, boost::json::error_code&)
+    {
+        if (!in_string)
+            begin_string();
+
+        if (string_kept)
+            stack.push_string(s);
+        else if (string_is_updated)
+            updated.append(s.data(), s.size());
+
+        in_string = false;
+        return true;
+    }
+
+    bool on_number_part(boost::json::string_view, boost::json::error_code&)
+    {
+        return true;
+    }
+
+    bool on_int64(std::int64_t i, boost::json::string_view, boost::json::error_code&)
+    {
+        if (keep_value())
+            stack.push_int64(i);
+
+        return true;
+    }
+
+    bool on_uint64(std::uint64_t u, boost::json::string_view, boost::json::error_code&)
+    {
+        if (keep_value())
+            stack.push_uint64(u);
+
+        return true;
+    }
+
+    bool on_double(double d, boost::json::string_view, boost::json::error_code&)
+    {
+        if (keep_value())
+            stack.push_double(d);
+
+        return true;
+    }
+
+    bool on_bool(bool b, boost::json::error_code&)
+    {
+        if (keep_value())
+            stack.push_bool(b);
+
+        return true;
+    }
+
+    bool on_null(boost::json::error_code&)
+    {
+        if (keep_value())
+            stack.push_null();
+
+        return true;
+    }
+
+    bool on_comment_part(boost::json::string_view, boost::json::error_code&)
+    {
+        return true;
+    }
+
+    bool on_comment(boost::json::string_view, boost::json::error_code&)
+    {
+        return true;
+    }
+
+    bool top_level_object{false};
+    bool has_products{false};
+    std::size_t product_count{0}; // of every architecture
+    std::string updated;
+    boost::json::object products; // of the architecture, by key
+
+private:
+    static constexpr int product_depth = 3;
+
+    // Whether the value starting now goes into the product being built, counting it if it does
+    bool keep_value()
+    {
+        if (!capturing || skipped_depth || std::exchange(skip_next, false))
+            return false;
+
+        ++sizes.back();
+        return true;
+    }
+
+    void begin_container()
+    {
+        const auto skipped = capturing && !skipped_depth && skip_next;
+        if (keep_value())
+        {
+            sizes.push_back(0);
+            path.push_back(std::exchange(member_key, {}));
+        }
+        else if (skipped)
+        {
+            skipped_depth = depth;
+        }
+    }
+
+    void end_container(bool object)
+    {
+        if (skipped_depth)
+        {
+            if (depth == *skipped_depth)
+                skipped_depth.reset();
+        }
+        else if (capturing)
+        {
+            if (object)
+                stack.push_object(sizes.back());
+            else
+                stack.push_array(sizes.back());
+
+            sizes.pop_back();
+            path.pop_back();
+        }
+    }
+
+    void begin_string()
+    {
+        in_string = true;
+        string_kept = keep_value();
+        string_is_updated = depth == 1 && top_key == "updated";
+    }
+
+    void begin_product()
+    {
+        capturing = true;
+        stack.reset();
+        sizes.assign(1, 0);
+        path.clear();
+    }
+
+    void end_product()
+    {
+        stack.push_object(sizes.back());
+        auto product = stack.release();
+        capturing = false;
+
+        if (string_or_empty(product, "arch") == arch)
+            products.insert_or_assign(product_key, std::move(product));
+    }
+
+    const std::string arch;
+    int depth{0}; // of open objects and arrays
+    std::string key, top_key, product_key;
+    bool in_products{false};
+    bool in_string{false}, string_kept{false}, string_is_updated{false};
+
+    // The product being built, with the number of values in each of its open objects and arrays and
+    // the keys they are under
+    bool capturing{false};
+    boost::json::value_stack stack;
+    std::vector<std::size_t> sizes;
+    std::vector<std::string> path;
+    std::string member_key;
+    // Whether the value of the key just read is left out, and the depth of the object or array
+    // being left out
+    bool skip_next{false};
+    std::optional<int> skipped_depth;
+};
+
+struct Products
+{
+    QString updated;
+    boost::json::object products;
+};
+
+Products parse_products(const QByteArray& json, const std::string& arch)
+{
+    boost::json::basic_parser<ProductsHandler> parser{boost::json::parse_options{}, arch};
+    boost::json::error_code ec;
+    const auto size = static_cast<std::size_t>(json.size());
+    const auto consumed = parser.write_some(false, json.constData(), size, ec);
+    if (!ec && consumed < size)
+        ec = boost::json::error::extra_data;
+    if (ec)
+        throw boost::system::system_error{ec};
+
+    auto& handler = parser.handler();
+    if (!handler.top_level_object)
+        throw mp::GenericManifestException("The manifest is not a JSON object");
+    if (!handler.has_products || handler.product_count == 0)
+        throw mp::GenericManifestException("No products found");
+
+    return {QString::fromStdString(handler.updated), std::move(handler.products)};
+}
+
 } // namespace
 
 mp::SimpleStreamsManifest::SimpleStreamsManifest(const QString& updated_at,
@@ -82,32 +412,22 @@ std::unique_ptr<mp::SimpleStreamsManifest> mp::SimpleStreamsManifest::fromJson(
     std::function<bool(VMImageInfo&)> mutator)
 try
 {
-    // Get the official manifest products
-    const auto manifest_from_official = boost::json::parse(std::string_view(json_from_official));
-    const auto updated = lookup_or<QString>(manifest_from_official, "updated", "");
-    const auto& manifest_products_from_official = manifest_from_official.at("products").as_object();
-    if (manifest_products_from_official.empty())
-        throw mp::GenericManifestException("No products found");
+    const auto arch = QSysInfo::currentCpuArchitecture();
+    const auto mapped_arch = arch_to_manifest.value(arch, arch).toStdString();
+    const auto host = host_url.toStdString();
 
-    auto arch = QSysInfo::currentCpuArchitecture();
-    auto mapped_arch = arch_to_manifest.value(arch, arch);
-
-    // Get the mirror manifest products, if any
-    std::optional<boost::json::object> manifest_products_from_mirror = std::nullopt;
+    // Only the products of this architecture are kept from either manifest
+    const auto official = parse_products(json_from_official, mapped_arch);
+    std::optional<Products> mirror = std::nullopt;
     if (json_from_mirror)
-    {
-        const auto manifest_from_mirror = boost::json::parse(std::string_view(*json_from_mirror));
-        manifest_products_from_mirror = manifest_from_mirror.at("products").as_object();
-    }
-    const auto& manifest_products =
-        manifest_products_from_mirror.value_or(manifest_products_from_official);
+        mirror = parse_products(*json_from_mirror, mapped_arch);
+
+    const auto& manifest_products_from_official = official.products;
+    const auto& manifest_products = mirror ? mirror->products : manifest_products_from_official;
 
     std::vector<VMImageInfo> products;
     for (const auto& [product_key, product] : manifest_products)
     {
-        if (lookup_or<QString>(product, "arch", "") != mapped_arch)
-            continue;
-
         const auto* official_product = manifest_products_from_official.if_contains(product_key);
         if (!official_product)
             continue;
@@ -136,8 +456,9 @@ try
         const auto latest_version = latest_version_in(*versions);
         for (const auto& [version_string, version] : *versions)
         {
+            // Without a mirror, the version is the official one, with nothing to compare
             const auto* official_version = official_versions->if_contains(version_string);
-            if (!official_version || version != *official_version)
+            if (!official_version || (official_version != &version && version != *official_version))
                 continue;
 
             const auto* items = if_contains_object(version, "items");
@@ -159,15 +480,14 @@ try
                 continue;
 
             const auto& image = items->at(image_key);
-            std::string image_location =
-                host_url.toStdString() + value_to<std::string>(image.at("path"));
+            std::string image_location = host + value_to<std::string>(image.at("path"));
             std::string sha256 = lookup_or<std::string>(image, "sha256", "");
             int size = lookup_or<int>(image, "size", -1);
 
-            const auto version_qstring = QString::fromStdString(version_string);
             // Aliases always alias to the latest version
-            const auto& aliases = version_qstring == latest_version ? product_aliases
-                                                                    : std::vector<std::string>{};
+            const auto& aliases = std::string_view{version_string} == latest_version
+                                      ? product_aliases
+                                      : std::vector<std::string>{};
 
             VMImageInfo info{aliases,
                              "Ubuntu",
@@ -177,7 +497,7 @@ try
                              supported,
                              image_location,
                              sha256,
-                             host_url.toStdString(),
+                             host,
                              version_string,
                              size,
                              true};
@@ -191,7 +511,7 @@ try
     if (products.empty())
         throw mp::EmptyManifestException("No supported products found.");
 
-    return std::make_unique<SimpleStreamsManifest>(updated, std::move(products));
+    return std::make_unique<SimpleStreamsManifest>(official.updated, std::move(products));
 }
 catch (const boost::system::system_error& e)
 {
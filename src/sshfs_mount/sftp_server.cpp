@@ -28,12 +28,15 @@
 
 extern "C"
 {
-int sftp_reply_version(sftp_client_message msg);
+int sftp_packet_write(sftp_session sftp, uint8_t type, ssh_buffer payload);
 }
 
 #include <QDir>
 #include <QFile>
 
+#include <array>
+#include <string_view>
+
 #include <fcntl.h>
 
 namespace mp = multipass;
@@ -43,9 +46,125 @@ namespace fs = std::filesystem;
 namespace
 {
 constexpr auto category = "sftp server";
+constexpr auto bytes_metric = "multipass_sftp_bytes_total";
+constexpr auto bytes_help = "File data transferred by SFTP servers";
 using SftpHandleUPtr = std::unique_ptr<ssh_string_struct, void (*)(ssh_string)>;
 using namespace std::literals::chrono_literals;
 
+constexpr auto resolved_path_ttl = 1s;
+constexpr std::size_t max_resolved_paths = 4096;
+
+// libssh refuses packets over 256KiB, and requests need some room for their header besides data
+constexpr std::uint64_t max_packet_length = 256 * 1024;
+constexpr std::uint64_t max_data_length = max_packet_length - 1024;
+constexpr std::uint64_t copy_chunk_size = 1024 * 1024;
+constexpr std::size_t max_pending_write = 1024 * 1024;
+
+// Advertised to clients with their versions, so that they know to use them
+constexpr std::array<std::pair<std::string_view, std::string_view>, 6> extensions{
+    {{"posix-rename@openssh.com", "1"},
+     {"hardlink@openssh.com", "1"},
+     {"statvfs@openssh.com", "2"},
+     {"fsync@openssh.com", "1"},
+     {"limits@openssh.com", "1"},
+     {"copy-data", "1"}}};
+
+// SFTP packs numbers big-endian and strings after their length
+void pack(std::string& out, std::uint64_t value, int size = 8)
+{
+    for (auto shift = (size - 1) * 8; shift >= 0; shift -= 8)
+        out += static_cast<char>((value >> shift) & 0xff);
+}
+
+void pack(std::string& out, std::string_view value)
+{
+    pack(out, value.size(), 4);
+    out += value;
+}
+
+// Reads what libssh leaves unparsed in extended requests: whatever follows the request id and the
+// name of the extension
+class ExtendedArguments
+{
+public:
+    explicit ExtendedArguments(sftp_client_message msg)
+    {
+        if (msg->complete_message != nullptr)
+        {
+            next = static_cast<const unsigned char*>(ssh_buffer_get_data(msg->complete_message));
+            left = ssh_buffer_get_len(msg->complete_message);
+        }
+
+        std::uint64_t id;
+        std::string name;
+        read(id, 4);
+        read(name);
+    }
+
+    bool read(std::uint64_t& value, int size = 8)
+    {
+        if (left < static_cast<std::size_t>(size))
+            return false;
+
+        value = 0;
+        for (int i = 0; i < size; ++i, --left)
+            value = (value << 8) | *next++;
+
+        return true;
+    }
+
+    bool read(std::string& value)
+    {
+        std::uint64_t size;
+        if (!read(size, 4) || left < size)
+            return false;
+
+        value.assign(reinterpret_cast<const char*>(next), size);
+        next += size;
+        left -= size;
+        return true;
+    }
+
+private:
+    const unsigned char* next{nullptr};
+    std::size_t left{0};
+};
+
+int send_packet(sftp_session sftp, std::uint8_t type, const std::string& payload)
+{
+    const std::unique_ptr<ssh_buffer_struct, decltype(ssh_buffer_free)*> buffer{ssh_buffer_new(),
+                                                                                ssh_buffer_free};
+    if (buffer == nullptr ||
+        ssh_buffer_add_data(buffer.get(), payload.data(), payload.size()) != SSH_OK ||
+        sftp_packet_write(sftp, type, buffer.get()) < 0)
+        return SSH_ERROR;
+
+    return SSH_OK;
+}
+
+// libssh's own sftp_reply_version only advertises the extensions libssh knows about
+int reply_version(sftp_session sftp)
+{
+    std::string payload;
+    pack(payload, LIBSFTP_VERSION, 4);
+    for (const auto& [name, version] : extensions)
+    {
+        pack(payload, name);
+        pack(payload, version);
+    }
+
+    return send_packet(sftp, SSH_FXP_VERSION, payload);
+}
+
+int reply_extended(sftp_client_message msg, const std::string& data)
+{
+    std::string payload;
+    pack(payload, msg->id, 4);
+    payload += data;
+
+    return send_packet(msg->sftp, SSH_FXP_EXTENDED_REPLY, payload);
+}
+
 enum Permissions
 {
     read_user = 0400,
@@ -83,7 +202,7 @@ auto make_sftp_session(ssh_session session, ssh_channel channel)
 
     // Optional: Log the SSH_FXP_INIT reception like libssh does with SSH_LOG but with mp::log
 
-    if (sftp_reply_version(msg) != SSH_OK)
+    if (reply_version(sftp_server_session.get()) != SSH_OK)
     {
         throw mp::SSHException(
             "[sftp] server init failed: 'FATAL: Failed to process the SSH_FXP_INIT message'");
@@ -297,9 +416,56 @@ constexpr bool follows_symlinks(uint8_t type)
         return false; // Fail-safe default
     }
 }
+
+std::string_view op_name(uint8_t type)
+{
+    switch (type)
+    {
+    case SFTP_REALPATH:
+        return "realpath";
+    case SFTP_OPENDIR:
+        return "opendir";
+    case SFTP_MKDIR:
+        return "mkdir";
+    case SFTP_RMDIR:
+        return "rmdir";
+    case SFTP_LSTAT:
+        return "lstat";
+    case SFTP_STAT:
+        return "stat";
+    case SFTP_FSTAT:
+        return "fstat";
+    case SFTP_READDIR:
+        return "readdir";
+    case SFTP_CLOSE:
+        return "close";
+    case SFTP_OPEN:
+        return "open";
+    case SFTP_READ:
+        return "read";
+    case SFTP_WRITE:
+        return "write";
+    case SFTP_RENAME:
+        return "rename";
+    case SFTP_REMOVE:
+        return "remove";
+    case SFTP_SETSTAT:
+        return "setstat";
+    case SFTP_FSETSTAT:
+        return "fsetstat";
+    case SFTP_READLINK:
+        return "readlink";
+    case SFTP_SYMLINK:
+        return "symlink";
+    case SFTP_EXTENDED:
+        return "extended";
+    default:
+        return "other";
+    }
+}
 } // namespace
 
-mp::SftpServer::SftpServer(std::unique_ptr<SSHSession>&& session,
+mp::SftpServer::SftpServer(std::shared_ptr<SSHSession> session,
                            const std::string& source,
                            const std::string& target,
                            const id_mappings& gid_mappings,
@@ -314,17 +480,22 @@ mp::SftpServer::SftpServer(std::unique_ptr<SSHSession>&& session,
                                                 ->release_channel())}, // TODO@rewiressh no cast
       source_path{MP_FILEOPS.weakly_canonical(source)},
       target_path{fs::path(target).lexically_normal()},
+      source_root{std::make_unique<NamedFd>(source_path,
+                                            mp::platform::open_resolution_root(source_path))},
       gid_mappings{gid_mappings},
       uid_mappings{uid_mappings},
       default_uid{default_uid},
       default_gid{default_gid},
-      sshfs_exec_line{sshfs_exec_line}
+      sshfs_exec_line{sshfs_exec_line},
+      bytes_read{MP_METRICS.counter(bytes_metric, bytes_help, {{"direction", "read"}})},
+      bytes_written{MP_METRICS.counter(bytes_metric, bytes_help, {{"direction", "written"}})}
 {
 }
 
 mp::SftpServer::~SftpServer()
 {
     stop_invoked = true;
+    flush_pending_write();
 }
 
 sftp_attributes_struct mp::SftpServer::attr_from(const QFileInfo& file_info)
@@ -411,36 +582,26 @@ bool mp::SftpServer::validate_path(const fs::path& current_path, bool follows_sy
     if (source_path.empty() || current_path.empty())
         return false;
 
+    if (resolves_beneath_source(current_path, follows_symlink))
+        return true;
+
     fs::path final_path;
     try
     {
-
-        // weakly_canonical allows paths that do not exist. This means that broken links will be
-        // treated as literal folders/files, so they need to be filtered out.
-        fs::path check_path = follows_symlink ? current_path : current_path.parent_path();
-        if (check_path.empty())
-        {
-            check_path = ".";
-        }
-        while (check_path != check_path.parent_path() && !MP_FILEOPS.exists(check_path))
+        if (follows_symlink)
         {
-            if (MP_FILEOPS.is_symlink(check_path))
-            {
-                // A broken symlink was detected! It could point anywhere on the host.
+            if (auto resolved = resolve(current_path))
+                final_path = *resolved;
+            else
                 return false;
-            }
-            check_path = check_path.parent_path();
         }
-        // If no broken symlinks, canonicalize the path.
-        if (follows_symlink)
-            final_path = MP_FILEOPS.weakly_canonical(current_path);
-        else
+        else if (auto resolved_parent = resolve(current_path.parent_path()))
         {
             // The target path is a symlink, we examine the parent path
-            auto resolved_parent = MP_FILEOPS.weakly_canonical(current_path.parent_path());
-            // If no broken symlinks, canonicalize the path.
-            final_path = (resolved_parent / current_path.filename()).lexically_normal();
+            final_path = (*resolved_parent / current_path.filename()).lexically_normal();
         }
+        else
+            return false;
     }
     catch (const fs::filesystem_error& e)
     {
@@ -453,6 +614,69 @@ bool mp::SftpServer::validate_path(const fs::path& current_path, bool follows_sy
     return source_it == source_path.end();
 }
 
+// The fast path of validate_path: one openat2 call, or two for paths that do not exist yet, instead
+// of a syscall per path component. It cannot vouch for absolute symlinks, even ones pointing inside
+// the source, so those are left to the walk in resolve().
+bool mp::SftpServer::resolves_beneath_source(const fs::path& current_path,
+                                             bool follows_symlink) const
+{
+    if (source_root->fd == -1)
+        return false;
+
+    auto [source_it, current_it] = std::mismatch(source_path.begin(),
+                                                 source_path.end(),
+                                                 current_path.begin(),
+                                                 current_path.end());
+    if (source_it != source_path.end())
+        return false;
+
+    fs::path relative_path{"."};
+    for (; current_it != current_path.end(); ++current_it)
+        relative_path /= *current_it;
+
+    if (MP_FILEOPS.resolves_beneath(source_root->fd, relative_path, follows_symlink))
+        return true;
+
+    // Something new is being created. A broken symlink is not not_found, so it is left to the walk
+    std::error_code err;
+    return MP_FILEOPS.resolves_beneath(source_root->fd, relative_path.parent_path(), true) &&
+           MP_FILEOPS.symlink_status(current_path, err).type() == fs::file_type::not_found;
+}
+
+// Resolves symlinks in a path that may not exist, unless it goes through a broken symlink
+std::optional<fs::path> mp::SftpServer::resolve(const fs::path& path) const
+{
+    const auto now = std::chrono::steady_clock::now();
+    if (auto it = resolved_paths.find(path.string());
+        it != resolved_paths.end() && now - it->second.when < resolved_path_ttl)
+        return it->second.path;
+
+    // weakly_canonical allows paths that do not exist. This means that broken links will be
+    // treated as literal folders/files, so they need to be filtered out.
+    fs::path check_path = path;
+    if (check_path.empty())
+    {
+        check_path = ".";
+    }
+    while (check_path != check_path.parent_path() && !MP_FILEOPS.exists(check_path))
+    {
+        if (MP_FILEOPS.is_symlink(check_path))
+        {
+            // A broken symlink was detected! It could point anywhere on the host.
+            return std::nullopt;
+        }
+        check_path = check_path.parent_path();
+    }
+
+    // If no broken symlinks, canonicalize the path.
+    auto resolved = MP_FILEOPS.weakly_canonical(path);
+    if (resolved_paths.size() >= max_resolved_paths)
+        resolved_paths.clear();
+    resolved_paths.insert_or_assign(path.string(), ResolvedPath{resolved, now});
+
+    return resolved;
+}
+
 fs::path mp::SftpServer::get_absolute_path(const char* path) const
 {
     fs::path raw = path != nullptr ? fs::path(path) : fs::path();
@@ -496,10 +720,26 @@ std::string mp::SftpServer::host_to_guest_path(const fs::path& host_path) const
     return (target_path / relative).lexically_normal().generic_string();
 }
 
-void mp::SftpServer::process_message(sftp_client_message msg)
+void mp::SftpServer::process_message(ClientMessageUptr client_msg)
 {
     int ret = 0;
+    const auto msg = client_msg.get();
     const auto type = sftp_client_message_get_type(msg);
+
+    auto& op_duration = op_durations[type];
+    if (!op_duration)
+        op_duration = &MP_METRICS.histogram("multipass_sftp_op_duration_seconds",
+                                            "Time taken by SFTP servers to handle each request",
+                                            {{"op", std::string{op_name(type)}}});
+    const mp::metrics::ScopedTimer timer{*op_duration};
+
+    // Writes are only held back while more of them follow, nothing else may see the file without
+    if (type != SFTP_WRITE)
+        ret = flush_pending_write();
+
+    if (ret != 0)
+        mpl::error(category, "error occurred when replying to client: {}", ret);
+
     switch (type)
     {
     case SFTP_REALPATH:
@@ -534,7 +774,7 @@ void mp::SftpServer::process_message(sftp_client_message msg)
         ret = handle_read(msg);
         break;
     case SFTP_WRITE:
-        ret = handle_write(msg);
+        ret = handle_write(std::move(client_msg));
         break;
     case SFTP_RENAME:
         ret = handle_rename(msg);
@@ -559,73 +799,92 @@ void mp::SftpServer::process_message(sftp_client_message msg)
         mpl::trace(category, "Unknown message: {}", static_cast<int>(type));
         ret = reply_unsupported(msg);
     }
+
+    switch (type)
+    {
+    case SFTP_MKDIR:
+    case SFTP_RMDIR:
+    case SFTP_RENAME:
+    case SFTP_REMOVE:
+    case SFTP_SYMLINK:
+    case SFTP_EXTENDED:
+        resolved_paths.clear();
+        break;
+    default:
+        break;
+    }
+
     if (ret != 0)
         mpl::error(category, "error occurred when replying to client: {}", ret);
 }
 
 void mp::SftpServer::run()
 {
-    using MsgUPtr =
-        std::unique_ptr<sftp_client_message_struct, decltype(sftp_client_message_free)*>;
+    while (serve_next())
+        ;
+}
 
-    while (true)
+bool mp::SftpServer::serve_next()
+{
+    ClientMessageUptr client_msg{sftp_get_client_message(sftp_server_session.get()),
+                                 sftp_client_message_free};
+    if (client_msg == nullptr)
     {
-        MsgUPtr client_msg{sftp_get_client_message(sftp_server_session.get()),
-                           sftp_client_message_free};
-        auto msg = client_msg.get();
-        if (msg == nullptr)
+        if (const auto ret = flush_pending_write(); ret != 0)
+            mpl::error(category, "error occurred when replying to client: {}", ret);
+
+        if (stop_invoked)
+            return false;
+
+        int status{0};
+        try
+        {
+            status = sshfs_process->exit_code(250ms);
+        }
+        catch (const mp::ExitlessSSHProcessException&) // should we limit this to
+                                                       // SSHProcessExitError?
         {
-            if (stop_invoked)
-                break;
+            status = 1;
+        }
 
-            int status{0};
-            try
-            {
-                status = sshfs_process->exit_code(250ms);
-            }
-            catch (const mp::ExitlessSSHProcessException&) // should we limit this to
-                                                           // SSHProcessExitError?
-            {
-                status = 1;
-            }
+        if (status == 0)
+            return false;
 
-            if (status != 0)
-            {
-                mpl::error(category,
-                           "sshfs in the instance appears to have exited unexpectedly.  Trying to "
-                           "recover.");
-
-                std::string mount_path = [this] {
-                    auto proc = ssh_session->exec(
-                        fmt::format("findmnt --source :{}  -o TARGET -n", source_path));
-                    return proc->read_std_output();
-                }();
-
-                if (!mount_path.empty())
-                {
-                    // TODO@sftp nodiscard
-                    (void)ssh_session->exec(fmt::format("sudo umount {}", mount_path));
-                }
-
-                sshfs_process = create_sshfs_process(*ssh_session,
-                                                     sshfs_exec_line,
-                                                     source_path.string(),
-                                                     target_path.generic_string());
-                sftp_server_session =
-                    make_sftp_session(*ssh_session,
-                                      static_cast<PlainSSHProcess*>(sshfs_process.get())
-                                          ->release_channel()); // TODO@rewiressh no cast
-
-                continue;
-            }
-            else
-            {
-                break;
-            }
+        mpl::error(category,
+                   "sshfs in the instance appears to have exited unexpectedly.  Trying to "
+                   "recover.");
+
+        std::string mount_path = [this] {
+            auto proc =
+                ssh_session->exec(fmt::format("findmnt --source :{}  -o TARGET -n", source_path));
+            return proc->read_std_output();
+        }();
+
+        if (!mount_path.empty())
+        {
+            // TODO@sftp nodiscard
+            (void)ssh_session->exec(fmt::format("sudo umount {}", mount_path));
         }
 
-        process_message(msg);
+        sshfs_process = create_sshfs_process(*ssh_session,
+                                             sshfs_exec_line,
+                                             source_path.string(),
+                                             target_path.generic_string());
+        sftp_server_session =
+            make_sftp_session(*ssh_session,
+                              static_cast<PlainSSHProcess*>(sshfs_process.get())
+                                  ->release_channel()); // TODO@rewiressh no cast
+
+        return true;
     }
+
+    process_message(std::move(client_msg));
+    return true;
+}
+
+ssh_channel mp::SftpServer::channel() const
+{
+    return sftp_server_session->channel;
 }
 
 void mp::SftpServer::stop()
@@ -919,12 +1178,15 @@ int mp::SftpServer::handle_read(sftp_client_message msg)
         return reply_failure(msg);
     }
 
-    constexpr auto max_packet_size = 65536u;
-    std::array<char, max_packet_size> buffer{};
+    const auto length = std::min<std::size_t>(msg->len, max_data_length);
+    if (read_buffer.size() < length)
+        read_buffer.resize(length);
 
-    if (const auto r = MP_FILEOPS.read(file, buffer.data(), std::min(msg->len, max_packet_size));
-        r > 0)
-        return sftp_reply_data(msg, buffer.data(), r);
+    if (const auto r = MP_FILEOPS.read(file, read_buffer.data(), length); r > 0)
+    {
+        bytes_read.increment(r);
+        return sftp_reply_data(msg, read_buffer.data(), r);
+    }
     else if (r == 0)
         return sftp_reply_status(msg, SSH_FX_EOF, "End of file");
 
@@ -1324,8 +1586,9 @@ int mp::SftpServer::handle_symlink(sftp_client_message msg)
     return reply_ok(msg);
 }
 
-int mp::SftpServer::handle_write(sftp_client_message msg)
+int mp::SftpServer::handle_write(ClientMessageUptr client_msg)
 {
+    const auto msg = client_msg.get();
     const auto handle = get_handle<NamedFd>(msg);
     if (handle == nullptr)
     {
@@ -1333,39 +1596,71 @@ int mp::SftpServer::handle_write(sftp_client_message msg)
         return reply_bad_handle(msg, "write");
     }
 
-    const auto& [path, file] = *handle;
+    int ret = 0;
+    if (pending_write.handle != handle ||
+        pending_write.offset + pending_write.data.size() != msg->offset)
+        ret = flush_pending_write();
 
-    if (MP_FILEOPS.lseek(file, msg->offset, SEEK_SET) == -1)
+    if (pending_write.requests.empty())
     {
-        mpl::trace(category,
-                   "{}: cannot seek to position {} in '{}'",
-                   __FUNCTION__,
-                   msg->offset,
-                   path.string());
-        return reply_failure(msg);
+        pending_write.handle = handle;
+        pending_write.offset = msg->offset;
     }
+    pending_write.data.append(ssh_string_get_char(msg->data), ssh_string_len(msg->data));
+    pending_write.requests.push_back(std::move(client_msg));
+
+    // While more requests are waiting, the next writes may join this one, so it is replied to with
+    // them, once they are all written
+    if (pending_write.data.size() < max_pending_write && ssh_channel_poll(channel(), 0) > 0)
+        return ret;
+
+    const auto flush_ret = flush_pending_write();
+    return ret != 0 ? ret : flush_ret;
+}
+
+int mp::SftpServer::flush_pending_write()
+{
+    if (pending_write.requests.empty())
+        return 0;
 
-    auto len = ssh_string_len(msg->data);
-    auto data_ptr = ssh_string_get_char(msg->data);
+    const auto& [path, file] = *pending_write.handle;
 
-    do
+    int error = 0;
+    std::string_view data{pending_write.data};
+    for (auto offset = pending_write.offset; !data.empty();)
     {
-        const auto r = MP_FILEOPS.write(file, data_ptr, len);
+        const auto r = MP_FILEOPS.pwrite(file, data.data(), data.size(), offset);
         if (r == -1)
         {
+            error = errno;
             mpl::trace(category,
                        "{}: write failed for '{}': {}",
                        __FUNCTION__,
                        path.string(),
-                       std::strerror(errno));
-            return reply_failure(msg);
+                       std::strerror(error));
+            break;
         }
 
-        data_ptr += r;
-        len -= r;
-    } while (len > 0);
+        data.remove_prefix(r);
+        offset += r;
+        bytes_written.increment(r);
+    }
 
-    return reply_ok(msg);
+    int ret = 0;
+    for (const auto& request : pending_write.requests)
+    {
+        const auto reply_ret = error ? sftp_reply_status(request.get(),
+                                                         SSH_FX_FAILURE,
+                                                         std::strerror(error))
+                                     : reply_ok(request.get());
+        if (ret == 0)
+            ret = reply_ret;
+    }
+
+    pending_write.handle = nullptr;
+    pending_write.data.clear();
+    pending_write.requests.clear();
+    return ret;
 }
 
 int mp::SftpServer::handle_extended(sftp_client_message msg)
@@ -1419,6 +1714,22 @@ int mp::SftpServer::handle_extended(sftp_client_message msg)
     {
         return handle_rename(msg);
     }
+    else if (method == "statvfs@openssh.com")
+    {
+        return handle_statvfs(msg);
+    }
+    else if (method == "fsync@openssh.com")
+    {
+        return handle_fsync(msg);
+    }
+    else if (method == "limits@openssh.com")
+    {
+        return handle_limits(msg);
+    }
+    else if (method == "copy-data")
+    {
+        return handle_copy_data(msg);
+    }
     else
     {
         mpl::trace(category, "Unhandled extended method requested: {}", method);
@@ -1428,8 +1739,220 @@ int mp::SftpServer::handle_extended(sftp_client_message msg)
     return reply_ok(msg);
 }
 
+int mp::SftpServer::handle_statvfs(sftp_client_message msg)
+{
+    ExtendedArguments arguments{msg};
+    std::string name;
+    if (!arguments.read(name))
+        return reply_failure(msg);
+
+    const auto path = get_absolute_path(name.c_str());
+    if (!validate_path(path, true))
+    {
+        mpl::trace(category,
+                   "{}: cannot validate path '{}' against source '{}'",
+                   __FUNCTION__,
+                   path,
+                   source_path);
+        return reply_perm_denied(msg);
+    }
+
+    std::error_code err;
+    const auto space = fs::space(path, err);
+    if (err)
+    {
+        mpl::trace(category,
+                   "{}: cannot get space of '{}': {}",
+                   __FUNCTION__,
+                   path,
+                   err.message());
+        return sftp_reply_status(msg, SSH_FX_FAILURE, err.message().c_str());
+    }
+
+    // Only sizes are known on every host, so they are given in blocks of a nominal size, and the
+    // file counts, filesystem id and mount flags are left out
+    constexpr std::uint64_t block_size = 4096;
+    constexpr std::uint64_t max_name_length = 255;
+
+    const std::array<std::uint64_t, 11> fields{block_size,
+                                               block_size,
+                                               space.capacity / block_size,
+                                               space.free / block_size,
+                                               space.available / block_size,
+                                               0,
+                                               0,
+                                               0,
+                                               0,
+                                               0,
+                                               max_name_length};
+
+    std::string reply;
+    for (const auto field : fields)
+        pack(reply, field);
+
+    return reply_extended(msg, reply);
+}
+
+int mp::SftpServer::handle_fsync(sftp_client_message msg)
+{
+    ExtendedArguments arguments{msg};
+    std::string handle_id;
+    const auto handle = arguments.read(handle_id) ? get_handle<NamedFd>(handle_id) : nullptr;
+    if (handle == nullptr)
+    {
+        mpl::trace(category, "{}: bad handle requested", __FUNCTION__);
+        return reply_bad_handle(msg, "fsync");
+    }
+
+    const auto& [path, file] = *handle;
+
+    if (!MP_FILEOPS.fsync(file))
+    {
+        mpl::trace(category,
+                   "{}: fsync failed for '{}': {}",
+                   __FUNCTION__,
+                   path.string(),
+                   std::strerror(errno));
+        return sftp_reply_status(msg, SSH_FX_FAILURE, std::strerror(errno));
+    }
+
+    return reply_ok(msg);
+}
+
+int mp::SftpServer::handle_limits(sftp_client_message msg)
+{
+    std::string reply;
+    pack(reply, max_packet_length);
+    pack(reply, max_data_length);  // reads
+    pack(reply, max_data_length);  // writes
+    pack(reply, std::uint64_t{0}); // open handles, of which there can be any number
+
+    return reply_extended(msg, reply);
+}
+
+// Copies data between two open files without it going through the guest, in the kernel where the
+// platform can
+int mp::SftpServer::handle_copy_data(sftp_client_message msg)
+{
+    ExtendedArguments arguments{msg};
+    std::string read_handle_id, write_handle_id;
+    std::uint64_t read_offset, length, write_offset;
+    if (!arguments.read(read_handle_id) || !arguments.read(read_offset) ||
+        !arguments.read(length) || !arguments.read(write_handle_id) ||
+        !arguments.read(write_offset))
+        return reply_failure(msg);
+
+    const auto source = get_handle<NamedFd>(read_handle_id);
+    const auto destination = get_handle<NamedFd>(write_handle_id);
+    if (source == nullptr || destination == nullptr)
+    {
+        mpl::trace(category, "{}: bad handle requested", __FUNCTION__);
+        return reply_bad_handle(msg, "copy-data");
+    }
+
+    if (source == destination)
+    {
+        mpl::trace(category, "{}: cannot copy data within the same handle", __FUNCTION__);
+        return reply_failure(msg);
+    }
+
+    const auto& [from_path, from] = *source;
+    const auto& [to_path, to] = *destination;
+
+    // Handles come open in whatever mode the client asked for, which empty reads and writes check
+    if (MP_FILEOPS.read(from, nullptr, 0) == -1 || MP_FILEOPS.write(to, nullptr, 0) == -1)
+    {
+        mpl::trace(category,
+                   "{}: cannot copy from '{}' to '{}': {}",
+                   __FUNCTION__,
+                   from_path.string(),
+                   to_path.string(),
+                   std::strerror(errno));
+        return reply_perm_denied(msg);
+    }
+
+    const auto source_size = MP_FILEOPS.lseek(from, 0, SEEK_END);
+    const auto destination_size = MP_FILEOPS.lseek(to, 0, SEEK_END);
+    if (source_size == -1 || destination_size == -1)
+        return reply_failure(msg);
+
+    // A length of 0 means up to the end of the source, which no copy goes past anyway
+    const auto available =
+        read_offset < static_cast<std::uint64_t>(source_size) ? source_size - read_offset : 0;
+    length = length == 0 ? available : std::min(length, available);
+
+    // The kernel copy leaves holes in the source alone, so it can only write where there is nothing
+    // to overwrite yet, past the end of the destination. It also goes by path rather than handle,
+    // so the paths are checked again, in case they were replaced by symlinks since
+    if (length > 0 && read_offset == write_offset &&
+        static_cast<std::uint64_t>(destination_size) <= write_offset &&
+        validate_path(from_path, true) && validate_path(to_path, true) &&
+        mp::platform::copy_file_range(from_path, to_path, read_offset, length))
+    {
+        std::error_code err;
+        if (fs::file_size(to_path, err) < write_offset + length && !err)
+            fs::resize_file(to_path, write_offset + length, err);
+
+        if (!err)
+            return reply_ok(msg);
+    }
+
+    std::vector<char> buffer(std::min(length, copy_chunk_size));
+    for (std::uint64_t copied = 0; copied < length;)
+    {
+        const auto chunk = std::min<std::uint64_t>(buffer.size(), length - copied);
+        if (MP_FILEOPS.lseek(from, read_offset + copied, SEEK_SET) == -1)
+            return reply_failure(msg);
+
+        const auto r = MP_FILEOPS.read(from, buffer.data(), chunk);
+        if (r <= 0)
+        {
+            mpl::trace(category,
+                       "{}: read failed for '{}': {}",
+                       __FUNCTION__,
+                       from_path.string(),
+                       r == 0 ? "unexpected end of file" : std::strerror(errno));
+            return reply_failure(msg);
+        }
+
+        if (MP_FILEOPS.lseek(to, write_offset + copied, SEEK_SET) == -1)
+            return reply_failure(msg);
+
+        for (int written = 0; written < r;)
+        {
+            const auto w = MP_FILEOPS.write(to, buffer.data() + written, r - written);
+            if (w == -1)
+            {
+                mpl::trace(category,
+                           "{}: write failed for '{}': {}",
+                           __FUNCTION__,
+                           to_path.string(),
+                           std::strerror(errno));
+                return reply_failure(msg);
+            }
+
+            written += w;
+        }
+
+        copied += r;
+    }
+
+    return reply_ok(msg);
+}
+
 template <typename T>
 T* multipass::SftpServer::get_handle(sftp_client_message msg)
 {
     return static_cast<T*>(sftp_handle(msg->sftp, msg->handle));
 }
+
+template <typename T>
+T* multipass::SftpServer::get_handle(const std::string& handle)
+{
+    const SftpHandleUPtr handle_string{ssh_string_new(handle.size()), ssh_string_free};
+    if (handle_string == nullptr ||
+        ssh_string_fill(handle_string.get(), handle.data(), handle.size()) != 0)
+        return nullptr;
+
+    return static_cast<T*>(sftp_handle(sftp_server_session.get(), handle_string.get()));
+}
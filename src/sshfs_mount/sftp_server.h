@@ -19,12 +19,18 @@
 
 #include <multipass/file_ops.h>
 #include <multipass/id_mappings.h>
+#include <multipass/metrics.h>
 #include <multipass/recursive_dir_iterator.h>
 
 #include <libssh/sftp.h>
 
+#include <chrono>
+#include <cstdint>
 #include <memory>
+#include <optional>
+#include <string>
 #include <unordered_map>
+#include <vector>
 
 #include <QFile>
 #include <QFileInfo>
@@ -37,7 +43,7 @@ class SSHProcess;
 class SftpServer
 {
 public:
-    SftpServer(std::unique_ptr<SSHSession>&& ssh_session,
+    SftpServer(std::shared_ptr<SSHSession> ssh_session,
                const std::string& source,
                const std::string& target,
                const id_mappings& gid_mappings,
@@ -51,11 +57,18 @@ public:
     void run();
     void stop();
 
+    // Handles the next request, waiting for it if need be. Returns false once no more will come.
+    // This is what run() loops on, for callers multiplexing several servers on one session.
+    bool serve_next();
+    ssh_channel channel() const; // the channel requests arrive on
+
     using SftpSessionUptr = std::unique_ptr<sftp_session_struct, decltype(sftp_server_free)*>;
     using SSHFSProcUptr = std::unique_ptr<SSHProcess>;
+    using ClientMessageUptr =
+        std::unique_ptr<sftp_client_message_struct, decltype(sftp_client_message_free)*>;
 
 private:
-    void process_message(sftp_client_message msg);
+    void process_message(ClientMessageUptr msg);
     sftp_attributes_struct attr_from(const QFileInfo& file_info);
     int mapped_uid_for(const int uid);
     int mapped_gid_for(const int gid);
@@ -67,6 +80,8 @@ private:
     bool has_reverse_gid_mapping_for(const int gid);
     bool has_id_mappings_for(const QFileInfo& file_info);
     bool validate_path(const fs::path& current_path, bool follows_symlinks) const;
+    bool resolves_beneath_source(const fs::path& current_path, bool follows_symlinks) const;
+    std::optional<fs::path> resolve(const fs::path& path) const;
     std::string host_to_guest_path(const fs::path& host_path) const;
     fs::path get_absolute_path(const char* path) const;
     std::optional<fs::path> get_validated_path(sftp_client_message msg) const;
@@ -86,17 +101,27 @@ private:
     int handle_setstat(sftp_client_message msg);
     int handle_stat(sftp_client_message msg, bool follow);
     int handle_symlink(sftp_client_message msg);
-    int handle_write(sftp_client_message msg);
+    int handle_write(ClientMessageUptr msg);
     int handle_extended(sftp_client_message msg);
+    int handle_statvfs(sftp_client_message msg);
+    int handle_fsync(sftp_client_message msg);
+    int handle_limits(sftp_client_message msg);
+    int handle_copy_data(sftp_client_message msg);
+
+    int flush_pending_write(); // replies to the writes it holds, returning any error doing so
 
     template <typename T>
     T* get_handle(sftp_client_message msg);
+    template <typename T>
+    T* get_handle(const std::string& handle);
 
-    std::unique_ptr<SSHSession> ssh_session;
+    std::shared_ptr<SSHSession> ssh_session;
     SSHFSProcUptr sshfs_process;
     SftpSessionUptr sftp_server_session;
     const std::filesystem::path source_path;
     const std::filesystem::path target_path;
+    // The source directory, for paths to be resolved beneath it in one go where the platform can
+    const std::unique_ptr<NamedFd> source_root;
     std::unordered_map<void*, std::unique_ptr<NamedFd>> open_file_handles;
     std::unordered_map<void*, std::unique_ptr<DirIterator>> open_dir_handles;
     const id_mappings gid_mappings;
@@ -105,5 +130,31 @@ private:
     const int default_gid;
     const std::string sshfs_exec_line;
     bool stop_invoked{false};
+    std::vector<char> read_buffer;
+
+    // Consecutive writes to one handle, written out together, with their requests, which are only
+    // replied to once their data is written
+    struct PendingWrite
+    {
+        NamedFd* handle{nullptr};
+        std::uint64_t offset{0};
+        std::string data;
+        std::vector<ClientMessageUptr> requests;
+    };
+    PendingWrite pending_write;
+
+    // Paths the fallback in validate_path resolved, kept briefly since the host can change the tree
+    // under them, and forgotten whenever a request changes it
+    struct ResolvedPath
+    {
+        fs::path path;
+        std::chrono::steady_clock::time_point when;
+    };
+    mutable std::unordered_map<std::string, ResolvedPath> resolved_paths;
+
+    // Only ever touched from the thread running the server, so no locking beyond the registry's
+    std::unordered_map<int, metrics::Histogram*> op_durations;
+    metrics::Counter& bytes_read;
+    metrics::Counter& bytes_written;
 };
 } // namespace multipass
@@ -24,18 +24,12 @@
 #include <multipass/logging/log.h>
 #include <multipass/logging/log_location.h>
 #include <multipass/ssh/plain_ssh_session.h>
-#include <multipass/top_catch_all.h>
 #include <multipass/utils.h>
 #include <multipass/utils/semver_compare.h>
 
-#include <scope_guard.hpp>
-
 #include <QDir>
 #include <QString>
 
-#include <cassert>
-#include <iostream>
-
 namespace mp = multipass;
 namespace mpl = multipass::logging;
 namespace mpu = multipass::utils;
@@ -122,7 +116,7 @@ auto get_sshfs_exec_and_options(mp::SSHSession& session)
     return sshfs_exec;
 }
 
-auto make_sftp_server(std::unique_ptr<mp::SSHSession>&& session,
+auto make_sftp_server(std::shared_ptr<mp::SSHSession> session,
                       const std::string& source,
                       const std::string& target,
                       const mp::id_mappings& gid_mappings,
@@ -163,43 +157,23 @@ auto make_sftp_server(std::unique_ptr<mp::SSHSession>&& session,
 
 } // namespace
 
-mp::SshfsMount::SshfsMount(std::unique_ptr<SSHSession>&& session,
+mp::SshfsMount::SshfsMount(std::shared_ptr<SSHSession> session,
                            const std::string& source,
                            const std::string& target,
                            const mp::id_mappings& gid_mappings,
                            const mp::id_mappings& uid_mappings)
-    : sftp_server{make_sftp_server(std::move(session), source, target, gid_mappings, uid_mappings)},
-      sftp_thread{[this] {
-          state.store(State::Running, std::memory_order_release);
-
-          mp::top_catch_all(category, [this] {
-              std::cout << "Connected" << std::endl;
-              sftp_server->run();
-              std::cout << "Stopped" << std::endl;
-          });
-
-          state.store(State::Stopped, std::memory_order_release);
-      }}
+    : sftp_server{make_sftp_server(std::move(session), source, target, gid_mappings, uid_mappings)}
 {
 }
 
-mp::SshfsMount::~SshfsMount()
-{
-    state.store(State::Stopped, std::memory_order_release);
-    top_catch_all(category, [this] { stop(); });
-}
+mp::SshfsMount::~SshfsMount() = default;
 
-void mp::SshfsMount::stop()
+bool mp::SshfsMount::serve_next()
 {
-    auto join_guard = sg::make_scope_guard([this]() noexcept {
-        if (sftp_thread.joinable())
-            sftp_thread.join();
-    });
-
-    sftp_server->stop();
+    return sftp_server->serve_next();
 }
 
-bool mp::SshfsMount::alive() const
+ssh_channel mp::SshfsMount::channel() const
 {
-    return state.load(std::memory_order_acquire) != State::Stopped;
+    return sftp_server->channel();
 }
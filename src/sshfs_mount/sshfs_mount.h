@@ -19,40 +19,35 @@
 
 #include <multipass/id_mappings.h>
 
+#include <libssh/libssh.h>
+
 #include <memory>
-#include <thread>
+#include <string>
 
 namespace multipass
 {
 class SSHSession;
 class SftpServer;
+
+// Serves one mount over a session that may be shared with other mounts. It runs on no thread of its
+// own: whoever owns the session calls serve_next() whenever the mount's channel has data.
 class SshfsMount
 {
 public:
-    SshfsMount(std::unique_ptr<SSHSession>&& session,
+    SshfsMount(std::shared_ptr<SSHSession> session,
                const std::string& source,
                const std::string& target,
                const id_mappings& gid_mappings,
                const id_mappings& uid_mappings);
-    SshfsMount(SshfsMount&& other);
     ~SshfsMount();
 
-    void stop();
-
-    [[nodiscard]] bool alive() const;
+    // Returns false once sshfs is gone from the instance, after which the mount can be dropped
+    bool serve_next();
+    ssh_channel channel() const;
 
 private:
-    enum class State
-    {
-        Unstarted,
-        Running,
-        Stopped
-    };
-
-    std::atomic<State> state{State::Unstarted};
     // sftp_server Doesn't need to be a pointer, but done for now to avoid bringing sftp.h
     // which has an error with -pedantic.
     std::unique_ptr<SftpServer> sftp_server;
-    std::thread sftp_thread;
 };
 } // namespace multipass
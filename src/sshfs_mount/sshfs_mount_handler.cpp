@@ -15,17 +15,14 @@
  *
  */
 
+#include "sshfs_server_process.h"
+
 #include <multipass/exceptions/exitless_sshprocess_exceptions.h>
 #include <multipass/exceptions/sshfs_missing_error.h>
-#include <multipass/platform.h>
 #include <multipass/ssh/ssh_session.h>
 #include <multipass/sshfs_mount/sshfs_mount_handler.h>
 #include <multipass/utils.h>
 
-#include <QCoreApplication>
-#include <QEventLoop>
-#include <QThread>
-
 namespace mp = multipass;
 namespace mpl = multipass::logging;
 namespace mpu = multipass::utils;
@@ -33,29 +30,7 @@ namespace mpu = multipass::utils;
 namespace
 {
 constexpr auto category = "sshfs-mount-handler";
-
-void start_and_block_until_connected(mp::Process* process)
-{
-    QEventLoop event_loop;
-    auto stop_conn =
-        QObject::connect(process, &mp::Process::finished, &event_loop, &QEventLoop::quit);
-    auto running_conn =
-        QObject::connect(process,
-                         &mp::Process::ready_read_standard_output,
-                         [process, &event_loop]() {
-                             if (process->read_all_standard_output().contains(
-                                     "Connected")) // Magic string printed by sshfs_server
-                                 event_loop.quit();
-                         });
-
-    process->start();
-
-    // This blocks and waits either for "Connected" or for failure.
-    event_loop.exec();
-
-    QObject::disconnect(stop_conn);
-    QObject::disconnect(running_conn);
-}
+constexpr auto unmount_timeout = std::chrono::milliseconds{5000};
 
 bool has_sshfs(const std::string& name, mp::SSHSession& session)
 {
@@ -122,16 +97,12 @@ SSHFSMountHandler::SSHFSMountHandler(VirtualMachine* vm,
                                      const std::string& target,
                                      VMMount mount_spec)
     : MountHandler{vm, ssh_key_provider, std::move(mount_spec), target},
-      process{nullptr},
       config{"",
              0,
              vm->ssh_username(),
              vm->get_name(),
              ssh_key_provider->private_key_as_base64(),
-             source,
-             target,
-             this->mount_spec.get_gid_mappings(),
-             this->mount_spec.get_uid_mappings()}
+             {}}
 {
     mpl::info(category,
               "initializing mount {} => {} in '{}'",
@@ -161,106 +132,33 @@ void SSHFSMountHandler::activate_impl(ServerVariant server, std::chrono::millise
     config.host = vm->ssh_hostname();
     config.port = vm->ssh_port();
 
-    process.reset(platform::make_sshfs_server_process(config).release());
-
-    QObject::connect(process.get(), &Process::finished, [this](const ProcessState& exit_state) {
-        if (exit_state.completed_successfully())
-        {
-            mpl::info(category,
-                      "Mount \"{}\" in instance '{}' has stopped",
-                      target,
-                      vm->get_name());
-        }
-        else
-        {
-            // not error as it failing can indicate we need to install sshfs in the VM
-            mpl::warn(category,
-                      "Mount \"{}\" in instance '{}' has stopped unsuccessfully: {}",
-                      target,
-                      vm->get_name(),
-                      exit_state.failure_message());
-        }
-    });
-    QObject::connect(
-        process.get(),
-        &Process::error_occurred,
-        [this](auto error, auto error_string) {
-            mpl::error(
-                category,
-                "There was an error with sshfs_server for instance '{}' with path \"{}\": {} - {}",
-                vm->get_name(),
-                target,
-                mpu::qenum_to_string(error),
-                error_string);
-        });
-
-    mpl::info(category, "process program '{}'", process->program());
-    mpl::info(category, "process arguments '{}'", process->arguments().join(", "));
-
-    start_and_block_until_connected(process.get());
-    // after the process is started, it must be moved to the main thread
-    // when starting an instance that already has mounts defined, it is started in a thread from the
-    // global thread pool this makes the sshfs_server process to be owned by that thread when
-    // stopping the mount from the main thread again, qt will try to send an event from the main
-    // thread to the one in which the process lives this will result in an error since qt can't send
-    // events from one thread to another
-    process->moveToThread(QCoreApplication::instance()->thread());
-    // So, for any future travelers, this^ is the main reason why we use qt_delete_later_unique_ptr
-    // thingy.
-
-    // Check in case sshfs_server stopped, usually due to an error
-    const auto process_state = process->process_state();
-    if (process_state.exit_code == 9) // Magic number returned by sshfs_server
-        throw SSHFSMissingError();
-    else if (process_state.exit_code || process_state.error)
-        throw std::runtime_error(fmt::format("{}: {}",
-                                             process_state.failure_message(),
-                                             process->read_all_standard_error()));
+    auto instance_server = SSHFSServerProcess::for_instance(config);
+    instance_server->add_mount(target, mount_spec, timeout);
+    server_process = std::move(instance_server);
 }
 
 void SSHFSMountHandler::deactivate_impl(bool force)
 {
     mpl::info(category, "Stopping mount \"{}\" in instance '{}'", target, vm->get_name());
-    QObject::disconnect(process.get(), &Process::error_occurred, nullptr, nullptr);
 
-    constexpr auto process_wait_timeout = std::chrono::milliseconds{5000};
-    if (process->terminate(); !process->wait_for_finished(process_wait_timeout.count()))
+    try
     {
-        auto fetch_stderr = [](Process& process) {
-            return fmt::format("Failed to terminate SSHFS mount process gracefully: {}",
-                               process.read_all_standard_error());
-        };
-
-        const auto err = fetch_stderr(*process.get());
-
-        if (force)
-        {
-            mpl::warn(category,
-                      "Failed to gracefully stop mount \"{}\" in instance '{}': {}, trying to stop "
-                      "it forcefully.",
-                      target,
-                      vm->get_name(),
-                      err);
-            /**
-             * Let's try brute force this time.
-             */
-            process->kill();
-            const auto result = process->wait_for_finished(process_wait_timeout.count());
-
-            mpl::warn(category,
-                      "{} to forcefully stop mount \"{}\" in instance '{}': {}",
-                      result ? "Succeeded" : "Failed",
-                      target,
-                      vm->get_name(),
-                      result ? "" : fetch_stderr(*process.get()));
-        }
-        else
-            throw std::runtime_error{err};
+        server_process->remove_mount(target, unmount_timeout);
+    }
+    catch (const std::exception& e)
+    {
+        if (!force)
+            throw;
+
+        mpl::warn(category,
+                  "Failed to gracefully stop mount \"{}\" in instance '{}': {}",
+                  target,
+                  vm->get_name(),
+                  e.what());
     }
 
-    // Finally, call reset() to disconnect all the signals and defer the deletion
-    // to the owning thread, in this case it's the QT main.
-    process.reset();
+    // The server stops along with the last of the instance's mounts
+    server_process.reset();
 }
 
 SSHFSMountHandler::~SSHFSMountHandler()
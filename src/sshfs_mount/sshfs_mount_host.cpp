@@ -0,0 +1,180 @@
+/*
+ * Copyright (C) Canonical, Ltd.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "sshfs_mount_host.h"
+#include "sshfs_mount.h"
+
+#include <multipass/exceptions/sshfs_missing_error.h>
+#include <multipass/logging/log.h>
+#include <multipass/ssh/ssh_session.h>
+#include <multipass/top_catch_all.h>
+
+#include <libssh/libssh.h>
+
+#include <cstdlib>
+
+namespace mp = multipass;
+namespace mpl = multipass::logging;
+namespace mpsp = multipass::sshfs_server_protocol;
+
+namespace
+{
+constexpr auto category = "sshfs mount host";
+constexpr auto idle_poll_timeout_ms = 100; // bounds how long new requests may wait when idle
+
+mpsp::Reply failed(const std::string& id, int code, const std::string& message)
+{
+    return {mpsp::Reply::Type::failed, id, code, message};
+}
+} // namespace
+
+mp::SshfsMountHost::SshfsMountHost(std::shared_ptr<SSHSession> session, ReplyHandler on_reply)
+    : session{std::move(session)}, on_reply{std::move(on_reply)}, thread{[this] {
+          mp::top_catch_all(category, [this] { run(); });
+          running = false;
+      }}
+{
+}
+
+mp::SshfsMountHost::~SshfsMountHost()
+{
+    stopping = true;
+    if (thread.joinable())
+        thread.join();
+}
+
+void mp::SshfsMountHost::handle(sshfs_server_protocol::Request request)
+{
+    std::lock_guard lock{mutex};
+    requests.push_back(std::move(request));
+}
+
+bool mp::SshfsMountHost::alive() const
+{
+    return running;
+}
+
+void mp::SshfsMountHost::run()
+{
+    while (!stopping && session->is_connected())
+    {
+        handle_pending_requests();
+
+        if (!serve_ready_mounts())
+            wait_for_session(idle_poll_timeout_ms);
+    }
+
+    for (const auto& [id, mount] : mounts)
+        on_reply({mpsp::Reply::Type::stopped, id});
+
+    mounts.clear();
+}
+
+void mp::SshfsMountHost::handle_pending_requests()
+{
+    std::deque<mpsp::Request> pending;
+    {
+        std::lock_guard lock{mutex};
+        pending.swap(requests);
+    }
+
+    for (const auto& request : pending)
+    {
+        if (request.type == mpsp::Request::Type::mount)
+            mount(request);
+        else
+        {
+            mounts.erase(request.id);
+            on_reply({mpsp::Reply::Type::stopped, request.id});
+        }
+    }
+}
+
+void mp::SshfsMountHost::mount(const sshfs_server_protocol::Request& request)
+{
+    mounts.erase(request.id); // in case the daemon lost track of it
+
+    try
+    {
+        // This runs a few commands in the instance, holding up the other mounts meanwhile
+        mounts[request.id] = std::make_unique<SshfsMount>(session,
+                                                          request.source,
+                                                          request.target,
+                                                          request.gid_mappings,
+                                                          request.uid_mappings);
+        on_reply({mpsp::Reply::Type::connected, request.id});
+    }
+    catch (const SSHFSMissingError& e)
+    {
+        mounts.erase(request.id);
+        on_reply(failed(request.id, mpsp::sshfs_missing_code, e.what()));
+    }
+    catch (const std::exception& e)
+    {
+        mounts.erase(request.id);
+        on_reply(failed(request.id, EXIT_FAILURE, e.what()));
+    }
+}
+
+bool mp::SshfsMountHost::serve_ready_mounts()
+{
+    auto served = false;
+    for (auto it = mounts.begin(); it != mounts.end();)
+    {
+        // Anything other than nothing to read (data, EOF or error) is for the mount to deal with
+        if (ssh_channel_poll(it->second->channel(), 0) == 0)
+        {
+            ++it;
+            continue;
+        }
+
+        served = true;
+        auto keep = false;
+        try
+        {
+            keep = it->second->serve_next();
+        }
+        catch (const std::exception& e)
+        {
+            mpl::error(category, "Mount \"{}\" failed: {}", it->first, e.what());
+        }
+
+        if (keep)
+            ++it;
+        else
+        {
+            on_reply({mpsp::Reply::Type::stopped, it->first});
+            it = mounts.erase(it);
+        }
+    }
+
+    return served;
+}
+
+void mp::SshfsMountHost::wait_for_session(int timeout_ms)
+{
+    // A session can only be polled by one event at a time and its processes poll with their own
+    // events when waiting for exit codes, so it is only added to this one for as long as we wait
+    std::unique_ptr<ssh_event_struct, decltype(ssh_event_free)*> event{ssh_event_new(),
+                                                                       ssh_event_free};
+    ssh_session raw_session = *session;
+    if (!event || ssh_event_add_session(event.get(), raw_session) != SSH_OK)
+        throw std::runtime_error{"Could not poll the SSH session"};
+
+    ssh_event_dopoll(event.get(), timeout_ms);
+    ssh_event_remove_session(event.get(), raw_session);
+}
@@ -0,0 +1,74 @@
+/*
+ * Copyright (C) Canonical, Ltd.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#pragma once
+
+#include "sshfs_server_protocol.h"
+
+#include <atomic>
+#include <deque>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+namespace multipass
+{
+class SSHSession;
+class SshfsMount;
+
+/*
+ * Serves all the mounts of an instance over a single SSH session, on a single thread of its own.
+ * libssh sessions can't be used from several threads at once, so instead of a thread per mount,
+ * the host polls the channels of all its mounts and serves whichever have requests pending.
+ */
+class SshfsMountHost
+{
+public:
+    using ReplyHandler = std::function<void(const sshfs_server_protocol::Reply&)>;
+
+    // The reply handler is called on the host's thread
+    SshfsMountHost(std::shared_ptr<SSHSession> session, ReplyHandler on_reply);
+    ~SshfsMountHost();
+
+    // Queues a request, to be handled between requests of the mounts being served
+    void handle(sshfs_server_protocol::Request request);
+
+    // False once the session is gone, after which nothing can be served anymore
+    [[nodiscard]] bool alive() const;
+
+private:
+    void run();
+    void handle_pending_requests();
+    void mount(const sshfs_server_protocol::Request& request);
+    bool serve_ready_mounts();
+    void wait_for_session(int timeout_ms);
+
+    const std::shared_ptr<SSHSession> session;
+    const ReplyHandler on_reply;
+
+    std::mutex mutex;
+    std::deque<sshfs_server_protocol::Request> requests;
+
+    std::map<std::string, std::unique_ptr<SshfsMount>> mounts; // only touched on the host's thread
+    std::atomic_bool stopping{false};
+    std::atomic_bool running{true};
+    std::thread thread;
+};
+} // namespace multipass
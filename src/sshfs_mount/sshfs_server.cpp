@@ -15,60 +15,69 @@
  *
  */
 
-#include "sshfs_mount.h"
+#include "sshfs_mount_host.h"
+#include "sshfs_server_protocol.h"
 
-#include <multipass/exceptions/sshfs_missing_error.h>
-#include <multipass/id_mappings.h>
+#include <multipass/constants.h>
+#include <multipass/format.h>
 #include <multipass/logging/log.h>
 #include <multipass/logging/multiplexing_logger.h>
 #include <multipass/logging/standard_logger.h>
+#include <multipass/metrics.h>
 #include <multipass/platform.h>
 #include <multipass/ssh/libssh_scope_guard.h>
 #include <multipass/ssh/plain_ssh_session.h>
 
 #include <ssh/ssh_client_key_provider.h>
 
-#include <QStringList>
-
+#include <atomic>
 #include <iostream>
 #include <memory>
+#include <mutex>
 #include <string>
+#include <thread>
 
 namespace mp = multipass;
 namespace mpl = multipass::logging;
 namespace mpp = multipass::platform;
+namespace mpsp = multipass::sshfs_server_protocol;
 using namespace std;
 
 namespace
 {
-mp::id_mappings convert_id_mappings(const char* in)
+constexpr auto metrics_report_interval = std::chrono::seconds{15};
+
+// Replies and metrics reports come from different threads, but must not interleave
+std::mutex output_mutex;
+
+void write_out(const std::string& text)
 {
-    mp::id_mappings ret_map;
-    QString input(in);
+    std::lock_guard lock{output_mutex};
+    cout << text << endl;
+}
 
-    auto maps = input.split(',', Qt::SkipEmptyParts);
-    for (auto map : maps)
+// The daemon collects these from our standard output, one report at a time, between markers
+void report_metrics()
+{
+    write_out(fmt::format("{}\n{}{}",
+                          mpsp::metrics_begin_marker,
+                          MP_METRICS.render(),
+                          mpsp::metrics_end_marker));
+}
+
+// Feeds the host with the daemon's requests until our standard input closes, i.e. until the
+// daemon has no more use for us
+void read_requests(mp::SshfsMountHost& mount_host, std::atomic_bool& requests_closed)
+{
+    for (std::string line; getline(cin, line);)
     {
-        auto ids = map.split(":");
-        if (ids.count() != 2)
-        {
-            cerr << "Incorrect ID mapping syntax";
-            continue;
-        }
-
-        bool ok1, ok2;
-        int from = ids.first().toInt(&ok1);
-        int to = ids.last().toInt(&ok2);
-        if (!ok1 || !ok2)
-        {
-            cerr << "Incorrect ID mapping ids found, ignored" << endl;
-            continue;
-        }
-
-        ret_map.push_back({from, to});
+        if (auto request = mpsp::parse_request(line))
+            mount_host.handle(std::move(*request));
+        else
+            cerr << "Ignoring malformed request: " << line << endl;
     }
 
-    return ret_map;
+    requests_closed = true;
 }
 } // namespace
 
@@ -77,7 +86,7 @@ int main(int argc, char* argv[])
     // TODO: Remove static once we do not use exit() anymore
     static multipass::LibsshScopeGuard libssh_guard;
 
-    if (argc != 9)
+    if (argc != 5)
     {
         cerr << "Incorrect arguments" << endl;
         exit(2);
@@ -93,18 +102,17 @@ int main(int argc, char* argv[])
     const auto host = string(argv[1]);
     const int port = atoi(argv[2]);
     const auto username = string(argv[3]);
-    const auto source_path = string(argv[4]);
-    const auto target_path = string(argv[5]);
-    const mp::id_mappings uid_mappings = convert_id_mappings(argv[6]);
-    const mp::id_mappings gid_mappings = convert_id_mappings(argv[7]);
-    const mpl::Level log_level = static_cast<mpl::Level>(atoi(argv[8]));
+    const mpl::Level log_level = static_cast<mpl::Level>(atoi(argv[4]));
 
     auto logger = mpp::make_logger(log_level);
     if (!logger)
         logger = std::make_unique<mpl::StandardLogger>(log_level);
 
-    // Use the MultiplexingLogger as we may end up routing messages to the daemon too at some point
-    auto standard_logger = std::make_shared<mpl::MultiplexingLogger>(std::move(logger));
+    // Use the MultiplexingLogger as we may end up routing messages to the daemon too at some point.
+    // Log asynchronously, so that SFTP handlers don't wait on the system logger at trace level
+    auto standard_logger =
+        std::make_shared<mpl::MultiplexingLogger>(std::move(logger),
+                                                  mpl::MultiplexingLogger::AsyncOptions{});
     mpl::set_logger(standard_logger);
 
     MP_PLATFORM.setup_permission_inheritance(false);
@@ -114,35 +122,49 @@ int main(int argc, char* argv[])
         auto watchdog = mpp::make_quit_watchdog(
             std::chrono::milliseconds{500}); // called while there is only one thread
 
-        mp::SshfsMount sshfs_mount(
-            std::make_unique<mp::PlainSSHSession>(host,
+        // All the mounts of the instance share this one session
+        auto session =
+            std::make_shared<mp::PlainSSHSession>(host,
                                                   port,
                                                   username,
-                                                  mp::SSHClientKeyProvider{priv_key_blob}),
-            source_path,
-            target_path,
-            gid_mappings,
-            uid_mappings);
+                                                  mp::SSHClientKeyProvider{priv_key_blob});
 
-        // ssh lives on its own thread, use this thread to listen for quit signal
-        auto sig = watchdog([&sshfs_mount] { return sshfs_mount.alive(); });
+        mp::SshfsMountHost mount_host{session, [](const mpsp::Reply& reply) {
+                                          write_out(mpsp::serialise(reply));
+                                      }};
+
+        std::atomic_bool requests_closed{false};
+        std::thread{read_requests, std::ref(mount_host), std::ref(requests_closed)}.detach();
+
+        const auto reporting_metrics = qEnvironmentVariableIsSet(mp::report_metrics_env_var);
+        auto last_report = std::chrono::steady_clock::now();
+
+        // ssh lives on the host's thread, use this thread to listen for quit signal
+        auto sig = watchdog([&mount_host, &requests_closed, reporting_metrics, &last_report] {
+            if (const auto now = std::chrono::steady_clock::now();
+                reporting_metrics && now - last_report >= metrics_report_interval)
+            {
+                report_metrics();
+                last_report = now;
+            }
+
+            return mount_host.alive() && !requests_closed;
+        });
 
         if (sig.has_value())
-            cout << "Received signal " << *sig << ". Stopping" << endl;
-        else
+            cerr << "Received signal " << *sig << ". Stopping" << endl;
+        else if (!mount_host.alive())
             cerr << "SFTP server thread stopped unexpectedly." << endl;
 
-        sshfs_mount.stop();
-        exit(sig.has_value() ? EXIT_SUCCESS : EXIT_FAILURE);
-    }
-    catch (const mp::SSHFSMissingError&)
-    {
-        cerr << "SSHFS was not found on the host: " << host << endl;
-        exit(9);
+        const auto succeeded = sig.has_value() || mount_host.alive();
+        standard_logger->flush(); // exit() won't wait for it
+        exit(succeeded ? EXIT_SUCCESS : EXIT_FAILURE);
     }
     catch (const exception& e)
     {
         cerr << e.what();
     }
+
+    standard_logger->flush();
     return 1;
 }
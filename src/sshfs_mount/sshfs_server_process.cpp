@@ -0,0 +1,368 @@
+/*
+ * Copyright (C) Canonical, Ltd.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "sshfs_server_process.h"
+
+#include <multipass/exceptions/sshfs_missing_error.h>
+#include <multipass/format.h>
+#include <multipass/logging/log.h>
+#include <multipass/metrics.h>
+#include <multipass/platform.h>
+#include <multipass/utils.h>
+#include <multipass/vm_mount.h>
+
+#include <exception>
+#include <utility>
+
+namespace mp = multipass;
+namespace mpl = multipass::logging;
+namespace mpu = multipass::utils;
+namespace mpsp = multipass::sshfs_server_protocol;
+
+namespace
+{
+constexpr auto category = "sshfs-server";
+constexpr auto max_error_output = 4096;      // Enough for the last few errors
+constexpr auto process_wait_timeout = std::chrono::milliseconds{5000};
+
+std::string metrics_key(const std::string& instance)
+{
+    return fmt::format("sshfs_server:{}", instance);
+}
+} // namespace
+
+std::shared_ptr<mp::SSHFSServerProcess> mp::SSHFSServerProcess::for_instance(
+    const SSHFSServerConfig& config)
+{
+    static std::mutex servers_mutex;
+    static std::map<std::string, std::weak_ptr<SSHFSServerProcess>> servers;
+
+    std::lock_guard lock{servers_mutex};
+    auto& server = servers[config.instance];
+    if (auto existing = server.lock(); existing && existing->running())
+        return existing;
+
+    // Mounts still holding on to a server that went away keep it to themselves
+    auto started = std::make_shared<SSHFSServerProcess>(config);
+    server = started;
+    return started;
+}
+
+mp::SSHFSServerProcess::SSHFSServerProcess(const SSHFSServerConfig& config)
+    : config{config}, context{std::make_unique<QObject>()}
+{
+    this->config.source_paths.clear(); // no mounts to serve yet
+
+    thread.setObjectName(QString::fromStdString(metrics_key(config.instance)));
+    context->moveToThread(&thread);
+    thread.start();
+
+    std::exception_ptr error;
+    QMetaObject::invokeMethod(
+        context.get(),
+        [this, &error] {
+            try
+            {
+                start();
+            }
+            catch (...)
+            {
+                error = std::current_exception();
+            }
+        },
+        Qt::BlockingQueuedConnection);
+
+    if (error)
+    {
+        thread.quit();
+        thread.wait();
+        std::rethrow_exception(error);
+    }
+}
+
+mp::SSHFSServerProcess::~SSHFSServerProcess()
+{
+    QMetaObject::invokeMethod(context.get(), [this] { stop(); }, Qt::BlockingQueuedConnection);
+    thread.quit();
+    thread.wait();
+
+    MP_METRICS.remove_external(metrics_key(config.instance));
+}
+
+void mp::SSHFSServerProcess::add_mount(const std::string& target,
+                                       const VMMount& mount,
+                                       std::chrono::milliseconds timeout)
+{
+    // The server must be let in before it is asked to serve
+    allow_source(target, mount.get_source_path());
+
+    Reply reply;
+    try
+    {
+        reply = request({Request::Type::mount,
+                         target,
+                         mount.get_source_path(),
+                         target,
+                         mount.get_uid_mappings(),
+                         mount.get_gid_mappings()},
+                        timeout);
+    }
+    catch (...)
+    {
+        send({Request::Type::unmount, target}); // in case it connects after all
+        disallow_source(target);
+        throw;
+    }
+
+    if (reply.type == Reply::Type::connected)
+        return;
+
+    disallow_source(target);
+    if (reply.code == mpsp::sshfs_missing_code)
+        throw SSHFSMissingError();
+
+    throw std::runtime_error(reply.message);
+}
+
+void mp::SSHFSServerProcess::remove_mount(const std::string& target,
+                                          std::chrono::milliseconds timeout)
+{
+    const auto reply = request({Request::Type::unmount, target}, timeout);
+    if (reply.type == Reply::Type::failed)
+        mpl::info(category,
+                  "sshfs_server for instance '{}' was gone before mount \"{}\" stopped: {}",
+                  config.instance,
+                  target,
+                  reply.message);
+
+    disallow_source(target);
+}
+
+bool mp::SSHFSServerProcess::running() const
+{
+    std::lock_guard lock{mutex};
+    return !exit_state;
+}
+
+auto mp::SSHFSServerProcess::request(const Request& request, std::chrono::milliseconds timeout)
+    -> Reply
+{
+    {
+        std::lock_guard lock{mutex};
+        replies.erase(request.id);
+    }
+
+    send(request);
+
+    std::unique_lock lock{mutex};
+    if (!replied.wait_for(lock, timeout, [this, &request] {
+            return replies.contains(request.id) || exit_state;
+        }))
+        throw std::runtime_error{fmt::format("Timed out waiting for sshfs_server of instance '{}'",
+                                             config.instance)};
+
+    if (auto it = replies.find(request.id); it != replies.end())
+    {
+        auto reply = std::move(it->second);
+        replies.erase(it);
+        return reply;
+    }
+
+    return {Reply::Type::failed, request.id, exit_state->exit_code.value_or(1), failure};
+}
+
+void mp::SSHFSServerProcess::send(const Request& request)
+{
+    auto line = QByteArray::fromStdString(mpsp::serialise(request) + "\n");
+    QMetaObject::invokeMethod(context.get(), [this, line = std::move(line)] {
+        if (process && process->running())
+            process->write(line);
+    });
+}
+
+void mp::SSHFSServerProcess::allow_source(const std::string& target, const std::string& source)
+{
+    std::lock_guard lock{confinement_mutex};
+    sources[target] = source;
+
+    config.source_paths.clear();
+    for (const auto& [_, path] : sources)
+        config.source_paths.push_back(path);
+
+    platform::update_sshfs_server_confinement(config);
+}
+
+void mp::SSHFSServerProcess::disallow_source(const std::string& target)
+{
+    std::lock_guard lock{confinement_mutex};
+    if (!sources.erase(target))
+        return;
+
+    config.source_paths.clear();
+    for (const auto& [_, path] : sources)
+        config.source_paths.push_back(path);
+
+    try
+    {
+        platform::update_sshfs_server_confinement(config);
+    }
+    catch (const std::exception& e)
+    {
+        // The server is still confined to the sources it had, which is no cause to fail over
+        mpl::warn(category,
+                  "Could not narrow the confinement of sshfs_server for instance '{}': {}",
+                  config.instance,
+                  e.what());
+    }
+}
+
+void mp::SSHFSServerProcess::start()
+{
+    process = platform::make_sshfs_server_process(config);
+
+    QObject::connect(process.get(),
+                     &Process::ready_read_standard_output,
+                     context.get(),
+                     [this] { read_output(); });
+    QObject::connect(process.get(), &Process::ready_read_standard_error, context.get(), [this] {
+        error_output += process->read_all_standard_error();
+        error_output = error_output.right(max_error_output);
+    });
+    QObject::connect(process.get(),
+                     &Process::finished,
+                     context.get(),
+                     [this](const ProcessState& exit_state) { handle_finished(exit_state); });
+    QObject::connect(
+        process.get(),
+        &Process::error_occurred,
+        context.get(),
+        [this](auto error, auto error_string) {
+            mpl::error(category,
+                       "There was an error with sshfs_server for instance '{}': {} - {}",
+                       config.instance,
+                       mpu::qenum_to_string(error),
+                       error_string);
+
+            // Nothing else will tell that the process did not make it
+            if (error == QProcess::FailedToStart)
+                handle_finished({std::nullopt, ProcessState::Error{error, error_string}});
+        });
+
+    mpl::info(category, "process program '{}'", process->program());
+    mpl::info(category, "process arguments '{}'", process->arguments().join(", "));
+
+    process->start();
+}
+
+void mp::SSHFSServerProcess::stop()
+{
+    if (!process)
+        return;
+
+    QObject::disconnect(process.get(), nullptr, context.get(), nullptr);
+
+    if (process->running())
+    {
+        if (process->terminate(); !process->wait_for_finished(process_wait_timeout.count()))
+        {
+            mpl::warn(category,
+                      "Failed to gracefully stop sshfs_server for instance '{}': {}, trying to "
+                      "stop it forcefully.",
+                      config.instance,
+                      process->read_all_standard_error());
+
+            process->kill();
+            process->wait_for_finished(process_wait_timeout.count());
+        }
+    }
+
+    process.reset();
+}
+
+void mp::SSHFSServerProcess::read_output()
+{
+    output += process->read_all_standard_output();
+
+    qsizetype line_end;
+    while ((line_end = output.indexOf('\n')) >= 0)
+    {
+        const auto line = output.left(line_end).toStdString();
+        output.remove(0, line_end + 1);
+
+        if (auto reply = mpsp::parse_reply(line))
+        {
+            if (reply->type == Reply::Type::stopped)
+                mpl::info(category,
+                          "Mount \"{}\" in instance '{}' has stopped",
+                          reply->id,
+                          config.instance);
+
+            std::lock_guard lock{mutex};
+            replies[reply->id] = std::move(*reply);
+            replied.notify_all();
+        }
+        else if (line == mpsp::metrics_begin_marker)
+        {
+            metrics.clear();
+            in_metrics = true;
+        }
+        else if (line == mpsp::metrics_end_marker && in_metrics)
+        {
+            MP_METRICS.set_external(metrics_key(config.instance),
+                                    std::exchange(metrics, {}),
+                                    {{"instance", config.instance}});
+            in_metrics = false;
+        }
+        else if (in_metrics)
+        {
+            metrics += line;
+            metrics += '\n';
+        }
+        else
+        {
+            mpl::debug(category,
+                       "Ignoring output from sshfs_server for instance '{}': {}",
+                       config.instance,
+                       line);
+        }
+    }
+}
+
+void mp::SSHFSServerProcess::handle_finished(const ProcessState& exit_state)
+{
+    error_output += process->read_all_standard_error();
+
+    auto message = exit_state.completed_successfully()
+                       ? fmt::format("sshfs_server for instance '{}' has stopped", config.instance)
+                       : exit_state.failure_message().toStdString();
+    if (!error_output.isEmpty())
+        message = fmt::format("{}: {}", message, mpu::trim_end(error_output.toStdString()));
+
+    if (exit_state.completed_successfully())
+        mpl::info(category, "{}", message);
+    else
+        // not error as it failing can indicate we need to install sshfs in the VM
+        mpl::warn(category,
+                  "sshfs_server for instance '{}' has stopped unsuccessfully: {}",
+                  config.instance,
+                  message);
+
+    std::lock_guard lock{mutex};
+    this->exit_state = exit_state;
+    failure = std::move(message);
+    replied.notify_all();
+}
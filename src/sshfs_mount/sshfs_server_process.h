@@ -0,0 +1,97 @@
+/*
+ * Copyright (C) Canonical, Ltd.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#pragma once
+
+#include "sshfs_server_protocol.h"
+
+#include <multipass/disabled_copy_move.h>
+#include <multipass/process/process.h>
+#include <multipass/sshfs_server_config.h>
+
+#include <QThread>
+
+#include <chrono>
+#include <condition_variable>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+
+namespace multipass
+{
+class VMMount;
+
+/*
+ * The sshfs_server process that serves all the mounts of an instance. The instance's mount handlers
+ * share it, and it stops with the last of them.
+ *
+ * The process lives on a thread of its own, where its signals are handled, so that mounts can be
+ * added and removed from any thread. Those calls block until the server replies.
+ */
+class SSHFSServerProcess : private DisabledCopyMove
+{
+public:
+    // Returns the server of the instance in the config, starting one if none is running
+    static std::shared_ptr<SSHFSServerProcess> for_instance(const SSHFSServerConfig& config);
+
+    explicit SSHFSServerProcess(const SSHFSServerConfig& config);
+    ~SSHFSServerProcess();
+
+    // Throws SSHFSMissingError when sshfs is missing in the instance, runtime_error otherwise
+    void add_mount(const std::string& target,
+                   const VMMount& mount,
+                   std::chrono::milliseconds timeout);
+    void remove_mount(const std::string& target, std::chrono::milliseconds timeout);
+
+    bool running() const;
+
+private:
+    using Request = sshfs_server_protocol::Request;
+    using Reply = sshfs_server_protocol::Reply;
+
+    Reply request(const Request& request, std::chrono::milliseconds timeout);
+    void send(const Request& request);
+    void allow_source(const std::string& target, const std::string& source);
+    void disallow_source(const std::string& target);
+
+    // These run on the process's thread
+    void start();
+    void stop();
+    void read_output();
+    void handle_finished(const ProcessState& exit_state);
+
+    SSHFSServerConfig config;
+    std::mutex confinement_mutex; // guards the sources below, and orders profile reloads
+    std::map<std::string, std::string> sources; // by target
+
+    QThread thread;
+    std::unique_ptr<QObject> context; // for what needs to happen on the thread
+    std::unique_ptr<Process> process;
+    QByteArray output;
+    std::string metrics;
+    bool in_metrics{false}; // between the markers of a metrics report
+    QByteArray error_output;
+
+    mutable std::mutex mutex;
+    std::condition_variable replied;
+    std::map<std::string, Reply> replies; // by mount ID, until picked up
+    std::optional<ProcessState> exit_state;
+    std::string failure; // what to tell about the exit, with the server's last errors
+};
+} // namespace multipass
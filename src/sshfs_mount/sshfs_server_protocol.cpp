@@ -0,0 +1,179 @@
+/*
+ * Copyright (C) Canonical, Ltd.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "sshfs_server_protocol.h"
+
+#include <multipass/format.h>
+
+#include <QByteArray>
+#include <QString>
+#include <QStringList>
+
+namespace mp = multipass;
+namespace mpsp = multipass::sshfs_server_protocol;
+
+namespace
+{
+constexpr auto mount_request = "mount";
+constexpr auto unmount_request = "unmount";
+constexpr auto connected_reply = "connected";
+constexpr auto failed_reply = "failed";
+constexpr auto stopped_reply = "stopped";
+
+// Fields may be empty, e.g. mappings, so only the line's end can go
+QStringList fields_of(std::string line)
+{
+    while (!line.empty() && (line.back() == '\n' || line.back() == '\r'))
+        line.pop_back();
+
+    return QString::fromStdString(line).split(' ');
+}
+
+std::string encode(const std::string& field)
+{
+    return QByteArray::fromStdString(field).toBase64().toStdString();
+}
+
+std::optional<std::string> decode(const QString& field)
+{
+    auto result = QByteArray::fromBase64Encoding(field.toLatin1(),
+                                                 QByteArray::AbortOnBase64DecodingErrors);
+    if (!result)
+        return std::nullopt;
+
+    return result->toStdString();
+}
+
+std::string serialise(const mp::id_mappings& xid_mappings)
+{
+    std::string out;
+    for (const auto& [from, to] : xid_mappings)
+        out += fmt::format("{}:{},", from, to);
+
+    return out;
+}
+
+std::optional<mp::id_mappings> parse_id_mappings(const QString& input)
+{
+    mp::id_mappings mappings;
+    for (const auto& mapping : input.split(',', Qt::SkipEmptyParts))
+    {
+        const auto ids = mapping.split(':');
+        if (ids.size() != 2)
+            return std::nullopt;
+
+        bool from_ok, to_ok;
+        const auto from = ids.first().toInt(&from_ok);
+        const auto to = ids.last().toInt(&to_ok);
+        if (!from_ok || !to_ok)
+            return std::nullopt;
+
+        mappings.push_back({from, to});
+    }
+
+    return mappings;
+}
+} // namespace
+
+std::string mpsp::serialise(const Request& request)
+{
+    if (request.type == Request::Type::unmount)
+        return fmt::format("{} {}", unmount_request, encode(request.id));
+
+    return fmt::format("{} {} {} {} {} {}",
+                       mount_request,
+                       encode(request.id),
+                       encode(request.source),
+                       encode(request.target),
+                       ::serialise(request.uid_mappings),
+                       ::serialise(request.gid_mappings));
+}
+
+std::string mpsp::serialise(const Reply& reply)
+{
+    switch (reply.type)
+    {
+    case Reply::Type::connected:
+        return fmt::format("{}{} {}", reply_marker, connected_reply, encode(reply.id));
+    case Reply::Type::failed:
+        return fmt::format("{}{} {} {} {}",
+                           reply_marker,
+                           failed_reply,
+                           encode(reply.id),
+                           reply.code,
+                           encode(reply.message));
+    case Reply::Type::stopped:
+        return fmt::format("{}{} {}", reply_marker, stopped_reply, encode(reply.id));
+    }
+
+    return {};
+}
+
+std::optional<mpsp::Request> mpsp::parse_request(const std::string& line)
+{
+    const auto fields = fields_of(line);
+    const auto id = fields.size() > 1 ? decode(fields[1]) : std::nullopt;
+    if (!id)
+        return std::nullopt;
+
+    if (fields[0] == unmount_request && fields.size() == 2)
+        return Request{Request::Type::unmount, *id};
+
+    if (fields[0] == mount_request && fields.size() == 6)
+    {
+        auto source = decode(fields[2]);
+        auto target = decode(fields[3]);
+        auto uid_mappings = parse_id_mappings(fields[4]);
+        auto gid_mappings = parse_id_mappings(fields[5]);
+        if (source && target && uid_mappings && gid_mappings)
+            return Request{Request::Type::mount,
+                           *id,
+                           *source,
+                           *target,
+                           *uid_mappings,
+                           *gid_mappings};
+    }
+
+    return std::nullopt;
+}
+
+std::optional<mpsp::Reply> mpsp::parse_reply(const std::string& line)
+{
+    if (!line.starts_with(reply_marker))
+        return std::nullopt;
+
+    const auto fields = fields_of(line.substr(1));
+    const auto id = fields.size() > 1 ? decode(fields[1]) : std::nullopt;
+    if (!id)
+        return std::nullopt;
+
+    if (fields[0] == connected_reply && fields.size() == 2)
+        return Reply{Reply::Type::connected, *id};
+
+    if (fields[0] == stopped_reply && fields.size() == 2)
+        return Reply{Reply::Type::stopped, *id};
+
+    if (fields[0] == failed_reply && fields.size() == 4)
+    {
+        bool ok;
+        const auto code = fields[2].toInt(&ok);
+        if (auto message = decode(fields[3]); ok && message)
+            return Reply{Reply::Type::failed, *id, code, *message};
+    }
+
+    return std::nullopt;
+}
@@ -0,0 +1,77 @@
+/*
+ * Copyright (C) Canonical, Ltd.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#pragma once
+
+#include <multipass/id_mappings.h>
+
+#include <optional>
+#include <string>
+
+// The line protocol between the daemon and sshfs_server. The daemon sends requests on the server's
+// standard input and the server replies on its standard output, one line each. Paths are base64
+// encoded, so that they may hold anything.
+namespace multipass::sshfs_server_protocol
+{
+// Replies start with this, so that they can't be mistaken for the metrics the server also reports
+constexpr char reply_marker = '!';
+
+// Metrics reports go between these lines, so that nothing else on the server's standard output
+// can be taken for metrics
+constexpr auto metrics_begin_marker = "# BEGIN METRICS";
+constexpr auto metrics_end_marker = "# EOF";
+
+// Failure code in replies when sshfs is missing in the instance
+constexpr int sshfs_missing_code = 9;
+
+struct Request
+{
+    enum class Type
+    {
+        mount,
+        unmount
+    };
+
+    Type type;
+    std::string id; // the mount's target, which is unique within an instance
+    std::string source{};
+    std::string target{};
+    id_mappings uid_mappings{};
+    id_mappings gid_mappings{};
+};
+
+struct Reply
+{
+    enum class Type
+    {
+        connected,
+        failed,
+        stopped
+    };
+
+    Type type;
+    std::string id;
+    int code{0};
+    std::string message{};
+};
+
+std::string serialise(const Request& request);
+std::string serialise(const Reply& reply);
+
+std::optional<Request> parse_request(const std::string& line);
+std::optional<Reply> parse_reply(const std::string& line);
+} // namespace multipass::sshfs_server_protocol
@@ -0,0 +1,107 @@
+/*
+ * Copyright (C) Canonical, Ltd.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#include <multipass/background_work.h>
+
+#include <multipass/logging/log.h>
+#include <multipass/platform.h>
+
+#include <algorithm>
+#include <thread>
+
+namespace mp = multipass;
+namespace mpl = multipass::logging;
+
+namespace
+{
+constexpr auto category = "background work";
+
+thread_local mp::BackgroundWork* current_work = nullptr;
+
+bool lower_priority()
+{
+    if (current_work)
+        return false; // an outer scope has done it already
+
+    if (!mp::platform::set_thread_background_priority(true))
+    {
+        mpl::debug(category, "Could not lower the priority of background work");
+        return false;
+    }
+
+    return true;
+}
+} // namespace
+
+mp::BackgroundWork::BackgroundWork(std::uint64_t bandwidth_limit, Promotion promotion)
+    : limit{bandwidth_limit},
+      promotion{std::move(promotion)},
+      outer{current_work},
+      lowered_priority{lower_priority()},
+      available_at{std::chrono::steady_clock::now()}
+{
+    current_work = this;
+}
+
+mp::BackgroundWork::~BackgroundWork()
+{
+    current_work = outer;
+
+    // Threads come from pools, so whatever runs on this one next must not inherit the priority
+    if (lowered_priority && !platform::set_thread_background_priority(false))
+        mpl::warn(category, "Could not restore the priority of a thread after background work");
+}
+
+bool mp::BackgroundWork::promoted() const
+{
+    return promotion && *promotion;
+}
+
+mp::BackgroundWork* mp::BackgroundWork::current()
+{
+    return current_work;
+}
+
+std::uint64_t mp::BackgroundWork::bandwidth_limit() const
+{
+    return promoted() ? 0 : limit;
+}
+
+void mp::BackgroundWork::follow_promotion()
+{
+    if (!lowered_priority || !promoted())
+        return;
+
+    lowered_priority = false;
+    if (platform::set_thread_background_priority(false))
+        mpl::debug(category, "Background work promoted to normal priority");
+    else
+        mpl::warn(category, "Could not raise the priority of promoted background work");
+}
+
+void mp::BackgroundWork::throttle(std::uint64_t bytes)
+{
+    follow_promotion();
+    if (!bandwidth_limit())
+        return;
+
+    // Time not spent transferring is not saved up for later, so that there are no bursts
+    const auto took = std::chrono::duration<double>{static_cast<double>(bytes) / limit};
+    available_at = std::max(available_at, std::chrono::steady_clock::now()) +
+                   std::chrono::duration_cast<std::chrono::steady_clock::duration>(took);
+
+    std::this_thread::sleep_until(available_at);
+}
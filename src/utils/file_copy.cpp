@@ -0,0 +1,153 @@
+/*
+ * Copyright (C) Canonical, Ltd.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <multipass/file_copy.h>
+
+#include <multipass/format.h>
+#include <multipass/logging/log.h>
+#include <multipass/platform.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <future>
+#include <stdexcept>
+#include <thread>
+
+namespace mp = multipass;
+namespace mpl = multipass::logging;
+namespace fs = std::filesystem;
+
+namespace
+{
+constexpr auto category = "file copy";
+constexpr std::uint64_t chunk_size = 64 * 1024 * 1024;
+constexpr std::size_t buffer_size = 1024 * 1024;
+// Disks rather than cores are the limit, so a few chunks at a time are enough to keep them busy
+constexpr unsigned max_workers = 4;
+constexpr auto progress_interval = std::chrono::milliseconds{200};
+
+struct Chunk
+{
+    const mp::FileCopy& file;
+    std::uint64_t offset;
+    std::uint64_t length;
+};
+
+void copy_by_hand(const Chunk& chunk,
+                  const std::atomic_bool& stopping,
+                  std::atomic_uint64_t& copied)
+{
+    const auto& [source, destination] = chunk.file;
+    std::ifstream in{source, std::ios::binary};
+    std::fstream out{destination, std::ios::in | std::ios::out | std::ios::binary};
+    in.seekg(chunk.offset);
+    out.seekp(chunk.offset);
+
+    std::vector<char> buffer(buffer_size);
+    for (auto left = chunk.length; left > 0 && !stopping;)
+    {
+        const auto size = std::min<std::uint64_t>(left, buffer.size());
+        in.read(buffer.data(), size);
+
+        // The destination starts out as one big hole, so zeros need not be written
+        if (std::all_of(buffer.data(), buffer.data() + size, [](char c) { return c == 0; }))
+            out.seekp(size, std::ios::cur);
+        else
+            out.write(buffer.data(), size);
+
+        if (!in || !out)
+            throw std::runtime_error{
+                fmt::format("Cannot copy {} to {} at {}", source, destination, chunk.offset)};
+
+        left -= size;
+        copied += size;
+    }
+}
+} // namespace
+
+void mp::copy_files(const std::vector<FileCopy>& files, const FileCopyProgress& progress)
+{
+    std::uint64_t total = 0;
+    std::atomic_uint64_t copied{0};
+    std::vector<Chunk> chunks;
+
+    for (const auto& file : files)
+    {
+        const auto size = fs::file_size(file.source);
+        total += size;
+
+        if (mp::platform::clone_file(file.source, file.destination))
+        {
+            mpl::debug(category, "Cloned {} to {}", file.source, file.destination);
+            copied += size;
+            continue;
+        }
+
+        std::ofstream{file.destination, std::ios::binary | std::ios::trunc};
+        fs::resize_file(file.destination, size);
+        fs::permissions(file.destination, fs::status(file.source).permissions());
+
+        for (std::uint64_t offset = 0; offset < size; offset += chunk_size)
+            chunks.push_back({file, offset, std::min(chunk_size, size - offset)});
+    }
+
+    std::atomic_size_t next_chunk{0};
+    std::atomic_bool stopping{false};
+    auto copy_chunks = [&] {
+        try
+        {
+            for (auto i = next_chunk++; i < chunks.size() && !stopping; i = next_chunk++)
+            {
+                const auto& chunk = chunks[i];
+                if (mp::platform::copy_file_range(chunk.file.source,
+                                                  chunk.file.destination,
+                                                  chunk.offset,
+                                                  chunk.length))
+                    copied += chunk.length;
+                else
+                    copy_by_hand(chunk, stopping, copied);
+            }
+        }
+        catch (...)
+        {
+            stopping = true; // no point in the others going on
+            throw;
+        }
+    };
+
+    const auto num_workers =
+        std::min<std::size_t>(chunks.size(),
+                              std::clamp(std::thread::hardware_concurrency(), 1u, max_workers));
+    mpl::debug(category, "Copying {} chunks with {} workers", chunks.size(), num_workers);
+
+    std::vector<std::future<void>> workers;
+    for (std::size_t i = 0; i < num_workers; ++i)
+        workers.push_back(std::async(std::launch::async, copy_chunks));
+
+    for (auto& worker : workers)
+        while (worker.wait_for(progress_interval) != std::future_status::ready)
+            if (progress)
+                progress(copied, total);
+
+    for (auto& worker : workers)
+        worker.get(); // throws whatever went wrong first
+
+    if (progress)
+        progress(copied, total);
+}
@@ -325,6 +325,16 @@ off_t mp::FileOps::lseek(int fd, off_t offset, int whence) const
     return ::lseek(fd, offset, whence);
 }
 
+bool mp::FileOps::fsync(int fd) const
+{
+    return mp::platform::fsync(fd);
+}
+
+std::int64_t mp::FileOps::pwrite(int fd, const void* buf, size_t nbytes, std::int64_t offset) const
+{
+    return mp::platform::pwrite(fd, buf, nbytes, offset);
+}
+
 void mp::FileOps::open(std::fstream& stream,
                        const std::filesystem::path& filename,
                        std::ios_base::openmode mode) const
@@ -475,6 +485,11 @@ fs::path mp::FileOps::relative(const fs::path& path,
     return fs::relative(path, base, ec);
 }
 
+bool mp::FileOps::resolves_beneath(int root_fd, const fs::path& path, bool follow_symlink) const
+{
+    return mp::platform::resolves_beneath(root_fd, path, follow_symlink);
+}
+
 fs::path mp::FileOps::remove_extension(const fs::path& path) const
 {
     return path.parent_path() / path.stem();
@@ -155,7 +155,7 @@ void mp::pretty_print(std::ostream& os,
             auto& i = std::get<JsonObjectIter>(stack.top());
             while (i != std::default_sentinel)
             {
-                indent(os, opts.indent * stack.size());
+                indent(os, opts.indent * (stack.size() + opts.nesting));
                 os << boost::json::serialize(i->key()) << ": ";
                 if (auto&& obj = i->value().if_object())
                 {
@@ -182,7 +182,7 @@ void mp::pretty_print(std::ostream& os,
             }
             stack.pop();
 
-            indent(os, opts.indent * stack.size());
+            indent(os, opts.indent * (stack.size() + opts.nesting));
             os.put('}');
             if (!stack.empty())
                 maybe_put_comma(os, stack.top());
@@ -192,7 +192,7 @@ void mp::pretty_print(std::ostream& os,
             auto& i = std::get<JsonArrayIter>(stack.top());
             while (i != std::default_sentinel)
             {
-                indent(os, opts.indent * stack.size());
+                indent(os, opts.indent * (stack.size() + opts.nesting));
                 if (auto&& obj = i->if_object())
                 {
                     ++i;
@@ -218,7 +218,7 @@ void mp::pretty_print(std::ostream& os,
             }
             stack.pop();
 
-            indent(os, opts.indent * stack.size());
+            indent(os, opts.indent * (stack.size() + opts.nesting));
             os.put(']');
             if (!stack.empty())
                 maybe_put_comma(os, stack.top());
@@ -0,0 +1,349 @@
+/*
+ * Copyright (C) Canonical, Ltd.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <multipass/metrics.h>
+
+#include <multipass/format.h>
+
+#include <algorithm>
+#include <stdexcept>
+#include <string_view>
+
+namespace mpm = multipass::metrics;
+
+namespace
+{
+struct RenderedFamily
+{
+    std::string help;
+    std::string type;
+    std::string samples;
+};
+
+std::string escape(std::string_view value)
+{
+    std::string escaped;
+    escaped.reserve(value.size());
+
+    for (const auto c : value)
+    {
+        if (c == '\\' || c == '"')
+            escaped += '\\';
+
+        if (c == '\n')
+            escaped += "\\n";
+        else
+            escaped += c;
+    }
+
+    return escaped;
+}
+
+std::string format_labels(const mpm::Labels& labels)
+{
+    std::string formatted;
+    for (const auto& [key, value] : labels)
+        formatted += fmt::format("{}{}=\"{}\"", formatted.empty() ? "" : ",", key, escape(value));
+
+    return formatted;
+}
+
+std::string braced(const std::string& labels)
+{
+    return labels.empty() ? labels : fmt::format("{{{}}}", labels);
+}
+
+std::vector<std::string_view> lines_of(std::string_view text)
+{
+    std::vector<std::string_view> lines;
+    for (std::size_t start = 0; start < text.size();)
+    {
+        const auto end = std::min(text.find('\n', start), text.size());
+        if (end > start)
+            lines.push_back(text.substr(start, end - start));
+
+        start = end + 1;
+    }
+
+    return lines;
+}
+
+std::string_view sample_name(std::string_view sample)
+{
+    return sample.substr(0, sample.find_first_of("{ "));
+}
+
+// Histograms spread over several sample names, which all belong to the family they derive from
+std::string family_of(std::string_view name, const std::map<std::string, RenderedFamily>& families)
+{
+    for (const std::string_view suffix : {"_bucket", "_sum", "_count"})
+    {
+        if (name.ends_with(suffix))
+        {
+            const std::string base{name.substr(0, name.size() - suffix.size())};
+            if (auto it = families.find(base);
+                it != families.end() && it->second.type == "histogram")
+                return base;
+        }
+    }
+
+    return std::string{name};
+}
+
+void parse_into(std::map<std::string, RenderedFamily>& families, std::string_view exposition)
+{
+    for (const auto line : lines_of(exposition))
+    {
+        for (const std::string_view marker : {"# HELP ", "# TYPE "})
+        {
+            if (line.starts_with(marker))
+            {
+                const auto rest = line.substr(marker.size());
+                const auto space = std::min(rest.find(' '), rest.size());
+                auto& family = families[std::string{rest.substr(0, space)}];
+                auto& field = marker == "# HELP " ? family.help : family.type;
+
+                if (field.empty() && space < rest.size())
+                    field = rest.substr(space + 1);
+            }
+        }
+
+        if (line.starts_with('#'))
+            continue;
+
+        auto& samples = families[family_of(sample_name(line), families)].samples;
+        samples += line;
+        samples += '\n';
+    }
+}
+
+std::string add_labels(std::string_view exposition, const std::string& labels)
+{
+    std::string relabelled;
+    for (const auto line : lines_of(exposition))
+    {
+        std::string sample{line};
+        if (!labels.empty() && !line.starts_with('#'))
+        {
+            const auto pos = sample_name(line).size();
+            if (pos < sample.size() && sample[pos] == '{')
+                sample.insert(pos + 1, sample[pos + 1] == '}' ? labels : labels + ",");
+            else
+                sample.insert(pos, braced(labels));
+        }
+
+        relabelled += sample;
+        relabelled += '\n';
+    }
+
+    return relabelled;
+}
+} // namespace
+
+void mpm::Counter::render(std::string& out,
+                          const std::string& name,
+                          const std::string& labels) const
+{
+    out += fmt::format("{}{} {}\n", name, braced(labels), value());
+}
+
+void mpm::Gauge::render(std::string& out, const std::string& name, const std::string& labels) const
+{
+    out += fmt::format("{}{} {}\n", name, braced(labels), value());
+}
+
+mpm::Histogram::Histogram(std::vector<double> bounds)
+    : bounds{std::move(bounds)},
+      buckets{std::make_unique<std::atomic_uint64_t[]>(this->bounds.size() + 1)}
+{
+}
+
+void mpm::Histogram::observe(double value) noexcept
+{
+    const auto bucket = std::ranges::lower_bound(bounds, value) - bounds.begin();
+    buckets[bucket].fetch_add(1, std::memory_order_relaxed);
+
+    auto current = total.load(std::memory_order_relaxed);
+    while (!total.compare_exchange_weak(current, current + value, std::memory_order_relaxed))
+        ;
+}
+
+std::uint64_t mpm::Histogram::count() const noexcept
+{
+    std::uint64_t count = 0;
+    for (std::size_t i = 0; i <= bounds.size(); ++i)
+        count += buckets[i].load(std::memory_order_relaxed);
+
+    return count;
+}
+
+double mpm::Histogram::sum() const noexcept
+{
+    return total.load(std::memory_order_relaxed);
+}
+
+void mpm::Histogram::render(std::string& out,
+                            const std::string& name,
+                            const std::string& labels) const
+{
+    const auto separator = labels.empty() ? "" : ",";
+
+    std::uint64_t cumulative = 0;
+    for (std::size_t i = 0; i < bounds.size(); ++i)
+    {
+        cumulative += buckets[i].load(std::memory_order_relaxed);
+        out += fmt::format("{}_bucket{{{}{}le=\"{}\"}} {}\n",
+                           name,
+                           labels,
+                           separator,
+                           bounds[i],
+                           cumulative);
+    }
+
+    // Counted from the buckets rather than separately, so that the total always matches them
+    cumulative += buckets[bounds.size()].load(std::memory_order_relaxed);
+    out += fmt::format("{}_bucket{{{}{}le=\"+Inf\"}} {}\n", name, labels, separator, cumulative);
+    out += fmt::format("{}_sum{} {}\n", name, braced(labels), sum());
+    out += fmt::format("{}_count{} {}\n", name, braced(labels), cumulative);
+}
+
+mpm::ScopedTimer::ScopedTimer(Histogram& histogram)
+    : histogram{histogram}, start{std::chrono::steady_clock::now()}
+{
+}
+
+mpm::ScopedTimer::~ScopedTimer()
+{
+    histogram.observe(
+        std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+}
+
+mpm::Registry::Registry(const Singleton<Registry>::PrivatePass& pass) noexcept
+    : Singleton<Registry>::Singleton{pass}
+{
+}
+
+template <typename T, typename... Args>
+T& mpm::Registry::get_or_add(const std::string& name,
+                             const std::string& help,
+                             const std::string& type,
+                             const Labels& labels,
+                             Args&&... args)
+{
+    std::lock_guard lock{mutex};
+
+    auto& family = families[name];
+    if (family.type.empty())
+    {
+        family.help = help;
+        family.type = type;
+    }
+    else if (family.type != type)
+        throw std::logic_error{
+            fmt::format("Metric {} is a {}, not a {}", name, family.type, type)};
+
+    family.removed.erase(labels);
+
+    auto& metric = family.metrics[labels];
+    if (!metric)
+        metric = std::make_unique<T>(std::forward<Args>(args)...);
+
+    return static_cast<T&>(*metric);
+}
+
+mpm::Counter& mpm::Registry::counter(const std::string& name,
+                                     const std::string& help,
+                                     const Labels& labels)
+{
+    return get_or_add<Counter>(name, help, "counter", labels);
+}
+
+mpm::Gauge& mpm::Registry::gauge(const std::string& name,
+                                 const std::string& help,
+                                 const Labels& labels)
+{
+    return get_or_add<Gauge>(name, help, "gauge", labels);
+}
+
+mpm::Histogram& mpm::Registry::histogram(const std::string& name,
+                                         const std::string& help,
+                                         const Labels& labels,
+                                         const std::vector<double>& bounds)
+{
+    return get_or_add<Histogram>(name, help, "histogram", labels, bounds);
+}
+
+void mpm::Registry::remove(const std::string& name, const Labels& labels)
+{
+    std::lock_guard lock{mutex};
+
+    // Only hidden, as callers may still hold on to the metric; it comes back if added again
+    if (auto it = families.find(name); it != families.end() && it->second.metrics.contains(labels))
+        it->second.removed.insert(labels);
+}
+
+void mpm::Registry::set_external(const std::string& key,
+                                 const std::string& exposition,
+                                 const Labels& labels)
+{
+    auto relabelled = add_labels(exposition, format_labels(labels));
+
+    std::lock_guard lock{mutex};
+    externals[key] = std::move(relabelled);
+}
+
+void mpm::Registry::remove_external(const std::string& key)
+{
+    std::lock_guard lock{mutex};
+    externals.erase(key);
+}
+
+std::string mpm::Registry::render() const
+{
+    std::map<std::string, RenderedFamily> rendered;
+    {
+        std::lock_guard lock{mutex};
+
+        for (const auto& [name, family] : families)
+        {
+            auto& out = rendered[name];
+            out.help = escape(family.help);
+            out.type = family.type;
+
+            for (const auto& [labels, metric] : family.metrics)
+                if (!family.removed.contains(labels))
+                    metric->render(out.samples, name, format_labels(labels));
+        }
+
+        // Samples of each family need to be kept together, whichever process they come from
+        for (const auto& [key, exposition] : externals)
+            parse_into(rendered, exposition);
+    }
+
+    std::string out;
+    for (const auto& [name, family] : rendered)
+    {
+        if (!family.help.empty())
+            out += fmt::format("# HELP {} {}\n", name, family.help);
+        if (!family.type.empty())
+            out += fmt::format("# TYPE {} {}\n", name, family.type);
+
+        out += family.samples;
+    }
+
+    return out;
+}
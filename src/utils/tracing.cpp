@@ -0,0 +1,148 @@
+/*
+ * Copyright (C) Canonical, Ltd.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <multipass/tracing.h>
+
+#include <multipass/format.h>
+#include <multipass/logging/log.h>
+#include <multipass/top_catch_all.h>
+
+#include <boost/json.hpp>
+
+#include <algorithm>
+#include <atomic>
+
+namespace mp = multipass;
+namespace mpl = multipass::logging;
+namespace mpt = multipass::tracing;
+
+namespace
+{
+constexpr auto category = "tracing";
+
+thread_local std::string current_trace;
+
+std::size_t current_thread()
+{
+    // Small sequential ids read better than native thread ids in trace viewers
+    static std::atomic_size_t next{1};
+    thread_local const auto id = next++;
+    return id;
+}
+
+boost::json::object to_chrome_trace_event(const mpt::Span& span)
+{
+    using std::chrono::duration_cast;
+    using std::chrono::microseconds;
+
+    boost::json::object args;
+    if (!span.trace.empty())
+        args["trace"] = span.trace;
+    for (const auto& [key, value] : span.attributes)
+        args[key] = value;
+
+    return {{"name", span.name},
+            {"cat", "multipass"},
+            {"ph", "X"},
+            {"ts", duration_cast<microseconds>(span.start.time_since_epoch()).count()},
+            {"dur", duration_cast<microseconds>(span.end - span.start).count()},
+            {"pid", 1},
+            {"tid", span.thread},
+            {"args", std::move(args)}};
+}
+} // namespace
+
+mpt::Tracer::Tracer(const Singleton<Tracer>::PrivatePass& pass) noexcept
+    : Singleton<Tracer>::Singleton{pass}
+{
+}
+
+void mpt::Tracer::record(Span span)
+{
+    std::lock_guard lock{mutex};
+
+    if (exported.is_open())
+        // The closing bracket is optional in the JSON array format, so every event can be flushed
+        // as it comes and the file stays loadable if the daemon goes away
+        exported << boost::json::serialize(to_chrome_trace_event(span)) << ",\n" << std::flush;
+
+    if (!span.trace.empty())
+    {
+        if (pending.size() == max_pending_spans)
+            pending.pop_front();
+
+        pending.push_back(std::move(span));
+    }
+}
+
+std::vector<mpt::Span> mpt::Tracer::take(const std::string& trace)
+{
+    std::vector<Span> taken;
+
+    std::lock_guard lock{mutex};
+    auto [first, last] = std::ranges::stable_partition(pending, [&trace](const Span& span) {
+        return span.trace != trace;
+    });
+    std::move(first, last, std::back_inserter(taken));
+    pending.erase(first, last);
+
+    std::ranges::sort(taken, {}, &Span::start);
+    return taken;
+}
+
+void mpt::Tracer::export_to(const std::filesystem::path& file)
+{
+    std::lock_guard lock{mutex};
+
+    exported = std::ofstream{file, std::ios::trunc};
+    if (!exported)
+        throw std::runtime_error{fmt::format("Cannot open trace file {}", file)};
+
+    exported << "[\n" << std::flush;
+    mpl::info(category, "Exporting traces to {}", file);
+}
+
+mpt::TraceScope::TraceScope(std::string trace)
+    : previous{std::exchange(current_trace, std::move(trace))}
+{
+}
+
+mpt::TraceScope::~TraceScope()
+{
+    current_trace = std::move(previous);
+}
+
+const std::string& mpt::TraceScope::current()
+{
+    return current_trace;
+}
+
+mpt::ScopedSpan::ScopedSpan(std::string name)
+    : span{TraceScope::current(), std::move(name), Clock::now(), {}, {}, current_thread()}
+{
+}
+
+mpt::ScopedSpan::~ScopedSpan()
+{
+    span.end = Clock::now();
+    mp::top_catch_all(category, [this] { MP_TRACER.record(std::move(span)); });
+}
+
+void mpt::ScopedSpan::add_attribute(std::string key, std::string value)
+{
+    span.attributes.emplace_back(std::move(key), std::move(value));
+}
@@ -0,0 +1,96 @@
+/*
+ * Copyright (C) Canonical, Ltd.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <benchmark/benchmark.h>
+
+#include <multipass/file_copy.h>
+
+#include <QTemporaryDir>
+
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <vector>
+
+/*
+ * Times copying the disks of an instance to clone it, against disk size: with copy_files, which
+ * clones copy-on-write where the filesystem allows and copies chunks in parallel otherwise, and
+ * with a plain sequential copy, for comparison.
+ *
+ * Disks are filled with random data, so that there are no holes to skip. This needs twice the
+ * largest disk size in free space in the temporary directory, and the results depend on its
+ * filesystem: on Btrfs or XFS, copy_files should take no time at all regardless of size.
+ */
+
+namespace
+{
+namespace fs = std::filesystem;
+
+constexpr std::uint64_t gib = 1024ULL * 1024 * 1024;
+
+enum class Copy
+{
+    copy_files,
+    sequential
+};
+
+struct Disk
+{
+    explicit Disk(std::uint64_t size)
+    {
+        std::ofstream out{source, std::ios::binary};
+        std::mt19937_64 generator{42};
+        std::vector<std::uint64_t> chunk(8 * 1024 * 1024);
+        for (std::uint64_t written = 0; written < size; written += chunk.size() * 8)
+        {
+            std::ranges::generate(chunk, [&generator] { return generator(); });
+            out.write(reinterpret_cast<const char*>(chunk.data()), chunk.size() * 8);
+        }
+    }
+
+    const QTemporaryDir dir;
+    const fs::path source = dir.filePath("ubuntu-24.04-server-cloudimg-amd64.img").toStdString();
+    const fs::path destination = dir.filePath("clone.img").toStdString();
+};
+
+void BM_CloneDisk(benchmark::State& state, Copy copy)
+{
+    const auto size = static_cast<std::uint64_t>(state.range(0)) * gib;
+    const Disk disk{size};
+
+    for (auto _ : state)
+    {
+        if (copy == Copy::copy_files)
+            multipass::copy_files({{disk.source, disk.destination}});
+        else
+            fs::copy_file(disk.source, disk.destination, fs::copy_options::overwrite_existing);
+
+        state.PauseTiming();
+        fs::remove(disk.destination);
+        state.ResumeTiming();
+    }
+
+    state.SetBytesProcessed(state.iterations() * size);
+}
+} // namespace
+
+// The argument is the disk size, in GiB
+BENCHMARK_CAPTURE(BM_CloneDisk, copy_files, Copy::copy_files)
+    ->Arg(1)->Arg(4)->Arg(16)->Iterations(3)->Unit(benchmark::kMillisecond)->UseRealTime();
+BENCHMARK_CAPTURE(BM_CloneDisk, sequential, Copy::sequential)
+    ->Arg(1)->Arg(4)->Arg(16)->Iterations(3)->Unit(benchmark::kMillisecond)->UseRealTime();
@@ -0,0 +1,426 @@
+/*
+ * Copyright (C) Canonical, Ltd.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <benchmark/benchmark.h>
+
+#include <multipass/cloud_init_iso.h>
+#include <multipass/simple_streams_manifest.h>
+#include <multipass/vm_image_vault_utils.h>
+#include <multipass/xz_image_decoder.h>
+
+#include <boost/json.hpp>
+#include <fmt/format.h>
+
+#include <QFile>
+#include <QProcess>
+#include <QStandardPaths>
+#include <QSysInfo>
+#include <QTemporaryDir>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <new>
+#include <random>
+#include <stdexcept>
+#include <string>
+
+/*
+ * Times the steps every launch goes through before the instance boots: parsing the image
+ * manifests, checking the hash of the downloaded image, decompressing it and writing the
+ * cloud-init ISO (which is read back and rewritten whenever the instance's identity changes).
+ *
+ * Manifests are generated at the size of the released ones, or read from the file
+ * MULTIPASS_BENCH_MANIFEST points at, e.g. a download of
+ * https://cloud-images.ubuntu.com/releases/streams/v1/com.ubuntu.cloud:released:download.json.
+ * Compressing the image to decode needs xz, either in PATH or pointed at by MULTIPASS_BENCH_XZ.
+ *
+ * The manifest benchmarks also report the most heap a parse holds at once, next to what it takes
+ * to hold the whole document, which is what parsing took before it kept only the products of the
+ * current architecture.
+ */
+
+namespace
+{
+// Heap in use, and the most in use since last reset, counted by the operator new below
+std::atomic<std::size_t> heap_in_use{0};
+std::atomic<std::size_t> heap_peak{0};
+
+void* counted_alloc(std::size_t size)
+{
+    // The size is kept in front of the block, for operator delete to take it off again
+    auto* block = static_cast<std::max_align_t*>(std::malloc(sizeof(std::max_align_t) + size));
+    if (!block)
+        throw std::bad_alloc{};
+
+    *reinterpret_cast<std::size_t*>(block) = size;
+    const auto in_use = heap_in_use.fetch_add(size, std::memory_order_relaxed) + size;
+    auto peak = heap_peak.load(std::memory_order_relaxed);
+    while (in_use > peak && !heap_peak.compare_exchange_weak(peak, in_use))
+    {
+    }
+
+    return block + 1;
+}
+
+void counted_free(void* ptr) noexcept
+{
+    if (!ptr)
+        return;
+
+    auto* block = static_cast<std::max_align_t*>(ptr) - 1;
+    heap_in_use.fetch_sub(*reinterpret_cast<std::size_t*>(block), std::memory_order_relaxed);
+    std::free(block);
+}
+} // namespace
+
+void* operator new(std::size_t size)
+{
+    return counted_alloc(size);
+}
+
+void operator delete(void* ptr) noexcept
+{
+    counted_free(ptr);
+}
+
+void operator delete(void* ptr, std::size_t) noexcept
+{
+    counted_free(ptr);
+}
+
+namespace
+{
+namespace fs = std::filesystem;
+namespace mp = multipass;
+
+constexpr std::int64_t mib = 1024 * 1024;
+
+// Stands in for a disk image: mostly empty, with random data in between, so that it compresses
+// about as well as a cloud image does
+void write_image(const fs::path& path, std::int64_t size)
+{
+    std::ofstream image{path, std::ios::binary};
+    std::mt19937_64 generator{42};
+    std::string chunk(mib, '\0');
+
+    for (std::int64_t written = 0; written < size; written += chunk.size())
+    {
+        std::ranges::fill(chunk, '\0');
+        if (written / mib % 3 == 0)
+            std::ranges::generate(chunk, [&generator] { return static_cast<char>(generator()); });
+
+        image.write(chunk.data(), chunk.size());
+    }
+}
+
+QString manifest_arch()
+{
+    // The common case of the mapping SimpleStreamsManifest does
+    const auto arch = QSysInfo::currentCpuArchitecture();
+    return arch == "x86_64" ? "amd64" : arch;
+}
+
+// Roughly the layout of the released manifest, with a product per release and architecture, each
+// with a version a week or so
+QByteArray generate_manifest(int num_products, int num_versions)
+{
+    const std::array<std::string, 3> arches{manifest_arch().toStdString(), "ppc64el", "s390x"};
+
+    std::string products;
+    for (int p = 0; p < num_products; ++p)
+    {
+        const auto& arch = arches[p % arches.size()];
+        const auto release = fmt::format("{}.04", 10 + p / arches.size());
+
+        std::string versions;
+        for (int v = 0; v < num_versions; ++v)
+        {
+            const auto version = fmt::format("2024{:04}", v);
+            std::string items;
+            for (const auto item : {"disk1.img", "uefi1.img", "lxd.tar.xz", "root.tar.xz"})
+                items += fmt::format(R"({}"{}": {{"ftype": "{}", "md5": "{:032}", )"
+                                     R"("path": "server/releases/{}/release-{}/{}", )"
+                                     R"("sha256": "{:064}", "size": 123456789}})",
+                                     items.empty() ? "" : ", ",
+                                     item,
+                                     item,
+                                     v,
+                                     release,
+                                     version,
+                                     item,
+                                     v);
+
+            versions += fmt::format(R"({}"{}": {{"items": {{{}}}, "label": "release", )"
+                                    R"("pubname": "ubuntu-{}-{}-{}"}})",
+                                    versions.empty() ? "" : ", ",
+                                    version,
+                                    items,
+                                    release,
+                                    arch,
+                                    version);
+        }
+
+        products += fmt::format(R"({}"com.ubuntu.cloud:server:{}:{}": {{"aliases": "{},{}", )"
+                                R"("arch": "{}", "os": "ubuntu", "release": "{}", )"
+                                R"("release_codename": "Codename {}", "release_title": "{} LTS", )"
+                                R"("supported": true, "versions": {{{}}}}})",
+                                products.empty() ? "" : ", ",
+                                release,
+                                arch,
+                                release,
+                                p,
+                                arch,
+                                release,
+                                p,
+                                release,
+                                versions);
+    }
+
+    return QByteArray::fromStdString(fmt::format(
+        R"({{"content_id": "com.ubuntu.cloud:released:download", "datatype": "image-downloads", )"
+        R"("format": "products:1.0", "updated": "Wed, 10 Apr 2024 15:34:09 +0000", )"
+        R"("products": {{{}}}}})",
+        products));
+}
+
+std::size_t heap_bytes(const std::string& string)
+{
+    const auto* inline_buffer = reinterpret_cast<const char*>(&string);
+    const auto is_inline =
+        string.data() >= inline_buffer && string.data() < inline_buffer + sizeof(string);
+
+    return is_inline ? 0 : string.capacity() + 1;
+}
+
+// What the parsed products take up, for the memory side of parsing: their entries, and the strings
+// they keep on the heap. The alias index only adds a key and pointer per alias on top.
+void count_product_memory(benchmark::State& state, const mp::SimpleStreamsManifest& manifest)
+{
+    std::size_t bytes = manifest.products.capacity() * sizeof(mp::VMImageInfo);
+    for (const auto& info : manifest.products)
+    {
+        bytes += info.aliases.capacity() * sizeof(std::string);
+        for (const auto& alias : info.aliases)
+            bytes += heap_bytes(alias);
+
+        for (const auto* field : {&info.os,
+                                  &info.release,
+                                  &info.release_title,
+                                  &info.release_codename,
+                                  &info.image_location,
+                                  &info.id,
+                                  &info.stream_location,
+                                  &info.version})
+            bytes += heap_bytes(*field);
+    }
+
+    state.counters["products"] = static_cast<double>(manifest.products.size());
+    state.counters["product_bytes"] = benchmark::Counter(static_cast<double>(bytes),
+                                                         benchmark::Counter::kDefaults,
+                                                         benchmark::Counter::kIs1024);
+}
+
+// The most heap that action holds at once, on top of what was in use before it
+template <typename Action>
+std::size_t peak_heap_of(Action&& action)
+{
+    const auto before = heap_in_use.load();
+    heap_peak = before;
+    action();
+
+    return heap_peak.load() - before;
+}
+
+void count_parse_memory(benchmark::State& state, const QByteArray& manifest)
+{
+    std::unique_ptr<mp::SimpleStreamsManifest> parsed;
+    const auto peak = peak_heap_of([&manifest, &parsed] {
+        parsed = mp::SimpleStreamsManifest::fromJson(manifest, std::nullopt, "https://host/");
+    });
+
+    count_product_memory(state, *parsed);
+    state.counters["peak_parse_bytes"] = benchmark::Counter(static_cast<double>(peak),
+                                                            benchmark::Counter::kDefaults,
+                                                            benchmark::Counter::kIs1024);
+}
+
+void BM_ParseManifest(benchmark::State& state)
+{
+    const auto manifest = generate_manifest(state.range(0), state.range(1));
+
+    for (auto _ : state)
+        benchmark::DoNotOptimize(
+            mp::SimpleStreamsManifest::fromJson(manifest, std::nullopt, "https://host/"));
+
+    state.SetBytesProcessed(state.iterations() * manifest.size());
+    count_parse_memory(state, manifest);
+}
+
+// Holding the whole document, as parsing did before it kept only the products of one architecture,
+// for the time and peak_parse_bytes to compare BM_ParseManifest with
+void BM_ParseManifestDocument(benchmark::State& state)
+{
+    const auto manifest = generate_manifest(state.range(0), state.range(1));
+
+    for (auto _ : state)
+        benchmark::DoNotOptimize(boost::json::parse(std::string_view{manifest}));
+
+    state.SetBytesProcessed(state.iterations() * manifest.size());
+    const auto peak = peak_heap_of(
+        [&manifest] { benchmark::DoNotOptimize(boost::json::parse(std::string_view{manifest})); });
+    state.counters["peak_parse_bytes"] = benchmark::Counter(static_cast<double>(peak),
+                                                            benchmark::Counter::kDefaults,
+                                                            benchmark::Counter::kIs1024);
+}
+
+// Mirrors serve a copy of the official manifest, which every product is checked against
+void BM_ParseManifestWithMirror(benchmark::State& state)
+{
+    const auto manifest = generate_manifest(state.range(0), state.range(1));
+
+    for (auto _ : state)
+        benchmark::DoNotOptimize(
+            mp::SimpleStreamsManifest::fromJson(manifest, manifest, "https://mirror/"));
+
+    state.SetBytesProcessed(state.iterations() * manifest.size() * 2);
+}
+
+void BM_ParseDownloadedManifest(benchmark::State& state)
+{
+    QFile file{qEnvironmentVariable("MULTIPASS_BENCH_MANIFEST")};
+    if (file.fileName().isEmpty() || !file.open(QIODevice::ReadOnly))
+    {
+        state.SkipWithError("MULTIPASS_BENCH_MANIFEST does not point at a manifest");
+        return;
+    }
+
+    const auto manifest = file.readAll();
+    for (auto _ : state)
+        benchmark::DoNotOptimize(
+            mp::SimpleStreamsManifest::fromJson(manifest, std::nullopt, "https://host/"));
+
+    state.SetBytesProcessed(state.iterations() * manifest.size());
+    count_parse_memory(state, manifest);
+}
+
+void BM_ComputeHash(benchmark::State& state, mp::ImageVaultUtils::EHashAlgorithm algorithm)
+{
+    const QTemporaryDir dir;
+    const auto image = fs::path{dir.filePath("image").toStdString()};
+    write_image(image, state.range(0) * mib);
+
+    for (auto _ : state)
+        benchmark::DoNotOptimize(MP_IMAGE_VAULT_UTILS.compute_file_hash(image, algorithm));
+
+    state.SetBytesProcessed(state.iterations() * state.range(0) * mib);
+}
+
+void BM_DecodeXz(benchmark::State& state)
+{
+    auto xz = qEnvironmentVariable("MULTIPASS_BENCH_XZ");
+    if (xz.isEmpty())
+        xz = QStandardPaths::findExecutable("xz");
+    if (xz.isEmpty())
+    {
+        state.SkipWithError("xz not found");
+        return;
+    }
+
+    const QTemporaryDir dir;
+    const auto image = fs::path{dir.filePath("image").toStdString()};
+    write_image(image, state.range(0) * mib);
+
+    QProcess compress;
+    compress.start(xz, {"--keep", "--check=crc32", QString::fromStdString(image.string())});
+    if (!compress.waitForFinished(-1) || compress.exitCode() != 0)
+    {
+        state.SkipWithError("Could not compress the image");
+        return;
+    }
+
+    const auto compressed = fs::path{image}.concat(".xz");
+    const auto decoded = fs::path{image}.concat(".decoded");
+    const mp::ProgressMonitor monitor = [](int, int) { return true; };
+
+    for (auto _ : state)
+        mp::XzImageDecoder{}.decode_to(compressed, decoded, monitor);
+
+    state.SetBytesProcessed(state.iterations() * state.range(0) * mib);
+}
+
+mp::CloudInitIso make_cloud_init_iso(std::int64_t user_data_size)
+{
+    mp::CloudInitIso iso;
+    iso.add_file("meta-data", "#cloud-config\ninstance-id: primary\nlocal-hostname: primary\n");
+    iso.add_file("vendor-data", "#cloud-config\ngrowpart:\n  mode: auto\n  devices: [\"/\"]\n");
+    iso.add_file("network-config",
+                 "#cloud-config\nversion: 2\nethernets:\n  default:\n    match:\n"
+                 "      macaddress: \"52:54:00:12:34:56\"\n    dhcp4: true\n");
+    iso.add_file("user-data", "#cloud-config\n" + std::string(user_data_size, '#'));
+
+    return iso;
+}
+
+void BM_WriteCloudInitIso(benchmark::State& state)
+{
+    const QTemporaryDir dir;
+    const auto path = fs::path{dir.filePath("cloud-init-config.iso").toStdString()};
+    const auto iso = make_cloud_init_iso(state.range(0));
+
+    for (auto _ : state)
+        iso.write_to(path);
+}
+
+void BM_ReadCloudInitIso(benchmark::State& state)
+{
+    const QTemporaryDir dir;
+    const auto path = fs::path{dir.filePath("cloud-init-config.iso").toStdString()};
+    make_cloud_init_iso(state.range(0)).write_to(path);
+
+    for (auto _ : state)
+    {
+        mp::CloudInitIso iso;
+        iso.read_from(path);
+        benchmark::DoNotOptimize(iso);
+    }
+}
+} // namespace
+
+// The arguments are the number of products and the number of versions of each
+BENCHMARK(BM_ParseManifest)->Args({12, 10})->Args({150, 30})->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_ParseManifestDocument)
+    ->Args({12, 10})->Args({150, 30})->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_ParseManifestWithMirror)
+    ->Args({12, 10})->Args({150, 30})->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_ParseDownloadedManifest)->Unit(benchmark::kMillisecond);
+
+// The argument is the image size, in MiB
+BENCHMARK_CAPTURE(BM_ComputeHash, sha256, mp::ImageVaultUtils::EHashAlgorithm::sha256)
+    ->Arg(64)->Arg(512)->Unit(benchmark::kMillisecond);
+BENCHMARK_CAPTURE(BM_ComputeHash, sha512, mp::ImageVaultUtils::EHashAlgorithm::sha512)
+    ->Arg(64)->Arg(512)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_DecodeXz)->Arg(64)->Arg(512)->Unit(benchmark::kMillisecond)->UseRealTime();
+
+// The argument is the size of the user data, in bytes
+BENCHMARK(BM_WriteCloudInitIso)->Arg(1024)->Arg(64 * 1024)->UseRealTime();
+BENCHMARK(BM_ReadCloudInitIso)->Arg(1024)->Arg(64 * 1024);
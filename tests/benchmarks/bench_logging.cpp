@@ -0,0 +1,143 @@
+/*
+ * Copyright (C) Canonical, Ltd.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <multipass/logging/log.h>
+#include <multipass/logging/multiplexing_logger.h>
+
+#include <benchmark/benchmark.h>
+#include <fmt/format.h>
+
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <optional>
+
+namespace mpl = multipass::logging;
+
+namespace
+{
+constexpr auto message = "Read 65536 bytes from /home/ubuntu/some/file at offset 1048576 in 0.2ms";
+
+// Stands in for journald or syslog: one serialised, flushed write per message
+class NullDeviceLogger : public mpl::Logger
+{
+public:
+    NullDeviceLogger() : Logger{mpl::Level::info}
+    {
+#ifdef _WIN32
+        file = std::fopen("NUL", "w");
+#else
+        file = std::fopen("/dev/null", "w");
+#endif
+    }
+
+    ~NullDeviceLogger() override
+    {
+        std::fclose(file);
+    }
+
+    void log(mpl::Level level, std::string_view category, std::string_view message) const override
+    {
+        if (level > logging_level)
+            return;
+
+        std::lock_guard lock{mutex};
+        fmt::print(file, "[{}] [{}] {}\n", as_string(level), category, message);
+        std::fflush(file);
+    }
+
+private:
+    std::FILE* file;
+    mutable std::mutex mutex;
+};
+
+std::shared_ptr<mpl::MultiplexingLogger> make_logger(
+    std::optional<mpl::MultiplexingLogger::OverflowPolicy> async)
+{
+    if (async)
+        return std::make_shared<mpl::MultiplexingLogger>(
+            std::make_unique<NullDeviceLogger>(),
+            mpl::MultiplexingLogger::AsyncOptions{.overflow = *async});
+
+    return std::make_shared<mpl::MultiplexingLogger>(std::make_unique<NullDeviceLogger>());
+}
+
+// Shared by all threads of a run, set up and torn down by the first of them
+std::shared_ptr<mpl::MultiplexingLogger> logger;
+
+void set_up(const benchmark::State& state,
+            std::optional<mpl::MultiplexingLogger::OverflowPolicy> async)
+{
+    if (state.thread_index() == 0)
+        logger = make_logger(async);
+}
+
+void tear_down(benchmark::State& state)
+{
+    state.SetItemsProcessed(state.iterations());
+
+    if (state.thread_index() == 0)
+    {
+        const auto dropped = logger->dropped();
+        logger.reset(); // drains what is left
+        state.counters["dropped"] = static_cast<double>(dropped);
+    }
+}
+
+void BM_LogSync(benchmark::State& state)
+{
+    set_up(state, std::nullopt);
+    for (auto _ : state)
+        logger->log(mpl::Level::info, "benchmark", message);
+    tear_down(state);
+}
+
+void BM_LogAsyncDrop(benchmark::State& state)
+{
+    set_up(state, mpl::MultiplexingLogger::OverflowPolicy::drop);
+    for (auto _ : state)
+        logger->log(mpl::Level::info, "benchmark", message);
+    tear_down(state);
+}
+
+void BM_LogAsyncBlock(benchmark::State& state)
+{
+    set_up(state, mpl::MultiplexingLogger::OverflowPolicy::block);
+    for (auto _ : state)
+        logger->log(mpl::Level::info, "benchmark", message);
+    tear_down(state);
+}
+
+// What trace logging costs when it is not enabled, formatting included
+void BM_LogFilteredOut(benchmark::State& state)
+{
+    if (state.thread_index() == 0)
+        mpl::set_logger(make_logger(std::nullopt));
+
+    for (auto _ : state)
+        mpl::trace("benchmark", "Read {} bytes from {} at offset {}", 65536, "/home/ubuntu", 1024);
+
+    state.SetItemsProcessed(state.iterations());
+    if (state.thread_index() == 0)
+        mpl::set_logger(nullptr);
+}
+} // namespace
+
+BENCHMARK(BM_LogSync)->ThreadRange(1, 16)->UseRealTime();
+BENCHMARK(BM_LogAsyncDrop)->ThreadRange(1, 16)->UseRealTime();
+BENCHMARK(BM_LogAsyncBlock)->ThreadRange(1, 16)->UseRealTime();
+BENCHMARK(BM_LogFilteredOut)->ThreadRange(1, 16)->UseRealTime();
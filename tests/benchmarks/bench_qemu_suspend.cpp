@@ -0,0 +1,373 @@
+/*
+ * Copyright (C) Canonical, Ltd.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <benchmark/benchmark.h>
+
+#include <QByteArray>
+#include <QDir>
+#include <QFile>
+#include <QProcess>
+#include <QStandardPaths>
+#include <QSysInfo>
+#include <QTemporaryDir>
+#include <QThread>
+
+#include <algorithm>
+#include <deque>
+#include <memory>
+#include <random>
+#include <stdexcept>
+#include <string>
+
+/*
+ * Times suspending and resuming the way the QEMU backend does it, with savevm/loadvm snapshots or
+ * with a migration to a file, against guest memory size.
+ *
+ * There is no guest to boot: QEMU is started paused, with its memory backed by a file that is
+ * filled with random data beforehand, so that no page can be skipped as empty. This needs
+ * qemu-system and qemu-img, either in PATH or pointed at by MULTIPASS_BENCH_QEMU and
+ * MULTIPASS_BENCH_QEMU_IMG, and twice the guest memory in free space in the temporary directory.
+ * Pick the sizes the machine can hold with --benchmark_filter.
+ */
+
+namespace
+{
+constexpr int qmp_timeout = 600000; // unit: ms, saving large guests to slow disks takes a while
+constexpr qint64 gib = 1024LL * 1024 * 1024;
+constexpr auto suspend_tag = "suspend";
+
+enum class SuspendMode
+{
+    snapshot,
+    file
+};
+
+QString find_binary(const char* env_var, const QString& name)
+{
+    if (auto binary = qEnvironmentVariable(env_var); !binary.isEmpty())
+        return binary;
+
+    return QStandardPaths::findExecutable(name);
+}
+
+QString qemu_system()
+{
+    auto arch = QSysInfo::currentCpuArchitecture();
+    if (arch == "arm64")
+        arch = "aarch64";
+
+    return find_binary("MULTIPASS_BENCH_QEMU", "qemu-system-" + arch);
+}
+
+QString qemu_img()
+{
+    return find_binary("MULTIPASS_BENCH_QEMU_IMG", "qemu-img");
+}
+
+int multifd_channels()
+{
+    // Same as the backend
+    return std::clamp(QThread::idealThreadCount(), 2, 8);
+}
+
+void run(const QString& program, const QStringList& arguments)
+{
+    QProcess process;
+    process.start(program, arguments);
+    if (!process.waitForFinished(qmp_timeout) || process.exitCode() != 0)
+        throw std::runtime_error{
+            QString{"%1 failed: %2"}
+                .arg(program, QString::fromUtf8(process.readAllStandardError()))
+                .toStdString()};
+}
+
+// A paused QEMU process, driven over QMP
+class Qemu
+{
+public:
+    Qemu(const QString& memory_file, qint64 memory_size, const QString& disk, QStringList extra)
+    {
+        process.setProcessChannelMode(QProcess::ForwardedErrorChannel);
+        process.start(qemu_system(),
+                      QStringList{"-nodefaults",
+                                  "-nographic",
+                                  "-S",
+                                  "-qmp",
+                                  "stdio",
+                                  "-object",
+                                  QString{"memory-backend-file,id=ram,size=%1,mem-path=%2,share=on"}
+                                      .arg(memory_size)
+                                      .arg(memory_file),
+                                  "-machine",
+                                  "accel=kvm:tcg,memory-backend=ram",
+                                  "-drive",
+                                  QString{"file=%1,if=none,id=disk,format=qcow2"}.arg(disk)}
+                          << extra);
+
+        if (!process.waitForStarted())
+            throw std::runtime_error{"Could not start " + qemu_system().toStdString()};
+
+        // The greeting only comes once -loadvm is done
+        wait_for("\"QMP\"");
+        execute(R"({"execute": "qmp_capabilities"})");
+    }
+
+    ~Qemu()
+    {
+        process.kill();
+        process.waitForFinished();
+    }
+
+    void execute(const QByteArray& command)
+    {
+        process.write(command + '\n');
+        if (auto reply = wait_for("\"return\"", "\"error\""); reply.contains("\"error\""))
+            throw std::runtime_error{reply.toStdString()};
+    }
+
+    void set_up_migration()
+    {
+        execute(R"({"execute": "migrate-set-capabilities", "arguments": {"capabilities": [)"
+                R"({"capability": "events", "state": true},)"
+                R"({"capability": "mapped-ram", "state": true},)"
+                R"({"capability": "multifd", "state": true}]}})");
+        execute(QString{R"({"execute": "migrate-set-parameters", )"
+                        R"("arguments": {"multifd-channels": %1}})"}
+                    .arg(multifd_channels())
+                    .toUtf8());
+    }
+
+    void wait_for_migration()
+    {
+        if (auto event = wait_for("\"completed\"", "\"failed\""); event.contains("\"failed\""))
+            throw std::runtime_error{"Migration failed"};
+    }
+
+    // Neither -loadvm nor an incoming migration of a stopped guest runs it, the backend has to
+    void run_guest()
+    {
+        execute(R"({"execute": "cont"})");
+        wait_for("\"RESUME\"");
+    }
+
+private:
+    // Returns the first line of QMP output with either text in it, keeping the others for later
+    QByteArray wait_for(const QByteArray& text, const QByteArray& other_text = {})
+    {
+        const auto matches = [&](const QByteArray& line) {
+            return line.contains(text) || (!other_text.isEmpty() && line.contains(other_text));
+        };
+
+        if (auto it = std::ranges::find_if(backlog, matches); it != backlog.end())
+        {
+            auto line = *it;
+            backlog.erase(it);
+            return line;
+        }
+
+        while (true)
+        {
+            while (process.canReadLine())
+            {
+                if (auto line = process.readLine(); matches(line))
+                    return line;
+                else
+                    backlog.push_back(std::move(line));
+            }
+
+            if (!process.waitForReadyRead(qmp_timeout))
+                throw std::runtime_error{"QEMU stopped answering: " +
+                                         process.errorString().toStdString()};
+        }
+    }
+
+    QProcess process;
+    std::deque<QByteArray> backlog;
+};
+
+// Everything a guest of a given size needs on disk, with its memory full of random data
+struct Guest
+{
+    explicit Guest(qint64 memory_size) : memory_size{memory_size}
+    {
+        if (qemu_system().isEmpty() || qemu_img().isEmpty())
+            throw std::runtime_error{"qemu-system or qemu-img not found"};
+
+        run(qemu_img(), {"create", "-f", "qcow2", disk, "1G"});
+
+        QFile memory{memory_file};
+        if (!memory.open(QIODevice::WriteOnly))
+            throw std::runtime_error{"Cannot create " + memory_file.toStdString()};
+
+        std::mt19937_64 generator{42};
+        QByteArray chunk(64 * 1024 * 1024, Qt::Uninitialized);
+        for (qint64 written = 0; written < memory_size; written += chunk.size())
+        {
+            std::ranges::generate(chunk, [&generator] { return static_cast<char>(generator()); });
+            memory.write(chunk);
+        }
+    }
+
+    // Gives a restore fresh, empty memory to load into
+    QString empty_memory_file() const
+    {
+        QFile::remove(restored_memory_file);
+
+        QFile memory{restored_memory_file};
+        if (!memory.open(QIODevice::WriteOnly) || !memory.resize(memory_size))
+            throw std::runtime_error{"Cannot create " + restored_memory_file.toStdString()};
+
+        return restored_memory_file;
+    }
+
+    std::unique_ptr<Qemu> start(QStringList extra = {}) const
+    {
+        return std::make_unique<Qemu>(memory_file, memory_size, disk, extra);
+    }
+
+    void suspend(Qemu& qemu, SuspendMode mode) const
+    {
+        if (mode == SuspendMode::snapshot)
+        {
+            qemu.execute(QString{R"({"execute": "human-monitor-command", )"
+                                 R"("arguments": {"command-line": "savevm %1"}})"}
+                             .arg(suspend_tag)
+                             .toUtf8());
+        }
+        else
+        {
+            qemu.set_up_migration();
+            qemu.execute(R"({"execute": "stop"})");
+            qemu.execute(QString{R"({"execute": "migrate", "arguments": {"uri": "file:%1"}})"}
+                             .arg(state_file)
+                             .toUtf8());
+            qemu.wait_for_migration();
+        }
+    }
+
+    std::unique_ptr<Qemu> resume(SuspendMode mode) const
+    {
+        std::unique_ptr<Qemu> qemu;
+        if (mode == SuspendMode::snapshot)
+        {
+            qemu = std::make_unique<Qemu>(empty_memory_file(),
+                                          memory_size,
+                                          disk,
+                                          QStringList{"-loadvm", suspend_tag});
+        }
+        else
+        {
+            qemu = std::make_unique<Qemu>(empty_memory_file(),
+                                          memory_size,
+                                          disk,
+                                          QStringList{"-incoming", "defer"});
+            qemu->set_up_migration();
+            qemu->execute(
+                QString{R"({"execute": "migrate-incoming", "arguments": {"uri": "file:%1"}})"}
+                    .arg(state_file)
+                    .toUtf8());
+            qemu->wait_for_migration();
+        }
+
+        qemu->run_guest();
+        return qemu;
+    }
+
+    void discard_suspended_state(SuspendMode mode) const
+    {
+        if (mode == SuspendMode::snapshot)
+            run(qemu_img(), {"snapshot", "-d", suspend_tag, disk});
+        else
+            QFile::remove(state_file);
+    }
+
+    const qint64 memory_size;
+    const QTemporaryDir dir;
+    const QString disk = dir.filePath("disk.qcow2");
+    const QString memory_file = dir.filePath("memory");
+    const QString restored_memory_file = dir.filePath("restored-memory");
+    const QString state_file = dir.filePath("suspend.state");
+};
+
+std::unique_ptr<Guest> make_guest(benchmark::State& state)
+{
+    try
+    {
+        return std::make_unique<Guest>(state.range(0) * gib);
+    }
+    catch (const std::exception& e)
+    {
+        state.SkipWithError(e.what());
+        return nullptr;
+    }
+}
+
+void BM_Suspend(benchmark::State& state, SuspendMode mode)
+{
+    const auto guest = make_guest(state);
+    if (!guest)
+        return;
+
+    for (auto _ : state)
+    {
+        state.PauseTiming();
+        auto qemu = guest->start();
+        state.ResumeTiming();
+
+        guest->suspend(*qemu, mode);
+
+        state.PauseTiming();
+        qemu.reset();
+        guest->discard_suspended_state(mode);
+        state.ResumeTiming();
+    }
+
+    state.SetBytesProcessed(state.iterations() * guest->memory_size);
+}
+
+// From starting QEMU to the guest running again
+void BM_Resume(benchmark::State& state, SuspendMode mode)
+{
+    const auto guest = make_guest(state);
+    if (!guest)
+        return;
+
+    guest->suspend(*guest->start(), mode);
+
+    for (auto _ : state)
+    {
+        auto qemu = guest->resume(mode);
+
+        state.PauseTiming();
+        qemu.reset();
+        state.ResumeTiming();
+    }
+
+    state.SetBytesProcessed(state.iterations() * guest->memory_size);
+    guest->discard_suspended_state(mode);
+}
+} // namespace
+
+// The argument is the guest memory size, in GiB
+BENCHMARK_CAPTURE(BM_Suspend, snapshot, SuspendMode::snapshot)
+    ->Arg(1)->Arg(4)->Arg(16)->Iterations(3)->Unit(benchmark::kMillisecond)->UseRealTime();
+BENCHMARK_CAPTURE(BM_Suspend, file, SuspendMode::file)
+    ->Arg(1)->Arg(4)->Arg(16)->Iterations(3)->Unit(benchmark::kMillisecond)->UseRealTime();
+BENCHMARK_CAPTURE(BM_Resume, snapshot, SuspendMode::snapshot)
+    ->Arg(1)->Arg(4)->Arg(16)->Iterations(3)->Unit(benchmark::kMillisecond)->UseRealTime();
+BENCHMARK_CAPTURE(BM_Resume, file, SuspendMode::file)
+    ->Arg(1)->Arg(4)->Arg(16)->Iterations(3)->Unit(benchmark::kMillisecond)->UseRealTime();
@@ -0,0 +1,108 @@
+/*
+ * Copyright (C) Canonical, Ltd.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <benchmark/benchmark.h>
+
+#include <multipass/file_ops.h>
+#include <multipass/platform.h>
+
+#include <QTemporaryDir>
+
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <string>
+
+/*
+ * Times what the SFTP server goes through to confine a stat request to the mounted directory,
+ * against how deeply nested the file is: resolving the path beneath the open directory in one go,
+ * where the platform can, and the walk that weakly_canonical does otherwise, a syscall per path
+ * component. Both are followed by the stat itself, as in the server.
+ *
+ * Resolving beneath a directory is only implemented on Linux 5.6 and up; elsewhere that benchmark
+ * is skipped.
+ */
+
+namespace
+{
+namespace fs = std::filesystem;
+
+enum class Resolution
+{
+    beneath,
+    walk
+};
+
+struct Tree
+{
+    explicit Tree(int depth)
+    {
+        auto dir = root;
+        for (int i = 0; i < depth; ++i)
+            dir /= "dir" + std::to_string(i);
+
+        fs::create_directories(dir);
+        file = dir / "file";
+        std::ofstream{file} << "contents";
+
+        relative_file = fs::path{"."} / fs::relative(file, root);
+    }
+
+    const QTemporaryDir dir;
+    const fs::path root = fs::weakly_canonical(dir.path().toStdString());
+    const multipass::NamedFd root_dir{root, multipass::platform::open_resolution_root(root)};
+    fs::path file;
+    fs::path relative_file;
+};
+
+bool is_beneath(const fs::path& root, const fs::path& path)
+{
+    const auto resolved = fs::weakly_canonical(path);
+    auto [root_it, path_it] =
+        std::mismatch(root.begin(), root.end(), resolved.begin(), resolved.end());
+    return root_it == root.end();
+}
+
+void BM_StatConfined(benchmark::State& state, Resolution resolution)
+{
+    const Tree tree{static_cast<int>(state.range(0))};
+
+    if (resolution == Resolution::beneath &&
+        !multipass::platform::resolves_beneath(tree.root_dir.fd, tree.relative_file, true))
+    {
+        state.SkipWithError("Cannot resolve paths beneath a directory on this platform");
+        return;
+    }
+
+    for (auto _ : state)
+    {
+        const auto confined =
+            resolution == Resolution::beneath
+                ? multipass::platform::resolves_beneath(tree.root_dir.fd, tree.relative_file, true)
+                : fs::exists(tree.file) && is_beneath(tree.root, tree.file);
+
+        std::error_code err;
+        benchmark::DoNotOptimize(confined && fs::exists(fs::status(tree.file, err)));
+    }
+
+    state.SetItemsProcessed(state.iterations());
+}
+} // namespace
+
+// The argument is the number of directories the file is nested in
+BENCHMARK_CAPTURE(BM_StatConfined, beneath, Resolution::beneath)->Arg(1)->Arg(8)->Arg(32);
+BENCHMARK_CAPTURE(BM_StatConfined, walk, Resolution::walk)->Arg(1)->Arg(8)->Arg(32);
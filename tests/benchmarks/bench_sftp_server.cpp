@@ -0,0 +1,146 @@
+/*
+ * Copyright (C) Canonical, Ltd.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "mock_sftpserver.h"
+#include "mock_ssh_process_exit_status.h"
+#include "mock_ssh_test_fixture.h"
+#include "stub_ssh_key_provider.h"
+
+#include <src/sshfs_mount/sftp_server.h>
+
+#include <multipass/file_ops.h>
+#include <multipass/ssh/plain_ssh_session.h>
+
+#include <benchmark/benchmark.h>
+
+#include <QTemporaryDir>
+
+#include <cstdlib>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <fcntl.h>
+
+/*
+ * Times the SFTP server handling the writes sshfs sends it, through SftpServer::run as a mount
+ * does. libssh is faked as in the unit tests, so what is timed is the server's own work and the
+ * writes it makes to disk, with no client or network in the way.
+ *
+ * In BM_ServeWrites/queued every request is already waiting, as when sshfs streams a file, so the
+ * server can merge consecutive writes. In BM_ServeWrites/one_at_a_time none is, so each request
+ * is written and replied to on its own.
+ */
+
+namespace
+{
+namespace mp = multipass;
+namespace mpt = multipass::test;
+
+using StringUPtr = std::unique_ptr<ssh_string_struct, void (*)(ssh_string)>;
+
+constexpr std::int64_t file_size = 16 * 1024 * 1024;
+
+enum class Arrival
+{
+    queued,
+    one_at_a_time
+};
+
+void BM_ServeWrites(benchmark::State& state, Arrival arrival)
+{
+    const auto chunk_size = static_cast<std::size_t>(state.range(0));
+    const QTemporaryDir dir;
+    const auto target = MP_FILEOPS.open_fd(dir.filePath("target").toStdString(),
+                                           O_WRONLY | O_CREAT | O_TRUNC,
+                                           0644);
+
+    const std::string chunk(chunk_size, 'x');
+    std::vector<StringUPtr> data;
+    std::vector<sftp_client_message_struct> writes(file_size / chunk_size);
+    for (std::size_t i = 0; i < writes.size(); ++i)
+    {
+        const auto& chunk_data = data.emplace_back(ssh_string_new(chunk_size), ssh_string_free);
+        ssh_string_fill(chunk_data.get(), chunk.data(), chunk.size());
+        writes[i].type = SFTP_WRITE;
+        writes[i].data = chunk_data.get();
+        writes[i].offset = i * chunk_size;
+    }
+
+    // The server takes the first message, the init, when it is made, and the writes on each run
+    sftp_client_message_struct init{};
+    init.type = SSH_FXP_INIT;
+    std::vector<sftp_client_message> messages{&init};
+    for (auto& write : writes)
+        messages.push_back(&write);
+    std::size_t next = 0;
+
+    const mpt::StubSSHKeyProvider key_provider;
+    mpt::MockSSHTestFixture mock_ssh_test_fixture;
+    mpt::ExitStatusMock exit_status_mock;
+
+    REPLACE(ssh_channel_new,
+            [](auto...) { return reinterpret_cast<ssh_channel>(0xdeadbeefdeadbeef); });
+    REPLACE(ssh_channel_free, [](auto...) { return; });
+    REPLACE(ssh_remove_channel_callbacks, [](auto...) { return SSH_OK; });
+    REPLACE(ssh_event_new,
+            [](auto...) { return reinterpret_cast<ssh_event>(0xdeadbeefdeadbeef); });
+    REPLACE(ssh_event_free, [](auto...) { return; });
+    REPLACE(ssh_event_add_session, [](auto...) { return SSH_OK; });
+    REPLACE(ssh_channel_poll, [&](auto...) {
+        return arrival == Arrival::queued && next < messages.size() ? 1 : 0;
+    });
+    REPLACE(sftp_server_new, [](auto...) {
+        return static_cast<sftp_session>(std::calloc(1, sizeof(sftp_session_struct)));
+    });
+    REPLACE(sftp_server_free, [](sftp_session sftp) {
+        std::free(sftp->handles);
+        std::free(sftp);
+    });
+    REPLACE(sftp_get_client_message, [&messages, &next](auto...) -> sftp_client_message {
+        return next < messages.size() ? messages[next++] : nullptr;
+    });
+    REPLACE(sftp_client_message_free, [](auto...) { return; });
+    REPLACE(sftp_handle, [&target](auto...) { return static_cast<void*>(target.get()); });
+    REPLACE(sftp_reply_status, [](auto...) { return SSH_OK; });
+    REPLACE(sftp_packet_write, [](auto...) { return SSH_OK; });
+
+    const auto source = dir.path().toStdString();
+    mp::SftpServer server{std::make_unique<mp::PlainSSHSession>("a", 42, "ubuntu", key_provider),
+                          source,
+                          source,
+                          {},
+                          {},
+                          1000,
+                          1000,
+                          "sshfs"};
+
+    for (auto _ : state)
+    {
+        next = 1;
+        server.run();
+    }
+
+    state.SetBytesProcessed(state.iterations() * file_size);
+}
+} // namespace
+
+// The argument is the size of each write, in bytes; sshfs sends up to 64KiB at a time
+BENCHMARK_CAPTURE(BM_ServeWrites, queued, Arrival::queued)
+    ->Arg(4096)->Arg(32 * 1024)->Arg(64 * 1024)->Unit(benchmark::kMillisecond)->UseRealTime();
+BENCHMARK_CAPTURE(BM_ServeWrites, one_at_a_time, Arrival::one_at_a_time)
+    ->Arg(4096)->Arg(32 * 1024)->Arg(64 * 1024)->Unit(benchmark::kMillisecond)->UseRealTime();
@@ -0,0 +1,134 @@
+/*
+ * Copyright (C) Canonical, Ltd.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <benchmark/benchmark.h>
+
+#include <multipass/file_ops.h>
+#include <multipass/ssh/sftp_client.h>
+
+#include <QFile>
+#include <QRegularExpression>
+#include <QTemporaryDir>
+
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <random>
+#include <string>
+
+/*
+ * Times moving file data over SFTP, both ways.
+ *
+ * Transfers push and pull with the SFTP client, which is timed against whatever SSH server
+ * MULTIPASS_BENCH_SSH points at, as user@host[:port], logging in with the private key
+ * MULTIPASS_BENCH_SSH_KEY points at. A local sshd will do. Files go to the server's /tmp. The
+ * SFTP server's side is timed on its own in bench_sftp_server.cpp.
+ */
+
+namespace
+{
+namespace fs = std::filesystem;
+namespace mp = multipass;
+
+constexpr std::int64_t mib = 1024 * 1024;
+
+void write_random_file(const fs::path& path, std::int64_t size)
+{
+    std::ofstream file{path, std::ios::binary};
+    std::mt19937_64 generator{42};
+    std::string chunk(mib, '\0');
+
+    for (std::int64_t written = 0; written < size; written += chunk.size())
+    {
+        std::ranges::generate(chunk, [&generator] { return static_cast<char>(generator()); });
+        file.write(chunk.data(), chunk.size());
+    }
+}
+
+std::unique_ptr<mp::SFTPClient> connect(benchmark::State& state)
+{
+    const QRegularExpression server_re{R"(^([^@]+)@([^:]+)(?::(\d+))?$)"};
+    const auto server = server_re.match(qEnvironmentVariable("MULTIPASS_BENCH_SSH"));
+    QFile key{qEnvironmentVariable("MULTIPASS_BENCH_SSH_KEY")};
+
+    if (!server.hasMatch() || key.fileName().isEmpty() || !key.open(QIODevice::ReadOnly))
+    {
+        state.SkipWithError("MULTIPASS_BENCH_SSH and MULTIPASS_BENCH_SSH_KEY are not set up");
+        return nullptr;
+    }
+
+    try
+    {
+        const auto port = server.captured(3).isEmpty() ? 22 : server.captured(3).toInt();
+        return std::make_unique<mp::SFTPClient>(server.captured(2).toStdString(),
+                                                port,
+                                                server.captured(1).toStdString(),
+                                                key.readAll().toStdString());
+    }
+    catch (const std::exception& e)
+    {
+        state.SkipWithError(e.what());
+        return nullptr;
+    }
+}
+
+void BM_Push(benchmark::State& state)
+{
+    const auto client = connect(state);
+    if (!client)
+        return;
+
+    const QTemporaryDir dir;
+    const auto source = fs::path{dir.filePath("source").toStdString()};
+    write_random_file(source, state.range(0) * mib);
+
+    for (auto _ : state)
+        if (!client->push(source, "/tmp/multipass-bench-push"))
+            state.SkipWithError("Push failed");
+
+    state.SetBytesProcessed(state.iterations() * state.range(0) * mib);
+}
+
+void BM_Pull(benchmark::State& state)
+{
+    const auto client = connect(state);
+    if (!client)
+        return;
+
+    const QTemporaryDir dir;
+    const auto source = fs::path{dir.filePath("source").toStdString()};
+    write_random_file(source, state.range(0) * mib);
+    if (!client->push(source, "/tmp/multipass-bench-pull"))
+    {
+        state.SkipWithError("Could not push the file to pull");
+        return;
+    }
+
+    const auto target = fs::path{dir.filePath("target").toStdString()};
+    for (auto _ : state)
+        if (!client->pull("/tmp/multipass-bench-pull", target))
+            state.SkipWithError("Pull failed");
+
+    state.SetBytesProcessed(state.iterations() * state.range(0) * mib);
+}
+} // namespace
+
+// The argument is the file size, in MiB
+BENCHMARK(BM_Push)->Arg(16)->Arg(256)->Unit(benchmark::kMillisecond)->UseRealTime();
+BENCHMARK(BM_Pull)->Arg(16)->Arg(256)->Unit(benchmark::kMillisecond)->UseRealTime();
+
@@ -195,7 +195,7 @@ TEST_F(AppleVZVirtualMachineFactory_UnitTests, cloneCopiesRelevantFiles)
 
     const mpt::MockCloudInitFileOps::GuardedMock mock_cloud_init_file_ops_injection =
         mpt::MockCloudInitFileOps::inject<NiceMock>();
-    EXPECT_CALL(*mock_cloud_init_file_ops_injection.first, update_identifiers(_, _, _, _)).Times(1);
+    EXPECT_CALL(*mock_cloud_init_file_ops_injection.first, update_cloud_init(_, _)).Times(1);
 
     namespace fs = std::filesystem;
     const fs::path instances_dir{dummy_data_dir.filePath("applevz/vault/instances").toStdString()};
@@ -228,7 +228,8 @@ TEST_F(AppleVZVirtualMachineFactory_UnitTests, cloneCopiesRelevantFiles)
                                    dest_vm_name,
                                    {},
                                    stub_key_provider,
-                                   stub_monitor));
+                                   stub_monitor,
+                                   {}));
 
     std::unordered_set<std::string> actual_files;
     for (const auto& file : fs::directory_iterator(dest_vm_dir))
@@ -36,6 +36,7 @@ add_c_mocks(
   ssh_channel_is_closed
   ssh_channel_is_eof
   ssh_channel_is_open
+  ssh_channel_poll
   ssh_channel_new
   ssh_channel_open_session
   ssh_channel_request_exec
@@ -60,7 +61,7 @@ add_c_mocks(
   sftp_reply_names
   sftp_reply_names_add
   sftp_reply_handle
-  sftp_reply_version
+  sftp_packet_write
   sftp_get_client_message
   sftp_client_message_free
   sftp_client_message_get_data
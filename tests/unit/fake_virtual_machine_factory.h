@@ -0,0 +1,140 @@
+/*
+ * Copyright (C) Canonical, Ltd.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#pragma once
+
+#include "stub_mount_handler.h"
+#include "stub_virtual_machine.h"
+#include "stub_virtual_machine_factory.h"
+
+#include <multipass/virtual_machine_description.h>
+
+#include <chrono>
+#include <mutex>
+#include <thread>
+
+namespace multipass
+{
+namespace test
+{
+// How long each operation of a FakeVirtualMachine takes, to stand in for a real backend
+struct FakeVirtualMachineLatencies
+{
+    std::chrono::milliseconds start{0};
+    std::chrono::milliseconds shutdown{0};
+    std::chrono::milliseconds suspend{0};
+    std::chrono::milliseconds current_state{0};
+    std::chrono::milliseconds ssh{0}; // for each command, and for SSH to come up
+    std::chrono::milliseconds mount{0};
+};
+
+// An instance that keeps track of its own state, without anything behind it, so that the daemon
+// can be given thousands of them
+struct FakeVirtualMachine : public StubVirtualMachine
+{
+    FakeVirtualMachine(const std::string& name,
+                       const FakeVirtualMachineLatencies& latencies,
+                       State initial_state = State::stopped)
+        : StubVirtualMachine{name}, latencies{latencies}
+    {
+        state = initial_state;
+    }
+
+    void start() override
+    {
+        std::this_thread::sleep_for(latencies.start);
+        set_state(State::running);
+    }
+
+    void shutdown(ShutdownPolicy shutdown_policy = ShutdownPolicy::Powerdown) override
+    {
+        std::this_thread::sleep_for(latencies.shutdown);
+
+        std::lock_guard lock{state_mutex};
+        if (shutdown_policy != ShutdownPolicy::Halt || state != State::suspended)
+            state = State::stopped;
+    }
+
+    void suspend() override
+    {
+        std::this_thread::sleep_for(latencies.suspend);
+        set_state(State::suspended);
+    }
+
+    State current_state() override
+    {
+        std::this_thread::sleep_for(latencies.current_state);
+
+        std::lock_guard lock{state_mutex};
+        return state;
+    }
+
+    // Every command gets what the daemon expects when gathering runtime information
+    std::string ssh_exec(const std::string& /*cmd*/, bool /*whisper*/ = false) override
+    {
+        std::this_thread::sleep_for(latencies.ssh);
+        return "loadavg: 0.01 0.02 0.03\n"
+               "mem_usage: 123456789\n"
+               "mem_total: 1073741824\n"
+               "disk_usage: 1234567890\n"
+               "disk_total: 5368709120\n"
+               "cpus: 1\n"
+               "cpu_times: cpu  1 2 3 4 5 6 7 8 9 10\n"
+               "uptime: 1 hour, 2 minutes\n"
+               "current_release: Ubuntu 24.04 LTS\n";
+    }
+
+    void wait_until_ssh_up(std::chrono::milliseconds) override
+    {
+        std::this_thread::sleep_for(latencies.ssh);
+    }
+
+    std::unique_ptr<MountHandler> make_native_mount_handler(const std::string&,
+                                                            const VMMount&) override
+    {
+        std::this_thread::sleep_for(latencies.mount);
+        return std::make_unique<StubMountHandler>();
+    }
+
+    void set_state(State new_state)
+    {
+        std::lock_guard lock{state_mutex};
+        state = new_state;
+    }
+
+    const FakeVirtualMachineLatencies latencies;
+};
+
+struct FakeVirtualMachineFactory : public StubVirtualMachineFactory
+{
+    FakeVirtualMachineFactory(AvailabilityZoneManager& az_manager,
+                              const FakeVirtualMachineLatencies& latencies)
+        : StubVirtualMachineFactory{az_manager}, latencies{latencies}
+    {
+    }
+
+    VirtualMachine::UPtr create_virtual_machine(const VirtualMachineDescription& desc,
+                                                const SSHKeyProvider&,
+                                                VMStatusMonitor&) override
+    {
+        return std::make_unique<FakeVirtualMachine>(desc.vm_name, latencies);
+    }
+
+    const FakeVirtualMachineLatencies latencies;
+};
+} // namespace test
+} // namespace multipass
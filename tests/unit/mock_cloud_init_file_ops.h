@@ -29,22 +29,8 @@ public:
     using CloudInitFileOps::CloudInitFileOps;
 
     MOCK_METHOD(void,
-                update_cloud_init_with_new_extra_interfaces_and_new_id,
-                (const std::string&,
-                 const std::vector<NetworkInterface>&,
-                 const std::string&,
-                 const std::filesystem::path&),
-                (const, override));
-    MOCK_METHOD(void,
-                update_identifiers,
-                (const std::string&,
-                 const std::vector<NetworkInterface>&,
-                 const std::string&,
-                 const std::filesystem::path&),
-                (const, override));
-    MOCK_METHOD(void,
-                add_extra_interface_to_cloud_init,
-                (const std::string&, const NetworkInterface&, const std::filesystem::path&),
+                update_cloud_init,
+                (const std::filesystem::path&, const std::function<void(CloudInitIso&)>&),
                 (const, override));
     MOCK_METHOD(std::string,
                 get_instance_id_from_cloud_init,
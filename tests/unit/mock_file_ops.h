@@ -89,6 +89,8 @@ public:
     MOCK_METHOD(int, read, (int, void*, size_t), (const, override));
     MOCK_METHOD(int, write, (int, const void*, size_t), (const, override));
     MOCK_METHOD(off_t, lseek, (int, off_t, int), (const, override));
+    MOCK_METHOD(bool, fsync, (int), (const, override));
+    MOCK_METHOD(std::int64_t, pwrite, (int, const void*, size_t, std::int64_t), (const, override));
 
     // Mock std methods
     MOCK_METHOD(void,
@@ -171,6 +173,10 @@ public:
                 relative,
                 (const fs::path& path, const fs::path& base, std::error_code& ec),
                 (override, const));
+    MOCK_METHOD(bool,
+                resolves_beneath,
+                (int root_fd, const fs::path& path, bool follow_symlink),
+                (override, const));
     MOCK_METHOD(fs::perms, get_permissions, (const fs::path&), (const, override));
 
     MOCK_METHOD(fs::path, remove_extension, (const fs::path& path), (const, override));
@@ -100,6 +100,7 @@ public:
     MOCK_METHOD(void, for_each_entry_do, (const Action&), (const, override));
     MOCK_METHOD(std::vector<std::string>, supported_remotes, (), (const, override));
     MOCK_METHOD(void, update_manifests, (bool), (override));
+    MOCK_METHOD(std::vector<RemoteRefreshStatus>, refresh_statuses, (), (const, override));
 
     TempFile image;
     VMImageInfo mock_bionic_image_info{{default_alias},
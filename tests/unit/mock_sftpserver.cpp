@@ -34,5 +34,5 @@ IMPL_MOCK_DEFAULT(1, sftp_client_message_get_filename);
 IMPL_MOCK_DEFAULT(2, sftp_handle);
 IMPL_MOCK_DEFAULT(2, sftp_handle_alloc);
 IMPL_MOCK_DEFAULT(2, sftp_handle_remove);
-IMPL_MOCK_DEFAULT(1, sftp_reply_version);
+IMPL_MOCK_DEFAULT(3, sftp_packet_write);
 }
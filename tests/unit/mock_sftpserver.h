@@ -22,7 +22,7 @@
 #include <libssh/sftp.h>
 extern "C"
 {
-int sftp_reply_version(sftp_client_message msg);
+int sftp_packet_write(sftp_session sftp, uint8_t type, ssh_buffer payload);
 }
 
 DECL_MOCK(sftp_server_new);
@@ -38,7 +38,7 @@ DECL_MOCK(sftp_get_client_message);
 DECL_MOCK(sftp_client_message_free);
 DECL_MOCK(sftp_client_message_get_data);
 DECL_MOCK(sftp_client_message_get_filename);
-DECL_MOCK(sftp_reply_version);
+DECL_MOCK(sftp_packet_write);
 DECL_MOCK(sftp_handle);
 DECL_MOCK(sftp_handle_alloc);
 DECL_MOCK(sftp_handle_remove);
@@ -26,6 +26,7 @@ IMPL_MOCK_DEFAULT(3, ssh_userauth_publickey);
 IMPL_MOCK_DEFAULT(1, ssh_channel_is_eof);
 IMPL_MOCK_DEFAULT(1, ssh_channel_is_closed);
 IMPL_MOCK_DEFAULT(1, ssh_channel_is_open);
+IMPL_MOCK_DEFAULT(2, ssh_channel_poll);
 IMPL_MOCK_DEFAULT(1, ssh_channel_new);
 IMPL_MOCK_DEFAULT(1, ssh_channel_free);
 IMPL_MOCK_DEFAULT(1, ssh_channel_open_session);
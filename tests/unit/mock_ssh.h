@@ -30,6 +30,7 @@ DECL_MOCK(ssh_userauth_publickey);
 DECL_MOCK(ssh_channel_is_eof);
 DECL_MOCK(ssh_channel_is_closed);
 DECL_MOCK(ssh_channel_is_open);
+DECL_MOCK(ssh_channel_poll);
 DECL_MOCK(ssh_channel_new);
 DECL_MOCK(ssh_channel_free);
 DECL_MOCK(ssh_channel_open_session);
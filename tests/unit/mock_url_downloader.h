@@ -29,6 +29,7 @@ struct MockURLDownloader : public multipass::URLDownloader
 
     MOCK_METHOD(QByteArray, download, (const QUrl&), (override));
     MOCK_METHOD(QByteArray, download, (const QUrl&, bool), (override));
+    MOCK_METHOD(void, download_range_to, (const QUrl&, qint64, qint64, QIODevice&), (override));
     MOCK_METHOD(QDateTime, last_modified, (const QUrl&), (override));
     MOCK_METHOD(void,
                 download_to,
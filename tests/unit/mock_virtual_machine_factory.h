@@ -42,7 +42,8 @@ struct MockVirtualMachineFactory : public VirtualMachineFactory
                  const std::string&,
                  const VMImage&,
                  const SSHKeyProvider&,
-                 VMStatusMonitor&),
+                 VMStatusMonitor&,
+                 const FileCopyProgress&),
                 (override));
     MOCK_METHOD(void, remove_resources_for, (const std::string&), (override));
 
@@ -243,6 +243,46 @@ TEST_F(DNSMasqServer, getIpForIgnoresNonIpv4AndMalformedLines)
     EXPECT_EQ(ip.value(), live_ip);
 }
 
+TEST_F(DNSMasqServer, getIpForPicksUpChangesToLeasesFile)
+{
+    auto dns = make_default_dnsmasq_server();
+    make_lease_entry();
+
+    auto ip = dns.get_ip_for(hw_addr);
+    ASSERT_TRUE(ip);
+    EXPECT_EQ(ip.value(), expected_ip);
+
+    const mp::IPAddress renewed_ip{"192.168.64.99"};
+    mpt::make_file_with_content(
+        QDir{data_dir.path()}.filePath("dnsmasq.leases"),
+        fmt::format("0 {} {} dummy_name *\n", hw_addr, renewed_ip.as_string()));
+
+    ip = dns.get_ip_for(hw_addr);
+    ASSERT_TRUE(ip);
+    EXPECT_EQ(ip.value(), renewed_ip);
+
+    QFile::remove(QDir{data_dir.path()}.filePath("dnsmasq.leases"));
+    EXPECT_FALSE(dns.get_ip_for(hw_addr));
+}
+
+TEST_F(DNSMasqServer, getIpForSkipsExpiredLeases)
+{
+    // A zero expiry means an infinite lease; anything else is a timestamp, here long gone.
+    const mp::IPAddress live_ip{"192.168.64.80"};
+    mpt::make_file_with_content(QDir{data_dir.path()}.filePath("dnsmasq.leases"),
+                                fmt::format("1 {} {} expired *\n0 {} {} vm-live *\n",
+                                            hw_addr,
+                                            expected_ip.as_string(),
+                                            hw_addr,
+                                            live_ip.as_string()));
+
+    auto dns = make_default_dnsmasq_server();
+
+    auto ip = dns.get_ip_for(hw_addr);
+    ASSERT_TRUE(ip);
+    EXPECT_EQ(ip.value(), live_ip);
+}
+
 TEST_F(DNSMasqServer, releaseMacReleasesIp)
 {
     const QString dhcp_release_called{QDir{data_dir.path()}.filePath("dhcp_release_called")};
@@ -288,6 +328,24 @@ TEST_F(DNSMasqServer, releaseMacLogsFailures)
     EXPECT_TRUE(logger->logged_lines.size() > 0);
 }
 
+TEST_F(DNSMasqServer, releaseMacKeepsLeaseThatFailedToBeReleased)
+{
+    const QString dhcp_release_called{QDir{data_dir.path()}.filePath("dhcp_release_called.fail")};
+
+    auto subnets = make_subnets(dhcp_release_called, default_subnet);
+    ASSERT_EQ(subnets.size(), 1);
+
+    mp::DNSMasqServer dns{data_dir.path(), subnets};
+    make_lease_entry();
+
+    dns.release_mac(hw_addr, subnets.front().first);
+
+    // The leases file is untouched, so the lease is still dnsmasq's
+    auto ip = dns.get_ip_for(hw_addr);
+    ASSERT_TRUE(ip);
+    EXPECT_EQ(ip.value(), expected_ip);
+}
+
 TEST_F(DNSMasqServer, releaseMacCrashesLogsFailure)
 {
     const QString dhcp_release_called{QDir{data_dir.path()}.filePath("dhcp_release_called")};
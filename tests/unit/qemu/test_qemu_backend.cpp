@@ -18,11 +18,13 @@
 #include "mock_qemu_platform.h"
 
 #include "tests/unit/common.h"
+#include "tests/unit/file_operations.h"
 #include "tests/unit/mock_cloud_init_file_ops.h"
 #include "tests/unit/mock_environment_helpers.h"
 #include "tests/unit/mock_logger.h"
 #include "tests/unit/mock_platform.h"
 #include "tests/unit/mock_process_factory.h"
+#include "tests/unit/mock_settings.h"
 #include "tests/unit/mock_snapshot.h"
 #include "tests/unit/mock_status_monitor.h"
 #include "tests/unit/mock_virtual_machine.h"
@@ -40,6 +42,7 @@
 #include <src/platform/backends/qemu/qemu_virtual_machine_factory.h>
 
 #include <multipass/auto_join_thread.h>
+#include <multipass/constants.h>
 #include <multipass/exceptions/ip_unavailable_exception.h>
 #include <multipass/exceptions/start_exception.h>
 #include <multipass/exceptions/virtual_machine_state_exceptions.h>
@@ -54,7 +57,10 @@
 #include <QDir>
 #include <boost/json.hpp>
 
+#include <algorithm>
+#include <map>
 #include <thread>
+#include <vector>
 
 namespace mp = multipass;
 namespace mpt = multipass::test;
@@ -180,6 +186,101 @@ struct QemuBackend : public mpt::TestWithMockedBinPath
         }
     };
 
+    // Suspend state files go next to the image, so keep it somewhere of the test's own
+    mp::VirtualMachineDescription description_with_image_in_instance_dir()
+    {
+        const auto image = QDir{instance_dir.path()}.filePath("image.img");
+        mpt::make_file_with_content(image);
+
+        auto desc = default_description;
+        desc.image.image_path = image.toStdString();
+        return desc;
+    }
+
+    QString suspend_state_file()
+    {
+        return QDir{instance_dir.path()}.filePath("suspend.state");
+    }
+
+    // Records the QMP commands written to the VM process, replying to some of them with the given
+    // output, as QEMU would
+    void record_qmp_commands(std::vector<boost::json::object>& commands,
+                             std::map<std::string, std::string> replies = {})
+    {
+        process_factory->register_callback([&commands, replies](mpt::MockProcess* process) {
+            if (!process->program().contains("qemu-system") ||
+                process->arguments().contains("-dump-vmstate"))
+                return;
+
+            EXPECT_CALL(*process, kill()).WillRepeatedly([process] {
+                mp::ProcessState exit_state{
+                    std::nullopt,
+                    mp::ProcessState::Error{QProcess::Crashed, QStringLiteral("")}};
+                emit process->finished(exit_state);
+            });
+
+            EXPECT_CALL(*process, write(_))
+                .WillRepeatedly([process, &commands, replies](const QByteArray& data) {
+                    auto json = boost::json::parse(std::string_view(data)).as_object();
+                    const auto execute = value_to<std::string>(json.at("execute"));
+                    commands.push_back(std::move(json));
+
+                    if (execute == "migrate")
+                    {
+                        const auto uri = value_to<std::string>(
+                            commands.back().at("arguments").at("uri"));
+                        mpt::make_file_with_content(QString::fromStdString(uri.substr(5)));
+                    }
+
+                    if (auto reply = replies.find(execute); reply != replies.end())
+                    {
+                        EXPECT_CALL(*process, read_all_standard_output())
+                            .WillRepeatedly(Return(QByteArray::fromStdString(reply->second)));
+                        emit process->ready_read_standard_output();
+                    }
+
+                    return data.size();
+                });
+        });
+    }
+
+    // Answers the QMP commands that carry an id, as QEMU would, with the given reply or success
+    static void reply_to_qmp_commands(mpt::MockProcess* process,
+                                      std::vector<boost::json::object>& commands,
+                                      const std::map<std::string, boost::json::object>& replies)
+    {
+        EXPECT_CALL(*process, write(_))
+            .WillRepeatedly([process, &commands, replies](const QByteArray& data) {
+                auto json = boost::json::parse(std::string_view(data)).as_object();
+                commands.push_back(json);
+
+                if (const auto* id = json.if_contains("id"))
+                {
+                    const auto execute = value_to<std::string>(json.at("execute"));
+                    const auto it = replies.find(execute);
+                    auto reply = it != replies.end()
+                                     ? it->second
+                                     : boost::json::object{{"return", boost::json::object{}}};
+                    reply["id"] = *id;
+
+                    EXPECT_CALL(*process, read_all_standard_output())
+                        .WillRepeatedly(Return(QByteArray::fromStdString(serialize(reply))));
+                    emit process->ready_read_standard_output();
+                }
+
+                return data.size();
+            });
+    }
+
+    static std::vector<std::string> executed(const std::vector<boost::json::object>& commands)
+    {
+        std::vector<std::string> names;
+        for (const auto& command : commands)
+            names.push_back(value_to<std::string>(command.at("execute")));
+
+        return names;
+    }
+
     auto expected_qemu_img_path()
     {
         return QDir(QCoreApplication::applicationDirPath()).filePath("qemu-img");
@@ -190,6 +291,9 @@ struct QemuBackend : public mpt::TestWithMockedBinPath
     }
 
     mpt::MockLogger::Scope logger_scope{mpt::MockLogger::inject()};
+    mpt::MockSettings::GuardedMock mock_settings_injection =
+        mpt::MockSettings::inject<NiceMock>();
+    mpt::MockSettings& mock_settings = *mock_settings_injection.first;
 
     mpt::SetEnvScope env_scope{"DISABLE_APPARMOR", "1"};
     std::unique_ptr<mpt::MockProcessFactory::Scope> process_factory{
@@ -278,6 +382,315 @@ TEST_F(QemuBackend, machineStartSuspendSendsMonitoringEvent)
     machine->suspend();
 }
 
+TEST_F(QemuBackend, suspendsToFileWhenConfigured)
+{
+    EXPECT_CALL(*mock_qemu_platform_factory, make_qemu_platform(_, _)).WillOnce([this](auto&&...) {
+        return std::move(mock_qemu_platform);
+    });
+
+    std::vector<boost::json::object> commands;
+    record_qmp_commands(commands,
+                        {{"migrate",
+                          "{\"event\": \"STOP\"}\n"
+                          "{\"event\": \"MIGRATION\", \"data\": {\"status\": \"completed\"}}\n"}});
+
+    NiceMock<mpt::MockVMStatusMonitor> mock_monitor;
+    boost::json::object metadata;
+    EXPECT_CALL(mock_monitor, update_metadata_for(_, _)).WillRepeatedly(SaveArg<1>(&metadata));
+
+    mp::QemuVirtualMachineFactory backend{data_dir.path(),
+                                          az_manager,
+                                          mp::QemuVirtualMachine::SuspendMode::file};
+    auto machine = backend.create_virtual_machine(description_with_image_in_instance_dir(),
+                                                  key_provider,
+                                                  mock_monitor);
+    machine->start();
+    machine->state = mp::VirtualMachine::State::running;
+
+    EXPECT_CALL(mock_monitor, on_suspend());
+    machine->suspend();
+
+    EXPECT_EQ(machine->current_state(), mp::VirtualMachine::State::suspended);
+    EXPECT_THAT(executed(commands),
+                IsSupersetOf({"migrate-set-capabilities", "migrate-set-parameters", "stop"}));
+    EXPECT_THAT(executed(commands), Not(Contains("human-monitor-command")));
+    EXPECT_THAT(serialize(commands[1]), HasSubstr("mapped-ram"));
+    EXPECT_THAT(serialize(commands[1]), HasSubstr("multifd"));
+
+    EXPECT_TRUE(QFile::exists(suspend_state_file()));
+    EXPECT_FALSE(QFile::exists(suspend_state_file() + ".part"));
+    EXPECT_EQ(value_to<std::string>(metadata.at("suspend_state").at("file")),
+              suspend_state_file().toStdString());
+}
+
+TEST_F(QemuBackend, suspendToFileFallsBackToSnapshotWhenMigrationFails)
+{
+    EXPECT_CALL(*mock_qemu_platform_factory, make_qemu_platform(_, _)).WillOnce([this](auto&&...) {
+        return std::move(mock_qemu_platform);
+    });
+
+    constexpr auto resume_event = "{\"event\": \"RESUME\"}\n";
+    std::vector<boost::json::object> commands;
+    record_qmp_commands(
+        commands,
+        {{"migrate", "{\"event\": \"MIGRATION\", \"data\": {\"status\": \"failed\"}}\n"},
+         {"cont", resume_event},
+         {"human-monitor-command", resume_event}});
+
+    NiceMock<mpt::MockVMStatusMonitor> mock_monitor;
+    mp::QemuVirtualMachineFactory backend{data_dir.path(),
+                                          az_manager,
+                                          mp::QemuVirtualMachine::SuspendMode::file};
+    auto machine = backend.create_virtual_machine(description_with_image_in_instance_dir(),
+                                                  key_provider,
+                                                  mock_monitor);
+    machine->start();
+    machine->state = mp::VirtualMachine::State::running;
+
+    logger_scope.mock_logger->screen_logs(mpl::Level::warning);
+    logger_scope.mock_logger->expect_log(mpl::Level::warning, "falling back to a snapshot");
+    EXPECT_CALL(mock_monitor, on_suspend());
+    machine->suspend();
+
+    EXPECT_EQ(machine->current_state(), mp::VirtualMachine::State::suspended);
+    ASSERT_EQ(executed(commands).back(), "human-monitor-command");
+    EXPECT_THAT(serialize(commands.back()), HasSubstr("savevm suspend"));
+    EXPECT_FALSE(QFile::exists(suspend_state_file() + ".part"));
+}
+
+TEST_F(QemuBackend, suspendToFileFallsBackToSnapshotWhenMigrationIsRefused)
+{
+    EXPECT_CALL(*mock_qemu_platform_factory, make_qemu_platform(_, _)).WillOnce([this](auto&&...) {
+        return std::move(mock_qemu_platform);
+    });
+
+    constexpr auto resume_event = "{\"event\": \"RESUME\"}\n";
+    std::vector<boost::json::object> commands;
+    record_qmp_commands(commands,
+                        {{"migrate",
+                          "{\"id\": \"suspend-to-file\", \"error\": {\"class\": "
+                          "\"GenericError\", \"desc\": \"mapped-ram unsupported\"}}\n"},
+                         {"cont", resume_event},
+                         {"human-monitor-command", resume_event}});
+
+    NiceMock<mpt::MockVMStatusMonitor> mock_monitor;
+    mp::QemuVirtualMachineFactory backend{data_dir.path(),
+                                          az_manager,
+                                          mp::QemuVirtualMachine::SuspendMode::file};
+    auto machine = backend.create_virtual_machine(description_with_image_in_instance_dir(),
+                                                  key_provider,
+                                                  mock_monitor);
+    machine->start();
+    machine->state = mp::VirtualMachine::State::running;
+
+    logger_scope.mock_logger->screen_logs(mpl::Level::warning);
+    logger_scope.mock_logger->expect_log(mpl::Level::warning, "mapped-ram unsupported");
+    logger_scope.mock_logger->expect_log(mpl::Level::warning, "falling back to a snapshot");
+    EXPECT_CALL(mock_monitor, on_suspend());
+    machine->suspend();
+
+    EXPECT_EQ(machine->current_state(), mp::VirtualMachine::State::suspended);
+    ASSERT_EQ(executed(commands).back(), "human-monitor-command");
+    EXPECT_THAT(serialize(commands.back()), HasSubstr("savevm suspend"));
+}
+
+TEST_F(QemuBackend, resumesFromSuspendStateFile)
+{
+    EXPECT_CALL(*mock_qemu_platform_factory, make_qemu_platform(_, _)).WillOnce([this](auto&&...) {
+        return std::move(mock_qemu_platform);
+    });
+
+    std::vector<boost::json::object> commands;
+    record_qmp_commands(
+        commands,
+        {{"migrate-incoming",
+          "{\"event\": \"MIGRATION\", \"data\": {\"status\": \"completed\"}}\n"}});
+
+    const auto desc = description_with_image_in_instance_dir();
+    mpt::make_file_with_content(suspend_state_file());
+
+    NiceMock<mpt::MockVMStatusMonitor> mock_monitor;
+    EXPECT_CALL(mock_monitor, retrieve_metadata_for(_))
+        .WillRepeatedly(Return(boost::json::object{
+            {"suspend_state",
+             {{"file", suspend_state_file().toStdString()}, {"multifd_channels", 3}}}}));
+
+    mp::QemuVirtualMachineFactory backend{data_dir.path(), az_manager};
+    auto machine = backend.create_virtual_machine(desc, key_provider, mock_monitor);
+    ASSERT_EQ(machine->current_state(), mp::VirtualMachine::State::suspended);
+
+    machine->start();
+    machine->state = mp::VirtualMachine::State::running;
+
+    const auto processes = process_factory->process_list();
+    const auto qemu = std::ranges::find_if(processes, [this](const auto& process_info) {
+        return process_info.command.startsWith(expected_qemu_system_prefix());
+    });
+    ASSERT_NE(qemu, processes.cend());
+    EXPECT_THAT(qemu->arguments, AllOf(Contains("-incoming"), Not(Contains("-loadvm"))));
+
+    // The guest was saved stopped, so it needs to be let run once restored
+    const auto names = executed(commands);
+    ASSERT_GE(names.size(), 3u);
+    EXPECT_EQ(names.back(), "cont");
+    ASSERT_EQ(names[names.size() - 2], "migrate-incoming");
+    const auto& incoming = commands[commands.size() - 2];
+    EXPECT_EQ(value_to<std::string>(incoming.at("arguments").at("uri")),
+              "file:" + suspend_state_file().toStdString());
+    EXPECT_THAT(serialize(commands[commands.size() - 3]), HasSubstr("\"multifd-channels\":3"));
+}
+
+TEST_F(QemuBackend, forceShutdownDeletesSuspendStateFile)
+{
+    EXPECT_CALL(*mock_qemu_platform_factory, make_qemu_platform(_, _)).WillOnce([this](auto&&...) {
+        return std::move(mock_qemu_platform);
+    });
+
+    const auto desc = description_with_image_in_instance_dir();
+    mpt::make_file_with_content(suspend_state_file());
+
+    NiceMock<mpt::MockVMStatusMonitor> mock_monitor;
+    EXPECT_CALL(mock_monitor, retrieve_metadata_for(_))
+        .WillRepeatedly(Return(boost::json::object{
+            {"machine_type", "k0mPuT0R"},
+            {"suspend_state", {{"file", suspend_state_file().toStdString()}}}}));
+    EXPECT_CALL(mock_monitor,
+                update_metadata_for(_, Eq(boost::json::object{{"machine_type", "k0mPuT0R"}})));
+
+    mp::QemuVirtualMachineFactory backend{data_dir.path(), az_manager};
+    const auto machine = backend.create_virtual_machine(desc, key_provider, mock_monitor);
+    ASSERT_EQ(machine->current_state(), mp::VirtualMachine::State::suspended);
+
+    machine->shutdown(mp::VirtualMachine::ShutdownPolicy::Poweroff);
+
+    EXPECT_EQ(machine->current_state(), mp::VirtualMachine::State::off);
+    EXPECT_FALSE(QFile::exists(suspend_state_file()));
+}
+
+TEST_F(QemuBackend, listsImageSnapshotsOnlyOnce)
+{
+    EXPECT_CALL(*mock_qemu_platform_factory, make_qemu_platform(_, _)).WillOnce([this](auto&&...) {
+        return std::move(mock_qemu_platform);
+    });
+
+    process_factory->register_callback([](mpt::MockProcess* process) {
+        if (process->program().contains("qemu-img") && process->arguments().contains("-l"))
+            ON_CALL(*process, read_all_standard_output())
+                .WillByDefault(Return("Snapshot list:\n"
+                                      "ID        TAG               VM SIZE                DATE\n"
+                                      "1         @s1                   0 B 2024-06-11 23:22:59\n"
+                                      "2         suspend               0 B 2024-06-11 23:23:59\n"));
+    });
+
+    mp::QemuVirtualMachineFactory backend{data_dir.path(), az_manager};
+    const auto machine =
+        backend.create_virtual_machine(default_description, key_provider, stub_monitor);
+    auto& qemu_machine = dynamic_cast<mp::QemuVirtualMachine&>(*machine);
+
+    const auto count_lists = [this] {
+        return std::ranges::count_if(process_factory->process_list(), [](const auto& process) {
+            return process.arguments.contains("-l");
+        });
+    };
+    const auto lists_before = count_lists();
+
+    EXPECT_TRUE(qemu_machine.image_has_snapshot("@s1"));
+    EXPECT_FALSE(qemu_machine.image_has_snapshot("@s2"));
+    EXPECT_FALSE(qemu_machine.image_has_snapshot("suspend"));
+
+    qemu_machine.capture_image_snapshot("@s2");
+    EXPECT_TRUE(qemu_machine.image_has_snapshot("@s2"));
+
+    qemu_machine.delete_image_snapshot("@s1");
+    EXPECT_FALSE(qemu_machine.image_has_snapshot("@s1"));
+
+    EXPECT_EQ(count_lists(), lists_before + 1);
+}
+
+TEST_F(QemuBackend, snapshotsRunningInstancesOverQmp)
+{
+    EXPECT_CALL(*mock_qemu_platform_factory, make_qemu_platform(_, _)).WillOnce([this](auto&&...) {
+        return std::move(mock_qemu_platform);
+    });
+
+    const auto query_block_reply = boost::json::parse(R"({"return": [{"device": "hda",
+        "inserted": {"image": {"snapshots": [{"name": "@s1"}]}}}]})")
+                                       .as_object();
+
+    std::vector<boost::json::object> commands;
+    process_factory->register_callback([&commands, &query_block_reply](mpt::MockProcess* process) {
+        if (process->program().contains("qemu-system") &&
+            !process->arguments().contains("-dump-vmstate"))
+            reply_to_qmp_commands(process, commands, {{"query-block", query_block_reply}});
+    });
+
+    mp::QemuVirtualMachineFactory backend{data_dir.path(), az_manager};
+    const auto machine =
+        backend.create_virtual_machine(default_description, key_provider, stub_monitor);
+    auto& qemu_machine = dynamic_cast<mp::QemuVirtualMachine&>(*machine);
+
+    machine->start();
+    machine->state = mp::VirtualMachine::State::running;
+
+    const auto image_processes = [this] {
+        return std::ranges::count_if(process_factory->process_list(), [](const auto& process) {
+            return process.command.contains("qemu-img");
+        });
+    };
+    const auto image_processes_before = image_processes();
+
+    EXPECT_TRUE(qemu_machine.image_has_snapshot("@s1"));
+    qemu_machine.capture_image_snapshot("@s2");
+    qemu_machine.delete_image_snapshot("@s1");
+    EXPECT_FALSE(qemu_machine.image_has_snapshot("@s1"));
+
+    EXPECT_EQ(image_processes(), image_processes_before);
+    EXPECT_THAT(executed(commands),
+                IsSupersetOf({"query-block",
+                              "blockdev-snapshot-internal-sync",
+                              "blockdev-snapshot-delete-internal-sync"}));
+
+    const auto& capture = *std::ranges::find_if(commands, [](const auto& command) {
+        return command.at("execute") == "blockdev-snapshot-internal-sync";
+    });
+    EXPECT_EQ(capture.at("arguments"), (boost::json::object{{"device", "hda"}, {"name", "@s2"}}));
+}
+
+TEST_F(QemuBackend, liveSnapshotThrowsOnQmpError)
+{
+    EXPECT_CALL(*mock_qemu_platform_factory, make_qemu_platform(_, _)).WillOnce([this](auto&&...) {
+        return std::move(mock_qemu_platform);
+    });
+
+    const auto error_reply = boost::json::parse(R"({"error": {"class": "GenericError",
+        "desc": "Device 'hda' is writable but does not support snapshots"}})")
+                                 .as_object();
+    const auto query_block_reply = boost::json::parse(R"({"return": []})").as_object();
+
+    std::vector<boost::json::object> commands;
+    process_factory->register_callback([&](mpt::MockProcess* process) {
+        if (process->program().contains("qemu-system") &&
+            !process->arguments().contains("-dump-vmstate"))
+            reply_to_qmp_commands(process,
+                                  commands,
+                                  {{"query-block", query_block_reply},
+                                   {"blockdev-snapshot-internal-sync", error_reply}});
+    });
+
+    mp::QemuVirtualMachineFactory backend{data_dir.path(), az_manager};
+    const auto machine =
+        backend.create_virtual_machine(default_description, key_provider, stub_monitor);
+    auto& qemu_machine = dynamic_cast<mp::QemuVirtualMachine&>(*machine);
+
+    machine->start();
+    machine->state = mp::VirtualMachine::State::running;
+
+    MP_EXPECT_THROW_THAT(qemu_machine.capture_image_snapshot("@s1"),
+                         std::runtime_error,
+                         mpt::match_what(HasSubstr("does not support snapshots")));
+    EXPECT_FALSE(qemu_machine.image_has_snapshot("@s1"));
+}
+
 TEST_F(QemuBackend, QMPErrorGetsLogged)
 {
     EXPECT_CALL(*mock_qemu_platform_factory, make_qemu_platform(_, _)).WillOnce([this](auto&&...) {
@@ -1314,7 +1727,7 @@ TEST_F(QemuBackend, addNetworkInterface)
     });
 
     const auto [mock_cloud_init_file_ops, _] = mpt::MockCloudInitFileOps::inject();
-    EXPECT_CALL(*mock_cloud_init_file_ops, add_extra_interface_to_cloud_init).Times(1);
+    EXPECT_CALL(*mock_cloud_init_file_ops, update_cloud_init).Times(1);
 
     mp::QemuVirtualMachineFactory backend{data_dir.path(), az_manager};
 
@@ -1397,7 +1810,7 @@ TEST_F(QemuBackend, cloneCopiesRelevantFiles)
     mp::QemuVirtualMachineFactory backend{data_dir.path(), az_manager};
     const mpt::MockCloudInitFileOps::GuardedMock mock_cloud_init_file_ops_injection =
         mpt::MockCloudInitFileOps::inject<NiceMock>();
-    EXPECT_CALL(*mock_cloud_init_file_ops_injection.first, update_identifiers(_, _, _, _)).Times(1);
+    EXPECT_CALL(*mock_cloud_init_file_ops_injection.first, update_cloud_init(_, _)).Times(1);
 
     const QString instance_sub_dir = "vault/instances/";
     namespace fs = std::filesystem;
@@ -1431,7 +1844,8 @@ TEST_F(QemuBackend, cloneCopiesRelevantFiles)
                                       dest_vm_name,
                                       {},
                                       key_provider,
-                                      stub_monitor));
+                                      stub_monitor,
+                                      {}));
 
     std::unordered_set<std::string> actual_files;
     for (const auto& file : fs::directory_iterator(dest_vm_dir))
@@ -59,6 +59,15 @@ struct PublicQemuSnapshot : public mp::QemuSnapshot
     // clang-format on
 };
 
+struct MockQemuVM : public mpt::MockVirtualMachineT<mp::QemuVirtualMachine>
+{
+    using mpt::MockVirtualMachineT<mp::QemuVirtualMachine>::MockVirtualMachineT;
+
+    MOCK_METHOD(bool, image_has_snapshot, (const std::string&), (override));
+    MOCK_METHOD(void, capture_image_snapshot, (const std::string&), (override));
+    MOCK_METHOD(void, delete_image_snapshot, (const std::string&), (override));
+};
+
 struct TestQemuSnapshot : public Test
 {
     using ArgsMatcher = Matcher<QStringList>;
@@ -88,12 +97,6 @@ struct TestQemuSnapshot : public Test
         EXPECT_CALL(*process, execute).WillOnce(Return(success));
     }
 
-    static void set_tag_output(mpt::MockProcess* process, std::string tag)
-    {
-        EXPECT_CALL(*process, read_all_standard_output)
-            .WillOnce(Return(QByteArray::fromStdString(tag + ' ')));
-    }
-
     mp::VirtualMachineDescription desc = [] {
         mp::VirtualMachineDescription ret{};
         ret.image.image_path = "raniunotuiroleh";
@@ -102,9 +105,7 @@ struct TestQemuSnapshot : public Test
 
     mpt::StubSSHKeyProvider key_provider{};
     mpt::StubAvailabilityZone zone{};
-    NiceMock<mpt::MockVirtualMachineT<mp::QemuVirtualMachine>> vm{"qemu-vm", key_provider, zone};
-    ArgsMatcher list_args_matcher =
-        ElementsAre("snapshot", "-l", QString::fromStdString(desc.image.image_path));
+    NiceMock<MockQemuVM> vm{"qemu-vm", key_provider, zone};
     const mpt::MockCloudInitFileOps::GuardedMock mock_cloud_init_file_ops_injection =
         mpt::MockCloudInitFileOps::inject<NiceMock>();
 
@@ -203,25 +204,11 @@ TEST_F(TestQemuSnapshot, capturesSnapshot)
     auto snapshot_tag = derive_tag(snapshot_index);
     EXPECT_CALL(vm, get_snapshot_count).WillOnce(Return(snapshot_index - 1));
 
-    auto proc_count = 0;
-
-    ArgsMatcher capture_args_matcher{ElementsAre("snapshot",
-                                                 "-c",
-                                                 QString::fromStdString(snapshot_tag),
-                                                 QString::fromStdString(desc.image.image_path))};
-
-    auto mock_factory_scope = mpt::MockProcessFactory::Inject();
-    mock_factory_scope->register_callback([&](mpt::MockProcess* process) {
-        ASSERT_LE(++proc_count, 2);
-
-        set_common_expectations_on(process);
-
-        const auto& args_matcher = proc_count == 1 ? list_args_matcher : capture_args_matcher;
-        EXPECT_THAT(process->arguments(), args_matcher);
-    });
+    InSequence seq;
+    EXPECT_CALL(vm, image_has_snapshot(snapshot_tag)).WillOnce(Return(false));
+    EXPECT_CALL(vm, capture_image_snapshot(snapshot_tag));
 
     quick_snapshot().capture();
-    EXPECT_EQ(proc_count, 2);
 }
 
 TEST_F(TestQemuSnapshot, captureThrowsOnRepeatedTag)
@@ -230,16 +217,8 @@ TEST_F(TestQemuSnapshot, captureThrowsOnRepeatedTag)
     auto snapshot_tag = derive_tag(snapshot_index);
     EXPECT_CALL(vm, get_snapshot_count).WillOnce(Return(snapshot_index - 1));
 
-    auto proc_count = 0;
-    auto mock_factory_scope = mpt::MockProcessFactory::Inject();
-    mock_factory_scope->register_callback([&](mpt::MockProcess* process) {
-        ASSERT_EQ(++proc_count, 1);
-
-        set_common_expectations_on(process);
-
-        EXPECT_THAT(process->arguments(), list_args_matcher);
-        set_tag_output(process, snapshot_tag);
-    });
+    EXPECT_CALL(vm, image_has_snapshot(snapshot_tag)).WillOnce(Return(true));
+    EXPECT_CALL(vm, capture_image_snapshot).Times(0);
 
     MP_EXPECT_THROW_THAT(quick_snapshot("whatever").capture(),
                          std::runtime_error,
@@ -251,47 +230,21 @@ TEST_F(TestQemuSnapshot, captureThrowsOnRepeatedTag)
 TEST_F(TestQemuSnapshot, erasesSnapshot)
 {
     auto snapshot = loaded_snapshot();
-    auto proc_count = 0;
+    auto tag = derive_tag(snapshot.get_index());
 
-    auto mock_factory_scope = mpt::MockProcessFactory::Inject();
-    mock_factory_scope->register_callback([&](mpt::MockProcess* process) {
-        ASSERT_LE(++proc_count, 2);
-
-        set_common_expectations_on(process);
-
-        auto tag = derive_tag(snapshot.get_index());
-        if (proc_count == 1)
-        {
-            EXPECT_THAT(process->arguments(), list_args_matcher);
-            set_tag_output(process, tag);
-        }
-        else
-        {
-            EXPECT_THAT(process->arguments(),
-                        ElementsAre("snapshot",
-                                    "-d",
-                                    QString::fromStdString(tag),
-                                    QString::fromStdString(desc.image.image_path)));
-        }
-    });
+    InSequence seq;
+    EXPECT_CALL(vm, image_has_snapshot(tag)).WillOnce(Return(true));
+    EXPECT_CALL(vm, delete_image_snapshot(tag));
 
     snapshot.erase();
-    EXPECT_EQ(proc_count, 2);
 }
 
 TEST_F(TestQemuSnapshot, eraseLogsOnMissingTag)
 {
     auto snapshot = loaded_snapshot();
-    auto proc_count = 0;
 
-    auto mock_factory_scope = mpt::MockProcessFactory::Inject();
-    mock_factory_scope->register_callback([&](mpt::MockProcess* process) {
-        ASSERT_EQ(++proc_count, 1);
-
-        set_common_expectations_on(process);
-        EXPECT_THAT(process->arguments(), list_args_matcher);
-        set_tag_output(process, "some-tag-other-than-the-one-we-are-looking-for");
-    });
+    EXPECT_CALL(vm, image_has_snapshot).WillOnce(Return(false));
+    EXPECT_CALL(vm, delete_image_snapshot).Times(0);
 
     auto expected_log_level = mpl::Level::warning;
     auto logger_scope = mpt::MockLogger::inject(expected_log_level);
@@ -119,6 +119,26 @@ TEST_F(TestQemuVMProcessSpec, resumeArgumentsTakenFromResumedata)
                   << mount_args.begin()->second.second);
 }
 
+TEST_F(TestQemuVMProcessSpec, resumeFromStateFileDefersIncomingMigration)
+{
+    const mp::QemuVMProcessSpec::ResumeData resume_data{"suspend_tag",
+                                                        "machine_type",
+                                                        {"-one"},
+                                                        "/path/to/suspend.state"};
+
+    mp::QemuVMProcessSpec spec(desc, platform_args, mount_args, resume_data);
+
+    EXPECT_EQ(spec.arguments(),
+              QStringList({"-L",
+                           spec.firmware_path(),
+                           "-one",
+                           "-incoming",
+                           "defer",
+                           "-machine",
+                           "machine_type"})
+                  << mount_args.begin()->second.second);
+}
+
 TEST_F(TestQemuVMProcessSpec, resumeWithMissingMachineTypeGuessesCorrectly)
 {
     mp::QemuVMProcessSpec::ResumeData resume_data_missing_machine_info;
@@ -175,6 +195,15 @@ TEST_F(TestQemuVMProcessSpec, apparmorProfileIncludesDiskImages)
     EXPECT_THAT(spec.apparmor_profile().toStdString(), HasSubstr("/path/to/cloud_init.iso rk,"));
 }
 
+TEST_F(TestQemuVMProcessSpec, apparmorProfileIncludesSuspendStateFile)
+{
+    mp::QemuVMProcessSpec spec(desc, platform_args, mount_args, std::nullopt);
+
+    EXPECT_EQ(mp::QemuVMProcessSpec::suspend_state_file(desc), "/path/to/suspend.state");
+    EXPECT_THAT(spec.apparmor_profile().toStdString(),
+                HasSubstr("/path/to/suspend.state{,.part} rw,"));
+}
+
 TEST_F(TestQemuVMProcessSpec, apparmorProfileIdentifier)
 {
     mp::QemuVMProcessSpec spec(desc, platform_args, mount_args, std::nullopt);
@@ -42,14 +42,14 @@ struct SftpServerTest : public testing::Test
         reply_status.returnValue(SSH_OK);
         get_client_msg.returnValue(nullptr);
         handle_sftp.returnValue(nullptr);
-        reply_version.returnValue(SSH_OK);
+        packet_write.returnValue(SSH_OK);
     }
 
     decltype(MOCK(sftp_reply_status)) reply_status{MOCK(sftp_reply_status)};
     decltype(MOCK(sftp_get_client_message)) get_client_msg{MOCK(sftp_get_client_message)};
     decltype(MOCK(sftp_client_message_free)) msg_free{MOCK(sftp_client_message_free)};
     decltype(MOCK(sftp_handle)) handle_sftp{MOCK(sftp_handle)};
-    decltype(MOCK(sftp_reply_version)) reply_version{MOCK(sftp_reply_version)};
+    decltype(MOCK(sftp_packet_write)) packet_write{MOCK(sftp_packet_write)};
     MockScope<decltype(mock_sftp_server_new)> sftp_server_new;
     MockScope<decltype(mock_sftp_server_free)> free_server_sftp;
 
@@ -60,6 +60,11 @@ struct StubVMImageHost final : public multipass::VMImageHost
     void update_manifests(bool /*force_update*/) override
     {
     }
+
+    std::vector<multipass::RemoteRefreshStatus> refresh_statuses() const override
+    {
+        return {};
+    }
 };
 } // namespace test
 } // namespace multipass
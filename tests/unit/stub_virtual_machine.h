@@ -31,7 +31,7 @@ namespace multipass
 {
 namespace test
 {
-struct StubVirtualMachine final : public VirtualMachine
+struct StubVirtualMachine : public VirtualMachine
 {
     StubVirtualMachine() : StubVirtualMachine{"stub"}
     {
@@ -173,6 +173,11 @@ struct StubVirtualMachine final : public VirtualMachine
         return nullptr;
     }
 
+    bool supports_live_snapshots() const override
+    {
+        return false;
+    }
+
     std::shared_ptr<const Snapshot> take_snapshot(const VMSpecs&,
                                                   const std::string&,
                                                   const std::string&) override
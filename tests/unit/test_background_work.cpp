@@ -0,0 +1,117 @@
+/*
+ * Copyright (C) Canonical, Ltd.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#include "common.h"
+
+#include <multipass/background_work.h>
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <thread>
+
+namespace mp = multipass;
+
+using namespace testing;
+
+namespace
+{
+struct BackgroundWork : public Test
+{
+};
+
+TEST_F(BackgroundWork, isCurrentWhileInScope)
+{
+    EXPECT_EQ(mp::BackgroundWork::current(), nullptr);
+    {
+        mp::BackgroundWork work;
+        EXPECT_EQ(mp::BackgroundWork::current(), &work);
+    }
+
+    EXPECT_EQ(mp::BackgroundWork::current(), nullptr);
+}
+
+TEST_F(BackgroundWork, scopesNest)
+{
+    mp::BackgroundWork outer{1000};
+    {
+        mp::BackgroundWork inner{10};
+        EXPECT_EQ(mp::BackgroundWork::current()->bandwidth_limit(), 10u);
+    }
+
+    EXPECT_EQ(mp::BackgroundWork::current(), &outer);
+}
+
+TEST_F(BackgroundWork, carriesOverToOtherThreads)
+{
+    std::function<std::uint64_t()> work;
+    {
+        mp::BackgroundWork scope{1234};
+        work = mp::in_current_background_work([] {
+            const auto current = mp::BackgroundWork::current();
+            return current ? current->bandwidth_limit() : 0;
+        });
+    }
+
+    std::uint64_t limit = 0;
+    std::thread{[&limit, &work] { limit = work(); }}.join();
+
+    EXPECT_EQ(limit, 1234u);
+}
+
+TEST_F(BackgroundWork, doesNotMakeUpWorkOutOfNothing)
+{
+    auto work = mp::in_current_background_work([] { return mp::BackgroundWork::current(); });
+
+    EXPECT_EQ(work(), nullptr);
+}
+
+TEST_F(BackgroundWork, throttlesToBandwidthLimit)
+{
+    mp::BackgroundWork work{100'000};
+
+    const auto start = std::chrono::steady_clock::now();
+    for (auto i = 0; i < 10; ++i)
+        work.throttle(2'000);
+
+    EXPECT_GE(std::chrono::steady_clock::now() - start, std::chrono::milliseconds{200});
+}
+
+TEST_F(BackgroundWork, doesNotThrottleWithoutLimit)
+{
+    mp::BackgroundWork work;
+
+    const auto start = std::chrono::steady_clock::now();
+    work.throttle(1'000'000'000);
+
+    EXPECT_LT(std::chrono::steady_clock::now() - start, std::chrono::seconds{1});
+}
+
+TEST_F(BackgroundWork, stopsThrottlingOncePromoted)
+{
+    auto promotion = std::make_shared<std::atomic_bool>(false);
+    mp::BackgroundWork work{1, promotion};
+    EXPECT_EQ(work.bandwidth_limit(), 1u);
+
+    *promotion = true;
+    EXPECT_EQ(work.bandwidth_limit(), 0u);
+
+    const auto start = std::chrono::steady_clock::now();
+    work.throttle(1'000'000'000);
+
+    EXPECT_LT(std::chrono::steady_clock::now() - start, std::chrono::seconds{1});
+}
+} // namespace
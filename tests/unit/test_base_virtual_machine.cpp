@@ -433,6 +433,30 @@ TEST_F(BaseVM, takesSnapshots)
     EXPECT_EQ(vm.get_num_snapshots(), 1);
 }
 
+TEST_F(BaseVM, takesLiveSnapshotsOfRunningInstancesAsStopped)
+{
+    vm.simulate_state(St::running);
+    EXPECT_CALL(vm, supports_live_snapshots).WillRepeatedly(Return(true));
+
+    mp::VMSpecs specs{};
+    specs.state = St::running;
+    specs.num_cores = 3;
+
+    auto snapshot = std::make_shared<NiceMock<mpt::MockSnapshot>>();
+    EXPECT_CALL(*snapshot, capture).Times(1);
+    EXPECT_CALL(vm,
+                make_specific_snapshot(_,
+                                       _,
+                                       _,
+                                       AllOf(Field(&mp::VMSpecs::state, St::off),
+                                             Field(&mp::VMSpecs::num_cores, 3)),
+                                       _))
+        .WillOnce(Return(snapshot));
+
+    vm.take_snapshot(specs, "s1", "");
+    EXPECT_EQ(vm.get_num_snapshots(), 1);
+}
+
 TEST_F(BaseVM, takeSnasphotThrowsIfSpecificSnapshotNotOverridden)
 {
     StubBaseVirtualMachine stub{zone};
@@ -898,9 +922,7 @@ TEST_F(BaseVM, restoresSnapshotsWithExtraInterfaceDiff)
         .Times(3)
         .WillRepeatedly(Return(original_specs.extra_interfaces));
 
-    EXPECT_CALL(*mock_cloud_init_file_ops_injection.first,
-                update_cloud_init_with_new_extra_interfaces_and_new_id(_, _, _, _))
-        .Times(1);
+    EXPECT_CALL(*mock_cloud_init_file_ops_injection.first, update_cloud_init(_, _)).Times(1);
 
     vm.restore_snapshot(snapshot_name, new_specs);
     EXPECT_EQ(original_specs, new_specs);
@@ -1302,6 +1302,44 @@ TEST_F(Client, launchCmdWithTimer)
     EXPECT_THAT(send_command({"launch", "--timeout", "1"}), Eq(mp::ReturnCode::Ok));
 }
 
+TEST_F(Client, launchCmdTimingsOptionShowsTimings)
+{
+    const auto timings_matcher = Property(&mp::LaunchRequest::timings, IsTrue());
+    mp::LaunchReply reply;
+    reply.set_vm_instance_name("foo");
+    auto* timing = reply.add_timings();
+    timing->set_name("fetch image");
+    timing->set_start_ms(250);
+    timing->set_duration_ms(1500);
+
+    std::stringstream cout_stream;
+    EXPECT_CALL(mock_daemon, launch)
+        .WillOnce(WithArg<1>(
+            check_request_and_return<mp::LaunchReply, mp::LaunchRequest>(timings_matcher,
+                                                                         ok,
+                                                                         reply)));
+
+    EXPECT_THAT(send_command({"launch", "--name", "foo", "--timings"}, cout_stream),
+                Eq(mp::ReturnCode::Ok));
+    EXPECT_THAT(cout_stream.str(), HasSubstr("Step"));
+    EXPECT_THAT(cout_stream.str(), HasSubstr("fetch image"));
+    EXPECT_THAT(cout_stream.str(), HasSubstr("0.250s"));
+    EXPECT_THAT(cout_stream.str(), HasSubstr("1.500s"));
+}
+
+TEST_F(Client, launchCmdWithoutTimingsOptionDoesNotAskForTimings)
+{
+    const auto timings_matcher = Property(&mp::LaunchRequest::timings, IsFalse());
+
+    std::stringstream cout_stream;
+    EXPECT_CALL(mock_daemon, launch)
+        .WillOnce(WithArg<1>(
+            check_request_and_return<mp::LaunchReply, mp::LaunchRequest>(timings_matcher, ok)));
+
+    EXPECT_THAT(send_command({"launch", "--name", "foo"}, cout_stream), Eq(mp::ReturnCode::Ok));
+    EXPECT_THAT(cout_stream.str(), Not(HasSubstr("Step")));
+}
+
 TEST_F(Client, launchCmdCloudinitOptionWithValidFileIsOk)
 {
     QTemporaryFile tmpfile; // file is auto-deleted when this goes out of scope
@@ -2132,6 +2170,99 @@ TEST_F(Client, listCmdFailsWithIpv4AndSnapshots)
                 Eq(mp::ReturnCode::CommandLineError));
 }
 
+TEST_F(Client, listCmdSendsFilters)
+{
+    const auto list_matcher =
+        AllOf(Property(&mp::ListRequest::name_pattern, StrEq("web-*")),
+              Property(&mp::ListRequest::states,
+                       ElementsAre(mp::InstanceStatus::RUNNING,
+                                   mp::InstanceStatus::DELAYED_SHUTDOWN)));
+    mp::ListReply reply;
+    reply.mutable_instance_list();
+
+    EXPECT_CALL(mock_daemon, list)
+        .WillOnce(WithArg<1>(
+            check_request_and_return<mp::ListReply, mp::ListRequest>(list_matcher, ok, reply)));
+    EXPECT_THAT(
+        send_command(
+            {"list", "--name", "web-*", "--state", "running", "--state", "delayed-shutdown"}),
+        Eq(mp::ReturnCode::Ok));
+}
+
+TEST_F(Client, listCmdFailsWithInvalidState)
+{
+    EXPECT_THAT(send_command({"list", "--state", "sleepy"}), Eq(mp::ReturnCode::CommandLineError));
+}
+
+TEST_F(Client, listCmdMergesPagesIntoOneTable)
+{
+    std::stringstream cout_stream;
+
+    EXPECT_CALL(mock_daemon, list)
+        .WillOnce([](auto, grpc::ServerReaderWriter<mp::ListReply, mp::ListRequest>* server) {
+            mp::ListRequest request;
+            server->Read(&request);
+            EXPECT_GT(request.page_size(), 0u);
+
+            for (const auto* name : {"foo", "bar"})
+            {
+                mp::ListReply page;
+                page.mutable_instance_list()->add_instances()->set_name(name);
+                server->Write(page);
+            }
+
+            mp::ListReply last_page;
+            last_page.mutable_instance_list();
+            server->Write(last_page);
+
+            return grpc::Status{};
+        });
+
+    EXPECT_THAT(send_command({"list"}, cout_stream), Eq(mp::ReturnCode::Ok));
+    const auto output = cout_stream.str();
+    EXPECT_THAT(output, AllOf(StartsWith("Name"), HasSubstr("foo"), Not(HasSubstr("No "))));
+    EXPECT_LT(output.find("bar"), output.find("foo"));
+    EXPECT_EQ(output.find("Name", 1), std::string::npos);
+}
+
+TEST_F(Client, listCmdPrintsTablePagesAsTheyComeToATerminal)
+{
+    std::ostringstream cout, cerr;
+    std::istringstream cin;
+    NiceMock<mpt::MockTerminal> mock_terminal;
+    ON_CALL(mock_terminal, cout).WillByDefault(ReturnRef(cout));
+    ON_CALL(mock_terminal, cerr).WillByDefault(ReturnRef(cerr));
+    ON_CALL(mock_terminal, cin).WillByDefault(ReturnRef(cin));
+    ON_CALL(mock_terminal, cout_is_live).WillByDefault(Return(true));
+
+    EXPECT_CALL(mock_daemon, list)
+        .WillOnce([](auto, grpc::ServerReaderWriter<mp::ListReply, mp::ListRequest>* server) {
+            mp::ListRequest request;
+            server->Read(&request);
+
+            for (const auto* name : {"foo", "bar"})
+            {
+                mp::ListReply page;
+                page.mutable_instance_list()->add_instances()->set_name(name);
+                server->Write(page);
+            }
+
+            mp::ListReply last_page;
+            last_page.mutable_instance_list();
+            server->Write(last_page);
+
+            return grpc::Status{};
+        });
+
+    EXPECT_EQ(setup_client_and_run({"list"}, mock_terminal), mp::ReturnCode::Ok);
+
+    // Rows come in the order of their pages, under the one header
+    const auto output = cout.str();
+    EXPECT_THAT(output, AllOf(StartsWith("Name"), HasSubstr("bar"), Not(HasSubstr("No "))));
+    EXPECT_LT(output.find("foo"), output.find("bar"));
+    EXPECT_EQ(output.find("Name", 1), std::string::npos);
+}
+
 // mount cli tests
 // Note: mpt::test_data_path() returns an absolute path
 TEST_F(Client, mountCmdGoodAbsoluteSourcePath)
@@ -3742,6 +3873,31 @@ TEST_F(Client, cloneCmdWithDestName)
     EXPECT_EQ(send_command({"clone", "vm1", "--name", "vm2"}), mp::ReturnCode::Ok);
 }
 
+TEST_F(Client, cloneCmdPrintsProgressOnOneLineAndLogLinesToCerr)
+{
+    EXPECT_CALL(mock_daemon, clone)
+        .WillOnce([](auto, grpc::ServerReaderWriter<mp::CloneReply, mp::CloneRequest>* server) {
+            mp::CloneReply reply;
+            reply.set_log_line("copying slowly");
+            server->Write(reply);
+
+            for (auto percent : {50, 100})
+            {
+                mp::CloneReply progress;
+                progress.set_percent_copied(percent);
+                server->Write(progress);
+            }
+
+            return grpc::Status{};
+        });
+
+    std::stringstream cout_stream, cerr_stream;
+    EXPECT_EQ(send_command({"clone", "vm1"}, cout_stream, cerr_stream), mp::ReturnCode::Ok);
+    EXPECT_THAT(cout_stream.str(), HasSubstr("\rCopying disks: 50%"));
+    EXPECT_THAT(cout_stream.str(), HasSubstr("\rCopying disks: 100%\n"));
+    EXPECT_THAT(cerr_stream.str(), HasSubstr("copying slowly"));
+}
+
 TEST_F(Client, cloneCmdFailedFromDaemon)
 {
     const grpc::Status clone_failure{grpc::StatusCode::FAILED_PRECONDITION, "dummy_msg"};
@@ -22,6 +22,9 @@
 #include <multipass/cloud_init_iso.h>
 #include <multipass/network_interface.h>
 
+#include <fstream>
+#include <string_view>
+
 namespace mp = multipass;
 namespace mpt = multipass::test;
 using namespace testing;
@@ -60,13 +63,18 @@ auto read_returns_failed_ifstream =
     return file;
 };
 
-// Since we can have a valid file to read from and FileOps::read is a cheap function, falls back to
-// the original implementation would be an easy way to implement EXPECT_CALL multiple times instead
-// of mocking multiple single calls with the correct output
-auto original_implementation_of_read =
-    [](std::ifstream& file, char* buffer, std::streamsize pos) -> std::ifstream& {
-    return MP_FILEOPS.FileOps::read(file, buffer, pos);
-};
+// 16 reserved blocks, then the primary volume descriptor
+constexpr std::streamoff joliet_descriptor_pos = 16 * 2048 + 2048;
+// Past the descriptors, path tables and ISO9660 records come the Joliet records, starting with the
+// 34-byte root and root parent ones
+constexpr std::streamoff first_joliet_file_record_pos = 22 * 2048 + 2 * 34;
+
+void overwrite_at(const std::filesystem::path& path, std::streamoff pos, std::string_view bytes)
+{
+    std::fstream file{path, std::ios::in | std::ios::out | std::ios::binary};
+    file.seekp(pos);
+    file.write(bytes.data(), bytes.size());
+}
 } // namespace
 
 struct CloudInitIso : public Test
@@ -161,7 +169,7 @@ TEST_F(CloudInitIso, readsIsoFileFailedToOpenFile)
                          mpt::match_what(HasSubstr("Failed to open file")));
 }
 
-TEST_F(CloudInitIso, readsIsoFileFailedToReadSingleBytes)
+TEST_F(CloudInitIso, readsIsoFileFailedToRead)
 {
     mp::CloudInitIso original_iso;
     original_iso.write_to(iso_path);
@@ -169,180 +177,85 @@ TEST_F(CloudInitIso, readsIsoFileFailedToReadSingleBytes)
     const auto [mock_file_ops, _] = mpt::MockFileOps::inject();
     EXPECT_CALL(*mock_file_ops, is_open(A<const std::ifstream&>())).WillOnce(Return(true));
 
+    // the whole file is read at once
     EXPECT_CALL(*mock_file_ops, read(An<std::ifstream&>(), A<char*>(), A<std::streamsize>()))
         .WillOnce(read_returns_failed_ifstream);
 
-    // failed on the first read_single_byte call
     mp::CloudInitIso new_iso;
-    MP_EXPECT_THROW_THAT(
-        new_iso.read_from(iso_path),
-        std::runtime_error,
-        mpt::match_what(HasSubstr("Can not read the next byte data from file at")));
+    MP_EXPECT_THROW_THAT(new_iso.read_from(iso_path),
+                         std::runtime_error,
+                         mpt::match_what(HasSubstr("bytes data from file")));
 }
 
 TEST_F(CloudInitIso, readsIsoFileFailedToCheckItHasJolietVolumeDescriptor)
 {
     mp::CloudInitIso original_iso;
     original_iso.write_to(iso_path);
-
-    const auto [mock_file_ops, _] = mpt::MockFileOps::inject();
-    EXPECT_CALL(*mock_file_ops, is_open(A<const std::ifstream&>())).WillOnce(Return(true));
-
-    // value 2_u8 is for Joliet volume descriptor
-    auto read_returns_one_byte_value_one =
-        [](std::ifstream& file, char* one_byte, std::streamsize) -> std::ifstream& {
-        const int non_joliet_volume_des_num{1U};
-        *one_byte = static_cast<std::uint8_t>(non_joliet_volume_des_num);
-        return file;
-    };
-    EXPECT_CALL(*mock_file_ops, read(An<std::ifstream&>(), A<char*>(), A<std::streamsize>()))
-        .WillOnce(read_returns_one_byte_value_one);
+    overwrite_at(iso_path, joliet_descriptor_pos, "\x01");
 
     mp::CloudInitIso new_iso;
-    MP_EXPECT_THROW_THAT(new_iso.read_from(iso_path),
-                         std::runtime_error,
-                         mpt::match_what(StrEq("The Joliet volume descriptor is not in place.")));
+    MP_EXPECT_THROW_THAT(
+        new_iso.read_from(iso_path),
+        std::runtime_error,
+        mpt::match_what(HasSubstr("The Joliet volume descriptor is not in place.")));
 }
 
 TEST_F(CloudInitIso, readsIsoFileJolietVolumeDescriptorMalformed)
 {
     mp::CloudInitIso original_iso;
     original_iso.write_to(iso_path);
-
-    const auto [mock_file_ops, _] = mpt::MockFileOps::inject();
-    EXPECT_CALL(*mock_file_ops, is_open(A<const std::ifstream&>())).WillOnce(Return(true));
-
-    const InSequence seq;
-    EXPECT_CALL(*mock_file_ops, read(An<std::ifstream&>(), A<char*>(), A<std::streamsize>()))
-        .WillOnce(original_implementation_of_read);
-
-    auto read_returns_five_bytes_string =
-        [](std::ifstream& file, char* buffer, std::streamsize size) -> std::ifstream& {
-        if (size != 5)
-        {
-            throw std::invalid_argument{"Size must be 5."};
-        }
-
-        if (nullptr == buffer)
-        {
-            throw std::invalid_argument{"Buffer must not be null!"};
-        }
-
-        constexpr char buf[] = {'N', 'o', 'n', 'J', 'o'};
-        std::memcpy(buffer, buf, size);
-        return file;
-    };
-    EXPECT_CALL(*mock_file_ops, read(An<std::ifstream&>(), A<char*>(), A<std::streamsize>()))
-        .WillOnce(read_returns_five_bytes_string);
+    overwrite_at(iso_path, joliet_descriptor_pos + 1, "NOTCD");
 
     mp::CloudInitIso new_iso;
     MP_EXPECT_THROW_THAT(new_iso.read_from(iso_path),
                          std::runtime_error,
-                         mpt::match_what(StrEq("The Joliet descriptor is malformed.")));
+                         mpt::match_what(HasSubstr("The Joliet descriptor is malformed.")));
 }
 
-TEST_F(CloudInitIso, readsIsoFileFailedToReadArray)
+TEST_F(CloudInitIso, readsIsoFileFailedToCheckRootDirRecordData)
 {
     mp::CloudInitIso original_iso;
     original_iso.write_to(iso_path);
-
-    const auto [mock_file_ops, _] = mpt::MockFileOps::inject();
-    EXPECT_CALL(*mock_file_ops, is_open(A<const std::ifstream&>())).WillOnce(Return(true));
-
-    const InSequence seq;
-    EXPECT_CALL(*mock_file_ops, read(An<std::ifstream&>(), A<char*>(), A<std::streamsize>()))
-        .WillOnce(original_implementation_of_read);
-
-    EXPECT_CALL(*mock_file_ops, read(An<std::ifstream&>(), A<char*>(), A<std::streamsize>()))
-        .WillOnce(read_returns_failed_ifstream);
+    overwrite_at(iso_path, joliet_descriptor_pos + 156, "\x21");
 
     mp::CloudInitIso new_iso;
-    MP_EXPECT_THROW_THAT(new_iso.read_from(iso_path),
-                         std::runtime_error,
-                         mpt::match_what(HasSubstr("bytes data from file at")));
+    MP_EXPECT_THROW_THAT(
+        new_iso.read_from(iso_path),
+        std::runtime_error,
+        mpt::match_what(HasSubstr("The root directory record data is malformed.")));
 }
 
-TEST_F(CloudInitIso, readsIsoFileFailedToCheckRootDirRecordData)
+TEST_F(CloudInitIso, readsIsoFileTruncatedBeforeDescriptors)
 {
     mp::CloudInitIso original_iso;
     original_iso.write_to(iso_path);
-
-    const auto [mock_file_ops, _] = mpt::MockFileOps::inject();
-    EXPECT_CALL(*mock_file_ops, is_open(A<const std::ifstream&>())).WillOnce(Return(true));
-
-    const InSequence seq;
-    EXPECT_CALL(*mock_file_ops, read(An<std::ifstream&>(), A<char*>(), A<std::streamsize>()))
-        .Times(2)
-        .WillRepeatedly(original_implementation_of_read);
-
-    // default buffer values makes the buffer[0] not 34_u8 which causes root directory record data
-    // checking fail
-    auto read_return_default_buffer = [](std::ifstream& file,
-                                         char* /*buffer*/,
-                                         std::streamsize) -> std::ifstream& { return file; };
-
-    EXPECT_CALL(*mock_file_ops, read(An<std::ifstream&>(), A<char*>(), A<std::streamsize>()))
-        .WillOnce(read_return_default_buffer);
+    std::filesystem::resize_file(iso_path, joliet_descriptor_pos + 3);
 
     mp::CloudInitIso new_iso;
     MP_EXPECT_THROW_THAT(new_iso.read_from(iso_path),
                          std::runtime_error,
-                         mpt::match_what(StrEq("The root directory record data is malformed.")));
+                         mpt::match_what(HasSubstr("bytes data from the image at")));
 }
 
-TEST_F(CloudInitIso, readsIsoFileFailedToReadVec)
+TEST_F(CloudInitIso, readsIsoFileTruncatedBeforeFileData)
 {
     mp::CloudInitIso original_iso;
-    // At least one actual file entry is need to reach the read_bytes_to_vec call
-    original_iso.add_file("test1", "test data1");
+    original_iso.add_file("test", "test data");
     original_iso.write_to(iso_path);
-
-    const auto [mock_file_ops, _] = mpt::MockFileOps::inject();
-    EXPECT_CALL(*mock_file_ops, is_open(A<const std::ifstream&>())).WillOnce(Return(true));
-
-    // The first read_bytes_to_vec call invoke the 7th call of MP_FILEOPS.read
-    const InSequence seq;
-    EXPECT_CALL(*mock_file_ops, read(An<std::ifstream&>(), A<char*>(), A<std::streamsize>()))
-        .Times(6)
-        .WillRepeatedly(original_implementation_of_read);
-
-    EXPECT_CALL(*mock_file_ops, read(An<std::ifstream&>(), A<char*>(), A<std::streamsize>()))
-        .WillOnce(read_returns_failed_ifstream);
+    std::filesystem::resize_file(iso_path, std::filesystem::file_size(iso_path) - 2048);
 
     mp::CloudInitIso new_iso;
     MP_EXPECT_THROW_THAT(new_iso.read_from(iso_path),
                          std::runtime_error,
-                         mpt::match_what(HasSubstr("bytes data from file at")));
+                         mpt::match_what(HasSubstr("bytes data from the image at")));
 }
 
 TEST_F(CloudInitIso, readsIsoFileEncodedFileNameIsNotEvenLength)
 {
     mp::CloudInitIso original_iso;
-    // At least one actual file entry is need to reach the convert_u16_name_back call
-    original_iso.add_file("test1", "test data1");
+    original_iso.add_file("test", "test data");
     original_iso.write_to(iso_path);
-
-    const auto [mock_file_ops, _] = mpt::MockFileOps::inject();
-    EXPECT_CALL(*mock_file_ops, is_open(A<const std::ifstream&>())).WillOnce(Return(true));
-
-    const InSequence seq;
-    EXPECT_CALL(*mock_file_ops, read(An<std::ifstream&>(), A<char*>(), A<std::streamsize>()))
-        .Times(7)
-        .WillRepeatedly(original_implementation_of_read);
-
-    auto read_returns_one_byte_value_three =
-        [](std::ifstream& file, char* one_byte, std::streamsize) -> std::ifstream& {
-        const int encoded_file_name_length{3U}; // any odd number will do it
-        *one_byte = static_cast<std::uint8_t>(encoded_file_name_length);
-        return file;
-    };
-
-    // read_single_byte encoded_file_name_length odd number
-    EXPECT_CALL(*mock_file_ops, read(An<std::ifstream&>(), A<char*>(), A<std::streamsize>()))
-        .WillOnce(read_returns_one_byte_value_three);
-
-    EXPECT_CALL(*mock_file_ops, read(An<std::ifstream&>(), A<char*>(), A<std::streamsize>()))
-        .WillOnce(original_implementation_of_read);
+    overwrite_at(iso_path, first_joliet_file_record_pos + 32, "\x03");
 
     mp::CloudInitIso new_iso;
     MP_EXPECT_THROW_THAT(
@@ -499,3 +412,64 @@ TEST_F(CloudInitIso, getInstanceIdFromCloudInit)
 
     EXPECT_EQ(MP_CLOUD_INIT_FILE_OPS.get_instance_id_from_cloud_init(iso_path), "vm1");
 }
+
+TEST_F(CloudInitIso, writesIsoFileWithoutLeavingTemporaryFile)
+{
+    mp::CloudInitIso iso;
+    iso.add_file("test", "test data");
+    iso.write_to(iso_path);
+    iso.write_to(iso_path);
+
+    EXPECT_EQ(std::filesystem::file_size(iso_path), iso.serialise().size());
+    EXPECT_FALSE(std::filesystem::exists(iso_path.string() + ".tmp"));
+}
+
+TEST_F(CloudInitIso, keepsPreviousIsoWhenNewOneCannotBeSynced)
+{
+    mp::CloudInitIso original_iso;
+    original_iso.add_file("meta-data", default_meta_data_content);
+    original_iso.write_to(iso_path);
+
+    const auto [mock_file_ops, _] = mpt::MockFileOps::inject();
+    // The temporary file is written for real, but cannot be synced
+    EXPECT_CALL(*mock_file_ops, open_fd).WillOnce([ops = mock_file_ops](auto&&... args) {
+        return ops->FileOps::open_fd(args...);
+    });
+    EXPECT_CALL(*mock_file_ops, write(A<int>(), _, _))
+        .WillRepeatedly(
+            [ops = mock_file_ops](auto... args) { return ops->FileOps::write(args...); });
+    EXPECT_CALL(*mock_file_ops, fsync).WillOnce(Return(false));
+
+    mp::CloudInitIso new_iso;
+    new_iso.add_file("meta-data", "instance-id: vm2\n");
+    MP_EXPECT_THROW_THAT(new_iso.write_to(iso_path),
+                         std::runtime_error,
+                         mpt::match_what(HasSubstr("Failed to write cloud-init ISO")));
+
+    EXPECT_FALSE(std::filesystem::exists(iso_path.string() + ".tmp"));
+    EXPECT_EQ(std::filesystem::file_size(iso_path), original_iso.serialise().size());
+}
+
+TEST_F(CloudInitIso, updateCloudInitAppliesAllChangesInOnePass)
+{
+    mp::CloudInitIso original_iso;
+    original_iso.add_file("meta-data", default_meta_data_content);
+    original_iso.add_file("network-config", "dummy_data");
+    original_iso.write_to(iso_path);
+
+    const std::string default_mac_addr = "52:54:00:56:78:90";
+    const std::vector<mp::NetworkInterface> extra_interfaces = {{"id", "52:54:00:56:78:91", true}};
+    MP_CLOUD_INIT_FILE_OPS.update_cloud_init(iso_path, [&](mp::CloudInitIso& iso) {
+        iso.set_extra_interfaces_and_instance_id(default_mac_addr, extra_interfaces, "vm2");
+        iso.add_file("user-data", "#cloud-config\n");
+    });
+
+    mp::CloudInitIso new_iso;
+    new_iso.read_from(iso_path);
+    EXPECT_EQ(new_iso.instance_id(), "vm2");
+    EXPECT_EQ(new_iso.at("user-data"), "#cloud-config\n");
+    EXPECT_EQ(new_iso.at("network-config"),
+              fmt::format(network_config_data_content_template,
+                          "52:54:00:56:78:90",
+                          "52:54:00:56:78:91"));
+}
@@ -56,15 +56,22 @@
 
 #include <scope_guard.hpp>
 
+#include <QCoreApplication>
+#include <QDeadlineTimer>
+#include <QJsonDocument>
+#include <QJsonObject>
 #include <QNetworkProxyFactory>
 #include <QStorageInfo>
 #include <QString>
 #include <QSysInfo>
 
+#include <atomic>
+#include <chrono>
 #include <memory>
 #include <ostream>
 #include <stdexcept>
 #include <string>
+#include <thread>
 #include <variant>
 
 namespace mp = multipass;
@@ -531,6 +538,183 @@ TEST_F(Daemon, callsOnRestartForAlreadyStartingVmsOnConstruction)
     mp::Daemon daemon{config_builder.build()};
 }
 
+TEST_F(Daemon, listsInstancesAsLoadingUntilLoadedInTheBackground)
+{
+    auto mock_factory = use_a_mock_vm_factory();
+    multipass::test::fake_vm_properties vm_props{};
+    vm_props.default_mac = "52:54:00:73:76:28";
+    vm_props.state = multipass::VirtualMachine::State::stopped;
+    const auto [temp_dir, _] = plant_instance_json(fake_json_contents(vm_props));
+    config_builder.data_directory = temp_dir->path();
+    config_builder.vault = std::make_unique<NiceMock<mpt::MockVMImageVault>>();
+    config_builder.load_instances_in_background = true;
+
+    EXPECT_CALL(*mock_factory, create_virtual_machine).WillOnce(WithArg<0>([](const auto& desc) {
+        return std::make_unique<mpt::StubVirtualMachine>(desc.vm_name);
+    }));
+
+    mp::Daemon daemon{config_builder.build()};
+
+    const auto list_instances = [&daemon] {
+        NiceMock<mpt::MockServerReaderWriter<mp::ListReply, mp::ListRequest>> mock_server;
+        mp::ListReply list_reply;
+        EXPECT_CALL(mock_server, Write).WillOnce(DoAll(SaveArg<0>(&list_reply), Return(true)));
+        EXPECT_TRUE(
+            call_daemon_slot(daemon, &mp::Daemon::list, mp::ListRequest{}, mock_server).ok());
+
+        return list_reply.instance_list().instances();
+    };
+    const auto status_is = [](auto status) {
+        return Property(&mp::ListVMInstance::instance_status,
+                        Property(&mp::InstanceStatus::status, status));
+    };
+
+    // Loaded instances only reach the daemon through its event loop
+    EXPECT_THAT(list_instances(),
+                ElementsAre(AllOf(Property(&mp::ListVMInstance::name, vm_props.name),
+                                  status_is(mp::InstanceStatus::LOADING))));
+
+    bool loaded = false;
+    daemon.when_instances_loaded([&loaded] { loaded = true; });
+    EXPECT_FALSE(loaded);
+
+    QDeadlineTimer deadline{std::chrono::seconds{5}};
+    while (!loaded && !deadline.hasExpired())
+        QCoreApplication::processEvents(QEventLoop::AllEvents, 10);
+
+    EXPECT_TRUE(loaded);
+    EXPECT_THAT(list_instances(),
+                ElementsAre(AllOf(Property(&mp::ListVMInstance::name, vm_props.name),
+                                  Not(status_is(mp::InstanceStatus::LOADING)))));
+}
+
+TEST_F(Daemon, listsInstancesThatFailedToLoadAsUnknown)
+{
+    auto mock_factory = use_a_mock_vm_factory();
+    multipass::test::fake_vm_properties vm_props{};
+    vm_props.default_mac = "52:54:00:73:76:28";
+    vm_props.state = multipass::VirtualMachine::State::stopped;
+    const auto [temp_dir, _] = plant_instance_json(fake_json_contents(vm_props));
+    config_builder.data_directory = temp_dir->path();
+    config_builder.vault = std::make_unique<NiceMock<mpt::MockVMImageVault>>();
+    config_builder.load_instances_in_background = true;
+
+    EXPECT_CALL(*mock_factory, create_virtual_machine)
+        .WillOnce(Throw(std::runtime_error{"cannot load"}));
+
+    mp::Daemon daemon{config_builder.build()};
+
+    bool loaded = false;
+    daemon.when_instances_loaded([&loaded] { loaded = true; });
+
+    QDeadlineTimer deadline{std::chrono::seconds{5}};
+    while (!loaded && !deadline.hasExpired())
+        QCoreApplication::processEvents(QEventLoop::AllEvents, 10);
+    ASSERT_TRUE(loaded);
+
+    NiceMock<mpt::MockServerReaderWriter<mp::ListReply, mp::ListRequest>> mock_server;
+    mp::ListReply list_reply;
+    EXPECT_CALL(mock_server, Write).WillOnce(DoAll(SaveArg<0>(&list_reply), Return(true)));
+    EXPECT_TRUE(call_daemon_slot(daemon, &mp::Daemon::list, mp::ListRequest{}, mock_server).ok());
+
+    EXPECT_THAT(list_reply.instance_list().instances(),
+                ElementsAre(AllOf(Property(&mp::ListVMInstance::name, vm_props.name),
+                                  Property(&mp::ListVMInstance::instance_status,
+                                           Property(&mp::InstanceStatus::status,
+                                                    mp::InstanceStatus::UNKNOWN)))));
+}
+
+TEST_F(Daemon, listsDeletedInstancesThatFailedToLoadAsDeleted)
+{
+    auto mock_factory = use_a_mock_vm_factory();
+    multipass::test::fake_vm_properties vm_props{};
+    vm_props.default_mac = "52:54:00:73:76:28";
+    vm_props.deleted = true;
+    vm_props.state = multipass::VirtualMachine::State::stopped;
+    const auto [temp_dir, _] = plant_instance_json(fake_json_contents(vm_props));
+    config_builder.data_directory = temp_dir->path();
+    config_builder.vault = std::make_unique<NiceMock<mpt::MockVMImageVault>>();
+    config_builder.load_instances_in_background = true;
+
+    EXPECT_CALL(*mock_factory, create_virtual_machine)
+        .WillOnce(Throw(std::runtime_error{"cannot load"}));
+
+    mp::Daemon daemon{config_builder.build()};
+
+    bool loaded = false;
+    daemon.when_instances_loaded([&loaded] { loaded = true; });
+
+    QDeadlineTimer deadline{std::chrono::seconds{5}};
+    while (!loaded && !deadline.hasExpired())
+        QCoreApplication::processEvents(QEventLoop::AllEvents, 10);
+    ASSERT_TRUE(loaded);
+
+    NiceMock<mpt::MockServerReaderWriter<mp::ListReply, mp::ListRequest>> mock_server;
+    mp::ListReply list_reply;
+    EXPECT_CALL(mock_server, Write).WillOnce(DoAll(SaveArg<0>(&list_reply), Return(true)));
+    EXPECT_TRUE(call_daemon_slot(daemon, &mp::Daemon::list, mp::ListRequest{}, mock_server).ok());
+
+    EXPECT_THAT(list_reply.instance_list().instances(),
+                ElementsAre(AllOf(Property(&mp::ListVMInstance::name, vm_props.name),
+                                  Property(&mp::ListVMInstance::instance_status,
+                                           Property(&mp::InstanceStatus::status,
+                                                    mp::InstanceStatus::DELETED)))));
+}
+
+TEST_F(Daemon, createsInstancesLoadedInBackgroundOneAtATime)
+{
+    auto mock_factory = use_a_mock_vm_factory();
+
+    // The records of all instances go in the one file, each under its own name
+    QJsonObject records;
+    for (auto i = 0; i < 4; ++i)
+    {
+        multipass::test::fake_vm_properties vm_props{};
+        vm_props.name = fmt::format("instance-{}", i);
+        vm_props.default_mac = fmt::format("52:54:00:73:76:{:02x}", i);
+        vm_props.state = multipass::VirtualMachine::State::stopped;
+
+        const auto record =
+            QJsonDocument::fromJson(QByteArray::fromStdString(fake_json_contents(vm_props)))
+                .object();
+        for (auto it = record.begin(); it != record.end(); ++it)
+            records.insert(it.key(), it.value());
+    }
+
+    const auto [temp_dir, _] = plant_instance_json(QJsonDocument{records}.toJson().toStdString());
+    config_builder.data_directory = temp_dir->path();
+    config_builder.vault = std::make_unique<NiceMock<mpt::MockVMImageVault>>();
+    config_builder.load_instances_in_background = true;
+
+    // Factories are not safe to call from several threads at once, even when loading in parallel
+    std::atomic_int creating{0};
+    std::atomic_bool overlapped{false};
+    EXPECT_CALL(*mock_factory, create_virtual_machine)
+        .Times(4)
+        .WillRepeatedly([&](const mp::VirtualMachineDescription& desc,
+                            auto&&...) -> mp::VirtualMachine::UPtr {
+            if (++creating > 1)
+                overlapped = true;
+
+            std::this_thread::sleep_for(std::chrono::milliseconds{20});
+            --creating;
+
+            return std::make_unique<mpt::StubVirtualMachine>(desc.vm_name);
+        });
+
+    mp::Daemon daemon{config_builder.build()};
+
+    bool loaded = false;
+    daemon.when_instances_loaded([&loaded] { loaded = true; });
+
+    QDeadlineTimer deadline{std::chrono::seconds{5}};
+    while (!loaded && !deadline.hasExpired())
+        QCoreApplication::processEvents(QEventLoop::AllEvents, 10);
+
+    ASSERT_TRUE(loaded);
+    EXPECT_FALSE(overlapped);
+}
+
 TEST_F(Daemon, updatesTheDeletedButNonStoppedVmState)
 {
     auto mock_factory = use_a_mock_vm_factory();
@@ -2380,6 +2564,79 @@ TEST_F(Daemon, infoAllReturnsAllInstances)
     call_daemon_slot(daemon, &mp::Daemon::info, mp::InfoRequest{}, mock_server);
 }
 
+struct DaemonInfoPaging : public Daemon
+{
+    DaemonInfoPaging()
+    {
+        const auto instances_json =
+            fmt::format("{{{}, {}}}",
+                        fmt::format(valid_template, good_instance_name, "10"),
+                        fmt::format(deleted_template, deleted_instance_name, "11"));
+        temp_dir = plant_instance_json(instances_json).first;
+        config_builder.data_directory = temp_dir->path();
+        config_builder.vault = std::make_unique<NiceMock<mpt::MockVMImageVault>>();
+
+        EXPECT_CALL(*use_a_mock_vm_factory(), create_virtual_machine)
+            .WillRepeatedly(WithArg<0>([](const auto& desc) {
+                return std::make_unique<mpt::StubVirtualMachine>(desc.vm_name);
+            }));
+    }
+
+    const std::string good_instance_name{"good-instance"};
+    const std::string deleted_instance_name{"deleted-instance"};
+    std::unique_ptr<mpt::TempDir> temp_dir;
+};
+
+TEST_F(DaemonInfoPaging, sendsOneReplyPerPage)
+{
+    mp::InfoRequest request;
+    request.set_page_size(1);
+
+    StrictMock<mpt::MockServerReaderWriter<mp::InfoReply, mp::InfoRequest>> mock_server{};
+    EXPECT_CALL(mock_server, Write(Property(&mp::InfoReply::details, SizeIs(1)), _))
+        .Times(2)
+        .WillRepeatedly(Return(true));
+    EXPECT_CALL(mock_server, Write(Property(&mp::InfoReply::details, IsEmpty()), _))
+        .WillOnce(Return(true));
+
+    mp::Daemon daemon{config_builder.build()};
+    call_daemon_slot(daemon, &mp::Daemon::info, request, mock_server);
+}
+
+TEST_F(DaemonInfoPaging, filtersInstancesByName)
+{
+    mp::InfoRequest request;
+    request.set_name_pattern("good-*");
+
+    StrictMock<mpt::MockServerReaderWriter<mp::InfoReply, mp::InfoRequest>> mock_server{};
+    EXPECT_CALL(mock_server,
+                Write(Property(&mp::InfoReply::details,
+                               ElementsAre(Property(&mp::DetailedInfoItem::name,
+                                                    good_instance_name))),
+                      _))
+        .WillOnce(Return(true));
+
+    mp::Daemon daemon{config_builder.build()};
+    call_daemon_slot(daemon, &mp::Daemon::info, request, mock_server);
+}
+
+TEST_F(DaemonInfoPaging, filtersInstancesByState)
+{
+    mp::InfoRequest request;
+    request.add_states(mp::InstanceStatus::DELETED);
+
+    StrictMock<mpt::MockServerReaderWriter<mp::InfoReply, mp::InfoRequest>> mock_server{};
+    EXPECT_CALL(mock_server,
+                Write(Property(&mp::InfoReply::details,
+                               ElementsAre(Property(&mp::DetailedInfoItem::name,
+                                                    deleted_instance_name))),
+                      _))
+        .WillOnce(Return(true));
+
+    mp::Daemon daemon{config_builder.build()};
+    call_daemon_slot(daemon, &mp::Daemon::info, request, mock_server);
+}
+
 TEST_F(Daemon, setsPermissionsOnProvidedStoragePath)
 {
     const QString path{"Where all the secrets go"};
@@ -163,6 +163,35 @@ TEST_F(TestDaemonClone, successfulCloneSpecifyDestNameOkStatus)
     EXPECT_EQ(status.error_code(), grpc::StatusCode::OK);
 }
 
+TEST_F(TestDaemonClone, reportsDiskCopyProgressOncePerPercent)
+{
+    const auto [daemon, instance] = build_daemon_with_mock_instance();
+    EXPECT_CALL(*instance, current_state).WillOnce(Return(mp::VirtualMachine::State::stopped));
+    EXPECT_CALL(mock_factory, clone_bare_vm)
+        .WillOnce([](auto&&, auto&&, auto&&, auto&&, auto&&, auto&&, auto&&, auto& progress) {
+            progress(0, 400);
+            progress(2, 400);
+            progress(400, 400);
+            return nullptr;
+        });
+
+    mp::CloneRequest request{};
+    request.set_source_name(mock_src_instance_name);
+
+    auto server = StrictMock<mpt::MockServerReaderWriter<mp::CloneReply, mp::CloneRequest>>{};
+    InSequence seq;
+    EXPECT_CALL(server, Write(Property(&mp::CloneReply::percent_copied, 0), _))
+        .WillOnce(Return(true));
+    EXPECT_CALL(server, Write(Property(&mp::CloneReply::percent_copied, 100), _))
+        .WillOnce(Return(true));
+    EXPECT_CALL(server, Write(Property(&mp::CloneReply::has_percent_copied, false), _))
+        .WillOnce(Return(true));
+
+    const auto status = call_daemon_slot(*daemon, &mp::Daemon::clone, request, server);
+
+    EXPECT_EQ(status.error_code(), grpc::StatusCode::OK);
+}
+
 TEST_F(TestDaemonClone, failsOnCloneOnNonStoppedInstance)
 {
     const auto [daemon, instance] = build_daemon_with_mock_instance();
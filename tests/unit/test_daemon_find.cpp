@@ -31,6 +31,8 @@
 #include <multipass/exceptions/download_exception.h>
 #include <multipass/format.h>
 
+#include <chrono>
+
 namespace mp = multipass;
 namespace mpt = multipass::test;
 using namespace testing;
@@ -298,3 +300,29 @@ TEST_F(DaemonFind, findForceUpdateRemoteSearchNameCheckUpdateManifestsCalls)
 
     send_command({"find", "release:22.04", "--force-update"});
 }
+
+TEST_F(DaemonFind, warnsAboutRemotesThatCouldNotBeRefreshed)
+{
+    auto mock_image_host = std::make_unique<NiceMock<mpt::MockImageHost>>();
+
+    const auto fetched_at = std::chrono::system_clock::now() - std::chrono::minutes{42};
+    EXPECT_CALL(*mock_image_host, refresh_statuses())
+        .WillRepeatedly(Return(std::vector<mp::RemoteRefreshStatus>{
+            {"release", "", fetched_at},
+            {"daily", "no route to host", fetched_at},
+            {"other", "no route to host", std::nullopt}}));
+
+    config_builder.image_hosts[0] = std::move(mock_image_host);
+    const mp::Daemon daemon{config_builder.build()};
+
+    std::stringstream cerr_stream;
+    send_command({"find"}, trash_stream, cerr_stream);
+
+    EXPECT_THAT(cerr_stream.str(), Not(HasSubstr("\"release\"")));
+    EXPECT_THAT(cerr_stream.str(),
+                HasSubstr("Could not refresh remote \"daily\" (no route to host); showing its "
+                          "images from 42 minute(s) ago"));
+    EXPECT_THAT(cerr_stream.str(),
+                HasSubstr("Could not refresh remote \"other\" (no route to host); it has no "
+                          "images to show"));
+}
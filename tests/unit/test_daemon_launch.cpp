@@ -0,0 +1,270 @@
+/*
+ * Copyright (C) Canonical, Ltd.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+// The daemon test fixture contains premock code so it must be included first.
+#include "daemon_test_fixture.h"
+
+#include "common.h"
+#include "mock_permission_utils.h"
+#include "mock_platform.h"
+#include "mock_settings.h"
+#include "mock_virtual_machine.h"
+#include "mock_vm_image_vault.h"
+#include "stub_availability_zone_manager.h"
+#include "temp_file.h"
+
+#include <src/daemon/daemon.h>
+
+#include <multipass/constants.h>
+#include <multipass/name_generator.h>
+#include <multipass/query.h>
+
+#include <QCoreApplication>
+#include <QDir>
+
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <sstream>
+#include <thread>
+
+namespace mp = multipass;
+namespace mpt = multipass::test;
+using namespace testing;
+
+namespace
+{
+// Hands out the given names in order, and then the last one over and over
+struct StubNameGenerator : public mp::NameGenerator
+{
+    explicit StubNameGenerator(std::deque<std::string> names) : names{std::move(names)}
+    {
+    }
+
+    std::string make_name() override
+    {
+        auto name = names.front();
+        if (names.size() > 1)
+            names.pop_front();
+
+        return name;
+    }
+
+    std::deque<std::string> names;
+};
+
+struct TestDaemonLaunch : public mpt::DaemonTestFixture
+{
+    TestDaemonLaunch()
+    {
+        ON_CALL(*mock_factory, get_instance_directory)
+            .WillByDefault([this](const std::string& name) {
+                return QDir{data_dir.path()}.filePath("instances/" + QString::fromStdString(name));
+            });
+
+        auto vault = std::make_unique<NiceMock<mpt::MockVMImageVault>>();
+        mock_vault = vault.get();
+        ON_CALL(*mock_vault, fetch_image)
+            .WillByDefault([this](const mp::Query& query,
+                                  const mp::VMImageVault::PrepareAction&,
+                                  const mp::ProgressMonitor&,
+                                  const std::optional<std::string>&,
+                                  const mp::Path& save_dir) {
+                QDir{}.mkpath(save_dir);
+                if (query.name.starts_with("_warm-pool-"))
+                    ++pool_fetches;
+
+                return mp::VMImage{image.path(), {}, {}, {}, {}, {}, {}};
+            });
+        config_builder.vault = std::move(vault);
+
+        config_builder.az_manager = std::make_unique<mpt::StubAvailabilityZoneManager>();
+        config_builder.name_generator =
+            std::make_unique<StubNameGenerator>(std::deque<std::string>{"pooled-one", "launched"});
+    }
+
+    void SetUp() override
+    {
+        EXPECT_CALL(mock_settings, register_handler).WillRepeatedly(Return(nullptr));
+        EXPECT_CALL(mock_settings, unregister_handler).Times(AnyNumber());
+        EXPECT_CALL(mock_settings, get(Eq(mp::petenv_key))).WillRepeatedly(Return("pet-instance"));
+        EXPECT_CALL(mock_settings, get(Eq(mp::mounts_key))).WillRepeatedly(Return("true"));
+        EXPECT_CALL(mock_settings, get(Eq(mp::winterm_key))).WillRepeatedly(Return("none"));
+        EXPECT_CALL(mock_settings, get(Eq(mp::bridged_interface_key)))
+            .WillRepeatedly(Return("eth8"));
+    }
+
+    template <typename Predicate>
+    static bool eventually(Predicate&& predicate)
+    {
+        const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds{5};
+        while (!predicate())
+        {
+            if (std::chrono::steady_clock::now() > deadline)
+                return false;
+
+            // The daemon boots pooled instances from its event loop
+            QCoreApplication::processEvents();
+            std::this_thread::sleep_for(std::chrono::milliseconds{10});
+        }
+
+        return true;
+    }
+
+    // The pool prepares one image at a time, in the order of its profiles
+    bool wait_for_pool_fetches(int count)
+    {
+        return eventually([this, count] { return pool_fetches >= count; });
+    }
+
+    mpt::MockVirtualMachineFactory* mock_factory = use_a_mock_vm_factory();
+    mpt::MockVMImageVault* mock_vault = nullptr;
+    mpt::TempFile image;
+    std::atomic_int pool_fetches{0};
+
+    mpt::MockPlatform::GuardedMock mock_platform_injection{mpt::MockPlatform::inject<NiceMock>()};
+
+    mpt::MockSettings::GuardedMock mock_settings_injection =
+        mpt::MockSettings::inject<StrictMock>();
+    mpt::MockSettings& mock_settings = *mock_settings_injection.first;
+
+    const mpt::MockPermissionUtils::GuardedMock mock_permission_utils_injection =
+        mpt::MockPermissionUtils::inject<NiceMock>();
+};
+
+auto named(const std::string& name)
+{
+    return Field(&mp::VirtualMachineDescription::vm_name, Eq(name));
+}
+
+TEST_F(TestDaemonLaunch, usesPreparedImage)
+{
+    config_builder.warm_pool_profiles = {{"", "noble", 1}, {"", "jammy", 1}};
+    mp::Daemon daemon{config_builder.build()};
+
+    // Once the jammy image is being prepared, the noble one is ready
+    ASSERT_TRUE(wait_for_pool_fetches(2));
+
+    EXPECT_CALL(*mock_vault, clone(StartsWith("_warm-pool-"), "foo"));
+
+    std::stringstream out;
+    send_command({"launch", "noble", "--name", "foo"}, out);
+
+    EXPECT_THAT(out.str(), HasSubstr("Launched: foo"));
+}
+
+TEST_F(TestDaemonLaunch, launchesNormallyWhenNoPreparedImageMatches)
+{
+    config_builder.warm_pool_profiles = {{"", "noble", 1}, {"", "jammy", 1}};
+    mp::Daemon daemon{config_builder.build()};
+
+    ASSERT_TRUE(wait_for_pool_fetches(2));
+
+    EXPECT_CALL(*mock_vault, clone).Times(0);
+    EXPECT_CALL(*mock_vault, fetch_image).Times(AnyNumber());
+    EXPECT_CALL(*mock_vault,
+                fetch_image(AllOf(Field(&mp::Query::name, "foo"),
+                                  Field(&mp::Query::release, "focal")),
+                            _,
+                            _,
+                            _,
+                            _));
+
+    std::stringstream out;
+    send_command({"launch", "focal", "--name", "foo"}, out);
+
+    EXPECT_THAT(out.str(), HasSubstr("Launched: foo"));
+}
+
+TEST_F(TestDaemonLaunch, resumesPooledInstance)
+{
+    config_builder.warm_pool_profiles = {{"", "noble", 0, 1}};
+    // So that the instance booted to refill the pool finds no name to take
+    config_builder.name_generator =
+        std::make_unique<StubNameGenerator>(std::deque<std::string>{"pooled-one"});
+
+    std::atomic_bool suspended{false};
+    auto booted_vm = std::make_unique<NiceMock<mpt::MockVirtualMachine>>();
+    EXPECT_CALL(*booted_vm, start);
+    EXPECT_CALL(*booted_vm, suspend).WillOnce([&suspended] { suspended = true; });
+
+    auto resumed_vm = std::make_unique<NiceMock<mpt::MockVirtualMachine>>();
+    ON_CALL(*resumed_vm, current_state).WillByDefault(Return(mp::VirtualMachine::State::running));
+    EXPECT_CALL(*resumed_vm, start);
+
+    EXPECT_CALL(*mock_factory, create_virtual_machine(named("pooled-one"), _, _))
+        .WillOnce(Return(ByMove(std::move(booted_vm))))
+        .WillOnce(Return(ByMove(std::move(resumed_vm))));
+
+    mp::Daemon daemon{config_builder.build()};
+    ASSERT_TRUE(eventually([&suspended] { return suspended.load(); }));
+
+    std::stringstream out;
+    send_command({"launch", "noble"}, out);
+
+    EXPECT_THAT(out.str(), HasSubstr("Launched: pooled-one"));
+}
+
+TEST_F(TestDaemonLaunch, doesNotResumePooledInstanceForLaunchesAskingForMore)
+{
+    config_builder.warm_pool_profiles = {{"", "noble", 0, 1}};
+
+    std::atomic_bool suspended{false};
+    auto booted_vm = std::make_unique<NiceMock<mpt::MockVirtualMachine>>();
+    EXPECT_CALL(*booted_vm, suspend).WillOnce([&suspended] { suspended = true; });
+
+    EXPECT_CALL(*mock_factory, create_virtual_machine(named("pooled-one"), _, _))
+        .WillOnce(Return(ByMove(std::move(booted_vm))));
+    EXPECT_CALL(*mock_factory,
+                create_virtual_machine(
+                    AllOf(named("launched"), Field(&mp::VirtualMachineDescription::num_cores, 2)),
+                    _,
+                    _));
+
+    mp::Daemon daemon{config_builder.build()};
+    ASSERT_TRUE(eventually([&suspended] { return suspended.load(); }));
+
+    std::stringstream out;
+    send_command({"launch", "noble", "--cpus", "2"}, out);
+
+    EXPECT_THAT(out.str(), HasSubstr("Launched: launched"));
+}
+
+TEST_F(TestDaemonLaunch, reportsTimingsWhenAsked)
+{
+    mp::Daemon daemon{config_builder.build()};
+
+    std::stringstream out;
+    send_command({"launch", "--name", "timed", "--timings"}, out);
+
+    // The client shows the timings the daemon puts in the reply, one step per line
+    EXPECT_THAT(out.str(), HasSubstr("Launched: timed"));
+    for (const auto* step : {"create instance", "fetch image", "write cloud-init", "wait for ssh"})
+        EXPECT_THAT(out.str(), HasSubstr(step));
+}
+
+TEST_F(TestDaemonLaunch, reportsNoTimingsUnlessAsked)
+{
+    mp::Daemon daemon{config_builder.build()};
+
+    std::stringstream out;
+    send_command({"launch", "--name", "foo"}, out);
+
+    EXPECT_THAT(out.str(), HasSubstr("Launched: foo"));
+    EXPECT_THAT(out.str(), Not(HasSubstr("fetch image")));
+}
+} // namespace
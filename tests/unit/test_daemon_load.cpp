@@ -0,0 +1,384 @@
+/*
+ * Copyright (C) Canonical, Ltd.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+// The daemon test fixture contains premock code so it must be included first.
+#include "daemon_test_fixture.h"
+
+#include "common.h"
+#include "fake_virtual_machine_factory.h"
+#include "mock_cert_provider.h"
+#include "mock_permission_utils.h"
+#include "mock_platform.h"
+#include "mock_settings.h"
+#include "temp_dir.h"
+
+#include <src/daemon/daemon.h>
+
+#include <multipass/cli/client_common.h>
+#include <multipass/constants.h>
+#include <multipass/format.h>
+#include <multipass/rpc/multipass.grpc.pb.h>
+
+#include <QFile>
+#include <QJsonDocument>
+#include <QJsonObject>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <map>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+/*
+ * Loads the daemon with many concurrent clients, each sending a mix of RPCs over gRPC, against
+ * thousands of fake instances, and reports the throughput and the latency percentiles of each RPC.
+ *
+ * It is disabled, being a measurement rather than a test. To run it:
+ *
+ *   multipass_cpp_tests --gtest_filter='DaemonLoad.*' --gtest_also_run_disabled_tests
+ *
+ * with any of these to change the load (defaults in brackets):
+ *
+ *   MULTIPASS_LOAD_INSTANCES  number of instances [1000]
+ *   MULTIPASS_LOAD_CLIENTS    number of concurrent clients [16]
+ *   MULTIPASS_LOAD_REQUESTS   requests each client sends [200]
+ *   MULTIPASS_LOAD_MIX        relative weight of each RPC
+ *                             [list=10,info=10,start=15,stop=15,ssh_info=40,mount=10]
+ *   MULTIPASS_LOAD_LATENCIES  milliseconds each instance operation takes
+ *                             [start=100,shutdown=50,suspend=50,state=0,ssh=5,mount=10]
+ *   MULTIPASS_LOAD_REPORT     file to also write the report to, as JSON
+ */
+
+namespace mp = multipass;
+namespace mpt = multipass::test;
+
+using namespace testing;
+
+namespace
+{
+using Clock = std::chrono::steady_clock;
+
+const std::vector<std::string> rpcs{"list", "info", "start", "stop", "ssh_info", "mount"};
+
+int env_int(const char* name, int fallback)
+{
+    bool ok = false;
+    const auto value = qEnvironmentVariableIntValue(name, &ok);
+    return ok && value > 0 ? value : fallback;
+}
+
+// Parses "key=value,..." pairs, taking those missing from the fallback
+std::map<std::string, int> env_pairs(const char* name, const std::map<std::string, int>& fallback)
+{
+    auto pairs = fallback;
+    for (const auto& pair : qEnvironmentVariable(name).split(',', Qt::SkipEmptyParts))
+    {
+        const auto key_value = pair.split('=');
+        if (key_value.size() != 2 || !pairs.contains(key_value[0].trimmed().toStdString()))
+            throw std::invalid_argument{fmt::format("Bad {} entry: {}", name, pair)};
+
+        pairs[key_value[0].trimmed().toStdString()] = key_value[1].trimmed().toInt();
+    }
+
+    return pairs;
+}
+
+mpt::FakeVirtualMachineLatencies env_latencies()
+{
+    using std::chrono::milliseconds;
+    const auto latencies = env_pairs("MULTIPASS_LOAD_LATENCIES",
+                                     {{"start", 100},
+                                      {"shutdown", 50},
+                                      {"suspend", 50},
+                                      {"state", 0},
+                                      {"ssh", 5},
+                                      {"mount", 10}});
+
+    return {milliseconds{latencies.at("start")},
+            milliseconds{latencies.at("shutdown")},
+            milliseconds{latencies.at("suspend")},
+            milliseconds{latencies.at("state")},
+            milliseconds{latencies.at("ssh")},
+            milliseconds{latencies.at("mount")}};
+}
+
+// Sends a single request on a new stream, reading every reply
+template <typename Request, typename Reply>
+grpc::Status send_on(std::unique_ptr<grpc::ClientReaderWriter<Request, Reply>> stream,
+                     const Request& request)
+{
+    stream->Write(request);
+    stream->WritesDone();
+
+    Reply reply;
+    while (stream->Read(&reply))
+        ;
+
+    return stream->Finish();
+}
+
+grpc::Status send_rpc(mp::Rpc::Stub& stub,
+                      const std::string& rpc,
+                      const std::string& instance,
+                      const std::string& mount_source,
+                      int id)
+{
+    grpc::ClientContext context;
+
+    if (rpc == "list")
+        return send_on(stub.list(&context), mp::ListRequest{});
+
+    if (rpc == "info")
+    {
+        mp::InfoRequest request;
+        request.add_instance_snapshot_pairs()->set_instance_name(instance);
+        return send_on(stub.info(&context), request);
+    }
+
+    if (rpc == "start")
+    {
+        mp::StartRequest request;
+        request.mutable_instance_names()->add_instance_name(instance);
+        return send_on(stub.start(&context), request);
+    }
+
+    if (rpc == "stop")
+    {
+        mp::StopRequest request;
+        request.mutable_instance_names()->add_instance_name(instance);
+        return send_on(stub.stop(&context), request);
+    }
+
+    if (rpc == "ssh_info")
+    {
+        mp::SSHInfoRequest request;
+        request.add_instance_name(instance);
+        return send_on(stub.ssh_info(&context), request);
+    }
+
+    mp::MountRequest request;
+    request.set_source_path(mount_source);
+    request.set_mount_type(mp::MountRequest::NATIVE);
+    auto target = request.add_target_paths();
+    target->set_instance_name(instance);
+    target->set_target_path(fmt::format("/home/ubuntu/load-{}", id));
+    return send_on(stub.mount(&context), request);
+}
+
+struct RpcStats
+{
+    std::vector<double> latencies_ms;
+    int failures = 0;
+};
+
+double percentile(const std::vector<double>& sorted, double p)
+{
+    if (sorted.empty())
+        return 0;
+
+    const auto rank = static_cast<std::size_t>(std::ceil(p * sorted.size()));
+    return sorted[std::max<std::size_t>(rank, 1) - 1];
+}
+
+struct DaemonLoad : public mpt::DaemonTestFixture
+{
+    DaemonLoad()
+    {
+        ON_CALL(mock_settings, get(Eq(mp::mounts_key))).WillByDefault(Return("true"));
+        config_builder.factory =
+            std::make_unique<mpt::FakeVirtualMachineFactory>(*config_builder.az_manager,
+                                                             env_latencies());
+    }
+
+    // Instances start stopped, so that the mix of RPCs decides how many are running
+    std::string instances_json(int count)
+    {
+        std::vector<std::string> entries;
+        for (int i = 0; i < count; ++i)
+        {
+            mpt::fake_vm_properties properties;
+            properties.name = instance_name(i);
+            properties.state = mp::VirtualMachine::State::stopped;
+
+            // Strip the braces around the single instance
+            const auto json = fake_json_contents(properties);
+            const auto begin = json.find('{') + 1;
+            entries.push_back(json.substr(begin, json.rfind('}') - begin));
+        }
+
+        return fmt::format("{{{}}}", fmt::join(entries, ","));
+    }
+
+    static std::string instance_name(int i)
+    {
+        return fmt::format("load-{:05}", i);
+    }
+
+    mpt::MockPlatform::GuardedMock platform_attr{mpt::MockPlatform::inject<NiceMock>()};
+
+    mpt::MockSettings::GuardedMock mock_settings_injection =
+        mpt::MockSettings::inject<NiceMock>();
+    mpt::MockSettings& mock_settings = *mock_settings_injection.first;
+
+    const mpt::MockPermissionUtils::GuardedMock mock_permission_utils_injection =
+        mpt::MockPermissionUtils::inject<NiceMock>();
+
+    mpt::TempDir mount_source;
+};
+
+TEST_F(DaemonLoad, DISABLED_reportsThroughputAndLatenciesOfEachRpc)
+{
+    const auto num_instances = env_int("MULTIPASS_LOAD_INSTANCES", 1000);
+    const auto num_clients = env_int("MULTIPASS_LOAD_CLIENTS", 16);
+    const auto num_requests = env_int("MULTIPASS_LOAD_REQUESTS", 200);
+    const auto mix = env_pairs(
+        "MULTIPASS_LOAD_MIX",
+        {{"list", 10}, {"info", 10}, {"start", 15}, {"stop", 15}, {"ssh_info", 40}, {"mount", 10}});
+
+    const auto [temp_dir, filename] = plant_instance_json(instances_json(num_instances));
+    config_builder.data_directory = temp_dir->path();
+
+    mp::Daemon daemon{config_builder.build()};
+
+    std::vector<int> weights;
+    std::ranges::transform(rpcs, std::back_inserter(weights), [&mix](const auto& rpc) {
+        return mix.at(rpc);
+    });
+
+    std::vector<std::map<std::string, RpcStats>> client_stats(num_clients);
+    std::atomic_int clients_left{num_clients};
+    std::atomic_int next_id{0};
+
+    const auto start_time = Clock::now();
+
+    std::vector<std::thread> clients;
+    for (int c = 0; c < num_clients; ++c)
+        clients.emplace_back([&, c] {
+            NiceMock<mpt::MockCertProvider> cert_provider;
+            const auto stub = mp::Rpc::NewStub(mp::client::make_channel(server_address,
+                                                                        cert_provider));
+
+            std::mt19937 generator(c);
+            std::discrete_distribution<> pick_rpc(weights.begin(), weights.end());
+            std::uniform_int_distribution<> pick_instance(0, num_instances - 1);
+
+            for (int r = 0; r < num_requests; ++r)
+            {
+                const auto& rpc = rpcs[pick_rpc(generator)];
+                const auto instance = instance_name(pick_instance(generator));
+
+                const auto sent = Clock::now();
+                const auto status =
+                    send_rpc(*stub, rpc, instance, mount_source.path().toStdString(), next_id++);
+                const std::chrono::duration<double, std::milli> latency = Clock::now() - sent;
+
+                auto& stats = client_stats[c][rpc];
+                stats.latencies_ms.push_back(latency.count());
+                stats.failures += !status.ok();
+            }
+
+            if (--clients_left == 0)
+            {
+                // The last client may finish before the loop gets going, see send_commands
+                while (!loop.isRunning())
+                    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+
+                loop.quit();
+            }
+        });
+
+    loop.exec();
+    for (auto& client : clients)
+        client.join();
+
+    const std::chrono::duration<double> elapsed = Clock::now() - start_time;
+    const auto total = num_clients * num_requests;
+
+    QJsonObject report{{"instances", num_instances},
+                       {"clients", num_clients},
+                       {"requests", total},
+                       {"seconds", elapsed.count()},
+                       {"requests_per_second", total / elapsed.count()}};
+
+    std::cout << fmt::format("{} requests from {} clients against {} instances in {:.2f}s: "
+                             "{:.1f} requests/s\n",
+                             total,
+                             num_clients,
+                             num_instances,
+                             elapsed.count(),
+                             total / elapsed.count())
+              << fmt::format("{:<10}{:>9}{:>10}{:>10}{:>10}{:>10}{:>10}\n",
+                             "rpc",
+                             "count",
+                             "failures",
+                             "req/s",
+                             "p50 ms",
+                             "p99 ms",
+                             "p999 ms");
+
+    int answered = 0;
+    for (const auto& rpc : rpcs)
+    {
+        RpcStats merged;
+        for (auto& stats : client_stats)
+        {
+            auto& rpc_stats = stats[rpc];
+            merged.latencies_ms.insert(merged.latencies_ms.end(),
+                                       rpc_stats.latencies_ms.begin(),
+                                       rpc_stats.latencies_ms.end());
+            merged.failures += rpc_stats.failures;
+        }
+
+        std::ranges::sort(merged.latencies_ms);
+        const auto count = static_cast<int>(merged.latencies_ms.size());
+        answered += count;
+
+        std::cout << fmt::format("{:<10}{:>9}{:>10}{:>10.1f}{:>10.2f}{:>10.2f}{:>10.2f}\n",
+                                 rpc,
+                                 count,
+                                 merged.failures,
+                                 count / elapsed.count(),
+                                 percentile(merged.latencies_ms, 0.5),
+                                 percentile(merged.latencies_ms, 0.99),
+                                 percentile(merged.latencies_ms, 0.999));
+
+        report.insert(QString::fromStdString(rpc),
+                      QJsonObject{{"count", count},
+                                  {"failures", merged.failures},
+                                  {"requests_per_second", count / elapsed.count()},
+                                  {"p50_ms", percentile(merged.latencies_ms, 0.5)},
+                                  {"p99_ms", percentile(merged.latencies_ms, 0.99)},
+                                  {"p999_ms", percentile(merged.latencies_ms, 0.999)}});
+    }
+
+    if (const auto report_path = qEnvironmentVariable("MULTIPASS_LOAD_REPORT");
+        !report_path.isEmpty())
+    {
+        QFile file{report_path};
+        ASSERT_TRUE(file.open(QIODevice::WriteOnly | QIODevice::Truncate));
+        file.write(QJsonDocument{report}.toJson());
+    }
+
+    EXPECT_EQ(answered, total);
+}
+} // namespace
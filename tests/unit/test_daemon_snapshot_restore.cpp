@@ -248,6 +248,49 @@ TEST_F(TestDaemonSnapshot, acceptsEmptySnapshotName)
     EXPECT_EQ(status.error_code(), grpc::OK);
 }
 
+TEST_F(TestDaemonSnapshot, snapshotsRunningInstanceWhenBackendSupportsIt)
+{
+    static constexpr auto* snapshot_name = "live";
+
+    mp::SnapshotRequest request{};
+    request.set_instance(mock_instance_name);
+    request.set_snapshot(snapshot_name);
+
+    auto [daemon, instance] = build_daemon_with_mock_instance();
+    EXPECT_CALL(*instance, current_state)
+        .WillRepeatedly(Return(mp::VirtualMachine::State::running));
+    EXPECT_CALL(*instance, supports_live_snapshots).WillRepeatedly(Return(true));
+
+    auto snapshot = std::make_shared<NiceMock<mpt::MockSnapshot>>();
+    EXPECT_CALL(*snapshot, get_name).WillOnce(Return(snapshot_name));
+    EXPECT_CALL(*instance, take_snapshot(_, Eq(snapshot_name), _)).WillOnce(Return(snapshot));
+
+    auto server = NiceMock<mpt::MockServerReaderWriter<mp::SnapshotReply, mp::SnapshotRequest>>{};
+    auto status = call_daemon_slot(*daemon, &mp::Daemon::snapshot, request, server);
+
+    EXPECT_EQ(status.error_code(), grpc::OK);
+}
+
+TEST_F(TestDaemonSnapshot, failsOnRunningInstanceWhenBackendDoesNotSupportLiveSnapshots)
+{
+    mp::SnapshotRequest request{};
+    request.set_instance(mock_instance_name);
+
+    auto [daemon, instance] = build_daemon_with_mock_instance();
+    EXPECT_CALL(*instance, current_state)
+        .WillRepeatedly(Return(mp::VirtualMachine::State::running));
+    EXPECT_CALL(*instance, take_snapshot).Times(0);
+
+    auto status = call_daemon_slot(*daemon,
+                                   &mp::Daemon::snapshot,
+                                   request,
+                                   NiceMock<mpt::MockServerReaderWriter<mp::SnapshotReply,
+                                                                        mp::SnapshotRequest>>{});
+
+    EXPECT_EQ(status.error_code(), grpc::FAILED_PRECONDITION);
+    EXPECT_THAT(status.error_message(), HasSubstr("only take snapshots of stopped instances"));
+}
+
 TEST_F(TestDaemonRestore, failsIfBackendDoesNotSupportSnapshots)
 {
     mp::RestoreRequest request{};
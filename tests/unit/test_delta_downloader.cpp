@@ -0,0 +1,188 @@
+/*
+ * Copyright (C) Canonical, Ltd.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#include "common.h"
+#include "file_operations.h"
+#include "mock_url_downloader.h"
+#include "temp_dir.h"
+
+#include <multipass/delta_downloader.h>
+#include <multipass/exceptions/download_exception.h>
+
+#include <QCryptographicHash>
+#include <QFileInfo>
+#include <QUrl>
+
+#include <cstdint>
+#include <random>
+
+namespace mp = multipass;
+namespace mpt = multipass::test;
+
+using namespace testing;
+
+namespace
+{
+constexpr qint64 block_size = 4096;
+
+QByteArray random_bytes(qint64 size, unsigned seed)
+{
+    std::mt19937 generator{seed};
+    QByteArray bytes(size, Qt::Uninitialized);
+    for (auto& byte : bytes)
+        byte = static_cast<char>(generator());
+
+    return bytes;
+}
+
+// Written independently of the code under test, following the zsync format
+QByteArray control_file_for(const QByteArray& data,
+                            int seq_matches,
+                            int rsum_bytes,
+                            int checksum_bytes)
+{
+    QByteArray control{"zsync: 0.6.2\nFilename: new.img\n"};
+    control += "Blocksize: " + QByteArray::number(block_size) + "\n";
+    control += "Length: " + QByteArray::number(data.size()) + "\n";
+    control += QByteArray{"Hash-Lengths: "} + QByteArray::number(seq_matches) + "," +
+               QByteArray::number(rsum_bytes) + "," + QByteArray::number(checksum_bytes) + "\n";
+    control += "URL: new.img\n";
+    control +=
+        "SHA-1: " + QCryptographicHash::hash(data, QCryptographicHash::Sha1).toHex() + "\n\n";
+
+    for (qint64 pos = 0; pos < data.size(); pos += block_size)
+    {
+        auto block = data.mid(pos, block_size);
+        block.resize(block_size, '\0');
+
+        std::uint16_t a = 0, b = 0;
+        for (qint64 i = 0; i < block_size; ++i)
+        {
+            a += static_cast<uchar>(block[i]);
+            b += static_cast<std::uint16_t>((block_size - i) * static_cast<uchar>(block[i]));
+        }
+
+        const char rsum[] = {static_cast<char>(a >> 8),
+                             static_cast<char>(a),
+                             static_cast<char>(b >> 8),
+                             static_cast<char>(b)};
+        control.append(rsum + 4 - rsum_bytes, rsum_bytes);
+        control += QCryptographicHash::hash(block, QCryptographicHash::Md4).first(checksum_bytes);
+    }
+
+    return control;
+}
+
+struct DeltaDownloader : public TestWithParam<std::tuple<int, int, int>>
+{
+    DeltaDownloader()
+    {
+        mpt::make_file_with_content(seed_file, old_data.toStdString());
+
+        // Shifted by a few bytes, with a block's worth changed in the middle
+        new_data = "new" + old_data;
+        new_data.replace(600 * block_size, block_size, random_bytes(block_size, 2));
+    }
+
+    void serve_control_file()
+    {
+        const auto [seq_matches, rsum_bytes, checksum_bytes] = GetParam();
+        EXPECT_CALL(downloader, download(QUrl{url.toString() + ".zsync"}, true))
+            .WillOnce(Return(control_file_for(new_data, seq_matches, rsum_bytes, checksum_bytes)));
+    }
+
+    bool download()
+    {
+        return mp::DeltaDownloader{&downloader}.download_to(url, seed_file, file, 0, monitor);
+    }
+
+    mpt::TempDir temp_dir;
+    const QString seed_file = temp_dir.filePath("old.img");
+    const QString file = temp_dir.filePath("new.img");
+    const QUrl url{"https://cloud-images.example.com/new.img"};
+    const QByteArray old_data = random_bytes(1024 * block_size, 1);
+    QByteArray new_data;
+    NiceMock<mpt::MockURLDownloader> downloader;
+    StrictMock<MockFunction<bool(int, int)>> mock_monitor;
+    mp::ProgressMonitor monitor = mock_monitor.AsStdFunction();
+};
+
+TEST_P(DeltaDownloader, rebuildsNewFileFetchingOnlyWhatChanged)
+{
+    serve_control_file();
+
+    qint64 fetched = 0;
+    EXPECT_CALL(downloader, download_range_to(url, _, _, _))
+        .WillRepeatedly(
+            [this, &fetched](const QUrl&, qint64 offset, qint64 length, QIODevice& out) {
+                fetched += length;
+                out.write(new_data.mid(offset, length));
+            });
+    EXPECT_CALL(mock_monitor, Call(0, _)).WillRepeatedly(Return(true));
+
+    ASSERT_TRUE(download());
+
+    EXPECT_EQ(mpt::load(file), new_data);
+    EXPECT_GT(fetched, 0);
+    EXPECT_LT(fetched, new_data.size() / 4);
+}
+
+TEST_P(DeltaDownloader, throwsAndRemovesFileWhenRebuiltFileDoesNotMatch)
+{
+    serve_control_file();
+
+    EXPECT_CALL(downloader, download_range_to(url, _, _, _))
+        .WillRepeatedly([](const QUrl&, qint64, qint64 length, QIODevice& out) {
+            out.write(QByteArray(length, 'x'));
+        });
+    EXPECT_CALL(mock_monitor, Call(0, _)).WillRepeatedly(Return(true));
+
+    EXPECT_THROW(download(), std::runtime_error);
+    EXPECT_FALSE(QFileInfo::exists(file));
+}
+
+TEST_P(DeltaDownloader, givesUpWhenTooLittleIsShared)
+{
+    new_data = random_bytes(old_data.size(), 3);
+    serve_control_file();
+
+    EXPECT_CALL(downloader, download_range_to).Times(0);
+
+    EXPECT_FALSE(download());
+    EXPECT_FALSE(QFileInfo::exists(file));
+}
+
+INSTANTIATE_TEST_SUITE_P(DeltaDownloader,
+                         DeltaDownloader,
+                         Values(std::make_tuple(1, 4, 16), std::make_tuple(2, 2, 5)));
+
+TEST(DeltaDownloaderWithoutControlFile, givesUp)
+{
+    mpt::TempDir temp_dir;
+    const auto file = temp_dir.filePath("new.img");
+    NiceMock<mpt::MockURLDownloader> downloader;
+    EXPECT_CALL(downloader, download(_, _))
+        .WillOnce(Throw(mp::DownloadException{"https://example.com/new.img.zsync", "not found"}));
+    EXPECT_CALL(downloader, download_range_to).Times(0);
+
+    EXPECT_FALSE(mp::DeltaDownloader{&downloader}.download_to(QUrl{"https://example.com/new.img"},
+                                                               temp_dir.filePath("old.img"),
+                                                               file,
+                                                               0,
+                                                               [](int, int) { return true; }));
+    EXPECT_FALSE(QFileInfo::exists(file));
+}
+} // namespace
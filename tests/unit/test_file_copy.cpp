@@ -0,0 +1,107 @@
+/*
+ * Copyright (C) Canonical, Ltd.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "common.h"
+#include "file_operations.h"
+#include "temp_dir.h"
+
+#include <multipass/file_copy.h>
+
+namespace mp = multipass;
+namespace mpt = multipass::test;
+
+using namespace testing;
+
+namespace
+{
+struct TestFileCopy : public Test
+{
+    std::filesystem::path path(const char* name)
+    {
+        return temp_dir.filePath(name).toStdString();
+    }
+
+    mpt::TempDir temp_dir;
+};
+
+TEST_F(TestFileCopy, copiesFiles)
+{
+    const std::string contents(3 * 1024 * 1024 + 5, 'x');
+    mpt::make_file_with_content(temp_dir.filePath("disk.img"), contents);
+    mpt::make_file_with_content(temp_dir.filePath("cloud-init-config.iso"), "config");
+
+    mp::copy_files({{path("disk.img"), path("disk-copy.img")},
+                    {path("cloud-init-config.iso"), path("config-copy.iso")}});
+
+    EXPECT_EQ(mpt::load(temp_dir.filePath("disk-copy.img")).toStdString(), contents);
+    EXPECT_EQ(mpt::load(temp_dir.filePath("config-copy.iso")), "config");
+}
+
+TEST_F(TestFileCopy, keepsZerosInSparseFiles)
+{
+    std::string contents(2 * 1024 * 1024, '\0');
+    contents.back() = 'x';
+    mpt::make_file_with_content(temp_dir.filePath("disk.raw"), contents);
+
+    mp::copy_files({{path("disk.raw"), path("copy.raw")}});
+
+    EXPECT_EQ(mpt::load(temp_dir.filePath("copy.raw")).toStdString(), contents);
+}
+
+TEST_F(TestFileCopy, replacesExistingDestination)
+{
+    mpt::make_file_with_content(temp_dir.filePath("disk.img"), "new");
+    mpt::make_file_with_content(temp_dir.filePath("copy.img"), "much older and longer");
+
+    mp::copy_files({{path("disk.img"), path("copy.img")}});
+
+    EXPECT_EQ(mpt::load(temp_dir.filePath("copy.img")), "new");
+}
+
+TEST_F(TestFileCopy, copiesEmptyFiles)
+{
+    mpt::make_file_with_content(temp_dir.filePath("empty.iso"), "");
+
+    mp::copy_files({{path("empty.iso"), path("copy.iso")}});
+
+    EXPECT_TRUE(std::filesystem::exists(path("copy.iso")));
+    EXPECT_EQ(std::filesystem::file_size(path("copy.iso")), 0u);
+}
+
+TEST_F(TestFileCopy, reportsAllBytesCopiedAtTheEnd)
+{
+    mpt::make_file_with_content(temp_dir.filePath("a.img"), "12345");
+    mpt::make_file_with_content(temp_dir.filePath("b.img"), "678");
+
+    std::uint64_t last_copied = 0, last_total = 0;
+    mp::copy_files({{path("a.img"), path("a-copy.img")}, {path("b.img"), path("b-copy.img")}},
+                   [&](std::uint64_t copied, std::uint64_t total) {
+                       EXPECT_GE(copied, last_copied);
+                       last_copied = copied;
+                       last_total = total;
+                   });
+
+    EXPECT_EQ(last_copied, 8u);
+    EXPECT_EQ(last_total, 8u);
+}
+
+TEST_F(TestFileCopy, throwsOnMissingSource)
+{
+    EXPECT_THROW(mp::copy_files({{path("missing.img"), path("copy.img")}}),
+                 std::filesystem::filesystem_error);
+}
+} // namespace
@@ -86,6 +86,15 @@ TEST(InstanceStatusString, unavailableStatusReturnsUnavailable)
     EXPECT_THAT(status_string, Eq("Unavailable"));
 }
 
+TEST(InstanceStatusString, loadingStatusReturnsLoading)
+{
+    mp::InstanceStatus status;
+    status.set_status(mp::InstanceStatus::LOADING);
+    auto status_string = mp::format::status_string_for(status);
+
+    EXPECT_THAT(status_string, Eq("Loading"));
+}
+
 TEST(InstanceStatusString, bogusStatusReturnsUnknown)
 {
     mp::InstanceStatus status;
@@ -0,0 +1,148 @@
+/*
+ * Copyright (C) Canonical, Ltd.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#include "common.h"
+#include "mock_settings.h"
+#include "mock_virtual_machine_factory.h"
+#include "mock_vm_image_vault.h"
+
+#include <src/daemon/image_maintenance.h>
+
+#include <multipass/background_work.h>
+#include <multipass/constants.h>
+
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <thread>
+
+namespace mp = multipass;
+namespace mpt = multipass::test;
+
+using namespace testing;
+
+namespace
+{
+struct ImageMaintenance : public Test
+{
+    template <typename Predicate>
+    static bool eventually(Predicate&& predicate)
+    {
+        const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds{5};
+        while (!predicate())
+        {
+            if (std::chrono::steady_clock::now() > deadline)
+                return false;
+            std::this_thread::sleep_for(std::chrono::milliseconds{10});
+        }
+
+        return true;
+    }
+
+    ImageMaintenance()
+    {
+        ON_CALL(mock_settings, get(Eq(mp::image_bandwidth_limit_key))).WillByDefault(Return("0"));
+    }
+
+    mpt::MockSettings::GuardedMock mock_settings_injection = mpt::MockSettings::inject<NiceMock>();
+    mpt::MockSettings& mock_settings = *mock_settings_injection.first;
+        NiceMock<mpt::MockVirtualMachineFactory> mock_factory;
+    NiceMock<mpt::MockVMImageVault> mock_vault;
+};
+
+TEST_F(ImageMaintenance, prunesAndUpdatesAsBackgroundWork)
+{
+    std::atomic_bool updated{false};
+    std::uint64_t limit_while_updating = 0;
+    EXPECT_CALL(mock_vault, prune_expired_images);
+    EXPECT_CALL(mock_vault, update_images).WillOnce([&updated, &limit_while_updating] {
+        if (auto work = mp::BackgroundWork::current())
+            limit_while_updating = work->bandwidth_limit();
+        updated = true;
+    });
+
+    EXPECT_CALL(mock_settings, get(Eq(mp::image_bandwidth_limit_key))).WillOnce(Return("4K"));
+
+    mp::ImageMaintenance maintenance{mock_vault, mock_factory, nullptr};
+    maintenance.run();
+
+    ASSERT_TRUE(eventually([&updated] { return updated.load(); }));
+    EXPECT_EQ(limit_while_updating, 4096u);
+}
+
+TEST_F(ImageMaintenance, holdsOffWhileHeld)
+{
+    std::atomic_bool updated{false};
+    EXPECT_CALL(mock_vault, update_images).WillOnce([&updated] { updated = true; });
+
+    mp::ImageMaintenance maintenance{mock_vault, mock_factory, nullptr};
+    auto hold = maintenance.hold();
+    maintenance.run();
+
+    ASSERT_TRUE(eventually([&maintenance] {
+        return maintenance.status().state == mp::ImageMaintenance::State::waiting;
+    }));
+
+    const auto status = maintenance.status();
+    EXPECT_EQ(status.step, "prune expired images");
+    EXPECT_EQ(status.steps_left, 1);
+    EXPECT_EQ(status.holds, 1);
+    EXPECT_FALSE(updated);
+
+    hold.reset();
+    EXPECT_TRUE(eventually([&updated] { return updated.load(); }));
+}
+
+TEST_F(ImageMaintenance, reportsDownloadProgress)
+{
+    std::promise<void> checked;
+    EXPECT_CALL(mock_vault, update_images)
+        .WillOnce([checked = checked.get_future().share()](const auto&, const auto& monitor) {
+            monitor(0, 42);
+            checked.wait();
+        });
+
+    mp::ImageMaintenance maintenance{mock_vault, mock_factory, nullptr};
+    maintenance.run();
+
+    EXPECT_TRUE(eventually([&maintenance] { return maintenance.status().progress == 42; }));
+    EXPECT_EQ(maintenance.status().step, "update images");
+    checked.set_value();
+}
+
+TEST_F(ImageMaintenance, abortsDownloadsWhenDestroyed)
+{
+    std::atomic_bool keep_going{true};
+    std::atomic_bool started{false};
+    EXPECT_CALL(mock_vault, update_images)
+        .WillOnce([&keep_going, &started](const auto&, const auto& monitor) {
+            started = true;
+            while (keep_going)
+            {
+                keep_going = monitor(0, 1);
+                std::this_thread::sleep_for(std::chrono::milliseconds{1});
+            }
+        });
+
+    {
+        mp::ImageMaintenance maintenance{mock_vault, mock_factory, nullptr};
+        maintenance.run();
+        ASSERT_TRUE(eventually([&started] { return started.load(); }));
+    }
+
+    EXPECT_FALSE(keep_going);
+}
+} // namespace
@@ -22,6 +22,7 @@
 #include "mock_image_host.h"
 #include "mock_logger.h"
 #include "mock_process_factory.h"
+#include "mock_url_downloader.h"
 #include "path.h"
 #include "stub_url_downloader.h"
 #include "temp_dir.h"
@@ -583,6 +584,98 @@ TEST_F(ImageVault, remembersInstanceImages)
     EXPECT_THAT(vm_image1.image_path, Eq(vm_image2.image_path));
 }
 
+TEST_F(ImageVault, backfillsMissingReleaseOfInstanceImagesOnce)
+{
+    auto info_without_release = host.mock_bionic_image_info;
+    info_without_release.release_title.clear();
+    EXPECT_CALL(host, info_for(_)).WillRepeatedly(Return(info_without_release));
+    EXPECT_CALL(host, info_for_full_hash(StrEq(mpt::default_id)))
+        .WillOnce(Return(host.mock_bionic_image_info));
+
+    mp::DefaultVMImageVault first_vault{hosts,
+                                        &url_downloader,
+                                        cache_dir.path(),
+                                        data_dir.path(),
+                                        mp::days{0}};
+    first_vault.fetch_image(default_query, stub_prepare, stub_monitor, std::nullopt, instance_dir);
+    const auto backfilled = first_vault.fetch_image(default_query,
+                                                    stub_prepare,
+                                                    stub_monitor,
+                                                    std::nullopt,
+                                                    instance_dir);
+
+    mp::DefaultVMImageVault another_vault{hosts,
+                                          &url_downloader,
+                                          cache_dir.path(),
+                                          data_dir.path(),
+                                          mp::days{0}};
+    const auto remembered = another_vault.fetch_image(default_query,
+                                                      stub_prepare,
+                                                      stub_monitor,
+                                                      std::nullopt,
+                                                      instance_dir);
+
+    EXPECT_EQ(backfilled.original_release, mpt::default_release_info);
+    EXPECT_EQ(remembered.original_release, mpt::default_release_info);
+}
+
+TEST_F(ImageVault, looksUpReleaseAgainUntilTheManifestsHaveTheImage)
+{
+    auto info_without_release = host.mock_bionic_image_info;
+    info_without_release.release_title.clear();
+    EXPECT_CALL(host, info_for(_)).WillRepeatedly(Return(info_without_release));
+    EXPECT_CALL(host, info_for_full_hash(StrEq(mpt::default_id)))
+        .WillOnce(Throw(std::runtime_error{"no such image"}))
+        .WillOnce(Return(host.mock_bionic_image_info));
+
+    mp::DefaultVMImageVault vault{hosts,
+                                  &url_downloader,
+                                  cache_dir.path(),
+                                  data_dir.path(),
+                                  mp::days{0}};
+    vault.fetch_image(default_query, stub_prepare, stub_monitor, std::nullopt, instance_dir);
+
+    const auto before_manifests =
+        vault.fetch_image(default_query, stub_prepare, stub_monitor, std::nullopt, instance_dir);
+    EXPECT_TRUE(before_manifests.original_release.empty());
+
+    for (auto i = 0; i < 2; ++i)
+    {
+        const auto image = vault.fetch_image(default_query,
+                                             stub_prepare,
+                                             stub_monitor,
+                                             std::nullopt,
+                                             instance_dir);
+        EXPECT_EQ(image.original_release, mpt::default_release_info);
+    }
+}
+
+TEST_F(ImageVault, looksUpReleaseOfImagesTheManifestsHaveWithoutOneOnce)
+{
+    auto info_without_release = host.mock_bionic_image_info;
+    info_without_release.release_title.clear();
+    EXPECT_CALL(host, info_for(_)).WillRepeatedly(Return(info_without_release));
+    EXPECT_CALL(host, info_for_full_hash(StrEq(mpt::default_id)))
+        .WillOnce(Return(info_without_release));
+
+    mp::DefaultVMImageVault vault{hosts,
+                                  &url_downloader,
+                                  cache_dir.path(),
+                                  data_dir.path(),
+                                  mp::days{0}};
+    vault.fetch_image(default_query, stub_prepare, stub_monitor, std::nullopt, instance_dir);
+
+    for (auto i = 0; i < 3; ++i)
+    {
+        const auto image = vault.fetch_image(default_query,
+                                             stub_prepare,
+                                             stub_monitor,
+                                             std::nullopt,
+                                             instance_dir);
+        EXPECT_TRUE(image.original_release.empty());
+    }
+}
+
 TEST_F(ImageVault, remembersPreparedImages)
 {
     int prepare_called_count{0};
@@ -945,6 +1038,35 @@ TEST_F(ImageVault, imageUpdateCreatesNewDirAndRemovesOld)
     EXPECT_FALSE(QFileInfo::exists(original_absolute_path));
 }
 
+TEST_F(ImageVault, imageUpdateTriesDeltaFromOldImageFirst)
+{
+    NiceMock<mpt::MockURLDownloader> mock_url_downloader;
+    ON_CALL(mock_url_downloader, download_to)
+        .WillByDefault(WithArg<1>(
+            [](const QString& file_name) { mpt::make_file_with_content(file_name, ""); }));
+
+    mp::DefaultVMImageVault vault{hosts,
+                                  &mock_url_downloader,
+                                  cache_dir.path(),
+                                  data_dir.path(),
+                                  mp::days{1}};
+    vault.fetch_image(default_query, stub_prepare, stub_monitor, std::nullopt, instance_dir);
+
+    host.mock_bionic_image_info.id =
+        "e3b0c44298fc1c149afbf4c8996fb92427ae41e4649b934ca495991b7852b856";
+    host.mock_bionic_image_info.version = "20180825";
+    host.mock_bionic_image_info.verify = false;
+
+    // Without a control file to go by, the image is downloaded in full
+    const QUrl control_url{
+        QString::fromStdString(host.mock_bionic_image_info.image_location + ".zsync")};
+    EXPECT_CALL(mock_url_downloader, download(control_url, true)).WillOnce(Return(QByteArray{}));
+    EXPECT_CALL(mock_url_downloader, download_range_to).Times(0);
+    EXPECT_CALL(mock_url_downloader, download_to).Times(1);
+
+    vault.update_images(stub_prepare, stub_monitor);
+}
+
 TEST_F(ImageVault, abortedDownloadThrows)
 {
     RunningURLDownloader running_url_downloader;
@@ -245,6 +245,15 @@ TEST_P(JsonPrettyPrintTest, prettyPrintsCustomIndentCorrectly)
     EXPECT_EQ(mp::pretty_print(json, {.indent = 2}), expected);
 }
 
+TEST_P(JsonPrettyPrintTest, prettyPrintsNestedCorrectly)
+{
+    std::string input = GetParam();
+    boost::json::value json = boost::json::parse(input);
+    // Every line but the first is indented by one more level, as if the value sat in a container
+    auto expected = std::regex_replace(input, std::regex("\n"), "\n    ") + "\n";
+    EXPECT_EQ(mp::pretty_print(json, {.nesting = 1}), expected);
+}
+
 INSTANTIATE_TEST_SUITE_P(TestJsonUtils,
                          JsonPrettyPrintTest,
                          Values(
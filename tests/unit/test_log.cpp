@@ -19,6 +19,7 @@
 
 #include <gtest/gtest.h>
 #include <multipass/logging/level.h>
+#include <multipass/logging/multiplexing_logger.h>
 
 namespace mpl = multipass::logging;
 namespace mpt = multipass::test;
@@ -103,3 +104,63 @@ TEST_F(LogTests, testLogTraceFunction)
     logger_scope.mock_logger->expect_log(mpl::Level::trace, "with formatting 1");
     mpl::trace("test_category", "with formatting {}", 1);
 }
+
+// ------------------------------------------------------------------------------
+
+TEST(LogLevelTests, skipsFormattingWhenNoLoggerWouldLog)
+{
+    struct QuietLogger : public mpl::Logger
+    {
+        void log(mpl::Level, std::string_view, std::string_view) const override
+        {
+            ADD_FAILURE() << "Should not have been asked to log";
+        }
+
+        bool is_enabled(mpl::Level level) const override
+        {
+            return level <= mpl::Level::error;
+        }
+    };
+
+    mpl::set_logger(std::make_shared<QuietLogger>());
+
+    // formatting would throw, with the argument missing
+    EXPECT_NO_THROW(mpl::log(mpl::Level::debug, "test_category", fmt::runtime("{} {}"), 1));
+
+    mpl::set_logger(nullptr);
+}
+
+TEST(LogLevelTests, followsClientLoggersOfTheGlobalLogger)
+{
+    struct LevelLogger : public mpl::Logger
+    {
+        explicit LevelLogger(mpl::Level level) : mpl::Logger{level}
+        {
+        }
+
+        void log(mpl::Level, std::string_view, std::string_view) const override
+        {
+        }
+
+        bool is_enabled(mpl::Level level) const override
+        {
+            return level <= logging_level;
+        }
+    };
+
+    auto logger = std::make_shared<mpl::MultiplexingLogger>(
+        std::make_unique<LevelLogger>(mpl::Level::warning));
+    LevelLogger client{mpl::Level::debug};
+
+    mpl::set_logger(logger);
+    EXPECT_FALSE(mpl::is_enabled(mpl::Level::info));
+
+    logger->add_logger(&client);
+    EXPECT_TRUE(mpl::is_enabled(mpl::Level::debug));
+    EXPECT_FALSE(mpl::is_enabled(mpl::Level::trace));
+
+    logger->remove_logger(&client);
+    EXPECT_FALSE(mpl::is_enabled(mpl::Level::info));
+
+    mpl::set_logger(nullptr);
+}
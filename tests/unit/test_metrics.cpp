@@ -0,0 +1,211 @@
+/*
+ * Copyright (C) Canonical, Ltd.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "common.h"
+
+#include <multipass/metrics.h>
+
+#include <thread>
+
+namespace mpm = multipass::metrics;
+
+using namespace testing;
+
+namespace
+{
+// The registry is not reset between tests, because code under test hangs on to metrics it looked
+// up. Each test sticks to metric names of its own instead.
+
+TEST(TestMetrics, rendersCounters)
+{
+    auto& counter = MP_METRICS.counter("test_counter_total", "Things counted", {{"kind", "foo"}});
+    counter.increment();
+    counter.increment(2);
+
+    EXPECT_EQ(counter.value(), 3u);
+    EXPECT_THAT(MP_METRICS.render(),
+                HasSubstr("# HELP test_counter_total Things counted\n"
+                          "# TYPE test_counter_total counter\n"
+                          "test_counter_total{kind=\"foo\"} 3\n"));
+}
+
+TEST(TestMetrics, looksUpTheSameMetricForTheSameLabels)
+{
+    auto& first = MP_METRICS.counter("test_lookup_total", "", {{"kind", "foo"}});
+    auto& again = MP_METRICS.counter("test_lookup_total", "", {{"kind", "foo"}});
+    auto& other = MP_METRICS.counter("test_lookup_total", "", {{"kind", "bar"}});
+
+    EXPECT_EQ(&first, &again);
+    EXPECT_NE(&first, &other);
+}
+
+TEST(TestMetrics, refusesToChangeTheTypeOfAFamily)
+{
+    MP_METRICS.counter("test_typed", "");
+    EXPECT_THROW(MP_METRICS.gauge("test_typed", ""), std::logic_error);
+}
+
+TEST(TestMetrics, rendersGaugesWithoutLabels)
+{
+    auto& gauge = MP_METRICS.gauge("test_gauge", "Current things");
+    gauge.set(5);
+    gauge.add(-7);
+
+    EXPECT_THAT(MP_METRICS.render(), HasSubstr("\ntest_gauge -2\n"));
+}
+
+TEST(TestMetrics, escapesLabelValues)
+{
+    MP_METRICS.gauge("test_escaped", "", {{"path", "a\"b\\c\nd"}}).set(1);
+    EXPECT_THAT(MP_METRICS.render(), HasSubstr(R"(test_escaped{path="a\"b\\c\nd"} 1)"));
+}
+
+TEST(TestMetrics, escapesHelpText)
+{
+    MP_METRICS.gauge("test_escaped_help", "Says \"hi\" in C:\\\nand more").set(1);
+    EXPECT_THAT(MP_METRICS.render(),
+                HasSubstr(R"(# HELP test_escaped_help Says \"hi\" in C:\\\nand more)" "\n"));
+}
+
+TEST(TestMetrics, rendersCumulativeHistogramBuckets)
+{
+    auto& histogram = MP_METRICS.histogram("test_duration_seconds", "", {{"op", "foo"}}, {1, 2});
+    histogram.observe(0.5);
+    histogram.observe(1.5);
+    histogram.observe(1.5);
+    histogram.observe(3);
+
+    EXPECT_EQ(histogram.count(), 4u);
+    EXPECT_DOUBLE_EQ(histogram.sum(), 6.5);
+    EXPECT_THAT(MP_METRICS.render(),
+                HasSubstr("test_duration_seconds_bucket{op=\"foo\",le=\"1\"} 1\n"
+                          "test_duration_seconds_bucket{op=\"foo\",le=\"2\"} 3\n"
+                          "test_duration_seconds_bucket{op=\"foo\",le=\"+Inf\"} 4\n"
+                          "test_duration_seconds_sum{op=\"foo\"} 6.5\n"
+                          "test_duration_seconds_count{op=\"foo\"} 4\n"));
+}
+
+TEST(TestMetrics, histogramsAreSafeToObserveConcurrently)
+{
+    auto& histogram = MP_METRICS.histogram("test_concurrent_seconds", "", {}, {1});
+
+    std::vector<std::thread> threads;
+    for (auto i = 0; i < 4; ++i)
+        threads.emplace_back([&histogram] {
+            for (auto j = 0; j < 1000; ++j)
+                histogram.observe(0.5);
+        });
+    for (auto& thread : threads)
+        thread.join();
+
+    EXPECT_EQ(histogram.count(), 4000u);
+    EXPECT_DOUBLE_EQ(histogram.sum(), 2000);
+}
+
+TEST(TestMetrics, removesMetrics)
+{
+    MP_METRICS.gauge("test_removed", "", {{"instance", "foo"}}).set(1);
+    MP_METRICS.gauge("test_removed", "", {{"instance", "bar"}}).set(1);
+    MP_METRICS.remove("test_removed", {{"instance", "foo"}});
+
+    const auto rendered = MP_METRICS.render();
+    EXPECT_THAT(rendered, Not(HasSubstr("test_removed{instance=\"foo\"}")));
+    EXPECT_THAT(rendered, HasSubstr("test_removed{instance=\"bar\"} 1"));
+}
+
+TEST(TestMetrics, keepsRemovedMetricsAliveForHolders)
+{
+    auto& gauge = MP_METRICS.gauge("test_revived", "", {{"instance", "foo"}});
+    MP_METRICS.remove("test_revived", {{"instance", "foo"}});
+
+    gauge.set(2); // still safe to update while removed
+    EXPECT_THAT(MP_METRICS.render(), Not(HasSubstr("test_revived{instance=\"foo\"}")));
+
+    EXPECT_EQ(&MP_METRICS.gauge("test_revived", "", {{"instance", "foo"}}), &gauge);
+    EXPECT_THAT(MP_METRICS.render(), HasSubstr("test_revived{instance=\"foo\"} 2"));
+}
+
+TEST(TestMetrics, addsLabelsToExternalMetrics)
+{
+    MP_METRICS.set_external("test-labelled",
+                            "# TYPE test_external_total counter\n"
+                            "test_external_total 1\n"
+                            "test_external_total{op=\"read\"} 2\n",
+                            {{"instance", "foo"}});
+
+    EXPECT_THAT(MP_METRICS.render(),
+                HasSubstr("# TYPE test_external_total counter\n"
+                          "test_external_total{instance=\"foo\"} 1\n"
+                          "test_external_total{instance=\"foo\",op=\"read\"} 2\n"));
+
+    MP_METRICS.remove_external("test-labelled");
+}
+
+TEST(TestMetrics, keepsFamiliesTogetherAcrossExternalMetrics)
+{
+    for (const auto instance : {"foo", "bar"})
+        MP_METRICS.set_external(fmt::format("test-merged-{}", instance),
+                                "# HELP test_merged_seconds Merged\n"
+                                "# TYPE test_merged_seconds histogram\n"
+                                "test_merged_seconds_bucket{le=\"+Inf\"} 1\n"
+                                "test_merged_seconds_sum 0.5\n"
+                                "test_merged_seconds_count 1\n",
+                                {{"instance", instance}});
+
+    const auto rendered = MP_METRICS.render();
+    const auto help = "# HELP test_merged_seconds Merged\n";
+    const auto type = "# TYPE test_merged_seconds histogram\n";
+
+    EXPECT_EQ(rendered.find(help), rendered.rfind(help));
+    EXPECT_EQ(rendered.find(type), rendered.rfind(type));
+
+    // all samples follow their (single) type line, before anything else comes along
+    const auto family = rendered.substr(rendered.find(type) + std::strlen(type));
+    EXPECT_THAT(family, StartsWith("test_merged_seconds_bucket"));
+    EXPECT_THAT(family.substr(0, family.find('#')),
+                HasSubstr("test_merged_seconds_count{instance=\"foo\"} 1\n"));
+    EXPECT_THAT(family.substr(0, family.find('#')),
+                HasSubstr("test_merged_seconds_count{instance=\"bar\"} 1\n"));
+
+    for (const auto instance : {"foo", "bar"})
+        MP_METRICS.remove_external(fmt::format("test-merged-{}", instance));
+}
+
+TEST(TestMetrics, replacesExternalMetricsUnderTheSameKey)
+{
+    MP_METRICS.set_external("test-replaced", "test_replaced_total 1\n");
+    MP_METRICS.set_external("test-replaced", "test_replaced_total 2\n");
+
+    auto rendered = MP_METRICS.render();
+    EXPECT_THAT(rendered, HasSubstr("test_replaced_total 2\n"));
+    EXPECT_THAT(rendered, Not(HasSubstr("test_replaced_total 1\n")));
+
+    MP_METRICS.remove_external("test-replaced");
+    EXPECT_THAT(MP_METRICS.render(), Not(HasSubstr("test_replaced_total")));
+}
+
+TEST(TestMetrics, scopedTimerObservesOnce)
+{
+    auto& histogram = MP_METRICS.histogram("test_timed_seconds", "");
+    {
+        mpm::ScopedTimer timer{histogram};
+    }
+
+    EXPECT_EQ(histogram.count(), 1u);
+    EXPECT_GE(histogram.sum(), 0);
+}
+} // namespace
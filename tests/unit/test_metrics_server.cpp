@@ -0,0 +1,124 @@
+/*
+ * Copyright (C) Canonical, Ltd.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "common.h"
+
+#include <src/daemon/metrics_server.h>
+
+#include <multipass/format.h>
+#include <multipass/metrics.h>
+
+#include <QEventLoop>
+#include <QNetworkInterface>
+#include <QTcpSocket>
+
+#include <algorithm>
+#include <thread>
+
+namespace mp = multipass;
+
+using namespace testing;
+
+namespace
+{
+struct MetricsServer : public Test
+{
+    // Sends the request from another thread, as the server answers from this one's event loop
+    QByteArray send(const QByteArray& request,
+                    const QHostAddress& address = QHostAddress::LocalHost)
+    {
+        QByteArray response;
+        QEventLoop loop;
+
+        std::thread client{[&] {
+            QTcpSocket socket;
+            socket.connectToHost(address, server.port());
+            if (socket.waitForConnected(5000))
+            {
+                socket.write(request);
+                socket.waitForBytesWritten(5000);
+
+                // The server closes the connection once it has answered
+                while (socket.waitForReadyRead(5000))
+                    response += socket.readAll();
+                response += socket.readAll();
+            }
+
+            QMetaObject::invokeMethod(&loop, &QEventLoop::quit, Qt::QueuedConnection);
+        }};
+
+        loop.exec();
+        client.join();
+
+        return response;
+    }
+
+    mp::MetricsServer server{0};
+};
+
+TEST_F(MetricsServer, listensOnAFreePortWhenGivenNone)
+{
+    EXPECT_NE(server.port(), 0);
+}
+
+TEST_F(MetricsServer, servesMetricsInTheExpositionFormat)
+{
+    MP_METRICS.counter("test_served_total", "Things served").increment();
+
+    const auto response = send("GET /metrics HTTP/1.1\r\nHost: localhost\r\n\r\n");
+
+    EXPECT_TRUE(response.startsWith("HTTP/1.1 200 OK\r\n"));
+    EXPECT_THAT(response.toStdString(),
+                HasSubstr("\r\nContent-Type: text/plain; version=0.0.4; charset=utf-8\r\n"));
+    EXPECT_THAT(response.toStdString(),
+                HasSubstr("# HELP test_served_total Things served\n"
+                          "# TYPE test_served_total counter\n"
+                          "test_served_total 1\n"));
+
+    const auto body = response.mid(response.indexOf("\r\n\r\n") + 4);
+    EXPECT_THAT(response.toStdString(),
+                HasSubstr(fmt::format("\r\nContent-Length: {}\r\n", body.size())));
+}
+
+TEST_F(MetricsServer, answersHeadRequestsWithoutABody)
+{
+    const auto response = send("HEAD /metrics HTTP/1.1\r\nHost: localhost\r\n\r\n");
+
+    EXPECT_TRUE(response.startsWith("HTTP/1.1 200 OK\r\n"));
+    EXPECT_TRUE(response.endsWith("\r\n\r\n"));
+}
+
+TEST_F(MetricsServer, refusesOtherPathsAndMethods)
+{
+    EXPECT_TRUE(send("GET /other HTTP/1.1\r\n\r\n").startsWith("HTTP/1.1 404 Not Found\r\n"));
+    EXPECT_TRUE(
+        send("POST /metrics HTTP/1.1\r\n\r\n").startsWith("HTTP/1.1 405 Method Not Allowed\r\n"));
+    EXPECT_TRUE(send("nonsense\r\n\r\n").startsWith("HTTP/1.1 400 Bad Request\r\n"));
+}
+
+TEST_F(MetricsServer, listensOnLoopbackOnly)
+{
+    const auto addresses = QNetworkInterface::allAddresses();
+    const auto external = std::ranges::find_if(addresses, [](const QHostAddress& address) {
+        return !address.isLoopback() && address.protocol() == QAbstractSocket::IPv4Protocol;
+    });
+    if (external == addresses.end())
+        GTEST_SKIP() << "No address other than loopback to try";
+
+    EXPECT_TRUE(send("GET /metrics HTTP/1.1\r\n\r\n", *external).isEmpty());
+}
+} // namespace
@@ -0,0 +1,266 @@
+/*
+ * Copyright (C) Canonical, Ltd.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "common.h"
+
+#include <multipass/logging/multiplexing_logger.h>
+
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+namespace mpl = multipass::logging;
+
+using namespace testing;
+
+namespace
+{
+// Records what it is asked to log, optionally holding logging threads until released
+class RecordingLogger : public mpl::Logger
+{
+public:
+    explicit RecordingLogger(mpl::Level level = mpl::Level::trace) : Logger{level}
+    {
+    }
+
+    void log(mpl::Level level, std::string_view, std::string_view message) const override
+    {
+        std::unique_lock lock{mutex};
+        entries.emplace_back(level, message);
+        cv.notify_all();
+        cv.wait(lock, [this] { return !held; });
+    }
+
+    void hold()
+    {
+        std::lock_guard lock{mutex};
+        held = true;
+    }
+
+    void release()
+    {
+        std::lock_guard lock{mutex};
+        held = false;
+        cv.notify_all();
+    }
+
+    void wait_for(std::size_t count) const
+    {
+        std::unique_lock lock{mutex};
+        cv.wait(lock, [this, count] { return entries.size() >= count; });
+    }
+
+    std::vector<std::string> messages() const
+    {
+        std::lock_guard lock{mutex};
+
+        std::vector<std::string> messages;
+        for (const auto& [level, message] : entries)
+            messages.push_back(message);
+
+        return messages;
+    }
+
+    mutable std::vector<std::pair<mpl::Level, std::string>> entries;
+
+private:
+    mutable std::mutex mutex;
+    mutable std::condition_variable cv;
+    bool held{false};
+};
+
+struct TestMultiplexingLogger : public Test
+{
+    mpl::MultiplexingLogger make_async(std::size_t capacity,
+                                       mpl::MultiplexingLogger::OverflowPolicy overflow)
+    {
+        auto system_logger = std::make_unique<RecordingLogger>();
+        system = system_logger.get();
+
+        return mpl::MultiplexingLogger{std::move(system_logger), {capacity, overflow}};
+    }
+
+    RecordingLogger* system{nullptr};
+};
+
+TEST_F(TestMultiplexingLogger, logsToSystemAndAddedLoggers)
+{
+    auto system_logger = std::make_unique<RecordingLogger>();
+    auto& system = *system_logger;
+    RecordingLogger client;
+
+    mpl::MultiplexingLogger logger{std::move(system_logger)};
+    logger.add_logger(&client);
+    logger.log(mpl::Level::info, "cat", "foo");
+    logger.remove_logger(&client);
+    logger.log(mpl::Level::info, "cat", "bar");
+
+    EXPECT_THAT(system.messages(), ElementsAre("foo", "bar"));
+    EXPECT_THAT(client.messages(), ElementsAre("foo"));
+}
+
+TEST_F(TestMultiplexingLogger, isEnabledUpToTheMostVerboseLogger)
+{
+    mpl::MultiplexingLogger logger{std::make_unique<RecordingLogger>(mpl::Level::info)};
+    RecordingLogger client{mpl::Level::trace};
+
+    EXPECT_TRUE(logger.is_enabled(mpl::Level::info));
+    EXPECT_FALSE(logger.is_enabled(mpl::Level::debug));
+
+    logger.add_logger(&client);
+    EXPECT_TRUE(logger.is_enabled(mpl::Level::trace));
+
+    logger.remove_logger(&client);
+    EXPECT_FALSE(logger.is_enabled(mpl::Level::debug));
+}
+
+TEST_F(TestMultiplexingLogger, asyncLoggingDeliversInOrder)
+{
+    auto logger = make_async(16, mpl::MultiplexingLogger::OverflowPolicy::block);
+
+    std::vector<std::string> expected;
+    for (auto i = 0; i < 100; ++i)
+    {
+        expected.push_back(std::to_string(i));
+        logger.log(mpl::Level::info, "cat", expected.back());
+    }
+
+    logger.flush();
+
+    EXPECT_EQ(system->messages(), expected);
+}
+
+TEST_F(TestMultiplexingLogger, asyncLoggingSkipsWhatTheSystemLoggerWouldFilter)
+{
+    auto system_logger = std::make_unique<RecordingLogger>(mpl::Level::info);
+    auto& system = *system_logger;
+    RecordingLogger client{mpl::Level::trace};
+
+    mpl::MultiplexingLogger logger{std::move(system_logger),
+                                   mpl::MultiplexingLogger::AsyncOptions{}};
+    logger.add_logger(&client);
+    logger.log(mpl::Level::debug, "cat", "foo");
+    logger.log(mpl::Level::info, "cat", "bar");
+    logger.flush();
+    logger.remove_logger(&client);
+
+    EXPECT_THAT(system.messages(), ElementsAre("bar"));
+    EXPECT_THAT(client.messages(), ElementsAre("foo", "bar"));
+}
+
+TEST_F(TestMultiplexingLogger, asyncLoggingDropsAndReportsOverflow)
+{
+    auto logger = make_async(2, mpl::MultiplexingLogger::OverflowPolicy::drop);
+
+    system->hold();
+    logger.log(mpl::Level::info, "cat", "first");
+    system->wait_for(1); // the drainer is now stuck with the first message
+
+    for (const auto message : {"second", "third", "fourth", "fifth"})
+        logger.log(mpl::Level::info, "cat", message);
+
+    EXPECT_EQ(logger.dropped(), 2u);
+
+    system->release();
+    logger.flush();
+    system->wait_for(4);
+
+    EXPECT_THAT(system->messages(),
+                ElementsAre("first",
+                            "second",
+                            "third",
+                            HasSubstr("Dropped 2 log messages")));
+    EXPECT_EQ(system->entries.back().first, mpl::Level::warning);
+}
+
+TEST_F(TestMultiplexingLogger, asyncLoggingBlocksOnOverflowWhenAskedTo)
+{
+    auto logger = make_async(2, mpl::MultiplexingLogger::OverflowPolicy::block);
+
+    system->hold();
+    logger.log(mpl::Level::info, "cat", "first");
+    system->wait_for(1);
+
+    std::thread producer{[&logger] {
+        for (const auto message : {"second", "third", "fourth", "fifth"})
+            logger.log(mpl::Level::info, "cat", message);
+    }};
+
+    system->release();
+    producer.join();
+    logger.flush();
+
+    EXPECT_EQ(logger.dropped(), 0u);
+    EXPECT_THAT(system->messages(), ElementsAre("first", "second", "third", "fourth", "fifth"));
+}
+
+TEST_F(TestMultiplexingLogger, asyncLoggingKeepsEachProducersOrder)
+{
+    constexpr auto producers = 4;
+    constexpr auto per_producer = 1000;
+    auto logger = make_async(64, mpl::MultiplexingLogger::OverflowPolicy::block);
+
+    std::vector<std::thread> threads;
+    for (auto p = 0; p < producers; ++p)
+        threads.emplace_back([&logger, p] {
+            for (auto i = 0; i < per_producer; ++i)
+                logger.log(mpl::Level::info, "cat", fmt::format("{} {}", p, i));
+        });
+    for (auto& thread : threads)
+        thread.join();
+
+    logger.flush();
+
+    std::vector<int> next(producers, 0);
+    for (const auto& message : system->messages())
+    {
+        const auto p = std::stoi(message.substr(0, message.find(' ')));
+        EXPECT_EQ(std::stoi(message.substr(message.find(' ') + 1)), next[p]++);
+    }
+
+    EXPECT_THAT(next, Each(per_producer));
+}
+
+TEST_F(TestMultiplexingLogger, asyncLoggingDrainsOnDestruction)
+{
+    // The system logger goes away with the multiplexing logger, so have it record elsewhere
+    struct ForwardingLogger : public mpl::Logger
+    {
+        explicit ForwardingLogger(std::vector<std::string>& messages)
+            : Logger{mpl::Level::trace}, messages{messages}
+        {
+        }
+
+        void log(mpl::Level, std::string_view, std::string_view message) const override
+        {
+            messages.emplace_back(message);
+        }
+
+        std::vector<std::string>& messages;
+    };
+
+    std::vector<std::string> messages;
+    {
+        mpl::MultiplexingLogger logger{std::make_unique<ForwardingLogger>(messages),
+                                       mpl::MultiplexingLogger::AsyncOptions{}};
+        for (const auto message : {"foo", "bar", "baz"})
+            logger.log(mpl::Level::info, "cat", message);
+    }
+
+    EXPECT_THAT(messages, ElementsAre("foo", "bar", "baz"));
+}
+} // namespace
@@ -30,6 +30,7 @@
 #include <multipass/settings/settings.h>
 
 #include <locale>
+#include <sstream>
 
 namespace mp = multipass;
 namespace mpt = multipass::test;
@@ -1287,6 +1288,42 @@ const std::vector<FormatterParamType> version_formatter_outputs{
      mpt::load_test_file("formatters/yaml/version_daemon_update_reply.yaml").toStdString(),
      "yaml_version_daemon_updates"}};
 
+// Splits replies the way the daemon pages them, with a last page that has no entries left
+std::vector<mp::ListReply> one_instance_per_page(const mp::ListReply& reply)
+{
+    std::vector<mp::ListReply> pages;
+    for (const auto& instance : reply.instance_list().instances())
+        pages.emplace_back().mutable_instance_list()->add_instances()->CopyFrom(instance);
+
+    pages.emplace_back().mutable_instance_list();
+    return pages;
+}
+
+std::vector<mp::InfoReply> one_instance_per_page(const mp::InfoReply& reply)
+{
+    std::vector<mp::InfoReply> pages;
+    for (const auto& details : reply.details())
+        pages.emplace_back().add_details()->CopyFrom(details);
+
+    pages.emplace_back();
+    return pages;
+}
+
+template <typename Reply>
+std::string render_pages(const mp::Formatter& formatter, const std::vector<Reply>& pages)
+{
+    std::string output;
+    const Reply* opening_page = nullptr;
+    for (const auto& page : pages)
+    {
+        const auto rendered = formatter.format_page(page, opening_page);
+        output += rendered;
+        if (!opening_page && !rendered.empty())
+            opening_page = &page;
+    }
+
+    return output + formatter.finish_pages(pages.back(), opening_page);
+}
 } // namespace
 
 TEST_P(FormatterSuite, properlyFormatsOutput)
@@ -1487,3 +1524,88 @@ TEST_F(BaseFormatterSuite, yaml_formatter_formats_zones_correctly)
 
     EXPECT_EQ(yaml_formatter.format(zones_reply), expected_output);
 }
+
+TEST_F(BaseFormatterSuite, jsonFormatterJoinsListPagesIntoOneDocument)
+{
+    EXPECT_EQ(render_pages(json_formatter, one_instance_per_page(multiple_instances_list_reply)),
+              json_formatter.format(multiple_instances_list_reply));
+}
+
+TEST_F(BaseFormatterSuite, jsonFormatterJoinsInfoPagesIntoOneDocument)
+{
+    EXPECT_EQ(render_pages(json_formatter, one_instance_per_page(multiple_instances_info_reply)),
+              json_formatter.format(multiple_instances_info_reply));
+}
+
+TEST_F(BaseFormatterSuite, jsonFormatterJoinsSnapshotListPagesIntoOneDocument)
+{
+    // The daemon pages snapshots by instance
+    std::vector<std::string> names;
+    std::vector<mp::ListReply> pages;
+    for (const auto& snapshot : multiple_snapshots_list_reply.snapshot_list().snapshots())
+    {
+        auto it = std::find(names.begin(), names.end(), snapshot.name());
+        if (it == names.end())
+        {
+            names.push_back(snapshot.name());
+            it = std::prev(names.end());
+            pages.emplace_back();
+        }
+
+        pages[std::distance(names.begin(), it)].mutable_snapshot_list()->add_snapshots()->CopyFrom(
+            snapshot);
+    }
+    pages.emplace_back().mutable_snapshot_list();
+
+    EXPECT_EQ(render_pages(json_formatter, pages),
+              json_formatter.format(multiple_snapshots_list_reply));
+}
+
+TEST_F(BaseFormatterSuite, tableFormatterLeavesPagesToBeMergedUnlessPrintingToATerminal)
+{
+    // Columns are sized, and rows sorted, over all instances at once for scripts
+    EXPECT_FALSE(table_formatter.renders_pages(false));
+    EXPECT_TRUE(table_formatter.renders_pages(true));
+}
+
+TEST_F(BaseFormatterSuite, tableFormatterJoinsListPagesUnderOneHeader)
+{
+    EXPECT_EQ(render_pages(table_formatter, one_instance_per_page(multiple_instances_list_reply)),
+              table_formatter.format(multiple_instances_list_reply));
+}
+
+TEST_F(BaseFormatterSuite, tableFormatterJoinsInfoPages)
+{
+    EXPECT_EQ(render_pages(table_formatter, one_instance_per_page(multiple_instances_info_reply)),
+              table_formatter.format(multiple_instances_info_reply));
+}
+
+TEST_F(BaseFormatterSuite, tableFormatterWidensColumnsOfLaterPagesOnlyForEntriesThatNeedIt)
+{
+    const std::string long_name(30, 'x');
+
+    std::vector<mp::ListReply> pages(3);
+    pages[0].mutable_instance_list()->add_instances()->set_name("short");
+    pages[1].mutable_instance_list()->add_instances()->set_name("shorter");
+    pages[2].mutable_instance_list()->add_instances()->set_name(long_name);
+    pages.emplace_back().mutable_instance_list();
+
+    const auto output = render_pages(table_formatter, pages);
+
+    std::vector<std::string> lines;
+    std::istringstream stream{output};
+    for (std::string line; std::getline(stream, line);)
+        lines.push_back(line);
+
+    ASSERT_EQ(lines.size(), 4u);
+    EXPECT_EQ(lines[0].find("State"), lines[1].find_first_not_of(' ', 5));
+    EXPECT_EQ(lines[1].find_first_not_of(' ', 5), lines[2].find_first_not_of(' ', 7));
+    EXPECT_GT(lines[3].find_first_not_of(' ', long_name.size()), long_name.size());
+}
+
+TEST_F(BaseFormatterSuite, jsonFormatterReportsNothingFoundWhenNoPageHasEntries)
+{
+    const std::vector<mp::ListReply> pages(2, empty_list_reply);
+
+    EXPECT_EQ(render_pages(json_formatter, pages), json_formatter.format(empty_list_reply));
+}
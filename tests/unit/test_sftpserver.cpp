@@ -40,6 +40,8 @@
 #include <algorithm>
 #include <queue>
 
+#include <fcntl.h>
+
 namespace mp = multipass;
 namespace mpl = multipass::logging;
 namespace mpt = multipass::test;
@@ -49,6 +51,7 @@ namespace fs = std::filesystem;
 using namespace testing;
 
 using StringUPtr = std::unique_ptr<ssh_string_struct, void (*)(ssh_string)>;
+using BufferUPtr = std::unique_ptr<ssh_buffer_struct, void (*)(ssh_buffer)>;
 
 namespace
 {
@@ -305,6 +308,34 @@ auto make_data(const std::string& in)
     return out;
 }
 
+std::string packed(std::uint64_t value, int size = 8)
+{
+    std::string out;
+    for (auto shift = (size - 1) * 8; shift >= 0; shift -= 8)
+        out += static_cast<char>((value >> shift) & 0xff);
+    return out;
+}
+
+std::string packed(const std::string& value)
+{
+    return packed(value.size(), 4) + value;
+}
+
+std::string contents_of(ssh_buffer buffer)
+{
+    return {static_cast<const char*>(ssh_buffer_get_data(buffer)), ssh_buffer_get_len(buffer)};
+}
+
+// Extended requests as libssh keeps them whole: id, extension name, then its own arguments
+auto make_extended_request(const std::string& name, const std::string& arguments)
+{
+    const auto request = packed(42, 4) + packed(name) + arguments;
+
+    BufferUPtr out{ssh_buffer_new(), ssh_buffer_free};
+    ssh_buffer_add_data(out.get(), request.data(), request.size());
+    return out;
+}
+
 bool content_match(const QString& path, const std::string& data)
 {
     auto content = mpt::load(path);
@@ -371,8 +402,8 @@ TEST_F(SftpServer, throwsWhenFailedToInit)
 {
     auto init_msg = make_msg(SSH_FXP_INIT);
     REPLACE(sftp_get_client_message, make_msg_handler());
-    auto bad_reply_version = [](auto...) { return SSH_ERROR; };
-    REPLACE(sftp_reply_version, bad_reply_version);
+    auto bad_packet_write = [](auto...) { return SSH_ERROR; };
+    REPLACE(sftp_packet_write, bad_packet_write);
     EXPECT_THROW(make_sftpserver(), mp::SSHException);
 }
 
@@ -2541,9 +2572,9 @@ TEST_F(SftpServer, handlesWrites)
     std::stringstream stream;
 
     const auto [file_ops, mock_file_ops_guard] = mpt::MockFileOps::inject();
-    EXPECT_CALL(*file_ops, lseek).WillRepeatedly(Return(true));
-    EXPECT_CALL(*file_ops, write(fd, _, _))
-        .WillRepeatedly([&stream](int, const void* buf, size_t nbytes) {
+    EXPECT_CALL(*file_ops, pwrite(fd, _, _, _))
+        .WillRepeatedly([&stream](int, const void* buf, size_t nbytes, std::int64_t offset) {
+            EXPECT_EQ(offset, stream.tellp());
             stream.write((const char*)buf, nbytes);
             return nbytes;
         });
@@ -2566,33 +2597,87 @@ TEST_F(SftpServer, handlesWrites)
     EXPECT_EQ(stream.str(), "The answer is always 42");
 }
 
-TEST_F(SftpServer, writeCannotSeekFails)
+TEST_F(SftpServer, mergesWritesWhileMoreAreWaiting)
 {
     mpt::TempDir temp_dir;
 
     auto init_msg = make_msg(SSH_FXP_INIT);
-    auto write_msg = make_msg(SFTP_WRITE);
+    auto write_msg1 = make_msg(SFTP_WRITE);
     auto data1 = make_data("The answer is ");
-    write_msg->data = data1.get();
-    write_msg->offset = 10;
+    write_msg1->data = data1.get();
+    write_msg1->offset = 10;
+
+    auto write_msg2 = make_msg(SFTP_WRITE);
+    auto data2 = make_data("always 42");
+    write_msg2->data = data2.get();
+    write_msg2->offset = 10 + ssh_string_len(data1.get());
 
     const auto path = mp::fs::path{temp_dir.path().toStdString()} / "test-file";
     const auto fd = 123;
     const auto named_fd = std::make_pair(path, fd);
 
+    int num_calls{0};
     const auto [file_ops, mock_file_ops_guard] = mpt::MockFileOps::inject();
-    EXPECT_CALL(*file_ops, lseek(fd, _, _)).WillRepeatedly(Return(-1));
+    EXPECT_CALL(*file_ops, pwrite(fd, _, _, 10))
+        .WillOnce([&num_calls](int, const void* buf, size_t nbytes, std::int64_t) {
+            EXPECT_EQ(num_calls, 0) << "writes are replied to before their data is written";
+            EXPECT_EQ(std::string((const char*)buf, nbytes), "The answer is always 42");
+            return nbytes;
+        });
 
+    REPLACE(ssh_channel_poll, [this](auto...) { return messages.empty() ? 0 : 1; });
     REPLACE(sftp_handle, [&named_fd](auto...) { return (void*)&named_fd; });
     REPLACE(sftp_get_client_message, make_msg_handler());
-    int failure_num_calls{0};
-    REPLACE(sftp_reply_status,
-            make_reply_status(write_msg.get(), SSH_FX_FAILURE, failure_num_calls));
+
+    auto reply_status = [&num_calls](auto, uint32_t status, auto) {
+        EXPECT_TRUE(status == SSH_FX_OK);
+        ++num_calls;
+        return SSH_OK;
+    };
+    REPLACE(sftp_reply_status, reply_status);
 
     auto sftp = make_sftpserver(temp_dir.path().toStdString());
     sftp.run();
 
-    EXPECT_EQ(failure_num_calls, 1);
+    EXPECT_EQ(num_calls, 2);
+}
+
+TEST_F(SftpServer, failsEveryMergedWriteWhenTheirDataCannotBeWritten)
+{
+    mpt::TempDir temp_dir;
+
+    auto init_msg = make_msg(SSH_FXP_INIT);
+    auto write_msg1 = make_msg(SFTP_WRITE);
+    auto data1 = make_data("The answer is ");
+    write_msg1->data = data1.get();
+    write_msg1->offset = 10;
+
+    auto write_msg2 = make_msg(SFTP_WRITE);
+    auto data2 = make_data("always 42");
+    write_msg2->data = data2.get();
+    write_msg2->offset = 10 + ssh_string_len(data1.get());
+
+    const auto path = mp::fs::path{temp_dir.path().toStdString()} / "test-file";
+    const auto fd = 123;
+    const auto named_fd = std::make_pair(path, fd);
+
+    const auto [file_ops, mock_file_ops_guard] = mpt::MockFileOps::inject();
+    EXPECT_CALL(*file_ops, pwrite(fd, _, _, _)).WillOnce(Return(-1));
+
+    REPLACE(ssh_channel_poll, [this](auto...) { return messages.empty() ? 0 : 1; });
+    REPLACE(sftp_handle, [&named_fd](auto...) { return (void*)&named_fd; });
+    REPLACE(sftp_get_client_message, make_msg_handler());
+
+    std::vector<uint32_t> statuses;
+    REPLACE(sftp_reply_status, [&statuses](auto, uint32_t status, auto) {
+        statuses.push_back(status);
+        return SSH_OK;
+    });
+
+    auto sftp = make_sftpserver(temp_dir.path().toStdString());
+    sftp.run();
+
+    EXPECT_THAT(statuses, ElementsAre(SSH_FX_FAILURE, SSH_FX_FAILURE));
 }
 
 TEST_F(SftpServer, writeFailureFails)
@@ -2610,8 +2695,7 @@ TEST_F(SftpServer, writeFailureFails)
     const auto named_fd = std::make_pair(path, fd);
 
     const auto [file_ops, mock_file_ops_guard] = mpt::MockFileOps::inject();
-    EXPECT_CALL(*file_ops, lseek(fd, _, _)).WillRepeatedly(Return(true));
-    EXPECT_CALL(*file_ops, write(fd, _, _)).WillRepeatedly(Return(-1));
+    EXPECT_CALL(*file_ops, pwrite(fd, _, _, _)).WillRepeatedly(Return(-1));
 
     REPLACE(sftp_handle, [&named_fd](auto...) { return (void*)&named_fd; });
     REPLACE(sftp_get_client_message, make_msg_handler());
@@ -3012,6 +3096,170 @@ TEST_F(SftpServer, invalidExtendedFails)
     EXPECT_THAT(num_calls, Eq(1));
 }
 
+TEST_F(SftpServer, advertisesExtensionsOnInit)
+{
+    auto init_msg = make_msg(SSH_FXP_INIT);
+    REPLACE(sftp_get_client_message, make_msg_handler());
+
+    std::string version;
+    REPLACE(sftp_packet_write, [&version](sftp_session, uint8_t type, ssh_buffer payload) {
+        EXPECT_EQ(type, SSH_FXP_VERSION);
+        version = contents_of(payload);
+        return SSH_OK;
+    });
+
+    auto sftp = make_sftpserver();
+
+    EXPECT_THAT(version, StartsWith(packed(LIBSFTP_VERSION, 4)));
+    EXPECT_THAT(version, HasSubstr(packed("statvfs@openssh.com") + packed("2")));
+    EXPECT_THAT(version, HasSubstr(packed("fsync@openssh.com") + packed("1")));
+    EXPECT_THAT(version, HasSubstr(packed("limits@openssh.com") + packed("1")));
+    EXPECT_THAT(version, HasSubstr(packed("copy-data") + packed("1")));
+}
+
+TEST_F(SftpServer, handlesLimits)
+{
+    auto init_msg = make_msg(SSH_FXP_INIT);
+    auto msg = make_msg(SFTP_EXTENDED);
+    auto submessage = name_as_char_array("limits@openssh.com");
+    msg->submessage = submessage.data();
+    msg->id = 42;
+
+    REPLACE(sftp_get_client_message, make_msg_handler());
+
+    std::string reply;
+    REPLACE(sftp_packet_write, [&reply](sftp_session, uint8_t type, ssh_buffer payload) {
+        if (type == SSH_FXP_EXTENDED_REPLY)
+            reply = contents_of(payload);
+        return SSH_OK;
+    });
+
+    auto sftp = make_sftpserver();
+    sftp.run();
+
+    EXPECT_EQ(reply,
+              packed(42, 4) + packed(256 * 1024) + packed(255 * 1024) + packed(255 * 1024) +
+                  packed(0));
+}
+
+TEST_F(SftpServer, handlesStatvfs)
+{
+    mpt::TempDir temp_dir;
+
+    auto init_msg = make_msg(SSH_FXP_INIT);
+    auto msg = make_msg(SFTP_EXTENDED);
+    auto submessage = name_as_char_array("statvfs@openssh.com");
+    msg->submessage = submessage.data();
+    msg->id = 42;
+    auto request =
+        make_extended_request("statvfs@openssh.com", packed(temp_dir.path().toStdString()));
+    msg->complete_message = request.get();
+
+    REPLACE(sftp_get_client_message, make_msg_handler());
+
+    std::string reply;
+    REPLACE(sftp_packet_write, [&reply](sftp_session, uint8_t type, ssh_buffer payload) {
+        if (type == SSH_FXP_EXTENDED_REPLY)
+            reply = contents_of(payload);
+        return SSH_OK;
+    });
+
+    auto sftp = make_sftpserver(temp_dir.path().toStdString());
+    sftp.run();
+
+    ASSERT_EQ(reply.size(), 4u + 11 * 8);
+    EXPECT_THAT(reply, StartsWith(packed(42, 4) + packed(4096) + packed(4096)));
+}
+
+TEST_F(SftpServer, handlesFsync)
+{
+    mpt::TempDir temp_dir;
+
+    auto init_msg = make_msg(SSH_FXP_INIT);
+    auto msg = make_msg(SFTP_EXTENDED);
+    auto submessage = name_as_char_array("fsync@openssh.com");
+    msg->submessage = submessage.data();
+    auto request = make_extended_request("fsync@openssh.com", packed("handle"));
+    msg->complete_message = request.get();
+
+    const auto path = mp::fs::path{temp_dir.path().toStdString()} / "test-file";
+    const auto fd = 123;
+    const auto named_fd = std::make_pair(path, fd);
+
+    const auto [file_ops, mock_file_ops_guard] = mpt::MockFileOps::inject();
+    EXPECT_CALL(*file_ops, fsync(fd)).WillOnce(Return(true));
+
+    REPLACE(sftp_handle, [&named_fd](auto...) { return (void*)&named_fd; });
+    REPLACE(sftp_get_client_message, make_msg_handler());
+
+    int num_calls{0};
+    auto reply_status = make_reply_status(msg.get(), SSH_FX_OK, num_calls);
+    REPLACE(sftp_reply_status, reply_status);
+
+    auto sftp = make_sftpserver(temp_dir.path().toStdString());
+    sftp.run();
+
+    EXPECT_THAT(num_calls, Eq(1));
+}
+
+struct CopyData : public SftpServer
+{
+    CopyData()
+    {
+        mpt::make_file_with_content(source_name, "The answer is always 42");
+        mpt::make_file_with_content(destination_name, "");
+    }
+
+    void copy(int destination_flags, uint32_t expected_status)
+    {
+        const auto source = MP_FILEOPS.open_fd(source_name.toStdString(), O_RDONLY, 0);
+        const auto destination =
+            MP_FILEOPS.open_fd(destination_name.toStdString(), destination_flags, 0);
+
+        auto init_msg = make_msg(SSH_FXP_INIT);
+        auto msg = make_msg(SFTP_EXTENDED);
+        auto submessage = name_as_char_array("copy-data");
+        msg->submessage = submessage.data();
+        auto request = make_extended_request(
+            "copy-data",
+            packed("source") + packed(0) + packed(0) + packed("destination") + packed(0));
+        msg->complete_message = request.get();
+
+        REPLACE(sftp_handle, [&source, &destination](sftp_session, ssh_string handle) -> void* {
+            const std::string id{ssh_string_get_char(handle), ssh_string_len(handle)};
+            return id == "source" ? source.get() : destination.get();
+        });
+        REPLACE(sftp_get_client_message, make_msg_handler());
+
+        int num_calls{0};
+        auto reply_status = make_reply_status(msg.get(), expected_status, num_calls);
+        REPLACE(sftp_reply_status, reply_status);
+
+        auto sftp = make_sftpserver(temp_dir.path().toStdString());
+        sftp.run();
+
+        EXPECT_THAT(num_calls, Eq(1));
+    }
+
+    mpt::TempDir temp_dir;
+    const QString source_name = temp_dir.path() + "/source";
+    const QString destination_name = temp_dir.path() + "/destination";
+};
+
+TEST_F(CopyData, copiesBetweenHandlesOnTheHost)
+{
+    copy(O_WRONLY, SSH_FX_OK);
+
+    EXPECT_TRUE(content_match(destination_name, "The answer is always 42"));
+}
+
+TEST_F(CopyData, needsWritableDestinationHandle)
+{
+    copy(O_RDONLY, SSH_FX_PERMISSION_DENIED);
+
+    EXPECT_TRUE(content_match(destination_name, ""));
+}
+
 TEST_P(Stat, handles)
 {
     mpt::TempDir temp_dir;
@@ -3587,6 +3835,44 @@ TEST_F(SftpServer, canonicalErrorPermissionDenied)
     EXPECT_THAT(num_calls, Eq(1));
 }
 
+TEST_F(SftpServer, pathResolvedBeneathSourceSkipsWalk)
+{
+    mpt::TempDir temp_dir;
+    const auto file_name = fs::weakly_canonical(temp_dir.path().toStdString()) / "test-file";
+    mpt::make_file_with_content(QString::fromStdString(file_name.string()));
+
+    auto init_msg = make_msg(SSH_FXP_INIT);
+    auto msg = make_msg(SFTP_LSTAT);
+    auto name = name_as_char_array(file_name.string());
+    msg->filename = name.data();
+
+    REPLACE(sftp_get_client_message, make_msg_handler());
+
+    const auto [file_ops, mock_file_ops_guard] = mpt::MockFileOps::inject();
+    // Only to find the source, when the server starts
+    EXPECT_CALL(*file_ops, weakly_canonical).WillOnce([](const fs::path& path) {
+        return fs::weakly_canonical(path);
+    });
+    EXPECT_CALL(*file_ops, resolves_beneath(_, fs::path{"./test-file"}, false))
+        .WillOnce(Return(true));
+    EXPECT_CALL(*file_ops, exists(A<const fs::path&>())).Times(0);
+    EXPECT_CALL(*file_ops, is_symlink).Times(0);
+    EXPECT_CALL(*file_ops, exists(A<const QFileInfo&>())).WillOnce(Return(true));
+
+    int num_calls{0};
+    auto reply_attr = [&num_calls, &msg](sftp_client_message m, sftp_attributes) {
+        EXPECT_THAT(m, Eq(msg.get()));
+        ++num_calls;
+        return SSH_OK;
+    };
+    REPLACE(sftp_reply_attr, reply_attr);
+
+    auto sftp = make_sftpserver(temp_dir.path().toStdString());
+    sftp.run();
+
+    EXPECT_THAT(num_calls, Eq(1));
+}
+
 TEST_F(SftpServer, relativeErrorPermissionDenied)
 {
     mpt::TempDir temp_dir;
@@ -111,6 +111,39 @@ TEST_F(TestSimpleStreamsManifest, throwsWhenFailedToParseAnyProducts)
                  mp::EmptyManifestException);
 }
 
+TEST_F(TestSimpleStreamsManifest, keepsOnlyProductsOfThisArchitecture)
+{
+    const auto product = QStringLiteral(
+        R"("com.ubuntu.cloud:server:24.04:%1": {"aliases": "%2", "arch": "%1", "os": "ubuntu", )"
+        R"("release": "noble", "supported": true, "versions": {"20240423": {"items": {)"
+        R"("lxd.tar.xz": {"ftype": "lxd.tar.xz", "path": "noble/lxd.tar.xz"}, )"
+        R"("disk1.img": {"ftype": "disk1.img", "path": "noble/%1-disk1.img", )"
+        R"("sha256": "%3", "size": 42}}}}})");
+    const auto other_arch = product.arg(QString{"not-this-arch"}, QString{"other"}, QString{"1"});
+    const auto this_arch = product.arg(QString{MANIFEST_ARCH}, QString{"noble"}, QString{"2"});
+    const auto json = QStringLiteral(R"({"updated": "today", "products": {%1, %2}})")
+                          .arg(other_arch, this_arch)
+                          .toUtf8();
+
+    const auto manifest = mp::SimpleStreamsManifest::fromJson(json, std::nullopt, "host/");
+
+    EXPECT_EQ(manifest->updated_at, "today");
+    ASSERT_EQ(manifest->products.size(), 1u);
+    EXPECT_EQ(manifest->products.front().id, "2");
+    EXPECT_EQ(manifest->products.front().image_location,
+              std::string{"host/noble/"} + MANIFEST_ARCH + "-disk1.img");
+    EXPECT_EQ(manifest->image_records.count("other"), 0u);
+}
+
+TEST_F(TestSimpleStreamsManifest, throwsOnTrailingData)
+{
+    auto json = mpt::load_test_file("simple_streams_manifest/good_manifest.json");
+    json.append("}");
+
+    EXPECT_THROW(mp::SimpleStreamsManifest::fromJson(json, std::nullopt, ""),
+                 mp::GenericManifestException);
+}
+
 TEST_F(TestSimpleStreamsManifest, choosesNewestVersion)
 {
     auto json = mpt::load_test_file("simple_streams_manifest/multiple_versions_manifest.json");
@@ -25,17 +25,23 @@
 #include "mock_virtual_machine.h"
 #include "stub_ssh_key_provider.h"
 
+#include <src/sshfs_mount/sshfs_server_protocol.h>
+
 #include <multipass/exceptions/exitless_sshprocess_exceptions.h>
 #include <multipass/exceptions/sshfs_missing_error.h>
 #include <multipass/sshfs_mount/sshfs_mount_handler.h>
 #include <multipass/vm_mount.h>
 
 #include <QCoreApplication>
-#include <QTimer>
+
+#include <functional>
+#include <memory>
+#include <optional>
 
 namespace mp = multipass;
 namespace mpl = multipass::logging;
 namespace mpt = multipass::test;
+namespace mpsp = multipass::sshfs_server_protocol;
 
 using namespace testing;
 
@@ -94,18 +100,60 @@ struct SSHFSMountHandlerTest : public ::Test
     NiceMock<mpt::MockVirtualMachine> vm;
     std::unique_ptr<mpt::MockProcessFactory::Scope> factory = mpt::MockProcessFactory::Inject();
 
-    mpt::MockProcessFactory::Callback sshfs_prints_connected = [](mpt::MockProcess* process) {
-        // Have "sshfs_server" print "Connected" to its stdout after short delay
-        ON_CALL(*process, read_all_standard_output).WillByDefault(Return("Connected"));
-        QTimer::singleShot(1, process, [process] { emit process->ready_read_standard_output(); });
-        // Ensure process_state() does not have an exit code set (i.e. still running)
-        ON_CALL(*process, process_state).WillByDefault(Return(mp::ProcessState{}));
-    };
+    // Has "sshfs_server" reply to each request it gets as the given function says, and remember
+    // the requests
+    mpt::MockProcessFactory::Callback replying_with(
+        std::function<std::optional<mpsp::Reply>(const mpsp::Request&)> reply_to)
+    {
+        return [this, reply_to](mpt::MockProcess* process) {
+            auto output = std::make_shared<QByteArray>();
+            ON_CALL(*process, read_all_standard_output).WillByDefault([output] {
+                return std::exchange(*output, {});
+            });
+            ON_CALL(*process, write).WillByDefault([this, process, output, reply_to](auto data) {
+                auto request = mpsp::parse_request(data.toStdString());
+                EXPECT_TRUE(request) << data.toStdString();
+
+                if (request)
+                {
+                    requests.push_back(*request);
+                    if (auto reply = reply_to(*request))
+                    {
+                        *output += QByteArray::fromStdString(mpsp::serialise(*reply) + "\n");
+                        emit process->ready_read_standard_output();
+                    }
+                }
+
+                return data.size();
+            });
+        };
+    }
+
+    // Has "sshfs_server" exit as soon as it gets a request
+    mpt::MockProcessFactory::Callback exiting_with(mp::ProcessState exit_state)
+    {
+        return [exit_state](mpt::MockProcess* process) {
+            ON_CALL(*process, write).WillByDefault([process, exit_state](auto data) {
+                emit process->finished(exit_state);
+                return data.size();
+            });
+        };
+    }
+
+    static std::optional<mpsp::Reply> acknowledge(const mpsp::Request& request)
+    {
+        return mpsp::Reply{request.type == mpsp::Request::Type::mount
+                               ? mpsp::Reply::Type::connected
+                               : mpsp::Reply::Type::stopped,
+                           request.id};
+    }
+
+    std::vector<mpsp::Request> requests; // only touched on the server's thread while it runs
 };
 
 TEST_F(SSHFSMountHandlerTest, mountCreatesSshfsProcess)
 {
-    factory->register_callback(sshfs_server_callback(sshfs_prints_connected));
+    factory->register_callback(sshfs_server_callback(replying_with(acknowledge)));
 
     mpt::MockVirtualMachine mock_vm{};
     EXPECT_CALL(mock_vm, ssh_port()).Times(1);
@@ -120,31 +168,76 @@ TEST_F(SSHFSMountHandlerTest, mountCreatesSshfsProcess)
     auto sshfs_command = factory->process_list()[0];
     EXPECT_TRUE(sshfs_command.command.endsWith("sshfs_server"));
 
-    ASSERT_EQ(sshfs_command.arguments.size(), 8);
+    ASSERT_EQ(sshfs_command.arguments.size(), 4);
     EXPECT_EQ(sshfs_command.arguments[0], "localhost");
     EXPECT_EQ(sshfs_command.arguments[1], "42");
     EXPECT_EQ(sshfs_command.arguments[2], "ubuntu");
-    EXPECT_EQ(sshfs_command.arguments[3].toStdString(), source_path);
-    EXPECT_EQ(sshfs_command.arguments[4], "/the/target/path");
-    // Ordering of the next 2 options not guaranteed, hence the or-s.
-    EXPECT_TRUE(sshfs_command.arguments[5] == "6:10,5:-1," ||
-                sshfs_command.arguments[5] == "5:-1,6:10,");
-    EXPECT_TRUE(sshfs_command.arguments[6] == "3:4,1:2," ||
-                sshfs_command.arguments[6] == "1:2,3:4,");
 
     const QString log_level_as_string{QString::number(static_cast<int>(default_log_level))};
-    EXPECT_EQ(sshfs_command.arguments[7], log_level_as_string);
+    EXPECT_EQ(sshfs_command.arguments[3], log_level_as_string);
+}
+
+TEST_F(SSHFSMountHandlerTest, mountRequestsServingTheMount)
+{
+    factory->register_callback(sshfs_server_callback(replying_with(acknowledge)));
+
+    mp::SSHFSMountHandler sshfs_mount_handler{&vm, &key_provider, target_path, mount};
+    sshfs_mount_handler.activate(&server);
+
+    ASSERT_EQ(requests.size(), 1u);
+    EXPECT_EQ(requests[0].type, mpsp::Request::Type::mount);
+    EXPECT_EQ(requests[0].id, target_path);
+    EXPECT_EQ(requests[0].source, source_path);
+    EXPECT_EQ(requests[0].target, target_path);
+    EXPECT_THAT(requests[0].uid_mappings, UnorderedElementsAreArray(uid_mappings));
+    EXPECT_THAT(requests[0].gid_mappings, UnorderedElementsAreArray(gid_mappings));
+}
+
+TEST_F(SSHFSMountHandlerTest, mountsOfAnInstanceShareOneProcess)
+{
+    factory->register_callback(sshfs_server_callback(replying_with(acknowledge)));
+    EXPECT_CALL(mock_file_ops, status)
+        .WillOnce(Return(mp::fs::file_status{mp::fs::file_type::directory, mp::fs::perms::all}))
+        .RetiresOnSaturation();
+
+    mp::SSHFSMountHandler first_handler{&vm, &key_provider, target_path, mount};
+    mp::SSHFSMountHandler second_handler{&vm, &key_provider, "/another/target", mount};
+    first_handler.activate(&server);
+    second_handler.activate(&server);
+
+    EXPECT_EQ(factory->process_list().size(), 1u);
+    ASSERT_EQ(requests.size(), 2u);
+    EXPECT_EQ(requests[1].target, "/another/target");
+}
+
+TEST_F(SSHFSMountHandlerTest, sshfsMissingInInstanceCausesException)
+{
+    factory->register_callback(sshfs_server_callback(replying_with([](const auto& request) {
+        return mpsp::Reply{mpsp::Reply::Type::failed,
+                           request.id,
+                           mpsp::sshfs_missing_code,
+                           "SSHFS was not found"};
+    })));
+
+    mp::SSHFSMountHandler sshfs_mount_handler{&vm, &key_provider, target_path, mount};
+    EXPECT_THROW(sshfs_mount_handler.activate(&server), mp::SSHFSMissingError);
+}
+
+TEST_F(SSHFSMountHandlerTest, failedMountCausesRuntimeException)
+{
+    factory->register_callback(sshfs_server_callback(replying_with([](const auto& request) {
+        return mpsp::Reply{mpsp::Reply::Type::failed, request.id, 1, "Whoopsie"};
+    })));
+
+    mp::SSHFSMountHandler sshfs_mount_handler{&vm, &key_provider, target_path, mount};
+    MP_EXPECT_THROW_THAT(sshfs_mount_handler.activate(&server),
+                         std::runtime_error,
+                         mpt::match_what(StrEq("Whoopsie")));
 }
 
 TEST_F(SSHFSMountHandlerTest, sshfsProcessFailingWithReturnCode9CausesException)
 {
-    factory->register_callback(sshfs_server_callback([](mpt::MockProcess* process) {
-        mp::ProcessState exit_state;
-        exit_state.exit_code = 9;
-        // Have "sshfs_server" die after short delay
-        QTimer::singleShot(100, process, [process]() { emit process->finished({9, {}}); });
-        ON_CALL(*process, process_state()).WillByDefault(Return(exit_state));
-    }));
+    factory->register_callback(sshfs_server_callback(exiting_with({9, {}})));
 
     mp::SSHFSMountHandler sshfs_mount_handler{&vm, &key_provider, target_path, mount};
     EXPECT_THROW(sshfs_mount_handler.activate(&server), mp::SSHFSMissingError);
@@ -156,15 +249,9 @@ TEST_F(SSHFSMountHandlerTest, sshfsProcessFailingWithReturnCode9CausesException)
 
 TEST_F(SSHFSMountHandlerTest, sshfsProcessFailingCausesRuntimeException)
 {
-    factory->register_callback(sshfs_server_callback([](mpt::MockProcess* process) {
-        mp::ProcessState exit_state;
-        exit_state.exit_code = 1;
-        // Have "sshfs_server" die after short delay
+    factory->register_callback(sshfs_server_callback([this](mpt::MockProcess* process) {
         ON_CALL(*process, read_all_standard_error()).WillByDefault(Return("Whoopsie"));
-        QTimer::singleShot(100, process, [process, exit_state]() {
-            emit process->finished(exit_state);
-        });
-        ON_CALL(*process, process_state()).WillByDefault(Return(exit_state));
+        exiting_with({1, {}})(process);
     }));
 
     mp::SSHFSMountHandler sshfs_mount_handler{&vm, &key_provider, target_path, mount};
@@ -173,10 +260,10 @@ TEST_F(SSHFSMountHandlerTest, sshfsProcessFailingCausesRuntimeException)
                          mpt::match_what(StrEq("Process returned exit code: 1: Whoopsie")));
 }
 
-TEST_F(SSHFSMountHandlerTest, stopTerminatesSshfsProcess)
+TEST_F(SSHFSMountHandlerTest, stopRequestsUnmountingAndTerminatesSshfsProcess)
 {
     factory->register_callback(sshfs_server_callback([this](mpt::MockProcess* process) {
-        sshfs_prints_connected(process);
+        replying_with(acknowledge)(process);
         EXPECT_CALL(*process, terminate);
         EXPECT_CALL(*process, wait_for_finished).WillOnce(Return(true));
     }));
@@ -184,6 +271,10 @@ TEST_F(SSHFSMountHandlerTest, stopTerminatesSshfsProcess)
     mp::SSHFSMountHandler sshfs_mount_handler{&vm, &key_provider, target_path, mount};
     sshfs_mount_handler.activate(&server);
     sshfs_mount_handler.deactivate();
+
+    ASSERT_EQ(requests.size(), 2u);
+    EXPECT_EQ(requests[1].type, mpsp::Request::Type::unmount);
+    EXPECT_EQ(requests[1].id, target_path);
 }
 
 TEST_F(SSHFSMountHandlerTest, throwsInstallSshfsWhichSnapFails)
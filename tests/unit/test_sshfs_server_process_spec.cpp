@@ -36,10 +36,7 @@ struct TestSSHFSServerProcessSpec : public Test
                                  "username",
                                  "instance",
                                  "private_key",
-                                 "source_path",
-                                 "target_path",
-                                 {{1, 2}, {3, 4}},
-                                 {{5, -1}, {6, 10}}};
+                                 {"/source/path", "/other/source/path"}};
 };
 
 TEST_F(TestSSHFSServerProcessSpec, programCorrect)
@@ -51,16 +48,11 @@ TEST_F(TestSSHFSServerProcessSpec, programCorrect)
 TEST_F(TestSSHFSServerProcessSpec, argumentsCorrect)
 {
     mp::SSHFSServerProcessSpec spec(config);
-    ASSERT_EQ(spec.arguments().size(), 8);
+    ASSERT_EQ(spec.arguments().size(), 4);
     EXPECT_EQ(spec.arguments()[0], "host");
     EXPECT_EQ(spec.arguments()[1], "42");
     EXPECT_EQ(spec.arguments()[2], "username");
-    EXPECT_EQ(spec.arguments()[3], "source_path");
-    EXPECT_EQ(spec.arguments()[4], "target_path");
-    // Ordering of the next 2 options not guaranteed, hence the or-s.
-    EXPECT_TRUE(spec.arguments()[5] == "6:10,5:-1," || spec.arguments()[5] == "5:-1,6:10,");
-    EXPECT_TRUE(spec.arguments()[6] == "3:4,1:2," || spec.arguments()[6] == "1:2,3:4,");
-    EXPECT_EQ(spec.arguments()[7], "0");
+    EXPECT_EQ(spec.arguments()[3], "0");
 }
 
 TEST_F(TestSSHFSServerProcessSpec, environmentCorrect)
@@ -103,3 +95,28 @@ TEST_F(TestSSHFSServerProcessSpec, unconfinedApparmorProfileReturnsExpectedData)
     EXPECT_TRUE(apparmor_profile.contains(current_dir.absolutePath() + "/{usr/,}lib/**"));
     EXPECT_TRUE(apparmor_profile.contains("signal (receive) peer=unconfined"));
 }
+
+TEST_F(TestSSHFSServerProcessSpec, identifierIsTheInstance)
+{
+    mp::SSHFSServerProcessSpec spec(config);
+    EXPECT_EQ(spec.identifier(), "instance");
+}
+
+TEST_F(TestSSHFSServerProcessSpec, apparmorProfileAllowsAllSourcePaths)
+{
+    mp::SSHFSServerProcessSpec spec(config);
+    const auto apparmor_profile = spec.apparmor_profile();
+
+    EXPECT_TRUE(apparmor_profile.contains("/source/path/ rw,"));
+    EXPECT_TRUE(apparmor_profile.contains("/source/path/** rwlk,"));
+    EXPECT_TRUE(apparmor_profile.contains("/other/source/path/ rw,"));
+    EXPECT_TRUE(apparmor_profile.contains("/other/source/path/** rwlk,"));
+}
+
+TEST_F(TestSSHFSServerProcessSpec, apparmorProfileAllowsNoSourcePathsWithoutMounts)
+{
+    config.source_paths.clear();
+    mp::SSHFSServerProcessSpec spec(config);
+
+    EXPECT_FALSE(spec.apparmor_profile().contains("rwlk"));
+}
@@ -0,0 +1,106 @@
+/*
+ * Copyright (C) Canonical, Ltd.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "common.h"
+
+#include <src/sshfs_mount/sshfs_server_protocol.h>
+
+namespace mp = multipass;
+namespace mpsp = multipass::sshfs_server_protocol;
+
+using namespace testing;
+
+namespace
+{
+TEST(SSHFSServerProtocol, mountRequestsSurviveTheTrip)
+{
+    const mpsp::Request request{mpsp::Request::Type::mount,
+                                "/home/ubuntu/space odyssey",
+                                "/home/me/space odyssey\nwith a newline",
+                                "/home/ubuntu/space odyssey",
+                                {{1000, 1001}, {5, -1}},
+                                {{1000, 1001}}};
+
+    const auto line = mpsp::serialise(request);
+    ASSERT_THAT(line, Not(HasSubstr("\n")));
+
+    const auto parsed = mpsp::parse_request(line + "\n");
+    ASSERT_TRUE(parsed);
+    EXPECT_EQ(parsed->type, mpsp::Request::Type::mount);
+    EXPECT_EQ(parsed->id, request.id);
+    EXPECT_EQ(parsed->source, request.source);
+    EXPECT_EQ(parsed->target, request.target);
+    EXPECT_EQ(parsed->uid_mappings, request.uid_mappings);
+    EXPECT_EQ(parsed->gid_mappings, request.gid_mappings);
+}
+
+TEST(SSHFSServerProtocol, mountRequestsWithoutMappingsSurviveTheTrip)
+{
+    const auto parsed = mpsp::parse_request(
+        mpsp::serialise({mpsp::Request::Type::mount, "/target", "/source", "/target"}));
+
+    ASSERT_TRUE(parsed);
+    EXPECT_EQ(parsed->source, "/source");
+    EXPECT_THAT(parsed->uid_mappings, IsEmpty());
+    EXPECT_THAT(parsed->gid_mappings, IsEmpty());
+}
+
+TEST(SSHFSServerProtocol, unmountRequestsSurviveTheTrip)
+{
+    const auto parsed =
+        mpsp::parse_request(mpsp::serialise({mpsp::Request::Type::unmount, "/some/target"}));
+
+    ASSERT_TRUE(parsed);
+    EXPECT_EQ(parsed->type, mpsp::Request::Type::unmount);
+    EXPECT_EQ(parsed->id, "/some/target");
+}
+
+TEST(SSHFSServerProtocol, repliesSurviveTheTrip)
+{
+    const mpsp::Reply reply{mpsp::Reply::Type::failed,
+                            "/some/target",
+                            mpsp::sshfs_missing_code,
+                            "SSHFS was not found"};
+
+    const auto line = mpsp::serialise(reply);
+    ASSERT_THAT(line, StartsWith(std::string{mpsp::reply_marker}));
+
+    const auto parsed = mpsp::parse_reply(line);
+    ASSERT_TRUE(parsed);
+    EXPECT_EQ(parsed->type, mpsp::Reply::Type::failed);
+    EXPECT_EQ(parsed->id, reply.id);
+    EXPECT_EQ(parsed->code, reply.code);
+    EXPECT_EQ(parsed->message, reply.message);
+}
+
+TEST(SSHFSServerProtocol, metricsAreNotReplies)
+{
+    EXPECT_FALSE(mpsp::parse_reply("multipass_sftp_bytes_total{direction=\"read\"} 42"));
+    EXPECT_FALSE(mpsp::parse_reply(mpsp::metrics_begin_marker));
+    EXPECT_FALSE(mpsp::parse_reply(mpsp::metrics_end_marker));
+}
+
+TEST(SSHFSServerProtocol, rejectsMalformedRequests)
+{
+    EXPECT_FALSE(mpsp::parse_request(""));
+    EXPECT_FALSE(mpsp::parse_request("mount"));
+    EXPECT_FALSE(mpsp::parse_request("mount L3Q= L3M="));
+    EXPECT_FALSE(mpsp::parse_request("mount L3Q= L3M= L3Q= 1:a, 1:2,"));
+    EXPECT_FALSE(mpsp::parse_request("unmount not*base64"));
+    EXPECT_FALSE(mpsp::parse_request("format L3Q="));
+}
+} // namespace
@@ -26,11 +26,12 @@
 
 #include <multipass/exceptions/sshfs_missing_error.h>
 #include <multipass/logging/log.h>
-#include <multipass/signal.h>
 #include <multipass/ssh/plain_ssh_session.h>
 #include <multipass/utils.h>
 
 #include <algorithm>
+#include <deque>
+#include <functional>
 #include <tuple>
 #include <vector>
 
@@ -175,7 +176,8 @@ struct SshfsMount : public mp::test::SftpServerTest
     void test_command_execution(const CommandVector& commands,
                                 std::optional<std::string> target = std::nullopt,
                                 std::optional<std::string> fail_cmd = std::nullopt,
-                                std::optional<bool> fail_invoked = std::nullopt)
+                                std::optional<bool> fail_invoked = std::nullopt,
+                                const std::function<void(mp::SshfsMount&)>& use = {})
     {
         bool invoked{false};
         std::string output;
@@ -202,7 +204,9 @@ struct SshfsMount : public mp::test::SftpServerTest
                                                         fail_invoked);
         REPLACE(ssh_channel_request_exec, request_exec);
 
-        make_sshfsmount(target.value_or(default_target));
+        auto sshfs_mount = make_sshfsmount(target.value_or(default_target));
+        if (use)
+            use(sshfs_mount);
 
         EXPECT_TRUE(next_expected_cmd == commands.end())
             << "\"" << next_expected_cmd->first << "\" not executed";
@@ -460,32 +464,37 @@ TEST_F(SshfsMount, throwsWhenSshfsDoesNotExist)
     EXPECT_TRUE(invoked);
 }
 
-TEST_F(SshfsMount, unblocksWhenSftpserverExits)
+TEST_F(SshfsMount, servesOneRequestPerCall)
 {
-    sftp_client_message_struct message{make_init_message()};
-    sftp_client_message message_ptr = &message;
-    mp::Signal client_message;
-    auto sftp_get_client_message_lambda =
-        [&client_message, message_ptr, calls = 0](sftp_session) mutable {
-            if (calls == 0)
-            {
-                calls++;
-                return message_ptr;
-            }
-            client_message.wait();
-            return static_cast<sftp_client_message>(nullptr);
-        };
-    REPLACE(sftp_get_client_message, sftp_get_client_message_lambda);
-    bool stopped_ok = false;
-    std::thread mount([&] {
-        test_command_execution(CommandVector());
-        stopped_ok = true;
+    sftp_client_message_struct init_message{make_init_message()};
+    sftp_client_message_struct unknown_message{};
+    unknown_message.type = 255u;
+    std::deque<sftp_client_message> messages{&init_message, &unknown_message};
+    REPLACE(sftp_get_client_message, [&messages](sftp_session) -> sftp_client_message {
+        if (messages.empty())
+            return nullptr;
+
+        auto message = messages.front();
+        messages.pop_front();
+        return message;
     });
 
-    client_message.signal();
+    int replies{0};
+    REPLACE(sftp_reply_status, [&replies](sftp_client_message, uint32_t status, const char*) {
+        EXPECT_EQ(status, SSH_FX_OP_UNSUPPORTED);
+        ++replies;
+        return SSH_OK;
+    });
 
-    mount.join();
-    EXPECT_TRUE(stopped_ok);
+    test_command_execution(CommandVector(),
+                           std::nullopt,
+                           std::nullopt,
+                           std::nullopt,
+                           [&replies](mp::SshfsMount& sshfs_mount) {
+                               EXPECT_EQ(replies, 0); // nothing is served unless asked
+                               EXPECT_TRUE(sshfs_mount.serve_next());
+                               EXPECT_EQ(replies, 1);
+                           });
 }
 
 TEST_F(SshfsMount, blankFuseVersionLogsError)
@@ -0,0 +1,186 @@
+/*
+ * Copyright (C) Canonical, Ltd.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "common.h"
+#include "file_operations.h"
+#include "temp_dir.h"
+
+#include <multipass/tracing.h>
+
+#include <boost/json.hpp>
+
+#include <thread>
+
+namespace mp = multipass;
+namespace mpt = multipass::test;
+namespace mptr = multipass::tracing;
+
+using namespace testing;
+
+namespace
+{
+struct TestTracing : public Test
+{
+    class TracerResetter : public mptr::Tracer
+    {
+    public:
+        static void reset()
+        {
+            mptr::Tracer::reset();
+        }
+    };
+
+    ~TestTracing() override
+    {
+        TracerResetter::reset();
+    }
+
+    static std::vector<std::string> names_of(const std::vector<mptr::Span>& spans)
+    {
+        std::vector<std::string> names;
+        for (const auto& span : spans)
+            names.push_back(span.name);
+
+        return names;
+    }
+};
+
+TEST_F(TestTracing, takesSpansOfTheCurrentTraceInStartOrder)
+{
+    {
+        mptr::TraceScope trace{"foo"};
+        mptr::ScopedSpan outer{"outer"};
+        {
+            mptr::ScopedSpan inner{"inner"};
+        }
+    }
+
+    const auto spans = MP_TRACER.take("foo");
+
+    EXPECT_THAT(names_of(spans), ElementsAre("outer", "inner"));
+    EXPECT_LE(spans[0].start, spans[1].start);
+    EXPECT_GE(spans[0].end, spans[1].end);
+}
+
+TEST_F(TestTracing, takeLeavesOtherTracesAlone)
+{
+    {
+        mptr::TraceScope trace{"foo"};
+        mptr::ScopedSpan span{"in foo"};
+    }
+    {
+        mptr::TraceScope trace{"bar"};
+        mptr::ScopedSpan span{"in bar"};
+    }
+
+    EXPECT_THAT(names_of(MP_TRACER.take("foo")), ElementsAre("in foo"));
+    EXPECT_THAT(MP_TRACER.take("foo"), IsEmpty());
+    EXPECT_THAT(names_of(MP_TRACER.take("bar")), ElementsAre("in bar"));
+}
+
+TEST_F(TestTracing, traceScopesNest)
+{
+    mptr::TraceScope outer{"foo"};
+    {
+        mptr::TraceScope inner{"bar"};
+        EXPECT_EQ(mptr::TraceScope::current(), "bar");
+    }
+
+    EXPECT_EQ(mptr::TraceScope::current(), "foo");
+}
+
+TEST_F(TestTracing, doesNotKeepSpansOutsideTraces)
+{
+    {
+        mptr::ScopedSpan span{"untraced"};
+    }
+
+    EXPECT_THAT(MP_TRACER.take(""), IsEmpty());
+}
+
+TEST_F(TestTracing, dropsOldestSpansBeyondBound)
+{
+    mptr::TraceScope trace{"foo"};
+    for (std::size_t i = 0; i <= mptr::Tracer::max_pending_spans; ++i)
+        mptr::ScopedSpan span{std::to_string(i)};
+
+    const auto spans = MP_TRACER.take("foo");
+
+    ASSERT_EQ(spans.size(), mptr::Tracer::max_pending_spans);
+    EXPECT_EQ(spans.front().name, "1");
+}
+
+TEST_F(TestTracing, carriesTraceOverToOtherThreads)
+{
+    std::function<void()> work;
+    {
+        mptr::TraceScope trace{"foo"};
+        work = mptr::in_current_trace([] { mptr::ScopedSpan span{"elsewhere"}; });
+    }
+
+    std::thread{work}.join();
+
+    const auto spans = MP_TRACER.take("foo");
+    ASSERT_THAT(names_of(spans), ElementsAre("elsewhere"));
+}
+
+TEST_F(TestTracing, recordsAttributes)
+{
+    {
+        mptr::TraceScope trace{"foo"};
+        mptr::ScopedSpan span{"download"};
+        span.add_attribute("url", "https://example.com");
+    }
+
+    const auto spans = MP_TRACER.take("foo");
+
+    ASSERT_EQ(spans.size(), 1u);
+    EXPECT_THAT(spans[0].attributes,
+                ElementsAre(std::pair<std::string, std::string>{"url", "https://example.com"}));
+}
+
+TEST_F(TestTracing, exportsChromeTraceEvents)
+{
+    mpt::TempDir temp_dir;
+    const auto file = temp_dir.filePath("trace.json");
+    MP_TRACER.export_to(file.toStdString());
+
+    {
+        mptr::TraceScope trace{"foo"};
+        mptr::ScopedSpan span{"fetch image"};
+        span.add_attribute("image", "noble");
+    }
+    {
+        mptr::ScopedSpan span{"untraced"};
+    }
+    TracerResetter::reset(); // closes the file
+
+    auto contents = mpt::load(file).toStdString();
+    ASSERT_THAT(contents, EndsWith(",\n"));
+    contents.replace(contents.size() - 2, 2, "]"); // the trailing comma is fine for Chrome only
+
+    const auto events = boost::json::parse(contents).as_array();
+    ASSERT_EQ(events.size(), 2u);
+
+    const auto& event = events[0].as_object();
+    EXPECT_EQ(event.at("name"), "fetch image");
+    EXPECT_EQ(event.at("ph"), "X");
+    EXPECT_EQ(event.at("args").at("trace"), "foo");
+    EXPECT_EQ(event.at("args").at("image"), "noble");
+    EXPECT_EQ(events[1].at("name"), "untraced");
+}
+} // namespace
@@ -16,11 +16,13 @@
  */
 
 #include "common.h"
+#include "file_operations.h"
 #include "image_host_remote_count.h"
 #include "mischievous_url_downloader.h"
 #include "mock_platform.h"
 #include "mock_settings.h"
 #include "path.h"
+#include "temp_dir.h"
 
 #include <multipass/constants.h>
 #include <multipass/exceptions/download_exception.h>
@@ -31,8 +33,11 @@
 
 #include <QUrl>
 
+#include <atomic>
+#include <chrono>
 #include <cstddef>
 #include <optional>
+#include <thread>
 #include <unordered_set>
 
 namespace mp = multipass;
@@ -44,6 +49,29 @@ using namespace std::literals::chrono_literals;
 
 namespace
 {
+// Fails or stalls downloads from the daily remote, leaving the others be
+struct FlakyDailyURLDownloader : public mpt::MischievousURLDownloader
+{
+    using MischievousURLDownloader::MischievousURLDownloader;
+
+    QByteArray download(const QUrl& url, const bool force_update) override
+    {
+        if (url.toString().contains("daily/"))
+        {
+            ++daily_attempts;
+            std::this_thread::sleep_for(daily_delay);
+            if (daily_down)
+                throw mp::DownloadException{url.toString().toStdString(), "daily is down"};
+        }
+
+        return MischievousURLDownloader::download(url, force_update);
+    }
+
+    std::atomic_int daily_attempts{0};
+    std::chrono::milliseconds daily_delay{0};
+    std::atomic_bool daily_down{false};
+};
+
 struct UbuntuImageHost : public testing::Test
 {
     UbuntuImageHost()
@@ -384,8 +412,8 @@ TEST_F(UbuntuImageHost, handlesAndRecoversFromLaterNetworkFailure)
     EXPECT_TRUE(host.info_for(query));
 
     url_downloader.mischiefs = 1000;
-    EXPECT_THROW(host.update_manifests(false), mp::DownloadException);
-    EXPECT_THROW(host.info_for(query), std::runtime_error);
+    EXPECT_NO_THROW(host.update_manifests(false));
+    EXPECT_TRUE(host.info_for(query));
 
     url_downloader.mischiefs = 0;
     host.update_manifests(false);
@@ -406,10 +434,120 @@ TEST_F(UbuntuImageHost, handlesAndRecoversFromIndependentServerFailures)
     for (size_t i = 1; i < num_remotes; ++i)
     {
         url_downloader.mischiefs = i;
-        EXPECT_THROW(mpt::count_remotes(host), mp::DownloadException);
+        EXPECT_EQ(mpt::count_remotes(host), num_remotes);
     }
 }
 
+TEST_F(UbuntuImageHost, servesOtherRemotesWhenOneMissesTheDeadline)
+{
+    FlakyDailyURLDownloader downloader{std::chrono::seconds{10}};
+    downloader.daily_delay = 1s;
+
+    mp::ManifestRefreshPolicy policy;
+    policy.deadline = 250ms;
+    mp::UbuntuVMImageHost host{all_remote_specs, &downloader, {}, policy};
+    EXPECT_NO_THROW(host.update_manifests(false));
+
+    EXPECT_TRUE(host.info_for(make_query("xenial", release_remote_spec.first)));
+    EXPECT_THROW(host.all_images_for(daily_remote_spec.first, false), std::runtime_error);
+
+    const auto statuses = host.refresh_statuses();
+    ASSERT_EQ(statuses.size(), 2u);
+    EXPECT_EQ(statuses[0].remote_name, release_remote_spec.first);
+    EXPECT_THAT(statuses[0].error, IsEmpty());
+    EXPECT_TRUE(statuses[0].fetched_at);
+    EXPECT_EQ(statuses[1].remote_name, daily_remote_spec.first);
+    EXPECT_THAT(statuses[1].error, HasSubstr("no manifest within"));
+    EXPECT_FALSE(statuses[1].fetched_at);
+}
+
+TEST_F(UbuntuImageHost, servesLookupsWhileARefreshDownloads)
+{
+    FlakyDailyURLDownloader downloader{std::chrono::seconds{10}};
+    mp::UbuntuVMImageHost host{all_remote_specs, &downloader};
+    host.update_manifests(false);
+
+    downloader.daily_delay = 1s;
+    std::thread refresh{[&host] { host.update_manifests(false); }};
+    while (downloader.daily_attempts < 3) // after the index and manifest of the first update
+        std::this_thread::sleep_for(10ms);
+
+    const auto start = std::chrono::steady_clock::now();
+    EXPECT_TRUE(host.info_for(make_query("xenial", release_remote_spec.first)));
+    EXPECT_LT(std::chrono::steady_clock::now() - start, 500ms);
+
+    refresh.join();
+}
+
+TEST_F(UbuntuImageHost, reportsFailedRefreshesWhileServingPreviousManifests)
+{
+    FlakyDailyURLDownloader downloader{std::chrono::seconds{10}};
+    mp::UbuntuVMImageHost host{all_remote_specs, &downloader};
+    host.update_manifests(false);
+
+    downloader.daily_down = true;
+    host.update_manifests(false);
+
+    EXPECT_FALSE(host.all_images_for(daily_remote_spec.first, false).empty());
+
+    const auto statuses = host.refresh_statuses();
+    ASSERT_EQ(statuses.size(), 2u);
+    EXPECT_THAT(statuses[0].error, IsEmpty());
+    EXPECT_THAT(statuses[1].error, HasSubstr("daily is down"));
+    EXPECT_TRUE(statuses[1].fetched_at);
+}
+
+TEST_F(UbuntuImageHost, backsOffRemotesThatKeepFailing)
+{
+    FlakyDailyURLDownloader downloader{std::chrono::seconds{10}};
+    downloader.daily_down = true;
+
+    mp::ManifestRefreshPolicy policy;
+    policy.failures_before_backoff = 2;
+    mp::UbuntuVMImageHost host{all_remote_specs, &downloader, {}, policy};
+
+    for (auto i = 0; i < 4; ++i)
+        host.update_manifests(false);
+    EXPECT_EQ(downloader.daily_attempts, 2);
+
+    downloader.daily_down = false;
+    host.update_manifests(true);
+    EXPECT_EQ(downloader.daily_attempts, 4); // the index and the manifest
+    EXPECT_FALSE(host.all_images_for(daily_remote_spec.first, false).empty());
+}
+
+TEST_F(UbuntuImageHost, doesNotDownloadAgainWhileAnOverrunDownloadRuns)
+{
+    FlakyDailyURLDownloader downloader{std::chrono::seconds{10}};
+    downloader.daily_delay = 1s;
+
+    mp::ManifestRefreshPolicy policy;
+    policy.deadline = 100ms;
+    mp::UbuntuVMImageHost host{all_remote_specs, &downloader, {}, policy};
+    host.update_manifests(false);
+    host.update_manifests(false);
+
+    EXPECT_EQ(downloader.daily_attempts, 1);
+
+    const auto statuses = host.refresh_statuses();
+    ASSERT_EQ(statuses.size(), 2u);
+    EXPECT_THAT(statuses[1].error, HasSubstr("has not finished"));
+}
+
+TEST_F(UbuntuImageHost, throwsWhileEveryRemoteBacksOffWithNothingToServe)
+{
+    url_downloader.mischiefs = 1000;
+
+    mp::ManifestRefreshPolicy policy;
+    policy.failures_before_backoff = 1;
+    mp::UbuntuVMImageHost host{all_remote_specs, &url_downloader, {}, policy};
+    EXPECT_THROW(host.update_manifests(false), mp::DownloadException);
+
+    MP_EXPECT_THROW_THAT(host.update_manifests(false),
+                         mp::DownloadException,
+                         mpt::match_what(HasSubstr("not tried again yet")));
+}
+
 TEST_F(UbuntuImageHost, throwsUnsupportedImageWhenImageNotSupported)
 {
     mp::UbuntuVMImageHost host{all_remote_specs, &url_downloader};
@@ -505,6 +643,17 @@ TEST_F(UbuntuImageHost, infoForFullHashFindsImage)
     EXPECT_EQ(image_info.release, "zesty");
 }
 
+TEST_F(UbuntuImageHost, infoForFullHashIgnoresCase)
+{
+    mp::UbuntuVMImageHost host{all_remote_specs, &url_downloader};
+    host.update_manifests(false);
+
+    auto image_info =
+        host.info_for_full_hash("ab115b83e7a8bebf3d3a02bf55ad0cb75a0ed515fcbc65fb0c9abe76c752921c");
+
+    EXPECT_EQ(image_info.release, "zesty");
+}
+
 TEST_F(UbuntuImageHost, unknownHashThrows)
 {
     const auto bad_hash = "1234";
@@ -516,3 +665,88 @@ TEST_F(UbuntuImageHost, unknownHashThrows)
         mp::ImageNotFoundException,
         mpt::match_what(StrEq(fmt::format("Image with hash \"{}\" not found", bad_hash))));
 }
+
+TEST_F(UbuntuImageHost, servesCachedManifestsWhenOffline)
+{
+    mpt::TempDir cache_dir;
+    {
+        mp::UbuntuVMImageHost host{{release_remote_spec}, &url_downloader, cache_dir.path()};
+        host.update_manifests(false);
+    }
+
+    url_downloader.mischiefs = 1000;
+    mp::UbuntuVMImageHost host{{release_remote_spec}, &url_downloader, cache_dir.path()};
+    EXPECT_NO_THROW(host.update_manifests(false));
+
+    auto info = host.info_for(make_query("xenial", release_remote_spec.first));
+
+    ASSERT_TRUE(info);
+    EXPECT_THAT(info->image_location, Eq(expected_location));
+    EXPECT_THAT(info->id, Eq(expected_id));
+}
+
+TEST_F(UbuntuImageHost, reportsWhenCachedManifestsWereFetchedWhenTheirRefreshFails)
+{
+    mpt::TempDir cache_dir;
+    FlakyDailyURLDownloader downloader{std::chrono::seconds{10}};
+    const auto before_fetch = std::chrono::system_clock::now();
+    {
+        mp::UbuntuVMImageHost host{all_remote_specs, &downloader, cache_dir.path()};
+        host.update_manifests(false);
+    }
+    const auto after_fetch = std::chrono::system_clock::now();
+
+    downloader.daily_down = true;
+    mp::UbuntuVMImageHost host{all_remote_specs, &downloader, cache_dir.path()};
+    host.update_manifests(false);
+
+    auto statuses = host.refresh_statuses();
+    for (auto i = 0; i < 500 && (statuses.size() < 2 || statuses[1].error.empty()); ++i)
+    {
+        std::this_thread::sleep_for(10ms);
+        statuses = host.refresh_statuses();
+    }
+
+    ASSERT_EQ(statuses.size(), 2u);
+    EXPECT_EQ(statuses[1].remote_name, daily_remote_spec.first);
+    EXPECT_THAT(statuses[1].error, HasSubstr("daily is down"));
+    ASSERT_TRUE(statuses[1].fetched_at);
+    EXPECT_GE(*statuses[1].fetched_at, before_fetch - 1s);
+    EXPECT_LE(*statuses[1].fetched_at, after_fetch);
+    EXPECT_FALSE(host.all_images_for(daily_remote_spec.first, false).empty());
+}
+
+TEST_F(UbuntuImageHost, doesNotServeCachedManifestsFromAnotherSite)
+{
+    mpt::TempDir cache_dir;
+    {
+        mp::UbuntuVMImageHost host{{release_remote_spec_with_mirror_allowed},
+                                   &url_downloader,
+                                   cache_dir.path()};
+        host.update_manifests(false);
+    }
+
+    EXPECT_CALL(mock_settings, get(Eq(mp::mirror_key)))
+        .WillRepeatedly(Return(test_valid_mirror_host));
+
+    mp::UbuntuVMImageHost host{{release_remote_spec_with_mirror_allowed},
+                               &url_downloader,
+                               cache_dir.path()};
+    host.update_manifests(false);
+
+    auto info = host.info_for(make_query("xenial", release_remote_spec.first));
+
+    ASSERT_TRUE(info);
+    EXPECT_THAT(info->image_location, Eq(test_valid_mirror_host + "releases/newest_image.img"));
+}
+
+TEST_F(UbuntuImageHost, downloadsManifestsWhenCacheIsCorrupt)
+{
+    mpt::TempDir cache_dir;
+    mpt::make_file_with_content(cache_dir.filePath("release.manifest"), "not a manifest");
+
+    url_downloader.mischiefs = 1000;
+    mp::UbuntuVMImageHost host{{release_remote_spec}, &url_downloader, cache_dir.path()};
+
+    EXPECT_THROW(host.update_manifests(false), mp::DownloadException);
+}
@@ -24,6 +24,10 @@
 #include <multipass/exceptions/aborted_download_exception.h>
 #include <multipass/exceptions/download_exception.h>
 
+#include <QBuffer>
+#include <QRegularExpression>
+#include <QTcpServer>
+#include <QTcpSocket>
 #include <QTimer>
 
 namespace mp = multipass;
@@ -84,6 +88,34 @@ TEST_F(URLDownloader, simpleDownloadReturnsExpectedData)
     EXPECT_EQ(downloaded_data, test_data);
 }
 
+TEST_F(URLDownloader, reusesNetworkManagerAcrossDownloads)
+{
+    const QByteArray test_data{"The answer to everything is 42."};
+    mpt::MockQNetworkReply* first_reply = new mpt::MockQNetworkReply();
+    mpt::MockQNetworkReply* second_reply = new mpt::MockQNetworkReply();
+
+    // The fixture lets the factory make a single manager
+    EXPECT_CALL(*mock_network_access_manager, createRequest(_, _, _))
+        .WillOnce(Return(first_reply))
+        .WillOnce(Return(second_reply));
+
+    for (auto* reply : {first_reply, second_reply})
+        EXPECT_CALL(*reply, readData(_, _))
+            .WillOnce([&test_data](char* data, auto) {
+                memcpy(data, test_data.constData(), test_data.size());
+                return test_data.size();
+            })
+            .WillOnce(Return(0));
+
+    mp::URLDownloader downloader(cache_dir.path(), 1s);
+
+    QTimer::singleShot(0, [first_reply] { first_reply->finished(); });
+    EXPECT_EQ(downloader.download(fake_url), test_data);
+
+    QTimer::singleShot(0, [second_reply] { second_reply->finished(); });
+    EXPECT_EQ(downloader.download(fake_url), test_data);
+}
+
 TEST_F(URLDownloader, simpleDownloadNetworkTimeoutTriesCache)
 {
     mpt::MockQNetworkReply* mock_reply_abort = new mpt::MockQNetworkReply();
@@ -631,3 +663,124 @@ TEST_F(URLConverter, lastModifiedHttpUrlBecomesHttps)
         downloader.last_modified(url);
     });
 }
+
+namespace
+{
+// Sends https requests over plain http instead, for a local server to answer them
+class PlainHttpNetworkAccessManager : public QNetworkAccessManager
+{
+protected:
+    QNetworkReply* createRequest(Operation op,
+                                 const QNetworkRequest& request,
+                                 QIODevice* data) override
+    {
+        auto url = request.url();
+        url.setScheme("http");
+
+        auto plain_request = request;
+        plain_request.setUrl(url);
+        return QNetworkAccessManager::createRequest(op, plain_request, data);
+    }
+};
+
+// Serves a file over HTTP on the loopback interface, with or without support for ranges
+class LocalHttpServer
+{
+public:
+    LocalHttpServer(QByteArray file, bool serves_ranges)
+        : file{std::move(file)}, serves_ranges{serves_ranges}
+    {
+        EXPECT_TRUE(server.listen(QHostAddress::LocalHost));
+        QObject::connect(&server, &QTcpServer::newConnection, [this] {
+            while (auto socket = server.nextPendingConnection())
+                QObject::connect(socket, &QTcpSocket::readyRead, [this, socket] {
+                    serve(socket);
+                });
+        });
+    }
+
+    QUrl url() const
+    {
+        return QUrl{QString{"https://127.0.0.1:%1/file.img"}.arg(server.serverPort())};
+    }
+
+private:
+    void serve(QTcpSocket* socket)
+    {
+        const auto request = socket->property("request").toByteArray() + socket->readAll();
+        socket->setProperty("request", request);
+        if (!request.contains("\r\n\r\n"))
+            return;
+
+        static const QRegularExpression range_regex{R"(\nRange: bytes=(\d+)-(\d+)\r)",
+                                                    QRegularExpression::CaseInsensitiveOption};
+        const auto match = range_regex.match(QString::fromLatin1(request));
+
+        std::string head;
+        QByteArray content;
+        if (serves_ranges && match.hasMatch())
+        {
+            const auto first = match.captured(1).toLongLong();
+            const auto last = match.captured(2).toLongLong();
+            content = file.mid(first, last - first + 1);
+            head = fmt::format("HTTP/1.1 206 Partial Content\r\nContent-Range: bytes {}-{}/{}\r\n",
+                               first,
+                               last,
+                               file.size());
+        }
+        else
+        {
+            content = file;
+            head = "HTTP/1.1 200 OK\r\n";
+        }
+
+        head += fmt::format("Content-Length: {}\r\nConnection: close\r\n\r\n", content.size());
+        socket->write(QByteArray::fromStdString(head) + content);
+        socket->disconnectFromHost();
+    }
+
+    QTcpServer server;
+    const QByteArray file;
+    const bool serves_ranges;
+};
+
+struct URLDownloaderOverHttp : public Test
+{
+    URLDownloaderOverHttp()
+    {
+        EXPECT_CALL(*mock_network_manager_factory, make_network_manager(_)).WillOnce([](auto...) {
+            return std::make_unique<PlainHttpNetworkAccessManager>();
+        });
+
+        for (auto i = 0; i < file.size(); ++i)
+            file[i] = static_cast<char>(i % 251);
+        out.open(QIODevice::WriteOnly);
+    }
+
+    mpt::MockNetworkManagerFactory::GuardedMock attr{mpt::MockNetworkManagerFactory::inject()};
+    mpt::MockNetworkManagerFactory* mock_network_manager_factory{attr.first};
+    QByteArray file{4 * 1024 * 1024, '\0'};
+    QBuffer out;
+};
+} // namespace
+
+TEST_F(URLDownloaderOverHttp, downloadsRangeIntoDevice)
+{
+    LocalHttpServer server{file, true};
+    mp::URLDownloader downloader{5s};
+
+    downloader.download_range_to(server.url(), 1000, 5000, out);
+
+    EXPECT_EQ(out.data(), file.mid(1000, 5000));
+}
+
+TEST_F(URLDownloaderOverHttp, rangeDownloadGivesUpOnWholeFilesBeforeTheyAreIn)
+{
+    LocalHttpServer server{file, false};
+    mp::URLDownloader downloader{5s};
+
+    MP_EXPECT_THROW_THAT(downloader.download_range_to(server.url(), 1000, 5000, out),
+                         mp::DownloadException,
+                         mpt::match_what(HasSubstr("did not send bytes 1000-5999")));
+    EXPECT_TRUE(out.data().isEmpty());
+}
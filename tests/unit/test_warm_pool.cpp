@@ -0,0 +1,289 @@
+/*
+ * Copyright (C) Canonical, Ltd.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "common.h"
+#include "mock_virtual_machine_factory.h"
+#include "mock_vm_image_vault.h"
+#include "temp_dir.h"
+
+#include <src/daemon/warm_pool.h>
+
+#include <multipass/query.h>
+
+#include <QDir>
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+namespace mp = multipass;
+namespace mpt = multipass::test;
+
+using namespace testing;
+
+namespace
+{
+struct WarmPoolProfiles : public Test
+{
+};
+
+TEST_F(WarmPoolProfiles, parsesImagesWithAndWithoutRemotes)
+{
+    const auto profiles = mp::parse_warm_pool_profiles(" noble=2, daily:jammy=1");
+
+    EXPECT_THAT(profiles,
+                ElementsAre(mp::WarmPoolProfile{"", "noble", 2},
+                            mp::WarmPoolProfile{"daily", "jammy", 1}));
+}
+
+TEST_F(WarmPoolProfiles, parsesPooledInstances)
+{
+    EXPECT_THAT(mp::parse_warm_pool_profiles("noble=2+1,jammy=0+3"),
+                ElementsAre(mp::WarmPoolProfile{"", "noble", 2, 1},
+                            mp::WarmPoolProfile{"", "jammy", 0, 3}));
+}
+
+TEST_F(WarmPoolProfiles, parsesEmptySettingAsNoProfiles)
+{
+    EXPECT_THAT(mp::parse_warm_pool_profiles(""), IsEmpty());
+}
+
+TEST_F(WarmPoolProfiles, dropsEmptyProfiles)
+{
+    EXPECT_THAT(mp::parse_warm_pool_profiles("noble=0,jammy=1"),
+                ElementsAre(mp::WarmPoolProfile{"", "jammy", 1}));
+}
+
+TEST_F(WarmPoolProfiles, rejectsMalformedEntries)
+{
+    for (const auto* setting : {"noble",
+                                "noble=",
+                                "noble=two",
+                                "noble=-1",
+                                "noble=1+",
+                                "noble=1+-1",
+                                "noble=1+1+1",
+                                "=1",
+                                "a:b:c=1",
+                                "daily:=1",
+                                "file:///tmp/image.img=1",
+                                "https://example.com/image.img=1",
+                                "noble=1,noble=2"})
+    {
+        EXPECT_THROW(mp::parse_warm_pool_profiles(setting), std::invalid_argument) << setting;
+    }
+}
+
+struct WarmPool : public Test
+{
+    WarmPool()
+    {
+        ON_CALL(mock_factory, get_instance_directory)
+            .WillByDefault([this](const std::string& name) {
+                return instances_dir.filePath(QString::fromStdString(name));
+            });
+        ON_CALL(mock_vault, fetch_image)
+            .WillByDefault([this](const mp::Query&,
+                                  const mp::VMImageVault::PrepareAction&,
+                                  const mp::ProgressMonitor&,
+                                  const std::optional<std::string>&,
+                                  const mp::Path& save_dir) {
+                QDir{}.mkpath(save_dir);
+                ++fetches;
+                return mp::VMImage{};
+            });
+    }
+
+    template <typename Predicate>
+    static bool eventually(Predicate&& predicate)
+    {
+        const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds{5};
+        while (!predicate())
+        {
+            if (std::chrono::steady_clock::now() > deadline)
+                return false;
+            std::this_thread::sleep_for(std::chrono::milliseconds{10});
+        }
+
+        return true;
+    }
+
+    mpt::TempDir instances_dir;
+    NiceMock<mpt::MockVirtualMachineFactory> mock_factory;
+    NiceMock<mpt::MockVMImageVault> mock_vault;
+    std::atomic_int fetches{0};
+    std::unique_ptr<mp::WarmPool> pool;
+};
+
+TEST_F(WarmPool, preparesImagesForEachProfile)
+{
+    EXPECT_CALL(mock_vault,
+                fetch_image(AllOf(Field(&mp::Query::release, "noble"),
+                                  Field(&mp::Query::name, StartsWith("_warm-pool-"))),
+                            _,
+                            _,
+                            _,
+                            _))
+        .Times(2);
+    EXPECT_CALL(mock_vault, fetch_image(Field(&mp::Query::release, "jammy"), _, _, _, _))
+        .Times(1);
+
+    pool = std::make_unique<mp::WarmPool>(
+        std::vector<mp::WarmPoolProfile>{{"", "noble", 2}, {"daily", "jammy", 1}},
+        mock_factory,
+        mock_vault);
+    EXPECT_TRUE(eventually([this] { return fetches == 3; }));
+}
+
+TEST_F(WarmPool, discardsLeftoversOnStartup)
+{
+    const auto leftover = instances_dir.filePath("_warm-pool-7");
+    ASSERT_TRUE(QDir{}.mkpath(leftover));
+
+    EXPECT_CALL(mock_vault, remove(Eq("_warm-pool-7")));
+
+    pool = std::make_unique<mp::WarmPool>(std::vector<mp::WarmPoolProfile>{{"", "noble", 1}},
+                                          mock_factory,
+                                          mock_vault);
+
+    EXPECT_FALSE(QFileInfo::exists(leftover));
+}
+
+TEST_F(WarmPool, claimHandsPreparedImageOverAndRefills)
+{
+    const mp::Query query{"foo", "noble", false, "", mp::Query::Type::Alias};
+
+    EXPECT_CALL(mock_vault, clone(StartsWith("_warm-pool-"), Eq("foo")));
+    EXPECT_CALL(mock_vault, remove(StartsWith("_warm-pool-")));
+
+    pool = std::make_unique<mp::WarmPool>(std::vector<mp::WarmPoolProfile>{{"", "noble", 1}},
+                                          mock_factory,
+                                          mock_vault);
+
+    ASSERT_TRUE(eventually([this, &query] { return pool->claim(query); }));
+    EXPECT_TRUE(QFileInfo{instances_dir.filePath("foo")}.isDir());
+    EXPECT_TRUE(eventually([this] { return fetches == 2; })); // the initial fill and the refill
+}
+
+TEST_F(WarmPool, claimIgnoresImagesWithoutProfile)
+{
+    EXPECT_CALL(mock_vault, clone).Times(0);
+
+    pool = std::make_unique<mp::WarmPool>(std::vector<mp::WarmPoolProfile>{{"", "noble", 1}},
+                                          mock_factory,
+                                          mock_vault);
+
+    EXPECT_FALSE(pool->claim({"foo", "jammy", false, "", mp::Query::Type::Alias}));
+    EXPECT_FALSE(pool->claim({"foo", "noble", false, "daily", mp::Query::Type::Alias}));
+    EXPECT_FALSE(
+        pool->claim({"foo", "file:///noble.img", false, "", mp::Query::Type::LocalFile}));
+}
+
+TEST_F(WarmPool, claimDiscardsPreparedImageWhenInstanceDirectoryExists)
+{
+    const mp::Query query{"foo", "noble", false, "", mp::Query::Type::Alias};
+    ASSERT_TRUE(QDir{}.mkpath(instances_dir.filePath("foo")));
+
+    std::atomic_bool discarded{false};
+    EXPECT_CALL(mock_vault, clone).Times(0);
+    EXPECT_CALL(mock_vault, remove(StartsWith("_warm-pool-")))
+        .WillRepeatedly([&discarded](const std::string&) { discarded = true; });
+
+    pool = std::make_unique<mp::WarmPool>(std::vector<mp::WarmPoolProfile>{{"", "noble", 1}},
+                                          mock_factory,
+                                          mock_vault);
+
+    EXPECT_TRUE(eventually([this, &query, &discarded] {
+        EXPECT_FALSE(pool->claim(query));
+        return discarded.load();
+    }));
+    pool.reset();
+}
+
+TEST_F(WarmPool, discardsImagesPreparedFromOutdatedImages)
+{
+    ON_CALL(mock_vault, all_info_for).WillByDefault([](const mp::Query&) {
+        mp::VMImageInfo info;
+        info.id = "newer";
+        return std::vector<std::pair<std::string, mp::VMImageInfo>>{{"release", info}};
+    });
+
+    std::atomic_bool discarded{false};
+    EXPECT_CALL(mock_vault, remove(StartsWith("_warm-pool-")))
+        .WillRepeatedly([&discarded](const std::string&) { discarded = true; });
+
+    pool = std::make_unique<mp::WarmPool>(std::vector<mp::WarmPoolProfile>{{"", "noble", 1}},
+                                          mock_factory,
+                                          mock_vault);
+    // the prepared image only counts once it is ready, which is shortly after it is fetched
+    ASSERT_TRUE(eventually([this, &discarded] {
+        pool->discard_stale();
+        return discarded.load();
+    }));
+
+    pool->refill();
+    EXPECT_TRUE(eventually([this] { return fetches == 2; }));
+}
+
+TEST_F(WarmPool, claimInstanceHandsOverBootedInstance)
+{
+    const mp::Query query{"", "noble", false, "", mp::Query::Type::Alias};
+    std::atomic_bool booted{false};
+
+    pool = std::make_unique<mp::WarmPool>(
+        std::vector<mp::WarmPoolProfile>{{"", "noble", 0, 1}},
+        mock_factory,
+        mock_vault,
+        [this, &booted](const std::string& pooled_name, const mp::Query& boot_query) {
+            EXPECT_EQ(boot_query.release, "noble");
+            if (!booted.exchange(true) && pool->hand_over(pooled_name, "pooled"))
+                pool->booted(pooled_name, {"pooled", {}, {}});
+        });
+
+    ASSERT_TRUE(eventually([this] { return pool->holds("pooled"); }));
+    EXPECT_TRUE(QFileInfo{instances_dir.filePath("pooled")}.isDir());
+
+    const auto instance = pool->claim_instance(query);
+    ASSERT_TRUE(instance);
+    EXPECT_EQ(instance->name, "pooled");
+    EXPECT_FALSE(pool->holds("pooled"));
+    EXPECT_FALSE(pool->claim_instance({"", "jammy", false, "", mp::Query::Type::Alias}));
+}
+
+TEST_F(WarmPool, discardInstanceReleasesIt)
+{
+    std::atomic_bool booted{false}, released{false};
+    EXPECT_CALL(mock_factory, remove_resources_for(Eq("pooled")));
+
+    pool = std::make_unique<mp::WarmPool>(
+        std::vector<mp::WarmPoolProfile>{{"", "noble", 0, 1}},
+        mock_factory,
+        mock_vault,
+        [this, &booted](const std::string& pooled_name, const mp::Query&) {
+            if (!booted.exchange(true) && pool->hand_over(pooled_name, "pooled"))
+                pool->booted(pooled_name, {"pooled", {}, {}});
+        },
+        [&released](const mp::VirtualMachineDescription&) { released = true; });
+
+    ASSERT_TRUE(eventually([this] { return pool->holds("pooled"); }));
+    pool->discard_instance("pooled");
+
+    EXPECT_FALSE(pool->holds("pooled"));
+    EXPECT_TRUE(released);
+    EXPECT_FALSE(QFileInfo::exists(instances_dir.filePath("pooled")));
+}
+} // namespace
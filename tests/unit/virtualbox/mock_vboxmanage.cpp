@@ -0,0 +1,52 @@
+/*
+ * Copyright (C) Canonical, Ltd.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+// Lists a few instances, counting the listings in the file MOCK_VBOXMANAGE_CALLS points to. Like
+// VBoxManage would print translated states, it refuses to list them outside the C locale.
+int main(int argc, char* argv[])
+{
+    if (argc != 4 || std::strcmp(argv[1], "list") || std::strcmp(argv[2], "--long") ||
+        std::strcmp(argv[3], "vms"))
+        return 1;
+
+    if (const auto locale = std::getenv("LC_ALL"); !locale || std::strcmp(locale, "C"))
+        return 1;
+
+    if (const auto calls = std::getenv("MOCK_VBOXMANAGE_CALLS"))
+        std::ofstream{calls, std::ios::app} << "list\n";
+
+    std::cout << "Name:                        primary\n"
+                 "Groups:                      /\n"
+                 "State:                       running (since 2024-04-10T15:34:09.0)\n"
+                 "Shared folders:\n\n"
+                 "Name: 'home', Host path: '/home' (machine mapping), writable\n"
+                 "Snapshots:\n\n"
+                 "   Name: snapshot1 (UUID: 93a6a9ba-9223-4b77-a8cf-80213439aaae)\n\n"
+                 "Name:                        sleepy\n"
+                 "State:                       saved (since 2024-04-10T15:34:09.0)\n\n"
+                 "Name:                        off\n"
+                 "State:                       powered off (since 2024-04-10T15:34:09.0)\n\n"
+                 "Name:                        odd\n"
+                 "State:                       guru meditation (since 2024-04-10T15:34:09.0)\n";
+
+    return 0;
+}
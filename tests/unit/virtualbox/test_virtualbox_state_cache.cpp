@@ -0,0 +1,101 @@
+/*
+ * Copyright (C) Canonical, Ltd.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "tests/unit/common.h"
+#include "tests/unit/file_operations.h"
+#include "tests/unit/mock_environment_helpers.h"
+#include "tests/unit/temp_dir.h"
+#include "tests/unit/test_with_mocked_bin_path.h"
+
+#include <src/platform/backends/virtualbox/virtualbox_state_cache.h>
+
+#include <QFile>
+
+namespace mp = multipass;
+namespace mpt = multipass::test;
+
+using namespace testing;
+using State = mp::VirtualMachine::State;
+
+namespace
+{
+struct VirtualBoxStateCache : public mpt::TestWithMockedBinPath
+{
+    int listings() const
+    {
+        return QFile::exists(calls_file) ? mpt::load(calls_file).count('\n') : 0;
+    }
+
+    mpt::TempDir temp_dir;
+    const QString calls_file = temp_dir.filePath("calls");
+    const mpt::SetEnvScope calls_env{"MOCK_VBOXMANAGE_CALLS", calls_file.toUtf8()};
+    mp::VirtualBoxStateCache states;
+};
+
+TEST_F(VirtualBoxStateCache, readsStatesOfAllInstancesFromOneListing)
+{
+    EXPECT_EQ(states.state_of("primary"), State::running);
+    EXPECT_EQ(states.state_of("sleepy"), State::suspended);
+    EXPECT_EQ(states.state_of("off"), State::stopped);
+    EXPECT_EQ(states.state_of("odd"), State::unknown);
+
+    EXPECT_EQ(listings(), 1);
+}
+
+TEST_F(VirtualBoxStateCache, doesNotTakeSnapshotsOrSharedFoldersForInstances)
+{
+    EXPECT_EQ(states.state_of("snapshot1"), State::unknown);
+    EXPECT_EQ(states.state_of("'home', Host path: '/home' (machine mapping), writable"),
+              State::unknown);
+}
+
+TEST_F(VirtualBoxStateCache, listsAgainForInstancesItDoesNotKnow)
+{
+    states.state_of("primary");
+    EXPECT_EQ(states.state_of("new"), State::unknown);
+
+    EXPECT_EQ(listings(), 2);
+}
+
+TEST_F(VirtualBoxStateCache, listsAgainForInstancesItDoesNotKnowOnlyOnce)
+{
+    states.state_of("primary");
+    for (auto i = 0; i < 3; ++i)
+        EXPECT_EQ(states.state_of("new"), State::unknown);
+
+    EXPECT_EQ(listings(), 2);
+}
+
+TEST_F(VirtualBoxStateCache, listsInTheCLocale)
+{
+    const mpt::SetEnvScope locale{"LC_ALL", "de_DE.UTF-8"};
+
+    EXPECT_EQ(states.state_of("primary"), State::running);
+}
+
+TEST_F(VirtualBoxStateCache, listsAgainOnceInvalidated)
+{
+    states.state_of("primary");
+    states.state_of("primary");
+    ASSERT_EQ(listings(), 1);
+
+    states.invalidate();
+
+    EXPECT_EQ(states.state_of("primary"), State::running);
+    EXPECT_EQ(listings(), 2);
+}
+} // namespace